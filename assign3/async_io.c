@@ -0,0 +1,495 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "async_io.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define AIO_HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static RC initRing(AIO_Context *aio);
+static void freeRing(AIO_Context *aio);
+static RC submitToRing(AIO_Context *aio, AIO_Request *request);
+static void queueToRing(AIO_Context *aio, AIO_Request *request);
+static RC enterRing(AIO_Context *aio, int minComplete);
+static void reapRing(AIO_Context *aio);
+static RC initWorkers(AIO_Context *aio);
+static void *ioWorker(void *arg);
+static void doPageIO(AIO_Request *request);
+static int takeDone(AIO_Context *aio, AIO_Request **done, int maxDone);
+static RC getReturnCode(AIO_Request *request, long result);
+static struct iovec *getRemainingIovs(AIO_Request *request, int *numIovs);
+static off_t getRequestOffset(AIO_Request *request);
+
+/*********************************************************************
+*
+*                       ASYNC IO FUNCTIONS
+*
+*********************************************************************/
+RC initAsyncIO (AIO_Context *aio, int queueDepth, bool useRing)
+{
+    memset(aio, 0, sizeof(AIO_Context));
+    aio->queueDepth = queueDepth > 0 ? queueDepth : AIO_DEFAULT_QUEUE_DEPTH;
+    //the ring may be missing or forbidden, the threads always work
+    if(useRing && initRing(aio) == RC_OK)
+        return RC_OK;
+    return initWorkers(aio);
+}
+
+RC shutdownAsyncIO (AIO_Context *aio)
+{
+    AIO_Request *done[AIO_DEFAULT_QUEUE_DEPTH];
+    //a ring that can't be entered won't complete the rest
+    RC returnCode = RC_OK;
+    while(aio->numInFlight > 0 && returnCode == RC_OK)
+        if(waitAsyncIO(aio, done, AIO_DEFAULT_QUEUE_DEPTH) < 0)
+            returnCode = RC_AIO_ENTER_FAILED;
+    if(aio->ring)
+    {
+        freeRing(aio);
+        return returnCode;
+    }
+    pthread_mutex_lock(&aio->mutex);
+    aio->stop = true;
+    pthread_cond_broadcast(&aio->submitted);
+    pthread_mutex_unlock(&aio->mutex);
+    for(int i = 0; i < aio->numWorkers; i++)
+        pthread_join(aio->workers[i], NULL);
+    free(aio->workers);
+    aio->workers = NULL;
+    pthread_mutex_destroy(&aio->mutex);
+    pthread_cond_destroy(&aio->submitted);
+    pthread_cond_destroy(&aio->completed);
+    return RC_OK;
+}
+
+RC submitPageIO (AIO_Context *aio, AIO_Request *request)
+{
+    request->iov.iov_base = request->data;
+    request->iov.iov_len = PAGE_SIZE;
+    request->numPages = 1;
+    request->iovs = &request->iov;
+    return submitPagesIO(aio, request);
+}
+
+RC submitPagesIO (AIO_Context *aio, AIO_Request *request)
+{
+    if(request->numPages < 1 || request->numPages > AIO_MAX_RUN_PAGES)
+        return RC_INVALID_PAGE_NUMBER;
+    request->returnCode = RC_INIT;
+    request->numBytesDone = 0;
+    request->next = NULL;
+    if(aio->ring)
+    {
+        RC returnCode = submitToRing(aio, request);
+        if(returnCode == RC_OK)
+            aio->numInFlight++;
+        return returnCode;
+    }
+    aio->numInFlight++;
+    pthread_mutex_lock(&aio->mutex);
+    if(aio->pendingTail)
+        aio->pendingTail->next = request;
+    else
+        aio->pending = request;
+    aio->pendingTail = request;
+    pthread_cond_signal(&aio->submitted);
+    pthread_mutex_unlock(&aio->mutex);
+    return RC_OK;
+}
+
+int pollAsyncIO (AIO_Context *aio, AIO_Request **done, int maxDone)
+{
+    if(aio->ring)
+    {
+        if(enterRing(aio, 0) != RC_OK)
+            return -1;
+        reapRing(aio);
+        return takeDone(aio, done, maxDone);
+    }
+    pthread_mutex_lock(&aio->mutex);
+    int numDone = takeDone(aio, done, maxDone);
+    pthread_mutex_unlock(&aio->mutex);
+    return numDone;
+}
+
+int waitAsyncIO (AIO_Context *aio, AIO_Request **done, int maxDone)
+{
+    if(aio->ring)
+    {
+        if(enterRing(aio, 0) != RC_OK)
+            return -1;
+        reapRing(aio);
+        //a completion may only resubmit the rest of its request
+        while(!aio->done && aio->numInFlight > 0)
+        {
+            if(enterRing(aio, 1) != RC_OK)
+                return -1;
+            reapRing(aio);
+        }
+        return takeDone(aio, done, maxDone);
+    }
+    pthread_mutex_lock(&aio->mutex);
+    while(!aio->done && aio->numInFlight > 0)
+        pthread_cond_wait(&aio->completed, &aio->mutex);
+    int numDone = takeDone(aio, done, maxDone);
+    pthread_mutex_unlock(&aio->mutex);
+    return numDone;
+}
+
+bool usesIoUring (AIO_Context *aio)
+{
+    return aio->ring != NULL;
+}
+
+/*********************************************************************
+*
+*                          IO_URING
+*
+*********************************************************************/
+
+/*********************************************************************
+The submission and completion rings are shared with the kernel. We
+own the tail of the submission ring and the head of the completion
+ring, the kernel the other ends, so they are read with acquire and
+written with release ordering. A request is submitted as a readv or
+writev of its iovs with the request as its user data, a completion
+that transferred part of it queues the rest again. No more than
+queueDepth requests are given to the kernel at once, so the
+completion ring, which is twice as large, can't overflow.
+*********************************************************************/
+#ifdef AIO_HAVE_IO_URING
+typedef struct AIO_Ring {
+    int fd;
+    void *sqPtr;
+    size_t sqSize;
+    void *cqPtr;
+    size_t cqSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+    int numQueued;              //in the submission ring, not entered yet
+    int numInKernel;            //entered, completion not reaped yet
+} AIO_Ring;
+
+static RC initRing(AIO_Context *aio)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int) syscall(__NR_io_uring_setup, aio->queueDepth, &params);
+    if(fd < 0)
+        return RC_AIO_INIT_FAILED;
+    VALID_CALLOC(AIO_Ring, ring, 1, sizeof(AIO_Ring));
+    ring->fd = fd;
+    ring->sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    //newer kernels map both rings at once
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(ring->cqSize > ring->sqSize)
+            ring->sqSize = ring->cqSize;
+        ring->cqSize = ring->sqSize;
+    }
+    ring->sqPtr = mmap(NULL, ring->sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQ_RING);
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->cqPtr = ring->sqPtr;
+    else
+        ring->cqPtr = mmap(NULL, ring->cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           fd, IORING_OFF_CQ_RING);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    aio->ring = ring;
+    if(ring->sqPtr == MAP_FAILED || ring->cqPtr == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        freeRing(aio);
+        return RC_AIO_INIT_FAILED;
+    }
+    char *sq = ring->sqPtr;
+    char *cq = ring->cqPtr;
+    ring->sqTail = (unsigned *) (sq + params.sq_off.tail);
+    ring->sqMask = (unsigned *) (sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned *) (sq + params.sq_off.array);
+    ring->cqHead = (unsigned *) (cq + params.cq_off.head);
+    ring->cqTail = (unsigned *) (cq + params.cq_off.tail);
+    ring->cqMask = (unsigned *) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    //the ring may be smaller than asked for
+    if((int) params.sq_entries < aio->queueDepth)
+        aio->queueDepth = params.sq_entries;
+    return RC_OK;
+}
+
+static void freeRing(AIO_Context *aio)
+{
+    AIO_Ring *ring = aio->ring;
+    if(ring->sqes != MAP_FAILED)
+        munmap(ring->sqes, ring->sqesSize);
+    if(ring->cqPtr != ring->sqPtr && ring->cqPtr != MAP_FAILED)
+        munmap(ring->cqPtr, ring->cqSize);
+    if(ring->sqPtr != MAP_FAILED)
+        munmap(ring->sqPtr, ring->sqSize);
+    close(ring->fd);
+    free(ring);
+    aio->ring = NULL;
+}
+
+static RC submitToRing(AIO_Context *aio, AIO_Request *request)
+{
+    AIO_Ring *ring = aio->ring;
+    //a full ring makes room by waiting for a completion
+    while(ring->numQueued + ring->numInKernel >= aio->queueDepth)
+    {
+        if(enterRing(aio, ring->numQueued > 0 ? 0 : 1) != RC_OK)
+            return RC_AIO_ENTER_FAILED;
+        reapRing(aio);
+    }
+    queueToRing(aio, request);
+    return RC_OK;
+}
+
+//puts the rest of the request into the submission ring, which has room
+static void queueToRing(AIO_Context *aio, AIO_Request *request)
+{
+    AIO_Ring *ring = aio->ring;
+    int numIovs;
+    struct iovec *iovs = getRemainingIovs(request, &numIovs);
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & *ring->sqMask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = request->op == AIO_READ ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = request->fd;
+    sqe->addr = (unsigned long) iovs;
+    sqe->len = numIovs;
+    sqe->off = (unsigned long long) getRequestOffset(request);
+    sqe->user_data = (unsigned long) request;
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ring->numQueued++;
+}
+
+//submits the queued requests, waits for minComplete completions
+static RC enterRing(AIO_Context *aio, int minComplete)
+{
+    AIO_Ring *ring = aio->ring;
+    if(ring->numQueued == 0 && minComplete == 0)
+        return RC_OK;
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    long numSubmitted;
+    do
+        numSubmitted = syscall(__NR_io_uring_enter, ring->fd, ring->numQueued, minComplete, flags, NULL, 0);
+    while(numSubmitted < 0 && errno == EINTR);
+    if(numSubmitted < 0)
+        return RC_AIO_INIT_FAILED;
+    ring->numQueued -= numSubmitted;
+    ring->numInKernel += numSubmitted;
+    return RC_OK;
+}
+
+//moves the completions to the done requests
+static void reapRing(AIO_Context *aio)
+{
+    AIO_Ring *ring = aio->ring;
+    unsigned head = *ring->cqHead;
+    unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+    for(; head != tail; head++)
+    {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+        AIO_Request *request = (AIO_Request *) (unsigned long) cqe->user_data;
+        RC returnCode = getReturnCode(request, cqe->res);
+        ring->numInKernel--;
+        //takes the place the completion left in the ring
+        if(returnCode == RC_INIT)
+        {
+            queueToRing(aio, request);
+            continue;
+        }
+        request->returnCode = returnCode;
+        request->next = aio->done;
+        aio->done = request;
+    }
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+}
+#else
+typedef struct AIO_Ring {
+    int fd;
+} AIO_Ring;
+
+static RC initRing(AIO_Context *aio)
+{
+    return RC_AIO_INIT_FAILED;
+}
+
+static void freeRing(AIO_Context *aio) {}
+static RC submitToRing(AIO_Context *aio, AIO_Request *request)
+{
+    return RC_OK;
+}
+static void queueToRing(AIO_Context *aio, AIO_Request *request) {}
+static RC enterRing(AIO_Context *aio, int minComplete)
+{
+    return RC_OK;
+}
+static void reapRing(AIO_Context *aio) {}
+#endif
+
+/*********************************************************************
+*
+*                         THREAD POOL
+*
+*********************************************************************/
+static RC initWorkers(AIO_Context *aio)
+{
+    pthread_mutex_init(&aio->mutex, NULL);
+    pthread_cond_init(&aio->submitted, NULL);
+    pthread_cond_init(&aio->completed, NULL);
+    aio->workers = (pthread_t *) calloc(AIO_NUM_WORKERS, sizeof(pthread_t));
+    if(!aio->workers)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    for(aio->numWorkers = 0; aio->numWorkers < AIO_NUM_WORKERS; aio->numWorkers++)
+        if(pthread_create(&aio->workers[aio->numWorkers], NULL, ioWorker, aio) != 0)
+            break;
+    if(aio->numWorkers > 0)
+        return RC_OK;
+    free(aio->workers);
+    pthread_mutex_destroy(&aio->mutex);
+    pthread_cond_destroy(&aio->submitted);
+    pthread_cond_destroy(&aio->completed);
+    return RC_AIO_INIT_FAILED;
+}
+
+static void *ioWorker(void *arg)
+{
+    AIO_Context *aio = arg;
+    pthread_mutex_lock(&aio->mutex);
+    while(true)
+    {
+        while(!aio->stop && !aio->pending)
+            pthread_cond_wait(&aio->submitted, &aio->mutex);
+        if(!aio->pending)
+            break;
+        AIO_Request *request = aio->pending;
+        aio->pending = request->next;
+        if(!aio->pending)
+            aio->pendingTail = NULL;
+        pthread_mutex_unlock(&aio->mutex);
+        doPageIO(request);
+        pthread_mutex_lock(&aio->mutex);
+        request->next = aio->done;
+        aio->done = request;
+        pthread_cond_signal(&aio->completed);
+    }
+    pthread_mutex_unlock(&aio->mutex);
+    return NULL;
+}
+
+//transfers the rest of the request until it is done or fails
+static void doPageIO(AIO_Request *request)
+{
+    do
+    {
+        int numIovs;
+        struct iovec *iovs = getRemainingIovs(request, &numIovs);
+        off_t offset = getRequestOffset(request);
+        long result;
+        if(request->op == AIO_READ)
+            result = preadv(request->fd, iovs, numIovs, offset);
+        else
+            result = pwritev(request->fd, iovs, numIovs, offset);
+        request->returnCode = getReturnCode(request, result < 0 ? -errno : result);
+    }
+    while(request->returnCode == RC_INIT);
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+//hands back done requests, the caller holds the mutex of the threads
+static int takeDone(AIO_Context *aio, AIO_Request **done, int maxDone)
+{
+    int numDone = 0;
+    while(aio->done && numDone < maxDone)
+    {
+        done[numDone++] = aio->done;
+        aio->done = aio->done->next;
+    }
+    aio->numInFlight -= numDone;
+    return numDone;
+}
+
+//result is the number of bytes transferred or -errno. RETURNS: RC_INIT
+//while bytes of the request are left, which are transferred next
+static RC getReturnCode(AIO_Request *request, long result)
+{
+    if(result == -EINTR || result == -EAGAIN)
+        return RC_INIT;
+    //nothing transferred is the end of the file or an error
+    if(result <= 0)
+        return request->op == AIO_READ ? RC_READ_FILE_FAILED : RC_WRITE_FAILED;
+    request->numBytesDone += result;
+    if(request->numBytesDone < request->numPages * request->iovs[0].iov_len)
+        return RC_INIT;
+    return RC_OK;
+}
+
+//the iovs of the bytes not transferred yet, the rest of a page
+//transferred in part goes on its own
+static struct iovec *getRemainingIovs(AIO_Request *request, int *numIovs)
+{
+    size_t pageBytes = request->iovs[0].iov_len;
+    int pageIndex = request->numBytesDone / pageBytes;
+    size_t pageDone = request->numBytesDone % pageBytes;
+    if(pageDone == 0)
+    {
+        *numIovs = request->numPages - pageIndex;
+        return request->iovs + pageIndex;
+    }
+    request->restIov.iov_base = (char *) request->iovs[pageIndex].iov_base + pageDone;
+    request->restIov.iov_len = pageBytes - pageDone;
+    *numIovs = 1;
+    return &request->restIov;
+}
+
+//the byte of the file the rest of the request starts at
+static off_t getRequestOffset(AIO_Request *request)
+{
+    return request->fileOffset + (off_t) request->pageNum * (off_t) request->iovs[0].iov_len
+           + (off_t) request->numBytesDone;
+}
@@ -0,0 +1,88 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "dberror.h"
+
+/*********************************************************************
+Asynchronous page IO: requests to read or write a page are submitted
+and complete later, so many of them can be in flight at once. The
+requests are carried out by io_uring if the kernel has it, otherwise
+by a pool of threads that do blocking preadv and pwritev.
+
+A request names a file descriptor from getPageFd, a page number
+and a buffer of PAGE_SIZE bytes, which must be page aligned if the
+file uses direct IO and must stay valid until the request completes.
+submitPagesIO transfers a run of consecutive pages in one request,
+each page from or into its own buffer (iovs), like preadv. The pages
+are as large as the buffers, page pageNum starts at fileOffset +
+pageNum times that, fileOffset is the one getPageFd returns with the
+descriptor, a run of pages must not cross into another segment.
+Writes don't grow the page file handle, the caller ensures the
+capacity first. A read or write that transfers less than the request
+is continued with the rest of it, a request only fails if nothing more
+can be transferred, e.g. at the end of the file. pollAsyncIO and
+waitAsyncIO hand back the completed requests with their returnCode set.
+They return -1 if the ring can't be entered, the requests in flight
+may never complete then.
+
+A context is used by one thread at a time.
+*********************************************************************/
+typedef enum AIO_Op {
+    AIO_READ = 0,
+    AIO_WRITE = 1
+} AIO_Op;
+
+typedef struct AIO_Request {
+    AIO_Op op;
+    int fd;
+    int pageNum;
+    off_t fileOffset;           //bytes of the file before page 0
+    char *data;                 //the page of submitPageIO
+    int numPages;               //pages from pageNum on, in iovs
+    struct iovec *iovs;         //a buffer per page, all of the same size
+    void *context;              //for the caller
+    RC returnCode;              //set when the request completed
+    struct iovec iov;           //iovs of submitPageIO
+    size_t numBytesDone;        //transferred so far, the rest is resubmitted
+    struct iovec restIov;       //the rest of a page transferred in part
+    struct AIO_Request *next;
+} AIO_Request;
+
+typedef struct AIO_Context {
+    int queueDepth;             //requests the ring takes at once
+    int numInFlight;            //submitted and not handed back yet
+    struct AIO_Ring *ring;      //NULL if the threads are used
+    AIO_Request *done;          //completed, not handed back yet
+    //thread pool
+    pthread_t *workers;
+    int numWorkers;
+    pthread_mutex_t mutex;
+    pthread_cond_t submitted;   //signaled when pending gets a request
+    pthread_cond_t completed;   //signaled when a request is added to done
+    AIO_Request *pending;
+    AIO_Request *pendingTail;
+    bool stop;
+} AIO_Context;
+
+#define AIO_DEFAULT_QUEUE_DEPTH 64
+#define AIO_NUM_WORKERS 4
+#define AIO_MAX_RUN_PAGES 1024
+
+// useRing false forces the thread pool
+extern RC initAsyncIO (AIO_Context *aio, int queueDepth, bool useRing);
+// waits for the requests in flight, RC_AIO_ENTER_FAILED if it can't
+extern RC shutdownAsyncIO (AIO_Context *aio);
+extern RC submitPageIO (AIO_Context *aio, AIO_Request *request);
+// numPages and iovs set by the caller, at most AIO_MAX_RUN_PAGES
+extern RC submitPagesIO (AIO_Context *aio, AIO_Request *request);
+// RETURNS: completed requests put into done, at most maxDone, or -1
+extern int pollAsyncIO (AIO_Context *aio, AIO_Request **done, int maxDone);
+// like pollAsyncIO, but waits for one if requests are in flight
+extern int waitAsyncIO (AIO_Context *aio, AIO_Request **done, int maxDone);
+extern bool usesIoUring (AIO_Context *aio);
+
+#endif // ASYNC_IO_H
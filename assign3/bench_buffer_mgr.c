@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+#include "record_mgr.h"
+#include "crc32c.h"
+
+/*********************************************************************
+Benchmarks of the buffer manager, the sizes are in MB:
+
+    make bench
+    bin/Release/bench_buffer_mgr pin [poolMB] [numPins]
+    bin/Release/bench_buffer_mgr io [fileMB] [numPins]
+    bin/Release/bench_buffer_mgr crc [bufferMB] [numRounds]
+    bin/Release/bench_buffer_mgr pagesize [tableMB] [numLookups]
+
+pin fills a pool as large as the page file with all pages, then pins
+and unpins random pages, once for every way of backing the frames. Its
+pool is BENCH_PIN_POOL_MB by default, much larger than the TLBs reach
+with 4 KB pages, so the backing shows; it needs as much free memory.
+io pins random pages of a file through pools of an eighth up to the
+whole of it, buffered and with direct IO, so misses are read from the
+page cache in one case and from the disk in the other.
+
+The page file of pin is sparse, so its pages take no disk space, the
+one of io is written out so direct reads go to the disk.
+
+crc checksums the pages of a buffer like the storage manager does when
+page checksums are on, numRounds times, with the crc32 instruction and
+with the slicing-by-8 tables, and prints the throughput of one core.
+
+pagesize creates a table of records of 128 bytes with pages of 4 KB up
+to 64 KB, then scans it and looks up random records, through a private
+pool of BENCH_POOL_MB whatever the page size. The scan reads ahead
+BENCH_PREFETCH_PAGES pages. Large pages take fewer reads per scan,
+small ones waste less of the pool on the records around a lookup.
+*********************************************************************/
+#define BENCH_FILE "bench_buffer_mgr.bin"
+#define BENCH_TABLE "bench_table"
+#define BENCH_PREFETCH 256
+#define BENCH_PREFETCH_PAGES 8
+#define BENCH_POOL_MB 4
+#define BENCH_PIN_POOL_MB 10240
+
+static int benchPins(int numPages, long numPins);
+static int benchIO(int numPages, long numPins);
+static int benchChecksums(int numPages, long numRounds);
+static double runChecksumBench(bool isHardware, char *pages, int numPages, long numRounds);
+static double runBench(BM_HugePages hugePages, int numPages, long numPins);
+static double runIOBench(bool directIO, int numFrames, int numPages, long numPins, double *hitRate);
+static double elapsedNs(struct timespec *start, struct timespec *end);
+static bool fillFile(int numPages, bool writeOut);
+static int benchPageSizes(long numRecords, long numLookups);
+static bool runPageSizeBench(int pageSize, long numRecords, long numLookups);
+
+int main (int argc, char *argv[])
+{
+    bool isIO = argc > 1 && strcmp(argv[1], "io") == 0;
+    bool isCrc = argc > 1 && strcmp(argv[1], "crc") == 0;
+    bool isPageSize = argc > 1 && strcmp(argv[1], "pagesize") == 0;
+    long sizeMB = argc > 2 ? atol(argv[2]) : (isIO ? 256 : (isCrc ? 16 : (isPageSize ? 32 : BENCH_PIN_POOL_MB)));
+    long numPins = argc > 3 ? atol(argv[3])
+                   : (isIO || isPageSize ? 200000 : (isCrc ? 64 : 10000000));
+    int numPages = (int) (sizeMB * 1024 * 1024 / PAGE_SIZE);
+
+    if(argc < 2 || (!isIO && !isCrc && !isPageSize && strcmp(argv[1], "pin") != 0)
+            || numPages < 8 || numPins < 1)
+    {
+        printf("usage: %s pin [poolMB] [numPins]\n", argv[0]);
+        printf("       %s io [fileMB] [numPins]\n", argv[0]);
+        printf("       %s crc [bufferMB] [numRounds]\n", argv[0]);
+        printf("       %s pagesize [tableMB] [numLookups]\n", argv[0]);
+        return 1;
+    }
+    if(isCrc)
+        return benchChecksums(numPages, numPins);
+    if(isPageSize)
+        return benchPageSizes(sizeMB * 1024 * 1024 / 128, numPins);
+    if(createPageFile(BENCH_FILE) != RC_OK || !fillFile(numPages, isIO))
+    {
+        printf("can't create %s\n", BENCH_FILE);
+        return 1;
+    }
+    int rc = isIO ? benchIO(numPages, numPins) : benchPins(numPages, numPins);
+    destroyPageFile(BENCH_FILE);
+    return rc;
+}
+
+static int benchPins(int numPages, long numPins)
+{
+    char *names[] = {"none", "transparent", "explicit"};
+    BM_HugePages modes[] = {BM_HUGE_PAGES_NONE, BM_HUGE_PAGES_TRANSPARENT, BM_HUGE_PAGES_EXPLICIT};
+    printf("%d MB pool, %d frames, %ld pin hits\n", numPages / 256, numPages, numPins);
+    for(int m = 0; m < 3; m++)
+    {
+        double ns = runBench(modes[m], numPages, numPins);
+        if(ns < 0)
+            return 1;
+        printf("huge pages %-12s %8.1f ns per pin and unpin\n", names[m], ns);
+    }
+    return 0;
+}
+
+static int benchIO(int numPages, long numPins)
+{
+    printf("%d MB file, %ld random pins\n", numPages / 256, numPins);
+    for(int numFrames = numPages / 8; numFrames <= numPages; numFrames *= 2)
+        for(int direct = 0; direct < 2; direct++)
+        {
+            double hitRate;
+            double ns = runIOBench(direct, numFrames, numPages, numPins, &hitRate);
+            if(ns < 0)
+                return 1;
+            printf("pool %5d MB %-8s %8.1f ns per pin, %3.0f%% hits\n", numFrames / 256,
+                   direct ? "direct" : "buffered", ns, hitRate * 100);
+        }
+    return 0;
+}
+
+static int benchChecksums(int numPages, long numRounds)
+{
+    char *pages = (char *) malloc((size_t) numPages * PAGE_SIZE);
+    if(!pages)
+        return 1;
+    srand(1);
+    for(size_t i = 0; i < (size_t) numPages * PAGE_SIZE; i++)
+        pages[i] = (char) rand();
+    printf("%d MB of pages, %ld rounds\n", numPages / 256, numRounds);
+    if(crc32cIsHardware())
+        printf("crc32 instruction %8.2f GB/s\n", runChecksumBench(true, pages, numPages, numRounds));
+    else
+        printf("crc32 instruction not available\n");
+    printf("slicing-by-8      %8.2f GB/s\n", runChecksumBench(false, pages, numPages, numRounds));
+    free(pages);
+    return 0;
+}
+
+//bytes checksummed per nanosecond, i.e. GB/s
+static double runChecksumBench(bool isHardware, char *pages, int numPages, long numRounds)
+{
+    struct timespec start, end;
+    uint32_t sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(long r = 0; r < numRounds; r++)
+        for(int i = 0; i < numPages; i++)
+        {
+            char *page = pages + (size_t) i * PAGE_SIZE;
+            sum ^= isHardware ? crc32c(0, page, PAGE_DATA_SIZE)
+                   : crc32cPortable(0, page, PAGE_DATA_SIZE);
+        }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    //keeps the loop from being optimized away
+    if(sum == 1)
+        printf(" ");
+    return (double) numRounds * numPages * PAGE_DATA_SIZE / elapsedNs(&start, &end);
+}
+
+static double runBench(BM_HugePages hugePages, int numPages, long numPins)
+{
+    BM_BufferPool bm;
+    BM_PageHandle page;
+    struct timespec start, end;
+    unsigned long long seed = 88172645463325252ULL;
+    RC returnCode;
+
+    setHugePages(hugePages);
+    if((returnCode = initBufferPool(&bm, BENCH_FILE, numPages, RS_CLOCK, NULL)) != RC_OK)
+    {
+        printError(returnCode);
+        return -1;
+    }
+    for(int i = 0; i < numPages; i += BENCH_PREFETCH)
+        prefetchPages(&bm, i, numPages - i < BENCH_PREFETCH ? numPages - i : BENCH_PREFETCH);
+    int numReadIO = getNumReadIO(&bm);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(long i = 0; i < numPins; i++)
+    {
+        //xorshift, rand() would cost more than a pin hit
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        pinPage(&bm, &page, (PageNumber) (seed % numPages));
+        unpinPage(&bm, &page);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if(getNumReadIO(&bm) != numReadIO)
+        printf("warning: %d pins missed the pool\n", getNumReadIO(&bm) - numReadIO);
+    shutdownBufferPool(&bm);
+    setHugePages(BM_HUGE_PAGES_NONE);
+    return elapsedNs(&start, &end) / numPins;
+}
+
+//RETURNS: nanoseconds per pin after the pool is warm, -1 on an error
+static double runIOBench(bool directIO, int numFrames, int numPages, long numPins, double *hitRate)
+{
+    BM_BufferPool bm;
+    BM_PageHandle page;
+    struct timespec start, end;
+    unsigned long long seed = 88172645463325252ULL;
+    RC returnCode;
+
+    setDirectIO(directIO);
+    if((returnCode = initBufferPool(&bm, BENCH_FILE, numFrames, RS_CLOCK, NULL)) != RC_OK)
+    {
+        printError(returnCode);
+        return -1;
+    }
+    for(int i = 0; i < numFrames; i += BENCH_PREFETCH)
+        prefetchPages(&bm, i, numFrames - i < BENCH_PREFETCH ? numFrames - i : BENCH_PREFETCH);
+    int numReadIO = getNumReadIO(&bm);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(long i = 0; i < numPins; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        if((returnCode = pinPage(&bm, &page, (PageNumber) (seed % numPages))) != RC_OK)
+        {
+            printError(returnCode);
+            return -1;
+        }
+        unpinPage(&bm, &page);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *hitRate = 1 - (double) (getNumReadIO(&bm) - numReadIO) / numPins;
+    shutdownBufferPool(&bm);
+    setDirectIO(false);
+    return elapsedNs(&start, &end) / numPins;
+}
+
+static double elapsedNs(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+//sizes the page file to numPages pages, writing them if writeOut,
+//the pages follow the header createPageFile wrote
+static bool fillFile(int numPages, bool writeOut)
+{
+    if(!writeOut)
+        return truncate(BENCH_FILE, SM_FILE_HEADER_SIZE + (off_t) numPages * PAGE_SIZE) == 0;
+    FILE *file = fopen(BENCH_FILE, "r+b");
+    if(!file)
+        return false;
+    if(fseek(file, SM_FILE_HEADER_SIZE, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return false;
+    }
+    char page[PAGE_SIZE];
+    memset(page, 'x', PAGE_SIZE);
+    for(int i = 0; i < numPages; i++)
+        if(fwrite(page, PAGE_SIZE, 1, file) != 1)
+        {
+            fclose(file);
+            return false;
+        }
+    return fclose(file) == 0;
+}
+
+static int benchPageSizes(long numRecords, long numLookups)
+{
+    printf("%ld records, %d MB pool, %ld random lookups\n", numRecords, BENCH_POOL_MB, numLookups);
+    for(int pageSize = SM_MIN_PAGE_SIZE; pageSize <= SM_MAX_PAGE_SIZE; pageSize *= 2)
+        if(!runPageSizeBench(pageSize, numRecords, numLookups))
+            return 1;
+    return 0;
+}
+
+//RETURNS: false on an error
+static bool runPageSizeBench(int pageSize, long numRecords, long numLookups)
+{
+    RM_Config config;
+    RM_TableData table;
+    RM_ScanHandle scan;
+    Record *record;
+    Expr *all;
+    Value *value;
+    struct timespec start, end;
+    unsigned long long seed = 88172645463325252ULL;
+    RC returnCode = RC_OK;
+
+    //an int key and a string, 128 bytes a record
+    char **names = (char **) malloc(2 * sizeof(char *));
+    DataType *dataTypes = (DataType *) malloc(2 * sizeof(DataType));
+    int *typeLength = (int *) malloc(2 * sizeof(int));
+    int *keys = (int *) malloc(sizeof(int));
+    RID *ids = (RID *) malloc(numRecords * sizeof(RID));
+    names[0] = strdup("id");
+    names[1] = strdup("payload");
+    dataTypes[0] = DT_INT;
+    dataTypes[1] = DT_STRING;
+    typeLength[0] = 0;
+    typeLength[1] = 128 - sizeof(int);
+    keys[0] = 0;
+    Schema *schema = createSchema(2, names, dataTypes, typeLength, 1, keys);
+
+    initConfig(&config);
+    config.tableDefaults.pageSize = pageSize;
+    config.tableDefaults.numPoolFrames = BENCH_POOL_MB * 1024 * 1024 / pageSize;
+    config.tableDefaults.prefetchDepth = BENCH_PREFETCH_PAGES;
+    if((returnCode = initRecordManager(&config)) != RC_OK
+            || (returnCode = createTable(BENCH_TABLE, schema)) != RC_OK
+            || (returnCode = openTable(&table, BENCH_TABLE)) != RC_OK)
+    {
+        printError(returnCode);
+        return false;
+    }
+    createRecord(&record, schema);
+    for(long i = 0; i < numRecords && returnCode == RC_OK; i++)
+    {
+        MAKE_VALUE(value, DT_INT, (int) i);
+        setAttr(record, schema, 0, value);
+        freeVal(value);
+        returnCode = insertRecord(&table, record);
+        ids[i] = record->id;
+    }
+    if(returnCode == RC_OK)
+        returnCode = closeTable(&table);
+    if(returnCode == RC_OK)
+        returnCode = openTable(&table, BENCH_TABLE);
+    if(returnCode != RC_OK)
+    {
+        printError(returnCode);
+        return false;
+    }
+
+    long numScanned = 0;
+    int numReadIO = getNumReadIO(table.bufferPool);
+    MAKE_CONS(all, stringToValue("btrue"));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    startScan(&table, &scan, all);
+    while(next(&scan, record) == RC_OK)
+        numScanned++;
+    closeScan(&scan);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double scanNs = elapsedNs(&start, &end);
+    int numScanReads = getNumReadIO(table.bufferPool) - numReadIO;
+
+    numReadIO = getNumReadIO(table.bufferPool);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(long i = 0; i < numLookups && returnCode == RC_OK; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        returnCode = getRecord(&table, ids[seed % numRecords], record);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double hitRate = 1 - (double) (getNumReadIO(table.bufferPool) - numReadIO) / numLookups;
+
+    printf("page %2d KB scan %7.1f ms %6d reads%s, lookup %7.1f ns %3.0f%% hits\n",
+           pageSize / 1024, scanNs / 1e6, numScanReads,
+           numScanned == numRecords ? "" : " (records missing)",
+           elapsedNs(&start, &end) / numLookups, hitRate * 100);
+    freeExpr(all);
+    freeRecord(record);
+    closeTable(&table);
+    deleteTable(BENCH_TABLE);
+    shutdownRecordManager();
+    freeSchema(schema);
+    free(ids);
+    return returnCode == RC_OK;
+}
@@ -0,0 +1,422 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "bloom_filter.h"
+#include "storage_mgr.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+/**Must declare RC returnCode in function before using ASSERT_RC_OK**/
+#define ASSERT_RC_OK(functionCall)  \
+    returnCode = functionCall;      \
+    if(returnCode != RC_OK )        \
+       return returnCode;
+
+/*********************************************************************
+Offset Macros for the bloom filter file header
+*********************************************************************/
+#define bfNumPagesOffset 0
+#define bfFilterSizeOffset sizeof(unsigned int)
+#define bfIsCleanOffset bfFilterSizeOffset + sizeof(unsigned short)
+#define bfNumFiltersOffset bfIsCleanOffset + sizeof(unsigned short)
+#define bfAttrNumOffset(i) bfNumFiltersOffset + (i+1)*sizeof(unsigned short)
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+#define getPageFilters(bloomFilters, pageNum) \
+    ((bloomFilters)->filters + (size_t)(pageNum)*(bloomFilters)->numFilters*(bloomFilters)->filterSize)
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static void growBloomFilters(RM_BloomFilters *bloomFilters, unsigned int numPages);
+static uint64_t hashBytes(const char *bytes, size_t length);
+static uint64_t hashAttr(DataType dt, int typeLength, char *attr);
+static bool hashCons(DataType dt, int typeLength, Value *cons, uint64_t *hash);
+static void setBits(char *filter, int filterSize, uint64_t hash);
+static bool testBits(char *filter, int filterSize, uint64_t hash);
+static bool canMatch(RM_BloomFilters *bloomFilters, char *pageFilters, Expr *expr);
+
+/*********************************************************************
+*
+*                      BLOOM FILTER FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+initBloomFilters sets up a table without filters. The filters added
+later are sized for numSlotsPerPage records.
+*********************************************************************/
+RC initBloomFilters (RM_BloomFilters *bloomFilters, Schema *schema, int *attrOffsets,
+                     int numSlotsPerPage)
+{
+    if(!bloomFilters || !schema || !attrOffsets)
+        return RC_RM_INIT_ERROR;
+    bloomFilters->schema = schema;
+    bloomFilters->attrOffsets = attrOffsets;
+    bloomFilters->numFilters = 0;
+    bloomFilters->attrNums = NULL;
+    bloomFilters->filterSize = (numSlotsPerPage*BLOOM_BITS_PER_RECORD + 7)/8;
+    bloomFilters->numPages = 0;
+    bloomFilters->filters = NULL;
+    return RC_OK;
+}
+
+void freeBloomFilters (RM_BloomFilters *bloomFilters)
+{
+    free(bloomFilters->attrNums);
+    free(bloomFilters->filters);
+    bloomFilters->attrNums = NULL;
+    bloomFilters->filters = NULL;
+    bloomFilters->numFilters = 0;
+    bloomFilters->numPages = 0;
+}
+
+RC addBloomFilterAttr (RM_BloomFilters *bloomFilters, int attrNum)
+{
+    if(attrNum < 0 || attrNum >= bloomFilters->schema->numAttr)
+        return RC_RM_INIT_ERROR;
+    for(int i = 0; i < bloomFilters->numFilters; i++)
+        if(bloomFilters->attrNums[i] == attrNum)
+            return RC_OK;
+    int *attrNums = (int *) realloc(bloomFilters->attrNums, (bloomFilters->numFilters + 1)*sizeof(int));
+    if(!attrNums)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    attrNums[bloomFilters->numFilters++] = attrNum;
+    bloomFilters->attrNums = attrNums;
+    free(bloomFilters->filters);
+    bloomFilters->filters = NULL;
+    bloomFilters->numPages = 0;
+    return RC_OK;
+}
+
+void clearBloomFilterPage (RM_BloomFilters *bloomFilters, unsigned int pageNum)
+{
+    if(pageNum < bloomFilters->numPages)
+        memset(getPageFilters(bloomFilters, pageNum), 0,
+               bloomFilters->numFilters*bloomFilters->filterSize);
+}
+
+void extendBloomFilter (RM_BloomFilters *bloomFilters, unsigned int pageNum, char *data)
+{
+    if(bloomFilters->numFilters == 0)
+        return;
+    growBloomFilters(bloomFilters, pageNum + 1);
+    Schema *schema = bloomFilters->schema;
+    char *filter = getPageFilters(bloomFilters, pageNum);
+    for(int i = 0; i < bloomFilters->numFilters; i++, filter += bloomFilters->filterSize)
+    {
+        int attrNum = bloomFilters->attrNums[i];
+        setBits(filter, bloomFilters->filterSize,
+                hashAttr(schema->dataTypes[attrNum], schema->typeLength[attrNum],
+                         data + bloomFilters->attrOffsets[attrNum]));
+    }
+}
+
+/*********************************************************************
+bloomFilterCanMatch probes the filters of page pageNum with the
+"attr = constant" comparisons of cond. Comparisons below AND and OR are
+followed, everything else is assumed to match.
+RETURNS: false if no record of the page can satisfy cond
+*********************************************************************/
+bool bloomFilterCanMatch (RM_BloomFilters *bloomFilters, unsigned int pageNum, Expr *cond)
+{
+    if(bloomFilters->numFilters == 0 || !cond)
+        return true;
+    //pages without filters never had a record
+    if(pageNum >= bloomFilters->numPages)
+        return false;
+    return canMatch(bloomFilters, getPageFilters(bloomFilters, pageNum), cond);
+}
+
+static bool canMatch(RM_BloomFilters *bloomFilters, char *pageFilters, Expr *expr)
+{
+    if(expr->type != EXPR_OP)
+        return true;
+    Operator *op = expr->expr.op;
+    switch(op->type)
+    {
+    case OP_BOOL_AND:
+        return canMatch(bloomFilters, pageFilters, op->args[0])
+               && canMatch(bloomFilters, pageFilters, op->args[1]);
+    case OP_BOOL_OR:
+        return canMatch(bloomFilters, pageFilters, op->args[0])
+               || canMatch(bloomFilters, pageFilters, op->args[1]);
+    case OP_COMP_EQUAL:
+        break;
+    default:
+        return true;
+    }
+    Expr *attr = op->args[0], *cons = op->args[1];
+    if(attr->type == EXPR_CONST)
+    {
+        attr = op->args[1];
+        cons = op->args[0];
+    }
+    if(attr->type != EXPR_ATTRREF || cons->type != EXPR_CONST)
+        return true;
+    Schema *schema = bloomFilters->schema;
+    for(int i = 0; i < bloomFilters->numFilters; i++)
+    {
+        int attrNum = bloomFilters->attrNums[i];
+        if(attrNum != attr->expr.attrRef)
+            continue;
+        uint64_t hash;
+        //constants that can't be equal to any value of the attribute
+        if(!hashCons(schema->dataTypes[attrNum], schema->typeLength[attrNum], cons->expr.cons, &hash))
+            return cons->expr.cons->dt != schema->dataTypes[attrNum];
+        return testBits(pageFilters + i*bloomFilters->filterSize, bloomFilters->filterSize, hash);
+    }
+    return true;
+}
+
+/*********************************************************************
+*
+*                        BLOOM FILTER FILES
+*
+*********************************************************************/
+
+/*********************************************************************
+readBloomFilters loads the attributes with filters and, if the file
+was closed cleanly, the filters saved in fileName
+INPUT:
+    *bloomFilters: set up by initBloomFilters
+    *fileName: name of the bloom filter file
+    *isClean: set to false if the filters have to be rebuilt
+RETURNS: RC_OK or the error of the storage manager
+*********************************************************************/
+RC readBloomFilters (RM_BloomFilters *bloomFilters, char *fileName, bool *isClean)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    ASSERT_RC_OK(openPageFile(fileName, &fHandle));
+    VALID_CALLOC(char, page, 1, PAGE_SIZE);
+    returnCode = readBlock(0, &fHandle, page);
+    unsigned int numPages = 0;
+    unsigned short filterSize = 0, clean = 0, numFilters = 0, attrNum;
+    if(returnCode == RC_OK)
+    {
+        memcpy(&numPages, page + bfNumPagesOffset, sizeof(unsigned int));
+        memcpy(&filterSize, page + bfFilterSizeOffset, sizeof(unsigned short));
+        memcpy(&clean, page + bfIsCleanOffset, sizeof(unsigned short));
+        memcpy(&numFilters, page + bfNumFiltersOffset, sizeof(unsigned short));
+        for(int i = 0; i < numFilters && returnCode == RC_OK; i++)
+        {
+            memcpy(&attrNum, page + bfAttrNumOffset(i), sizeof(unsigned short));
+            returnCode = addBloomFilterAttr(bloomFilters, attrNum);
+        }
+    }
+    long long size = (long long) numPages*bloomFilters->numFilters*bloomFilters->filterSize;
+    *isClean = returnCode == RC_OK && clean && filterSize == bloomFilters->filterSize
+               && bloomFilters->numFilters == numFilters
+               && size <= (long long)(fHandle.totalNumPages - 1)*PAGE_DATA_SIZE;
+    if(*isClean && size > 0)
+    {
+        growBloomFilters(bloomFilters, numPages);
+        for(long long offset = 0; offset < size && returnCode == RC_OK; offset += PAGE_DATA_SIZE)
+        {
+            int length = size - offset < PAGE_DATA_SIZE ? size - offset : PAGE_DATA_SIZE;
+            returnCode = readBlock(1 + offset/PAGE_DATA_SIZE, &fHandle, page);
+            memcpy(bloomFilters->filters + offset, page, length);
+        }
+    }
+    free(page);
+    if(returnCode != RC_OK)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    return closePageFile(&fHandle);
+}
+
+/*********************************************************************
+writeBloomFilters saves the filters in fileName, which is created if
+it doesn't exist. The filters themselves are only written if isClean
+is set, since filters that aren't clean are rebuilt on openTable.
+*********************************************************************/
+RC writeBloomFilters (RM_BloomFilters *bloomFilters, char *fileName, bool isClean)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    if(openPageFile(fileName, &fHandle) != RC_OK)
+    {
+        ASSERT_RC_OK(createPageFile(fileName));
+        ASSERT_RC_OK(openPageFile(fileName, &fHandle));
+    }
+    VALID_CALLOC(char, page, 1, PAGE_SIZE);
+    unsigned short filterSize = (unsigned short) bloomFilters->filterSize;
+    unsigned short clean = isClean ? 1 : 0;
+    unsigned short numFilters = (unsigned short) bloomFilters->numFilters;
+    memcpy(page + bfNumPagesOffset, &bloomFilters->numPages, sizeof(unsigned int));
+    memcpy(page + bfFilterSizeOffset, &filterSize, sizeof(unsigned short));
+    memcpy(page + bfIsCleanOffset, &clean, sizeof(unsigned short));
+    memcpy(page + bfNumFiltersOffset, &numFilters, sizeof(unsigned short));
+    for(int i = 0; i < numFilters; i++)
+    {
+        unsigned short attrNum = (unsigned short) bloomFilters->attrNums[i];
+        memcpy(page + bfAttrNumOffset(i), &attrNum, sizeof(unsigned short));
+    }
+    returnCode = writeBlock(0, &fHandle, page);
+    long long size = isClean ? (long long) bloomFilters->numPages*numFilters*bloomFilters->filterSize : 0;
+    if(returnCode == RC_OK && size > 0)
+        returnCode = ensureCapacity(1 + (size + PAGE_DATA_SIZE - 1)/PAGE_DATA_SIZE, &fHandle);
+    for(long long offset = 0; offset < size && returnCode == RC_OK; offset += PAGE_DATA_SIZE)
+    {
+        int length = size - offset < PAGE_DATA_SIZE ? size - offset : PAGE_DATA_SIZE;
+        memset(page, 0, PAGE_SIZE);
+        memcpy(page, bloomFilters->filters + offset, length);
+        returnCode = writeBlock(1 + offset/PAGE_DATA_SIZE, &fHandle, page);
+    }
+    free(page);
+    if(returnCode != RC_OK)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    return closePageFile(&fHandle);
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+
+//makes room for the filters of numPages pages, new filters are empty
+static void growBloomFilters(RM_BloomFilters *bloomFilters, unsigned int numPages)
+{
+    if(numPages <= bloomFilters->numPages)
+        return;
+    unsigned int capacity = bloomFilters->numPages ? bloomFilters->numPages : 1;
+    while(capacity < numPages)
+        capacity *= 2;
+    size_t pageSize = (size_t) bloomFilters->numFilters*bloomFilters->filterSize;
+    char *filters = (char *) realloc(bloomFilters->filters, capacity*pageSize);
+    if(!filters)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    memset(filters + bloomFilters->numPages*pageSize, 0, (capacity - bloomFilters->numPages)*pageSize);
+    bloomFilters->filters = filters;
+    bloomFilters->numPages = capacity;
+}
+
+static uint64_t hashBytes(const char *bytes, size_t length)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char) bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/*********************************************************************
+hashAttr hashes an attribute value stored in record format. Values
+that evalExpr considers equal get the same hash.
+*********************************************************************/
+static uint64_t hashAttr(DataType dt, int typeLength, char *attr)
+{
+    switch(dt)
+    {
+    case DT_STRING:
+    {
+        //strings end at the terminator or after typeLength characters
+        char *end = (char *) memchr(attr, '\0', typeLength);
+        return hashBytes(attr, end ? (size_t)(end - attr) : (size_t) typeLength);
+    }
+    case DT_FLOAT:
+    {
+        float value;
+        memcpy(&value, attr, sizeof(float));
+        if(value == 0)
+            value = 0; //-0.0 equals 0.0
+        return hashBytes((char *) &value, sizeof(float));
+    }
+    case DT_BOOL:
+    {
+        bool value;
+        memcpy(&value, attr, sizeof(bool));
+        unsigned char normalized = value ? 1 : 0;
+        return hashBytes((char *) &normalized, sizeof(unsigned char));
+    }
+    case DT_INT:
+        break;
+    }
+    return hashBytes(attr, sizeof(int));
+}
+
+/*********************************************************************
+hashCons hashes a constant like hashAttr hashes the attribute it is
+compared with
+RETURNS: false if no value of the attribute can be equal to cons
+*********************************************************************/
+static bool hashCons(DataType dt, int typeLength, Value *cons, uint64_t *hash)
+{
+    if(cons->dt != dt)
+        return false;
+    switch(dt)
+    {
+    case DT_INT:
+        *hash = hashAttr(dt, typeLength, (char *) &cons->v.intV);
+        return true;
+    case DT_FLOAT:
+        if(cons->v.floatV != cons->v.floatV) //NaN is never equal
+            return false;
+        *hash = hashAttr(dt, typeLength, (char *) &cons->v.floatV);
+        return true;
+    case DT_BOOL:
+        *hash = hashAttr(dt, typeLength, (char *) &cons->v.boolV);
+        return true;
+    case DT_STRING:
+        if(strlen(cons->v.stringV) > (size_t) typeLength)
+            return false;
+        *hash = hashBytes(cons->v.stringV, strlen(cons->v.stringV));
+        return true;
+    }
+    return false;
+}
+
+//double hashing: probe i is at (h1 + i*h2) mod the number of bits
+static void setBits(char *filter, int filterSize, uint64_t hash)
+{
+    uint32_t h1 = (uint32_t) hash, h2 = (uint32_t)(hash >> 32) | 1;
+    uint32_t numBits = (uint32_t) filterSize*8;
+    for(uint32_t i = 0; i < BLOOM_NUM_HASHES; i++)
+    {
+        uint32_t bit = (h1 + i*h2) % numBits;
+        filter[bit/8] |= (char)(1 << (bit%8));
+    }
+}
+
+static bool testBits(char *filter, int filterSize, uint64_t hash)
+{
+    uint32_t h1 = (uint32_t) hash, h2 = (uint32_t)(hash >> 32) | 1;
+    uint32_t numBits = (uint32_t) filterSize*8;
+    for(uint32_t i = 0; i < BLOOM_NUM_HASHES; i++)
+    {
+        uint32_t bit = (h1 + i*h2) % numBits;
+        if(!(filter[bit/8] & (1 << (bit%8))))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <stdbool.h>
+#include "dberror.h"
+#include "tables.h"
+#include "expr.h"
+
+/*********************************************************************
+Bloom filters can be added to selected attributes of a table. Every
+data page then has one filter per selected attribute, so scans with an
+"attr = constant" condition skip pages whose filter doesn't have the
+constant. A filter has BLOOM_BITS_PER_RECORD bits for every slot of a
+page and is probed with BLOOM_NUM_HASHES hashes. Deleted values stay in
+the filter until the page is rebuilt.
+
+The filters of a table are kept in memory while it is open and saved
+in the page file <table name>.bf when it is closed:
+page 0:  uint numPages | ushort filterSize | ushort isClean |
+         ushort numFilters | ushort attrNum * numFilters
+page 1+: numFilters filters of filterSize bytes for every page
+*********************************************************************/
+typedef struct RM_BloomFilters {
+    Schema *schema;
+    int *attrOffsets;   //byte offset of every attribute in the record
+    int numFilters;
+    int *attrNums;      //attribute of every filter
+    int filterSize;     //bytes of one filter
+    unsigned int numPages; //number of pages with filters
+    char *filters;
+} RM_BloomFilters;
+
+#define BLOOM_FILTER_SUFFIX ".bf"
+#define BLOOM_BITS_PER_RECORD 10
+#define BLOOM_NUM_HASHES 7
+
+extern RC initBloomFilters (RM_BloomFilters *bloomFilters, Schema *schema, int *attrOffsets,
+                            int numSlotsPerPage);
+extern void freeBloomFilters (RM_BloomFilters *bloomFilters);
+// adds a filter on attrNum and drops the filters of all pages, which
+// have to be rebuilt from their records
+extern RC addBloomFilterAttr (RM_BloomFilters *bloomFilters, int attrNum);
+extern void clearBloomFilterPage (RM_BloomFilters *bloomFilters, unsigned int pageNum);
+// adds the attributes of the record data to the filters of pageNum
+extern void extendBloomFilter (RM_BloomFilters *bloomFilters, unsigned int pageNum, char *data);
+// returns false only if no record of pageNum can satisfy cond
+extern bool bloomFilterCanMatch (RM_BloomFilters *bloomFilters, unsigned int pageNum, Expr *cond);
+
+// bloom filter files
+extern RC readBloomFilters (RM_BloomFilters *bloomFilters, char *fileName, bool *isClean);
+extern RC writeBloomFilters (RM_BloomFilters *bloomFilters, char *fileName, bool isClean);
+
+#endif // BLOOM_FILTER_H
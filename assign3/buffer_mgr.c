@@ -3,12 +3,36 @@
 #include <stdbool.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include "replace_strat.h"
+#include "async_io.h"
+
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+#define BM_HUGE_PAGE_SIZE (2*1024*1024)
+#define BM_CACHE_LINE_SIZE 64
+//pages of a file written or read ahead with a single request at most
+#define BM_MAX_RUN_PAGES 256
+
+//a dirty frame, flushes sort them by file and page to write runs
+typedef struct BM_DirtyFrame {
+    int fileId;
+    PageNumber pageNum;
+    int frameNum;
+} BM_DirtyFrame;
+
+//backing of the frames of pools created from now on
+static BM_HugePages hugePagesMode = BM_HUGE_PAGES_NONE;
 
 //PROTOTYPES
-static RC initBufferPoolInfo(BM_BufferPool * bm,ReplacementStrategy strategy,void * stratData);
+static RC initBufferPoolInfo(BM_BufferPool * bm,int frameSize,ReplacementStrategy strategy,void * stratData);
 static RC initRelpacementStrategy(BM_BufferPool * bm,ReplacementStrategy strategy,void *stratData);
 static RC freeReplacementStrategy(BM_BufferPool *const bm);
 static BM_Frame * findEmptyFrame(BM_BufferPool *bm);
@@ -16,6 +40,43 @@ static BM_Frame * findEmptyFrame(BM_BufferPool *bm);
 //Prototypes helper functions
 static int findFrameNumber(BM_BufferPool * bm, PageNumber pageNumber);
 static void pinRplcStrat(BM_BufferPool* bm, int frameNum);
+static RC callBeforeWrite(BM_PoolInfo *pi, int fileId, PageNumber pageNum, char *data);
+static int addFile(BM_PoolInfo *pi, BM_BufferPool *handle, const char *pageFileName);
+static RC getFilePageSize(const char *pageFileName, int *pageSize);
+static unsigned int hashPage(BM_PoolInfo *pi, int fileId, PageNumber pageNum);
+static int findFrame(BM_PoolInfo *pi, int fileId, PageNumber pageNum);
+static void mapFrame(BM_PoolInfo *pi, int frameNum, int fileId, PageNumber pageNum);
+static void unmapFrame(BM_PoolInfo *pi, int frameNum);
+static RC writeFrame(BM_PoolInfo *pi, int frameNum);
+static RC writeVictim(BM_PoolInfo *pi, int frameNum);
+static RC readFrame(char *pageFile, PageNumber pageNum, BM_Frame *framePtr, int frameSize, bool *isRead);
+static RC detachFile(BM_BufferPool *const bm);
+static void addChunk(BM_PoolInfo *pi, int numFrames);
+static void freeChunk(BM_PoolInfo *pi, int chunk);
+static BM_Frame *mapFrames(size_t *bytes, BM_HugePages hugePages);
+static BM_FrameDesc *allocFrameDescs(int numPages);
+static int getFrameNumber(BM_PoolInfo *pi, BM_Frame *framePtr);
+static void resizeFrameArrays(BM_PoolInfo *pi, int numFrames, int numPages);
+static void freeChunksPast(BM_PoolInfo *pi, int numFrames);
+static RC releaseRetiredFrames(BM_PoolInfo *pi);
+static void rebuildPageTable(BM_PoolInfo *pi, int numPages);
+static void resizeRplcStrat(BM_BufferPool *bm, int newNumPages);
+static void setNumPages(BM_PoolInfo *pi, int numPages);
+static AIO_Context *getAsyncIO(BM_PoolInfo *pi);
+static RC submitReads(BM_PoolInfo *pi, AIO_Context *aio, AIO_Request *run);
+static RC completeReads(BM_BufferPool *bm, AIO_Context *aio, SM_FileHandle *fHandle);
+static RC completeWrites(BM_PoolInfo *pi, AIO_Context *aio);
+static int compareDirtyFrames(const void *a, const void *b);
+static RC writeRun(BM_PoolInfo *pi, SM_FileHandle *fHandle, BM_DirtyFrame *run, int numPages,
+                   struct iovec *iovs);
+
+//Prototypes of the unlocked implementations
+static RC forceFlushPoolUnlocked(BM_BufferPool *const bm);
+static RC pinPageUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page,
+                          const PageNumber pageNum);
+static RC unpinPageUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page);
+static RC markDirtyUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page);
+static RC forcePageUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page);
 /*********************************************************************
 *
 *             BUFFER MANAGER INTERFACE POOL HANDLING
@@ -30,6 +91,7 @@ page frames should be empty. The page file should already exist, i.e.,
 this method should not generate a new page file. stratData can be used
 to pass parameters for the page replacement strategy. For example, for
 LRU-k this could be the parameter k.
+The frames are as large as the pages of the file, see createPageFileEx.
 *********************************************************************/
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
                   const int numPages, ReplacementStrategy strategy, void *stratData)
@@ -42,17 +104,26 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
         return RC_NO_FILENAME;
     bm->pageFile = (char *)pageFileName;
     //check if the pageFile is a valid one
-    if(access(pageFileName, R_OK|W_OK) == -1)
+    if(!pageFileExists((char *) pageFileName))
         return RC_FILE_NOT_FOUND;
     //check the number of pages
     if(numPages<1)
         return RC_INVALID_PAGE_NUMBER;
     bm->numPages = numPages;
     bm->strategy = strategy;
-    return initBufferPoolInfo(bm,strategy,stratData);
+    int frameSize;
+    RC returnCode = getFilePageSize(pageFileName, &frameSize);
+    if(returnCode != RC_OK)
+        return returnCode;
+    returnCode = initBufferPoolInfo(bm,frameSize,strategy,stratData);
+    if(returnCode != RC_OK)
+        return returnCode;
+    //the pool caches a single file
+    bm->fileId = addFile(bm->mgmtData, bm, pageFileName);
+    return RC_OK;
 }
 
-static RC initBufferPoolInfo(BM_BufferPool * bm,ReplacementStrategy strategy,void * stratData)
+static RC initBufferPoolInfo(BM_BufferPool * bm,int frameSize,ReplacementStrategy strategy,void * stratData)
 {
     BM_PoolInfo * pi = MAKE_POOL_INFO();
     if(!pi)
@@ -63,39 +134,31 @@ static RC initBufferPoolInfo(BM_BufferPool * bm,ReplacementStrategy strategy,voi
     //initialize PoolInfo values
     pi->numReadIO = 0;
     pi->numWriteIO = 0;
+    pi->numSyncs = 0;
 
-    //Set the isDirtyArray false
-    pi->isDirtyArray = (bool *)calloc(bm->numPages, sizeof(bool));
-    if(!pi->isDirtyArray)
-    {
-        printError(RC_BM_MEMORY_ALOC_FAIL);
-        exit(-1);
-    }
-
-    //Set the fixCountArray to 0
-    pi->fixCountArray = (int *)calloc(bm->numPages,sizeof(int));
-    if(!pi->fixCountArray)
-    {
-        printError(RC_BM_MEMORY_ALOC_FAIL);
-        exit(-1);
-    }
+    //empty frames: clean, not fixed, NO_PAGE of NO_FILE
+    resizeFrameArrays(pi, bm->numPages, bm->numPages);
 
-    //Set the frameContent to NO_PAGE
-    pi->frameContent = (int *)calloc(bm->numPages, sizeof(int));
-    if(!pi->frameContent)
+    //hash table of the pages in the frames, with at least twice as many
+    //buckets as frames
+    pi->numBuckets = 1;
+    while(pi->numBuckets < 2*bm->numPages)
+        pi->numBuckets *= 2;
+    pi->pageTable = (int *)calloc(pi->numBuckets, sizeof(int));
+    if(!pi->pageTable)
     {
         printError(RC_BM_MEMORY_ALOC_FAIL);
         exit(-1);
     }
-    memset(pi->frameContent, NO_PAGE, bm->numPages*(sizeof(int)));
+    memset(pi->pageTable, NO_PAGE, pi->numBuckets*(sizeof(int)));
 
     //allocate memory for pageFrames
-    pi->poolMem_ptr = (BM_Frame *)calloc(bm->numPages, sizeof(BM_Frame));
-    if(!pi->poolMem_ptr)
-    {
-        printError(RC_BM_MEMORY_ALOC_FAIL);
-        exit(-1);
-    }
+    pi->frameSize = frameSize;
+    pi->hugePages = hugePagesMode;
+    addChunk(pi, bm->numPages);
+    pthread_mutex_init(&pi->mutex, NULL);
+    pthread_cond_init(&pi->frameIdle, NULL);
+    pi->owner = bm;
     bm->mgmtData = pi;
     return initRelpacementStrategy(bm, strategy, stratData);
 }
@@ -128,6 +191,161 @@ static RC initRelpacementStrategy(BM_BufferPool * bm,ReplacementStrategy strateg
     return RC_OK;
 }
 
+/*********************************************************************
+setHugePages sets how the frames of the pools created afterwards are
+backed, see mapFrames. Pools that exist keep their backing, also for
+the frames they get by growing.
+*********************************************************************/
+void setHugePages(BM_HugePages hugePages)
+{
+    hugePagesMode = hugePages;
+}
+
+/*********************************************************************
+*
+*             BUFFER MANAGER INTERFACE SHARED POOLS
+*
+*********************************************************************/
+
+/*********************************************************************
+initSharedPool creates a buffer pool of numPages frames that isn't
+bound to a page file. Page files are cached in it through handles made
+by attachBufferPool, so tables compete for the same frames under one
+replacement strategy and the frames go to whichever table is used most.
+Frames are found by hashing (file, page number). The frames hold pages
+of PAGE_SIZE bytes.
+*********************************************************************/
+RC initSharedPool(BM_BufferPool *const pool, const int numPages,
+                  ReplacementStrategy strategy, void *stratData)
+{
+    return initSharedPoolEx(pool, numPages, PAGE_SIZE, strategy, stratData);
+}
+
+/*********************************************************************
+initSharedPoolEx works like initSharedPool with frames of frameSize
+bytes, only page files of pages that large can be attached to it.
+*********************************************************************/
+RC initSharedPoolEx(BM_BufferPool *const pool, const int numPages, const int frameSize,
+                    ReplacementStrategy strategy, void *stratData)
+{
+    //check BM_BufferPool has space allocated
+    if(!pool)
+        return RC_BM_NOT_ALLOCATED;
+    //check the number of pages
+    if(numPages<1)
+        return RC_INVALID_PAGE_NUMBER;
+    if(frameSize < SM_MIN_PAGE_SIZE || frameSize > SM_MAX_PAGE_SIZE || (frameSize & (frameSize - 1)))
+        return RC_INCOMPATIBLE_BLOCKSIZE;
+    pool->pageFile = NULL;
+    pool->numPages = numPages;
+    pool->strategy = strategy;
+    pool->fileId = NO_FILE;
+    RC returnCode = initBufferPoolInfo(pool,frameSize,strategy,stratData);
+    if(returnCode != RC_OK)
+        return returnCode;
+    pool->mgmtData->isShared = true;
+    return RC_OK;
+}
+
+/*********************************************************************
+attachBufferPool makes bm a handle for the page file pageFileName in
+the shared pool. The handle is used like a pool of its own: pinPage,
+forceFlushPool, the before-write hook and the IO counters only concern
+its file, while the frame statistics cover the whole pool.
+shutdownBufferPool on the handle writes its dirty pages and gives its
+frames back to the pool. The shared pool must be shut down last.
+RC_INCOMPATIBLE_BLOCKSIZE if the pages of the file don't fit the
+frames of the pool.
+*********************************************************************/
+RC attachBufferPool(BM_BufferPool *const bm, BM_BufferPool *const pool,
+                    const char *const pageFileName)
+{
+    //validate input
+    if(!bm || !pool || !pool->mgmtData || !pool->mgmtData->isShared)
+        return RC_BM_NOT_ALLOCATED;
+    if(!pageFileName)
+        return RC_NO_FILENAME;
+    //check if the pageFile is a valid one
+    if(!pageFileExists((char *) pageFileName))
+        return RC_FILE_NOT_FOUND;
+    int pageSize;
+    RC returnCode = getFilePageSize(pageFileName, &pageSize);
+    if(returnCode != RC_OK)
+        return returnCode;
+    if(pageSize != pool->mgmtData->frameSize)
+        return RC_INCOMPATIBLE_BLOCKSIZE;
+    bm->pageFile = (char *)pageFileName;
+    bm->numPages = pool->numPages;
+    bm->strategy = pool->strategy;
+    bm->mgmtData = pool->mgmtData;
+    pthread_mutex_lock(&pool->mgmtData->mutex);
+    bm->fileId = addFile(pool->mgmtData, bm, pageFileName);
+    pthread_mutex_unlock(&pool->mgmtData->mutex);
+    return RC_OK;
+}
+
+/*********************************************************************
+resizeBufferPool changes the number of frames of the pool while it is
+in use. The frames are kept in chunks that are never moved, so pages
+pinned before stay where they are. Growing adds a chunk of empty
+frames, which are used before any page is replaced. Shrinking drops
+the frames from newNumPages on right away: their dirty pages are
+written and the pages are evicted. A dropped frame that is pinned is
+retired instead: it keeps its page, pinPage and unpinPage still find
+it, but it is never replaced. It is written and let go of once the
+page is unpinned, see releaseRetiredFrames.
+On a handle of a shared pool, the shared pool is resized. The arrays
+returned by the statistics functions move when the pool is resized.
+*********************************************************************/
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages)
+{
+    //validate input
+    if(!bm || !bm->mgmtData)
+        return RC_BM_NOT_ALLOCATED;
+    if(newNumPages<1)
+        return RC_INVALID_PAGE_NUMBER;
+    BM_PoolInfo *pi = bm->mgmtData;
+    pthread_mutex_lock(&pi->mutex);
+    int oldNumPages = pi->owner->numPages;
+    int oldNumFrames = pi->numFrames;
+    //evict the pages of the frames that are dropped, pinned ones and
+    //the ones retired before that are still pinned stay
+    int numFrames = newNumPages;
+    for(int i = newNumPages; i < oldNumFrames; i++)
+    {
+        if(pi->frames[i].fixCount > 0)
+        {
+            numFrames = i + 1;
+            continue;
+        }
+        if(pi->frames[i].isDirty)
+        {
+            RC returnCode = writeFrame(pi, i);
+            if(returnCode != RC_OK)
+            {
+                pthread_mutex_unlock(&pi->mutex);
+                return returnCode;
+            }
+        }
+        unmapFrame(pi, i);
+    }
+    resizeRplcStrat(pi->owner, newNumPages);
+    resizeFrameArrays(pi, numFrames, newNumPages);
+    if(numFrames > pi->capacity)
+        addChunk(pi, numFrames - pi->capacity);
+    else
+        freeChunksPast(pi, numFrames);
+    if(2*newNumPages > pi->numBuckets)
+        rebuildPageTable(pi, newNumPages);
+    setNumPages(pi, newNumPages);
+    //retired frames the pool grew back over are replaced like the others
+    for(int i = oldNumPages; i < oldNumFrames && i < newNumPages; i++)
+        if(pi->frames[i].pageNum != NO_PAGE)
+            pinRplcStrat(pi->owner, i);
+    pthread_mutex_unlock(&pi->mutex);
+    return RC_OK;
+}
+
 /*********************************************************************
 shutdownBufferPool destroys a buffer pool. This method should free up
 all resources associated with buffer pool. For example, it should free
@@ -151,17 +369,55 @@ RC shutdownBufferPool(BM_BufferPool *const bm)
     {
         return rc;
     }
+    return dropBufferPool(bm);
+}
+
+/*********************************************************************
+dropBufferPool destroys a buffer pool like shutdownBufferPool, but
+throws the dirty pages away instead of writing them, as if the process
+crashed. A handle of a shared pool drops the pages of its file only.
+*********************************************************************/
+RC dropBufferPool(BM_BufferPool *const bm)
+{
+    //validate input
+    if(!bm || !bm->mgmtData)
+        return RC_BM_NOT_ALLOCATED;
+
+    RC rc;
     //free up space from pageFrames
     BM_PoolInfo *poolInfo = bm->mgmtData;
+    //a handle of a shared pool only gives back its frames
+    if(poolInfo->isShared && bm->fileId != NO_FILE)
+        return detachFile(bm);
     //free up pool info
-    free(poolInfo->poolMem_ptr);
-    poolInfo->poolMem_ptr=NULL;
-    free(poolInfo->isDirtyArray);
-    poolInfo->isDirtyArray=NULL;
-    free(poolInfo->fixCountArray);
-    poolInfo->fixCountArray=NULL;
-    free(poolInfo->frameContent);
-    poolInfo->frameContent=NULL;
+    for(int i = 0; i < poolInfo->numChunks; i++)
+        freeChunk(poolInfo, i);
+    free(poolInfo->frameChunks);
+    poolInfo->frameChunks=NULL;
+    free(poolInfo->chunkBytes);
+    poolInfo->chunkBytes=NULL;
+    free(poolInfo->chunkStart);
+    poolInfo->chunkStart=NULL;
+    free(poolInfo->frames);
+    poolInfo->frames=NULL;
+    free(poolInfo->statContent);
+    poolInfo->statContent=NULL;
+    free(poolInfo->statDirty);
+    poolInfo->statDirty=NULL;
+    free(poolInfo->statFixCount);
+    poolInfo->statFixCount=NULL;
+    free(poolInfo->pageTable);
+    poolInfo->pageTable=NULL;
+    if(poolInfo->aio)
+    {
+        shutdownAsyncIO(poolInfo->aio);
+        free(poolInfo->aio);
+        poolInfo->aio=NULL;
+    }
+    free(poolInfo->files);
+    poolInfo->files=NULL;
+    pthread_mutex_destroy(&poolInfo->mutex);
+    pthread_cond_destroy(&poolInfo->frameIdle);
     //free up replacement Strategy
     if((rc = freeReplacementStrategy(bm))!=RC_OK)
     {
@@ -214,45 +470,107 @@ RC forceFlushPool(BM_BufferPool *const bm)
     if(!bm)
         return RC_BM_NOT_ALLOCATED;
 
-    SM_FileHandle *fHandle = calloc(1, sizeof(SM_FileHandle));
-    if(!fHandle)
+    pthread_mutex_lock(&bm->mgmtData->mutex);
+    RC returnCode = forceFlushPoolUnlocked(bm);
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return returnCode;
+}
+
+//the dirty pages are sorted by file and page, runs of consecutive
+//pages are written with one request each, all at once with async IO.
+//Every page file is opened once and synced once all its pages are
+//written
+static RC forceFlushPoolUnlocked(BM_BufferPool *const bm)
+{
+    RC returnCode = RC_OK;
+    BM_PoolInfo *pi = bm->mgmtData;
+    AIO_Context *aio = getAsyncIO(pi);
+    if(!aio)
+        return RC_AIO_INIT_FAILED;
+    VALID_CALLOC(BM_DirtyFrame, dirty, pi->numFrames, sizeof(BM_DirtyFrame));
+    int numDirty = 0;
+    //retired frames are written as well
+    for(int i = 0; i < pi->numFrames; i++)
     {
-        printError(RC_BM_MEMORY_ALOC_FAIL);
-        exit(-1);
+        //a shared pool itself flushes the pages of every file
+        if(bm->fileId != NO_FILE && pi->frames[i].fileId != bm->fileId)
+            continue;
+        if (pi->frames[i].fixCount != 0 || !pi->frames[i].isDirty)
+            continue;
+        dirty[numDirty].fileId = pi->frames[i].fileId;
+        dirty[numDirty].pageNum = pi->frames[i].pageNum;
+        dirty[numDirty++].frameNum = i;
     }
-    SM_PageHandle memPage = NULL;
-    RC returnCode = RC_INIT;
+    qsort(dirty, numDirty, sizeof(BM_DirtyFrame), compareDirtyFrames);
+    VALID_CALLOC(SM_FileHandle, handles, pi->numFiles + 1, sizeof(SM_FileHandle));
+    VALID_CALLOC(AIO_Request, requests, numDirty + 1, sizeof(AIO_Request));
+    VALID_CALLOC(struct iovec, iovs, numDirty + 1, sizeof(struct iovec));
+    int numRequests = 0;
 
-    for(int i = 0; i < bm->numPages; i++)
+    for(int start = 0, end; start < numDirty && returnCode == RC_OK; start = end)
     {
-        if (bm->mgmtData->fixCountArray[i] == 0 && bm->mgmtData->isDirtyArray[i] == true)
+        int fileId = dirty[start].fileId;
+        if(!handles[fileId].fileName &&
+                (returnCode = openPageFile(pi->files[fileId].pageFile, &handles[fileId])) != RC_OK)
+            break;
+        //a run ends with the segment file of the page file
+        int segmentPages = getSegmentPages(&handles[fileId]);
+        for(end = start + 1; end < numDirty && end - start < BM_MAX_RUN_PAGES; end++)
+            if(dirty[end].fileId != fileId || dirty[end].pageNum != dirty[end - 1].pageNum + 1
+                    || dirty[end].pageNum % segmentPages == 0)
+                break;
+        for(int i = start; i < end && returnCode == RC_OK; i++)
         {
-            memPage = (char*)(bm->mgmtData->poolMem_ptr + i);
-            if((returnCode = openPageFile(bm->pageFile, fHandle)) != RC_OK)
-            {
-                free(fHandle);
-                fHandle = NULL;
-                return returnCode;
-            }
-            if((returnCode = writeBlock(bm->mgmtData->frameContent[i], fHandle, memPage)))
-            {
-                free(fHandle);
-                fHandle = NULL;
-                return returnCode;
-            }
-            if((returnCode = closePageFile(fHandle)) != RC_OK)
-            {
-                free(fHandle);
-                fHandle = NULL;
-                return returnCode;
-            }
-            bm->mgmtData->isDirtyArray[i] = false;
-            bm->mgmtData->numWriteIO++;
+            iovs[i].iov_base = getFrame(pi, dirty[i].frameNum);
+            iovs[i].iov_len = pi->frameSize;
+            //the log is flushed before the page is written
+            returnCode = callBeforeWrite(pi, fileId, dirty[i].pageNum, iovs[i].iov_base);
+            stampPageChecksum(&handles[fileId], iovs[i].iov_base);
         }
+        if(returnCode != RC_OK ||
+                (returnCode = ensureCapacity(dirty[end - 1].pageNum + 1, &handles[fileId])) != RC_OK)
+            break;
+        //compressed pages are only written through the storage manager
+        if(isCompressedPageFile(&handles[fileId]))
+        {
+            returnCode = writeRun(pi, &handles[fileId], &dirty[start], end - start, &iovs[start]);
+            continue;
+        }
+        AIO_Request *request = &requests[numRequests++];
+        request->op = AIO_WRITE;
+        request->fd = getPageFd(&handles[fileId], dirty[start].pageNum, &request->fileOffset);
+        request->pageNum = dirty[start].pageNum;
+        request->numPages = end - start;
+        request->iovs = &iovs[start];
+        request->context = &dirty[start];
+        //the pages of a run that can't be submitted stay dirty
+        if((returnCode = submitPagesIO(aio, request)) != RC_OK)
+            numRequests--;
     }
-    free(fHandle);
-    fHandle = NULL;
-    return RC_OK;
+    RC writeCode = completeWrites(pi, aio);
+    for(int i = 0; i < pi->numFiles; i++)
+    {
+        if(!handles[i].fileName)
+            continue;
+        if(writeCode == RC_OK && (writeCode = syncPageFile(&handles[i])) == RC_OK)
+        {
+            pi->numSyncs++;
+            pi->files[i].numSyncs++;
+        }
+        closePageFile(&handles[i]);
+    }
+    free(handles);
+    free(requests);
+    free(iovs);
+    free(dirty);
+    //retired frames whose earlier write failed are let go of once clean
+    if(pi->numFrames > pi->owner->numPages)
+    {
+        RC releaseCode = releaseRetiredFrames(pi);
+        if(writeCode == RC_OK)
+            writeCode = releaseCode;
+    }
+    return returnCode != RC_OK ? returnCode : writeCode;
 }
 
 /*********************************************************************
@@ -274,26 +592,46 @@ BM_BufferPool
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, const
             PageNumber pageNum)
 {
-
     //validate input
     if(!bm)
         return RC_BM_NOT_ALLOCATED;
+
+    pthread_mutex_lock(&bm->mgmtData->mutex);
+    RC returnCode = pinPageUnlocked(bm, page, pageNum);
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return returnCode;
+}
+
+//the mutex is released while the page is read and while the page of
+//the victim is written, the frame is busy meanwhile
+static RC pinPageUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page,
+                          const PageNumber pageNum)
+{
     if(!page)
         return RC_BM_PAGE_NOT_FOUND;
     if(pageNum <0)
         return RC_BM_PAGE_NOT_FOUND;
+    //a shared pool caches pages through the handles attached to it
+    if(bm->fileId == NO_FILE)
+        return RC_NO_FILENAME;
 
-    //Finds the frame number if the page is already pinned in a frame
-    int frameNum = findFrameNumber(bm, pageNum);
+    BM_PoolInfo *pi = bm->mgmtData;
+    //Finds the frame number if the page is already pinned in a frame,
+    //a page that is read or written by another pin is waited for
+    int frameNum;
+    while((frameNum = findFrameNumber(bm, pageNum)) != NO_PAGE && pi->frames[frameNum].isBusy)
+        pthread_cond_wait(&pi->frameIdle, &pi->mutex);
     //If the page exists in a frame
     if(frameNum != NO_PAGE)
     {
         //Increment the pin count for that frame
-        bm->mgmtData->fixCountArray[frameNum]++;
+        pi->frames[frameNum].fixCount++;
         //Initialize the BM_PageHandle data
         page->pageNum = pageNum;
-        page->data = (char*)(bm->mgmtData->poolMem_ptr + frameNum);
-        pinRplcStrat(bm, frameNum);
+        page->data = (char*)getFrame(pi, frameNum);
+        //retired frames are never replaced
+        if(frameNum < bm->numPages)
+            pinRplcStrat(bm, frameNum);
         return RC_OK;
     }
 
@@ -307,42 +645,160 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, const
 
     //Arrive here if we have a valid framePtr to a frame
     //But we need to forcePage to disk first IF DIRTY
-    frameNum = ((framePtr - bm->mgmtData->poolMem_ptr));
-    if(bm->mgmtData->isDirtyArray[frameNum] == true)
+    frameNum = getFrameNumber(pi, framePtr);
+    //the victim may belong to another file of a shared pool, writeVictim
+    //flushes its log up to the page first (write-ahead logging)
+    RC returnCode;
+    if(pi->frames[frameNum].isDirty == true)
     {
-        BM_PageHandle *ph = (BM_PageHandle*) calloc(1, sizeof(BM_PageHandle));
-        ph->pageNum = bm->mgmtData->frameContent[frameNum];
-        ph->data = (char*)framePtr;
-        forcePage(bm, ph);
-        free(ph);
+        returnCode = writeVictim(pi, frameNum);
+        //the victim keeps its page if it can't be written
+        if(returnCode != RC_OK)
+            return returnCode;
+        //the pool was unlocked, another pin may have read the page or a
+        //shrink retired the victim meanwhile
+        if(findFrameNumber(bm, pageNum) != NO_PAGE || frameNum >= bm->numPages)
+        {
+            if(frameNum >= bm->numPages)
+                releaseRetiredFrames(pi);
+            else
+                unmapFrame(pi, frameNum);
+            return pinPageUnlocked(bm, page, pageNum);
+        }
     }
 
-    //Maybe try to read from disk
-    struct SM_FileHandle fHandle;
-    RC returnCode;
-    if((returnCode = openPageFile(bm->pageFile,&fHandle))!=RC_OK)
+    //the frame gets the page before it is read, so it isn't read twice,
+    //and the victim's clean page is given up even if the read fails
+    pi->frames[frameNum].fixCount = 1;
+    pi->frames[frameNum].isBusy = true;
+    mapFrame(pi, frameNum, bm->fileId, pageNum);
+    pthread_mutex_unlock(&pi->mutex);
+    bool isRead = false;
+    returnCode = readFrame(bm->pageFile, pageNum, framePtr, pi->frameSize, &isRead);
+    pthread_mutex_lock(&pi->mutex);
+    pi->frames[frameNum].isBusy = false;
+    pthread_cond_broadcast(&pi->frameIdle);
+    if(returnCode != RC_OK)
     {
+        pi->frames[frameNum].fixCount = 0;
+        unmapFrame(pi, frameNum);
+        if(frameNum >= bm->numPages)
+            releaseRetiredFrames(pi);
         return returnCode;
     }
-    if(fHandle.totalNumPages>pageNum)
+    if(isRead)
     {
-        if((returnCode = readBlock(pageNum,&fHandle,((SM_PageHandle)framePtr)))!=RC_OK)
-            return returnCode;
-        bm->mgmtData->numReadIO++;
+        pi->numReadIO++;
+        pi->files[bm->fileId].numReadIO++;
     }
-    if((returnCode=closePageFile(&fHandle))!=RC_OK)
-        return returnCode;
 
     page->pageNum = pageNum;
     page->data = (char*)framePtr;
-    //Calculate frameNum from framePtr to increment pool info
+    //retired frames are never replaced
+    if(frameNum < bm->numPages)
+        pinRplcStrat(bm, frameNum);
 
-    bm->mgmtData->fixCountArray[frameNum] = 1;
-    bm->mgmtData->frameContent[frameNum] = pageNum;
+    return RC_OK;
+}
+
+/*********************************************************************
+prefetchPages reads the pages startPage to startPage + numPages - 1
+that aren't in the pool yet into frames, opening the page file only
+once. Consecutive pages are read with one request into their frames.
+The pages aren't pinned, pinPage finds them later. Prefetching stops
+early if no frame is free, pages beyond the end of the file are
+skipped.
+*********************************************************************/
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber startPage, const int numPages)
+{
+    //validate input
+    if(!bm)
+        return RC_BM_NOT_ALLOCATED;
+    if(bm->fileId == NO_FILE)
+        return RC_NO_FILENAME;
+    if(startPage < 0 || numPages < 0)
+        return RC_BM_PAGE_NOT_FOUND;
 
-    pinRplcStrat(bm, frameNum);
+    BM_PoolInfo *pi = bm->mgmtData;
+    SM_FileHandle fHandle;
+    RC returnCode = RC_INIT;
+    if((returnCode = openPageFile(bm->pageFile, &fHandle)) != RC_OK)
+        return returnCode;
+    //compressed pages are read when they are pinned
+    if(isCompressedPageFile(&fHandle))
+        return closePageFile(&fHandle);
+    PageNumber endPage = startPage + numPages;
+    if(endPage > fHandle.totalNumPages)
+        endPage = fHandle.totalNumPages;
+    int segmentPages = getSegmentPages(&fHandle);
+    int maxPages = endPage > startPage ? endPage - startPage : 1;
+    VALID_CALLOC(AIO_Request, requests, maxPages, sizeof(AIO_Request));
+    VALID_CALLOC(struct iovec, iovs, maxPages, sizeof(struct iovec));
+    VALID_CALLOC(int, frameNums, maxPages, sizeof(int));
+    int numRequests = 0, numRead = 0;
+    AIO_Request *run = NULL; //run of pages not submitted yet
 
-    return RC_OK;
+    pthread_mutex_lock(&pi->mutex);
+    AIO_Context *aio = getAsyncIO(pi);
+    if(!aio)
+        returnCode = RC_AIO_INIT_FAILED;
+    for(PageNumber pageNum = startPage; pageNum < endPage && returnCode == RC_OK; pageNum++)
+    {
+        if(findFrameNumber(bm, pageNum) != NO_PAGE)
+            continue;
+        BM_Frame *framePtr = findEmptyFrame(bm);
+        //a pool without free frames only doesn't prefetch
+        if(!framePtr)
+            break;
+        int frameNum = getFrameNumber(pi, framePtr);
+        if(pi->frames[frameNum].isDirty && (returnCode = writeFrame(pi, frameNum)) != RC_OK)
+            break;
+        //the frame is fixed until its page is read, so it isn't used twice
+        pi->frames[frameNum].fixCount = 1;
+        mapFrame(pi, frameNum, bm->fileId, pageNum);
+        pinRplcStrat(bm, frameNum);
+        iovs[numRead].iov_base = framePtr;
+        iovs[numRead].iov_len = pi->frameSize;
+        frameNums[numRead] = frameNum;
+        //a cached page or the end of a segment file ends the run
+        if(run && run->pageNum + run->numPages == pageNum && run->numPages < BM_MAX_RUN_PAGES
+                && pageNum % segmentPages != 0)
+            run->numPages++;
+        else
+        {
+            if(run && (returnCode = submitReads(pi, aio, run)) != RC_OK)
+            {
+                //neither the run nor this page is read
+                run = NULL;
+                pi->frames[frameNum].fixCount = 0;
+                unmapFrame(pi, frameNum);
+                break;
+            }
+            run = &requests[numRequests++];
+            run->op = AIO_READ;
+            run->fd = getPageFd(&fHandle, pageNum, &run->fileOffset);
+            run->pageNum = pageNum;
+            run->numPages = 1;
+            run->iovs = &iovs[numRead];
+            run->context = &frameNums[numRead];
+        }
+        numRead++;
+    }
+    if(run)
+    {
+        RC submitCode = submitReads(pi, aio, run);
+        if(returnCode == RC_OK)
+            returnCode = submitCode;
+    }
+    RC readCode = aio ? completeReads(bm, aio, &fHandle) : RC_OK;
+    pthread_mutex_unlock(&pi->mutex);
+    free(requests);
+    free(iovs);
+    free(frameNums);
+    RC closeCode = closePageFile(&fHandle);
+    if(returnCode != RC_OK)
+        return returnCode;
+    return readCode != RC_OK ? readCode : closeCode;
 }
 
 static void pinRplcStrat(BM_BufferPool* bm, int frameNum)
@@ -375,9 +831,9 @@ static BM_Frame * findEmptyFrame(BM_BufferPool *bm)
     //search for empty frame
     for(int i = 0; i < bm->numPages; i++)
     {
-        if(bm->mgmtData->frameContent[i] == NO_PAGE)
+        if(bm->mgmtData->frames[i].pageNum == NO_PAGE)
         {
-            return (bm->mgmtData->poolMem_ptr + i);
+            return getFrame(bm->mgmtData, i);
         }
     }
 
@@ -416,12 +872,26 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page)
     //validate input
     if(!bm)
         return RC_BM_NOT_ALLOCATED;
+
+    pthread_mutex_lock(&bm->mgmtData->mutex);
+    RC returnCode = unpinPageUnlocked(bm, page);
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return returnCode;
+}
+
+static RC unpinPageUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
     if(!page)
         return RC_BM_PAGE_NOT_FOUND;
 
     int frameNum = findFrameNumber(bm, page->pageNum);
-    if(bm->mgmtData->fixCountArray[frameNum] > 0)
-        bm->mgmtData->fixCountArray[frameNum] -= 1;
+    if(frameNum == NO_PAGE)
+        return RC_BM_PAGE_NOT_FOUND;
+    if(bm->mgmtData->frames[frameNum].fixCount > 0)
+        bm->mgmtData->frames[frameNum].fixCount -= 1;
+    //a retired frame is let go of once it is unpinned
+    if(frameNum >= bm->numPages && bm->mgmtData->frames[frameNum].fixCount == 0)
+        return releaseRetiredFrames(bm->mgmtData);
 
     return RC_OK;
 }
@@ -434,6 +904,15 @@ RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
     //validate input
     if(!bm)
         return RC_BM_NOT_ALLOCATED;
+
+    pthread_mutex_lock(&bm->mgmtData->mutex);
+    RC returnCode = markDirtyUnlocked(bm, page);
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return returnCode;
+}
+
+static RC markDirtyUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
     if(!page)
         return RC_BM_PAGE_NOT_FOUND;
 
@@ -443,7 +922,7 @@ RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
     //search through the pages stored in the buffer pool for the page of interest
     if((frameNum = findFrameNumber(bm, page->pageNum)) == NO_PAGE)
         return RC_BM_PAGE_NOT_FOUND;
-    bm->mgmtData->isDirtyArray[frameNum] = true;
+    bm->mgmtData->frames[frameNum].isDirty = true;
 
     return RC_OK;
 }
@@ -457,8 +936,19 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
     //validate input
     if(!bm)
         return RC_BM_NOT_ALLOCATED;
+
+    pthread_mutex_lock(&bm->mgmtData->mutex);
+    RC returnCode = forcePageUnlocked(bm, page);
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return returnCode;
+}
+
+static RC forcePageUnlocked(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
     if(!page)
         return RC_BM_PAGE_NOT_FOUND;
+    if(bm->fileId == NO_FILE)
+        return RC_NO_FILENAME;
 
     SM_FileHandle *fHandle = (SM_FileHandle*) calloc(1, sizeof(SM_FileHandle));
     if(!fHandle)
@@ -468,6 +958,12 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
     }
     RC returnCode = RC_INIT;
 
+    if((returnCode = callBeforeWrite(bm->mgmtData, bm->fileId, page->pageNum, page->data)) != RC_OK)
+    {
+        free(fHandle);
+        fHandle = NULL;
+        return returnCode;
+    }
     if((returnCode = openPageFile(bm->pageFile, fHandle)) != RC_OK)
     {
         free(fHandle);
@@ -487,17 +983,160 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
         return returnCode;
     }
     bm->mgmtData->numWriteIO++;
+    bm->mgmtData->files[bm->fileId].numWriteIO++;
     //search through the pages stored in the buffer pool for the page of interest
     int frameNum = -1;
+    free(fHandle);
+    fHandle = NULL;
     if((frameNum = findFrameNumber(bm, page->pageNum)) == -1)
         return RC_BM_PAGE_NOT_FOUND;
-    bm->mgmtData->isDirtyArray[frameNum] = false;
+    bm->mgmtData->frames[frameNum].isDirty = false;
+    return returnCode;
+}
 
-    free(fHandle);
-    fHandle = NULL;
+/*********************************************************************
+*
+*               BUFFER MANAGER INTERFACE CHECKPOINTS
+*
+*********************************************************************/
+
+/*********************************************************************
+getDirtyPages returns the numbers of the pages of the pool's file that
+are dirty or pinned, so they may hold changes that aren't in the page
+file yet. The caller has to free *pages.
+*********************************************************************/
+RC getDirtyPages (BM_BufferPool *const bm, PageNumber **pages, int *numPages)
+{
+    //validate input
+    if(!bm)
+        return RC_BM_NOT_ALLOCATED;
+
+    *numPages = 0;
+    pthread_mutex_lock(&bm->mgmtData->mutex);
+    *pages = (PageNumber *) calloc(bm->mgmtData->numFrames, sizeof(PageNumber));
+    if(!*pages)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    for(int i = 0; i < bm->mgmtData->numFrames; i++)
+    {
+        if(bm->mgmtData->frames[i].pageNum != NO_PAGE && bm->mgmtData->frames[i].fileId == bm->fileId &&
+                (bm->mgmtData->frames[i].isDirty || bm->mgmtData->frames[i].fixCount > 0))
+            (*pages)[(*numPages)++] = bm->mgmtData->frames[i].pageNum;
+    }
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return RC_OK;
+}
+
+/*********************************************************************
+writeDirtyPage writes page pageNum to the page file if it is dirty. It
+is meant for a background writer: the frame is copied while the pool
+is locked and written after unlocking it, so pinPage isn't blocked by
+the write. The frame stays pinned meanwhile, so it can't be evicted and
+written by pinPage before the older copy.
+RETURNS: RC_OK if the page file has the page as it was when this was
+called, RC_BM_PAGE_PINNED if the page is in use and has to be retried
+*********************************************************************/
+RC writeDirtyPage (BM_BufferPool *const bm, const PageNumber pageNum)
+{
+    //validate input
+    if(!bm)
+        return RC_BM_NOT_ALLOCATED;
+
+    BM_PoolInfo *pi = bm->mgmtData;
+    pthread_mutex_lock(&pi->mutex);
+    int frameNum = findFrameNumber(bm, pageNum);
+    //a page that was evicted meanwhile already is in the file
+    if(frameNum == NO_PAGE)
+    {
+        pthread_mutex_unlock(&pi->mutex);
+        return RC_OK;
+    }
+    //a pinned page may be changed and marked dirty yet
+    if(pi->frames[frameNum].fixCount > 0)
+    {
+        pthread_mutex_unlock(&pi->mutex);
+        return RC_BM_PAGE_PINNED;
+    }
+    //a page that was forced meanwhile already is in the file
+    if(!pi->frames[frameNum].isDirty)
+    {
+        pthread_mutex_unlock(&pi->mutex);
+        return RC_OK;
+    }
+    VALID_CALLOC(char, copy, 1, pi->frameSize);
+    memcpy(copy, getFrame(pi, frameNum), pi->frameSize);
+    pi->frames[frameNum].fixCount++;
+    pi->frames[frameNum].isDirty = false;
+    pthread_mutex_unlock(&pi->mutex);
+
+    SM_FileHandle fHandle;
+    RC returnCode = callBeforeWrite(pi, bm->fileId, pageNum, copy);
+    if(returnCode == RC_OK)
+        returnCode = openPageFile(bm->pageFile, &fHandle);
+    if(returnCode == RC_OK)
+    {
+        returnCode = writeBlock(pageNum, &fHandle, copy);
+        RC closeCode = closePageFile(&fHandle);
+        if(returnCode == RC_OK)
+            returnCode = closeCode;
+    }
+    free(copy);
+
+    pthread_mutex_lock(&pi->mutex);
+    pi->frames[frameNum].fixCount--;
+    if(returnCode == RC_OK)
+    {
+        pi->numWriteIO++;
+        pi->files[bm->fileId].numWriteIO++;
+    }
+    else
+        pi->frames[frameNum].isDirty = true;
+    if(frameNum >= bm->numPages && pi->frames[frameNum].fixCount == 0)
+    {
+        RC releaseCode = releaseRetiredFrames(pi);
+        if(returnCode == RC_OK)
+            returnCode = releaseCode;
+    }
+    pthread_mutex_unlock(&pi->mutex);
     return returnCode;
 }
 
+/*********************************************************************
+setBeforeWriteHook makes the pool call beforeWrite(context, page)
+before it writes a page to the page file, whether the page is forced,
+flushed or evicted by pinPage. A record manager uses it to flush its
+log up to the last change of the page. The page isn't written if the
+hook returns an error.
+*********************************************************************/
+RC setBeforeWriteHook (BM_BufferPool *const bm, BM_BeforeWriteFunc beforeWrite, void *context)
+{
+    //validate input
+    if(!bm)
+        return RC_BM_NOT_ALLOCATED;
+    if(bm->fileId == NO_FILE)
+        return RC_NO_FILENAME;
+
+    pthread_mutex_lock(&bm->mgmtData->mutex);
+    bm->mgmtData->files[bm->fileId].beforeWrite = beforeWrite;
+    bm->mgmtData->files[bm->fileId].beforeWriteContext = context;
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return RC_OK;
+}
+
+/*********************************************************************
+getFrame returns frame frameNum of the pool. The frames are spread
+over the chunks, a pool that never grew has a single one.
+*********************************************************************/
+BM_Frame *getFrame (BM_PoolInfo *const pi, const int frameNum)
+{
+    int chunk = pi->numChunks - 1;
+    while(pi->chunkStart[chunk] > frameNum)
+        chunk--;
+    return pi->frameChunks[chunk] + (size_t) (frameNum - pi->chunkStart[chunk]) * pi->frameSize;
+}
+
 /*********************************************************************
 *
 *                        STATISTICS INTERFACE
@@ -508,11 +1147,16 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
 getFrameContents returns an array of PageNumbers (of size
 numPages) where the ith element is the number of the page stored in
 the ith page frame. An empty page frame is represented using the
-constant NO_PAGE.
+constant NO_PAGE. Frames of a shared pool may hold pages of any file.
 *********************************************************************/
 PageNumber *getFrameContents (BM_BufferPool *const bm)
 {
-    return (PageNumber*) bm->mgmtData->frameContent;
+    BM_PoolInfo *pi = bm->mgmtData;
+    pthread_mutex_lock(&pi->mutex);
+    for(int i = 0; i < bm->numPages; i++)
+        pi->statContent[i] = pi->frames[i].pageNum;
+    pthread_mutex_unlock(&pi->mutex);
+    return pi->statContent;
 }
 
 /*********************************************************************
@@ -522,7 +1166,12 @@ page frame is dirty. Empty page frames are considered as clean.
 *********************************************************************/
 bool *getDirtyFlags (BM_BufferPool *const bm)
 {
-    return bm->mgmtData->isDirtyArray;
+    BM_PoolInfo *pi = bm->mgmtData;
+    pthread_mutex_lock(&pi->mutex);
+    for(int i = 0; i < bm->numPages; i++)
+        pi->statDirty[i] = pi->frames[i].isDirty;
+    pthread_mutex_unlock(&pi->mutex);
+    return pi->statDirty;
 }
 /*********************************************************************
 getFixCounts returns an array of ints (of size numPages)
@@ -531,7 +1180,12 @@ page frame. Return 0 for empty page frames.
 *********************************************************************/
 int *getFixCounts (BM_BufferPool *const bm)
 {
-    return bm->mgmtData->fixCountArray;
+    BM_PoolInfo *pi = bm->mgmtData;
+    pthread_mutex_lock(&pi->mutex);
+    for(int i = 0; i < bm->numPages; i++)
+        pi->statFixCount[i] = pi->frames[i].fixCount;
+    pthread_mutex_unlock(&pi->mutex);
+    return pi->statFixCount;
 }
 
 /*********************************************************************
@@ -539,10 +1193,13 @@ getNumReadIO returns the number of pages that have been
 read from disk since a buffer pool has been initialized. You code is
 responsible to initializing this statistic at pool creating time and
 update whenever a page is read from the page file into a page frame.
+A shared pool itself counts the reads of all its files.
 *********************************************************************/
 int getNumReadIO (BM_BufferPool *const bm)
 {
-    return bm->mgmtData->numReadIO;
+    if(bm->fileId == NO_FILE)
+        return bm->mgmtData->numReadIO;
+    return bm->mgmtData->files[bm->fileId].numReadIO;
 }
 
 /*********************************************************************
@@ -551,7 +1208,27 @@ since the buffer pool has been initialized.
 *********************************************************************/
 int getNumWriteIO (BM_BufferPool *const bm)
 {
-    return bm->mgmtData->numWriteIO;
+    if(bm->fileId == NO_FILE)
+        return bm->mgmtData->numWriteIO;
+    return bm->mgmtData->files[bm->fileId].numWriteIO;
+}
+
+/*********************************************************************
+getNumSyncs returns how often forceFlushPool made the page file
+durable since the buffer pool has been initialized, once per call
+that wrote pages of it.
+*********************************************************************/
+int getNumSyncs (BM_BufferPool *const bm)
+{
+    if(bm->fileId == NO_FILE)
+        return bm->mgmtData->numSyncs;
+    return bm->mgmtData->files[bm->fileId].numSyncs;
+}
+
+//the bytes of a frame of the pool, the page size of its files
+int getFrameSize (BM_BufferPool *const bm)
+{
+    return bm->mgmtData->frameSize;
 }
 
 /*********************************************************************
@@ -560,6 +1237,14 @@ int getNumWriteIO (BM_BufferPool *const bm)
 *
 *********************************************************************/
 
+static RC callBeforeWrite(BM_PoolInfo *pi, int fileId, PageNumber pageNum, char *data)
+{
+    if(!pi->files[fileId].beforeWrite)
+        return RC_OK;
+    BM_PageHandle page = {pageNum, data};
+    return pi->files[fileId].beforeWrite(pi->files[fileId].beforeWriteContext, &page);
+}
+
 /*********************************************************************
 Helper function to find the frame number for given pageNumber in
 a buffer pool. If a page number doesn't exist then the function will
@@ -567,15 +1252,515 @@ return NO_PAGE = -1.
 *********************************************************************/
 static int findFrameNumber(BM_BufferPool * bm, PageNumber pageNumber)
 {
-    //get memory address frameContentArray
-    int *frameContent = bm->mgmtData->frameContent;
+    return findFrame(bm->mgmtData, bm->fileId, pageNumber);
+}
+
+//RETURNS: the id of a free slot in the files of the pool
+static int addFile(BM_PoolInfo *pi, BM_BufferPool *handle, const char *pageFileName)
+{
+    int fileId = 0;
+    while(fileId < pi->numFiles && pi->files[fileId].pageFile)
+        fileId++;
+    if(fileId == pi->numFiles)
+    {
+        pi->files = (BM_FileInfo *) realloc(pi->files, (pi->numFiles + 1) * sizeof(BM_FileInfo));
+        if(!pi->files)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+        pi->numFiles++;
+    }
+    memset(&pi->files[fileId], 0, sizeof(BM_FileInfo));
+    pi->files[fileId].pageFile = (char *)pageFileName;
+    pi->files[fileId].handle = handle;
+    return fileId;
+}
+
+//sets *pageSize to the bytes of the pages of the page file
+static RC getFilePageSize(const char *pageFileName, int *pageSize)
+{
+    SM_FileHandle fHandle;
+    RC returnCode = openPageFile((char *)pageFileName, &fHandle);
+    if(returnCode != RC_OK)
+        return returnCode;
+    *pageSize = fHandle.pageSize;
+    return closePageFile(&fHandle);
+}
+
+static unsigned int hashPage(BM_PoolInfo *pi, int fileId, PageNumber pageNum)
+{
+    unsigned int hash = (unsigned int) pageNum * 2654435761u ^ (unsigned int) fileId * 40503u;
+    return hash & (pi->numBuckets - 1);
+}
+
+static int findFrame(BM_PoolInfo *pi, int fileId, PageNumber pageNum)
+{
+    int frameNum = pi->pageTable[hashPage(pi, fileId, pageNum)];
+    while(frameNum != NO_PAGE &&
+            (pi->frames[frameNum].pageNum != pageNum || pi->frames[frameNum].fileId != fileId))
+        frameNum = pi->frames[frameNum].nextInBucket;
+    return frameNum;
+}
+
+//puts page pageNum of fileId into frame frameNum, replacing its page
+static void mapFrame(BM_PoolInfo *pi, int frameNum, int fileId, PageNumber pageNum)
+{
+    unmapFrame(pi, frameNum);
+    unsigned int bucket = hashPage(pi, fileId, pageNum);
+    pi->frames[frameNum].nextInBucket = pi->pageTable[bucket];
+    pi->pageTable[bucket] = frameNum;
+    pi->frames[frameNum].pageNum = pageNum;
+    pi->frames[frameNum].fileId = fileId;
+}
+
+static void unmapFrame(BM_PoolInfo *pi, int frameNum)
+{
+    if(pi->frames[frameNum].pageNum == NO_PAGE)
+        return;
+    int *link = &pi->pageTable[hashPage(pi, pi->frames[frameNum].fileId, pi->frames[frameNum].pageNum)];
+    while(*link != frameNum)
+        link = &pi->frames[*link].nextInBucket;
+    *link = pi->frames[frameNum].nextInBucket;
+    pi->frames[frameNum].pageNum = NO_PAGE;
+    pi->frames[frameNum].fileId = NO_FILE;
+}
 
-    //search through the pages stored in the buffer pool
-    //for the page of interest
-    for (int i = 0; i < bm->numPages; i++)
+//writes the page in frame frameNum to the page file it belongs to
+static RC writeFrame(BM_PoolInfo *pi, int frameNum)
+{
+    int fileId = pi->frames[frameNum].fileId;
+    PageNumber pageNum = pi->frames[frameNum].pageNum;
+    char *memPage = (char*)getFrame(pi, frameNum);
+    SM_FileHandle fHandle;
+    RC returnCode = callBeforeWrite(pi, fileId, pageNum, memPage);
+    if(returnCode != RC_OK)
+        return returnCode;
+    if((returnCode = openPageFile(pi->files[fileId].pageFile, &fHandle)) != RC_OK)
+        return returnCode;
+    if((returnCode = writeBlock(pageNum, &fHandle, memPage)) != RC_OK)
     {
-        if (frameContent[i] == pageNumber)
-            return i;
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    if((returnCode = closePageFile(&fHandle)) != RC_OK)
+        return returnCode;
+    pi->frames[frameNum].isDirty = false;
+    pi->numWriteIO++;
+    pi->files[fileId].numWriteIO++;
+    return RC_OK;
+}
+
+/*********************************************************************
+writeVictim writes the dirty page in frame frameNum before pinPage
+replaces it. The mutex is released during the write, so pins of other
+pages don't wait for it. The frame is fixed and busy meanwhile: it
+isn't chosen again and pins of its page wait until it is written. The
+mutex has to be held, it is held again on return.
+*********************************************************************/
+static RC writeVictim(BM_PoolInfo *pi, int frameNum)
+{
+    int fileId = pi->frames[frameNum].fileId;
+    PageNumber pageNum = pi->frames[frameNum].pageNum;
+    //files moves if another file is attached meanwhile
+    BM_FileInfo file = pi->files[fileId];
+    BM_PageHandle page = {pageNum, (char*)getFrame(pi, frameNum)};
+    pi->frames[frameNum].fixCount++;
+    pi->frames[frameNum].isBusy = true;
+    pthread_mutex_unlock(&pi->mutex);
+
+    SM_FileHandle fHandle;
+    RC returnCode = file.beforeWrite ? file.beforeWrite(file.beforeWriteContext, &page) : RC_OK;
+    if(returnCode == RC_OK)
+        returnCode = openPageFile(file.pageFile, &fHandle);
+    if(returnCode == RC_OK)
+    {
+        returnCode = writeBlock(pageNum, &fHandle, page.data);
+        RC closeCode = closePageFile(&fHandle);
+        if(returnCode == RC_OK)
+            returnCode = closeCode;
+    }
+
+    pthread_mutex_lock(&pi->mutex);
+    pi->frames[frameNum].fixCount--;
+    pi->frames[frameNum].isBusy = false;
+    pthread_cond_broadcast(&pi->frameIdle);
+    if(returnCode != RC_OK)
+        return returnCode;
+    pi->frames[frameNum].isDirty = false;
+    pi->numWriteIO++;
+    pi->files[fileId].numWriteIO++;
+    return RC_OK;
+}
+
+//reads page pageNum of pageFile into framePtr, pages beyond the end of
+//the file are empty. *isRead tells whether the page was in the file
+static RC readFrame(char *pageFile, PageNumber pageNum, BM_Frame *framePtr, int frameSize, bool *isRead)
+{
+    SM_FileHandle fHandle;
+    RC returnCode = openPageFile(pageFile, &fHandle);
+    if(returnCode != RC_OK)
+        return returnCode;
+    *isRead = fHandle.totalNumPages > pageNum;
+    if(*isRead)
+        returnCode = readBlock(pageNum, &fHandle, framePtr);
+    else
+        memset(framePtr, 0, frameSize);
+    RC closeCode = closePageFile(&fHandle);
+    return returnCode != RC_OK ? returnCode : closeCode;
+}
+
+//adds numFrames empty frames after the last chunk
+static void addChunk(BM_PoolInfo *pi, int numFrames)
+{
+    pi->frameChunks = (BM_Frame **) realloc(pi->frameChunks, (pi->numChunks + 1) * sizeof(BM_Frame *));
+    pi->chunkBytes = (size_t *) realloc(pi->chunkBytes, (pi->numChunks + 1) * sizeof(size_t));
+    pi->chunkStart = (int *) realloc(pi->chunkStart, (pi->numChunks + 1) * sizeof(int));
+    if(!pi->frameChunks || !pi->chunkBytes || !pi->chunkStart)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    pi->chunkBytes[pi->numChunks] = (size_t) numFrames * pi->frameSize;
+    pi->frameChunks[pi->numChunks] = mapFrames(&pi->chunkBytes[pi->numChunks], pi->hugePages);
+    pi->chunkStart[pi->numChunks] = pi->capacity;
+    pi->numChunks++;
+    pi->capacity += numFrames;
+}
+
+static void freeChunk(BM_PoolInfo *pi, int chunk)
+{
+    munmap(pi->frameChunks[chunk], pi->chunkBytes[chunk]);
+    pi->frameChunks[chunk] = NULL;
+}
+
+/*********************************************************************
+mapFrames maps *bytes of zeroed memory for frames and rounds *bytes up
+to the size that was mapped. The memory is page aligned, as direct IO
+needs it. With huge pages a pin hit touches far fewer TLB entries:
+transparent huge pages are only asked for, the kernel may still use
+normal pages, and explicit ones fall back to normal pages if the
+kernel has none reserved.
+*********************************************************************/
+static BM_Frame *mapFrames(size_t *bytes, BM_HugePages hugePages)
+{
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    if(hugePages != BM_HUGE_PAGES_NONE)
+        pageSize = BM_HUGE_PAGE_SIZE;
+    *bytes = (*bytes + pageSize - 1) / pageSize * pageSize;
+    void *memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if(hugePages == BM_HUGE_PAGES_EXPLICIT)
+        memory = mmap(NULL, *bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if(memory == MAP_FAILED)
+        memory = mmap(NULL, *bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+#ifdef MADV_HUGEPAGE
+    if(hugePages == BM_HUGE_PAGES_TRANSPARENT)
+        madvise(memory, *bytes, MADV_HUGEPAGE);
+#endif
+    return (BM_Frame *) memory;
+}
+
+//descriptors start on a cache line, so none of them spans two
+static BM_FrameDesc *allocFrameDescs(int numPages)
+{
+    void *descs = NULL;
+    if(posix_memalign(&descs, BM_CACHE_LINE_SIZE, numPages * sizeof(BM_FrameDesc)) != 0)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    return (BM_FrameDesc *) descs;
+}
+
+//RETURNS: the number of the frame framePtr points to
+static int getFrameNumber(BM_PoolInfo *pi, BM_Frame *framePtr)
+{
+    for(int chunk = 0; chunk < pi->numChunks; chunk++)
+    {
+        int chunkSize = (chunk + 1 < pi->numChunks ? pi->chunkStart[chunk + 1] : pi->capacity)
+                        - pi->chunkStart[chunk];
+        size_t offset = framePtr - pi->frameChunks[chunk];
+        if(framePtr >= pi->frameChunks[chunk] && offset < (size_t) chunkSize * pi->frameSize)
+            return pi->chunkStart[chunk] + (int) (offset / pi->frameSize);
     }
     return NO_PAGE;
 }
+
+//resizes the descriptors to numFrames and the statistics arrays to
+//numPages, new frames are empty
+static void resizeFrameArrays(BM_PoolInfo *pi, int numFrames, int numPages)
+{
+    BM_FrameDesc *frames = allocFrameDescs(numFrames);
+    int oldNumFrames = pi->frames ? pi->numFrames : 0;
+    if(pi->frames)
+        memcpy(frames, pi->frames, (oldNumFrames < numFrames ? oldNumFrames : numFrames) * sizeof(BM_FrameDesc));
+    free(pi->frames);
+    pi->frames = frames;
+    pi->numFrames = numFrames;
+    pi->statContent = (PageNumber *) realloc(pi->statContent, numPages * sizeof(PageNumber));
+    pi->statDirty = (bool *) realloc(pi->statDirty, numPages * sizeof(bool));
+    pi->statFixCount = (int *) realloc(pi->statFixCount, numPages * sizeof(int));
+    if(!pi->statContent || !pi->statDirty || !pi->statFixCount)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    for(int i = oldNumFrames; i < numFrames; i++)
+    {
+        memset(&pi->frames[i], 0, sizeof(BM_FrameDesc));
+        pi->frames[i].pageNum = NO_PAGE;
+        pi->frames[i].fileId = NO_FILE;
+    }
+}
+
+//frees the chunks that only hold frames from numFrames on
+static void freeChunksPast(BM_PoolInfo *pi, int numFrames)
+{
+    while(pi->numChunks > 1 && pi->chunkStart[pi->numChunks - 1] >= numFrames)
+    {
+        pi->numChunks--;
+        pi->capacity = pi->chunkStart[pi->numChunks];
+        freeChunk(pi, pi->numChunks);
+    }
+}
+
+/*********************************************************************
+releaseRetiredFrames writes the pages of the frames a shrink retired
+that aren't pinned anymore and empties them. The descriptors and the
+chunks past the last frame still in use are given up. A frame whose
+page can't be written stays retired, the next call tries it again.
+The mutex has to be held.
+RETURNS: the first error of a write
+*********************************************************************/
+static RC releaseRetiredFrames(BM_PoolInfo *pi)
+{
+    RC returnCode = RC_OK;
+    int numPages = pi->owner->numPages;
+    int numFrames = numPages;
+    for(int i = numPages; i < pi->numFrames; i++)
+    {
+        if(pi->frames[i].fixCount == 0 && pi->frames[i].isDirty)
+        {
+            RC writeCode = writeFrame(pi, i);
+            if(returnCode == RC_OK)
+                returnCode = writeCode;
+        }
+        if(pi->frames[i].fixCount == 0 && !pi->frames[i].isDirty)
+            unmapFrame(pi, i);
+        if(pi->frames[i].pageNum != NO_PAGE)
+            numFrames = i + 1;
+    }
+    //the descriptors past numFrames are only copied again if the pool grows
+    pi->numFrames = numFrames;
+    freeChunksPast(pi, numFrames);
+    return returnCode;
+}
+
+//rehashes the pages of all frames, retired ones too, into a table with
+//at least twice as many buckets as numPages
+static void rebuildPageTable(BM_PoolInfo *pi, int numPages)
+{
+    while(pi->numBuckets < 2*numPages)
+        pi->numBuckets *= 2;
+    free(pi->pageTable);
+    pi->pageTable = (int *)calloc(pi->numBuckets, sizeof(int));
+    if(!pi->pageTable)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    memset(pi->pageTable, NO_PAGE, pi->numBuckets*(sizeof(int)));
+    for(int i = 0; i < pi->numFrames; i++)
+    {
+        if(pi->frames[i].pageNum == NO_PAGE)
+            continue;
+        int bucket = hashPage(pi, pi->frames[i].fileId, pi->frames[i].pageNum);
+        pi->frames[i].nextInBucket = pi->pageTable[bucket];
+        pi->pageTable[bucket] = i;
+    }
+}
+
+//bm->numPages is still the old size
+static void resizeRplcStrat(BM_BufferPool *bm, int newNumPages)
+{
+    switch(bm->strategy)
+    {
+    case RS_FIFO:
+        fifoResize(bm, newNumPages);
+        break;
+    case RS_LRU:
+        lruResize(bm, newNumPages);
+        break;
+    case RS_CLOCK:
+        clockResize(bm, newNumPages);
+        break;
+    case RS_LFU:
+        lfuResize(bm, newNumPages);
+        break;
+    default:
+        break;
+    }
+}
+
+//the pool and all handles of its files see the new size
+static void setNumPages(BM_PoolInfo *pi, int numPages)
+{
+    pi->owner->numPages = numPages;
+    for(int i = 0; i < pi->numFiles; i++)
+        if(pi->files[i].pageFile)
+            pi->files[i].handle->numPages = numPages;
+}
+
+//RETURNS: the async IO of the pool, NULL if it can't be started
+static AIO_Context *getAsyncIO(BM_PoolInfo *pi)
+{
+    if(pi->aio)
+        return pi->aio;
+    VALID_CALLOC(AIO_Context, aio, 1, sizeof(AIO_Context));
+    if(initAsyncIO(aio, AIO_DEFAULT_QUEUE_DEPTH, true) != RC_OK)
+    {
+        free(aio);
+        return NULL;
+    }
+    pi->aio = aio;
+    return aio;
+}
+
+//submits a prefetched run, its frames are emptied if it can't be
+static RC submitReads(BM_PoolInfo *pi, AIO_Context *aio, AIO_Request *run)
+{
+    RC returnCode = submitPagesIO(aio, run);
+    if(returnCode == RC_OK)
+        return RC_OK;
+    int *frameNums = run->context;
+    for(int i = 0; i < run->numPages; i++)
+    {
+        pi->frames[frameNums[i]].fixCount = 0;
+        unmapFrame(pi, frameNums[i]);
+    }
+    return returnCode;
+}
+
+//waits for the prefetched runs, the frames of runs that couldn't be
+//read are emptied. The context of a run holds its frame numbers,
+//fHandle is the page file they are read from
+static RC completeReads(BM_BufferPool *bm, AIO_Context *aio, SM_FileHandle *fHandle)
+{
+    BM_PoolInfo *pi = bm->mgmtData;
+    AIO_Request *done[AIO_DEFAULT_QUEUE_DEPTH];
+    RC returnCode = RC_OK;
+    int numDone;
+    while((numDone = waitAsyncIO(aio, done, AIO_DEFAULT_QUEUE_DEPTH)) > 0)
+        for(int i = 0; i < numDone; i++)
+        {
+            int *frameNums = done[i]->context;
+            for(int j = 0; j < done[i]->numPages; j++)
+            {
+                pi->frames[frameNums[j]].fixCount = 0;
+                //a page that fails its checksum isn't cached
+                RC pageCode = done[i]->returnCode;
+                if(pageCode == RC_OK)
+                    pageCode = checkPageChecksum(fHandle, (char *) getFrame(pi, frameNums[j]));
+                if(pageCode != RC_OK)
+                {
+                    unmapFrame(pi, frameNums[j]);
+                    returnCode = pageCode;
+                }
+            }
+            if(done[i]->returnCode != RC_OK)
+                continue;
+            pi->numReadIO += done[i]->numPages;
+            pi->files[bm->fileId].numReadIO += done[i]->numPages;
+        }
+    //the frames of runs still in flight stay fixed
+    if(numDone < 0)
+        returnCode = RC_AIO_ENTER_FAILED;
+    return returnCode;
+}
+
+//writes a run of forceFlushPool synchronously with writeBlocks
+static RC writeRun(BM_PoolInfo *pi, SM_FileHandle *fHandle, BM_DirtyFrame *run, int numPages,
+                   struct iovec *iovs)
+{
+    VALID_CALLOC(SM_PageHandle, pages, numPages, sizeof(SM_PageHandle));
+    for(int i = 0; i < numPages; i++)
+        pages[i] = iovs[i].iov_base;
+    RC returnCode = writeBlocks(run->pageNum, numPages, fHandle, pages);
+    free(pages);
+    if(returnCode != RC_OK)
+        return returnCode;
+    for(int i = 0; i < numPages; i++)
+        pi->frames[run[i].frameNum].isDirty = false;
+    pi->numWriteIO += numPages;
+    pi->files[run->fileId].numWriteIO += numPages;
+    return RC_OK;
+}
+
+//waits for the flushed runs, the pages that were written are clean.
+//The context of a run is its first BM_DirtyFrame
+static RC completeWrites(BM_PoolInfo *pi, AIO_Context *aio)
+{
+    AIO_Request *done[AIO_DEFAULT_QUEUE_DEPTH];
+    RC returnCode = RC_OK;
+    int numDone;
+    while((numDone = waitAsyncIO(aio, done, AIO_DEFAULT_QUEUE_DEPTH)) > 0)
+        for(int i = 0; i < numDone; i++)
+        {
+            BM_DirtyFrame *run = done[i]->context;
+            if(done[i]->returnCode != RC_OK)
+            {
+                returnCode = done[i]->returnCode;
+                continue;
+            }
+            for(int j = 0; j < done[i]->numPages; j++)
+                pi->frames[run[j].frameNum].isDirty = false;
+            pi->numWriteIO += done[i]->numPages;
+            pi->files[run->fileId].numWriteIO += done[i]->numPages;
+        }
+    //the pages of runs still in flight stay dirty
+    if(numDone < 0)
+        returnCode = RC_AIO_ENTER_FAILED;
+    return returnCode;
+}
+
+static int compareDirtyFrames(const void *a, const void *b)
+{
+    const BM_DirtyFrame *left = a, *right = b;
+    if(left->fileId != right->fileId)
+        return left->fileId - right->fileId;
+    return left->pageNum - right->pageNum;
+}
+
+/*********************************************************************
+detachFile gives the frames of a handle of a shared pool back to the
+pool without writing them. The frames become empty, so they are the
+first to be used again.
+*********************************************************************/
+static RC detachFile(BM_BufferPool *const bm)
+{
+    BM_PoolInfo *pi = bm->mgmtData;
+    pthread_mutex_lock(&pi->mutex);
+    for(int i = 0; i < pi->numFrames; i++)
+    {
+        if(pi->frames[i].fileId != bm->fileId)
+            continue;
+        unmapFrame(pi, i);
+        pi->frames[i].isDirty = false;
+        pi->frames[i].fixCount = 0;
+    }
+    //retired frames of the file are empty now, nothing is written
+    releaseRetiredFrames(pi);
+    pi->files[bm->fileId].pageFile = NULL;
+    pthread_mutex_unlock(&pi->mutex);
+    bm->fileId = NO_FILE;
+    bm->mgmtData = NULL;
+    return RC_OK;
+}
@@ -4,6 +4,8 @@
 // Include return codes and methods for logging errors
 #include "dberror.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
 
 // Replacement Strategies
 typedef enum ReplacementStrategy {
@@ -23,18 +25,68 @@ typedef struct BM_PageHandle {
     char *data;
 } BM_PageHandle;
 
-typedef struct BM_Frame {
-    char frame[PAGE_SIZE];
-} BM_Frame;
+// called before a page is written to the page file
+typedef RC (*BM_BeforeWriteFunc)(void *context, BM_PageHandle *const page);
+
+// the first byte of a frame, the frames of a pool are frameSize bytes
+typedef char BM_Frame;
+
+// a page file whose pages a pool caches
+typedef struct BM_FileInfo {
+    char *pageFile; //NULL if the slot is free
+    struct BM_BufferPool *handle; //pool struct the file is cached through
+    int numReadIO;
+    int numWriteIO;
+    int numSyncs;
+    BM_BeforeWriteFunc beforeWrite; //lets the owner flush its log first
+    void *beforeWriteContext;
+} BM_FileInfo;
+
+#define NO_FILE -1
+
+// the bookkeeping of a frame, two of them share a cache line
+typedef struct BM_FrameDesc {
+    PageNumber pageNum; //page in the frame, NO_PAGE if it is empty
+    int fileId; //file (index into files) of the page, NO_FILE if empty
+    int fixCount;
+    int nextInBucket; //next frame in the same bucket of the page table
+    bool isDirty;
+    bool isBusy; //pinPage reads or writes its page with the mutex released
+} __attribute__((aligned(32))) BM_FrameDesc;
+
+// how the memory of the frames is backed
+typedef enum BM_HugePages {
+    BM_HUGE_PAGES_NONE = 0, //normal pages
+    BM_HUGE_PAGES_TRANSPARENT = 1, //asks the kernel for transparent huge pages
+    BM_HUGE_PAGES_EXPLICIT = 2 //reserved huge pages, normal pages if there are none
+} BM_HugePages;
 
 typedef struct BM_PoolInfo {
-    BM_Frame *poolMem_ptr; //points to the start of the pool in memory
+    BM_Frame **frameChunks; //frames, a chunk is added whenever the pool grows, so frames never move
+    int frameSize; //bytes of a frame, the page size of the files in the pool
+    size_t *chunkBytes; //mapped size of every chunk
+    int *chunkStart; //number of the first frame of every chunk
+    int numChunks;
+    int capacity; //frames in all chunks, more than numPages after shrinking
+    int numFrames; //frames with a descriptor, numPages and the pinned ones a shrink retired
+    BM_HugePages hugePages; //backing of the chunks
     int numReadIO; //track number of pages read from disk since initialization
     int numWriteIO; //track number of pages written to disk since initialization
-    bool *isDirtyArray; //array that tracks the dirty state of each frame
-    int *fixCountArray; //array that tracks the fixCount of each frame
-    int *frameContent; //array that tracks the pageNumber for every frame
+    int numSyncs; //page files made durable by forceFlushPool
+    BM_FrameDesc *frames; //bookkeeping of every frame
+    PageNumber *statContent; //arrays filled by the statistics functions
+    bool *statDirty;
+    int *statFixCount;
+    int *pageTable; //hash buckets of (file, page), first frame or NO_PAGE
+    int numBuckets;
     void *rplcStratStruct; //contains data needed for replacement strategy
+    pthread_mutex_t mutex; //guards the arrays above against the checkpoint writer
+    pthread_cond_t frameIdle; //signalled whenever a frame stops being busy
+    BM_FileInfo *files; //page files cached in the pool
+    int numFiles;
+    bool isShared; //created by initSharedPool, files attach to it
+    struct BM_BufferPool *owner; //pool struct passed to initBufferPool or initSharedPool
+    struct AIO_Context *aio; //async IO of prefetching and flushing, made when first used
 } BM_PoolInfo;
 
 typedef struct BM_BufferPool {
@@ -43,6 +95,7 @@ typedef struct BM_BufferPool {
     ReplacementStrategy strategy;
     BM_PoolInfo *mgmtData; // use this one to store the bookkeeping info your buffer
     // manager needs for a buffer pool
+    int fileId; // pageFile in mgmtData->files, NO_FILE for a shared pool itself
 } BM_BufferPool;
 
 
@@ -61,7 +114,18 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
                   const int numPages, ReplacementStrategy strategy,
                   void *stratData);
 RC shutdownBufferPool(BM_BufferPool *const bm);
+RC dropBufferPool(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
 RC forceFlushPool(BM_BufferPool *const bm);
+void setHugePages(BM_HugePages hugePages);
+
+// Buffer Manager Interface Shared Pools
+RC initSharedPool(BM_BufferPool *const pool, const int numPages,
+                  ReplacementStrategy strategy, void *stratData);
+RC initSharedPoolEx(BM_BufferPool *const pool, const int numPages, const int frameSize,
+                    ReplacementStrategy strategy, void *stratData);
+RC attachBufferPool(BM_BufferPool *const bm, BM_BufferPool *const pool,
+                    const char *const pageFileName);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -69,6 +133,15 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
             const PageNumber pageNum);
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber startPage, const int numPages);
+
+// Buffer Manager Interface Checkpoints
+RC getDirtyPages (BM_BufferPool *const bm, PageNumber **pages, int *numPages);
+RC writeDirtyPage (BM_BufferPool *const bm, const PageNumber pageNum);
+RC setBeforeWriteHook (BM_BufferPool *const bm, BM_BeforeWriteFunc beforeWrite, void *context);
+
+// Frame of a pool, for the replacement strategies
+BM_Frame *getFrame (BM_PoolInfo *const pi, const int frameNum);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -76,5 +149,7 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getNumSyncs (BM_BufferPool *const bm);
+int getFrameSize (BM_BufferPool *const bm);
 
 #endif
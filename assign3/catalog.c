@@ -0,0 +1,620 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "catalog.h"
+#include "storage_mgr.h"
+#include "crc32c.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+/**Must declare RC returnCode in function before using ASSERT_RC_OK**/
+#define ASSERT_RC_OK(functionCall)  \
+    returnCode = functionCall;      \
+    if(returnCode != RC_OK )        \
+       return returnCode;
+
+/*********************************************************************
+Offset Macros for the catalog file header
+*********************************************************************/
+#define catNumTablesOffset CATALOG_MAGIC_SIZE
+#define catNumBytesOffset catNumTablesOffset + sizeof(unsigned int)
+#define catChecksumOffset catNumBytesOffset + sizeof(unsigned int)
+#define catEntriesOffset catChecksumOffset + sizeof(unsigned int)
+
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+//buckets of a hash map before it grows
+#define CATALOG_MIN_BUCKETS 64
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static unsigned int hashBytes(unsigned int hash, const void *bytes, size_t length);
+static unsigned int hashSchema(Schema *schema);
+static bool isSameSchema(Schema *schema, Schema *other);
+static Schema *internSchema(RM_Catalog *catalog, Schema *schema);
+static void unrefSchema(RM_Catalog *catalog, Schema *schema);
+static RM_CatalogEntry **findEntry(RM_Catalog *catalog, char *name);
+static void addEntry(RM_Catalog *catalog, char *name, Schema *schema, RM_PageLayout layout,
+                     int pageSize, unsigned short numSlotsPerPage);
+static void freeEntry(RM_Catalog *catalog, RM_CatalogEntry *entry);
+static void clearTables(RM_Catalog *catalog);
+static void growTables(RM_Catalog *catalog);
+static void growSchemas(RM_Catalog *catalog);
+static int getEntryBytes(RM_CatalogEntry *entry);
+static RC readCatalog(RM_Catalog *catalog);
+static RC writeCatalog(RM_Catalog *catalog);
+static unsigned short readUShort(char **data);
+static void writeUShort(char **data, unsigned short value);
+
+/*********************************************************************
+*
+*                         CATALOG FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+loadCatalog replaces the tables of the catalog with those of fileName,
+the file the catalog is saved to from now on. The catalog stays empty
+if the file doesn't exist yet or was never written, its tables are
+added again as they are opened. So does a file that is cut short or
+fails its checksum, e.g. torn by a crash while it was saved: it only
+caches the page file headers, it is saved over once tables are added
+again. A file that can't be opened is an error, the catalog is left
+empty and without a file then, so the file isn't saved over.
+*********************************************************************/
+RC loadCatalog (RM_Catalog *catalog, char *fileName)
+{
+    clearCatalog(catalog);
+    if(!fileName)
+        return RC_OK;
+    pthread_mutex_lock(&catalog->mutex);
+    VALID_CALLOC(char, catalogFile, strlen(fileName) + 1, sizeof(char));
+    strcpy(catalogFile, fileName);
+    catalog->fileName = catalogFile;
+    RC returnCode = pageFileExists(fileName) ? readCatalog(catalog) : RC_OK;
+    if(returnCode == RC_READ_FILE_FAILED || returnCode == RC_PAGE_CHECKSUM_FAILED)
+    {
+        clearTables(catalog);
+        returnCode = RC_OK;
+    }
+    if(returnCode != RC_OK)
+    {
+        clearTables(catalog);
+        free(catalog->fileName);
+        catalog->fileName = NULL;
+    }
+    pthread_mutex_unlock(&catalog->mutex);
+    return returnCode;
+}
+
+RC saveCatalog (RM_Catalog *catalog)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&catalog->mutex);
+    if(catalog->fileName && catalog->isDirty)
+        returnCode = writeCatalog(catalog);
+    if(returnCode == RC_OK)
+        catalog->isDirty = false;
+    pthread_mutex_unlock(&catalog->mutex);
+    return returnCode;
+}
+
+void clearCatalog (RM_Catalog *catalog)
+{
+    pthread_mutex_lock(&catalog->mutex);
+    clearTables(catalog);
+    //the schemas of open tables stay interned
+    if(catalog->numSchemas == 0)
+    {
+        free(catalog->schemas);
+        catalog->schemas = NULL;
+        catalog->numSchemaBuckets = 0;
+    }
+    free(catalog->fileName);
+    catalog->fileName = NULL;
+    catalog->isDirty = false;
+    pthread_mutex_unlock(&catalog->mutex);
+}
+
+/*********************************************************************
+addCatalogTable adds the table name, or replaces its entry. Added
+tables are saved by saveCatalog.
+*********************************************************************/
+void addCatalogTable (RM_Catalog *catalog, char *name, Schema *schema, RM_PageLayout layout,
+                      int pageSize, unsigned short numSlotsPerPage)
+{
+    pthread_mutex_lock(&catalog->mutex);
+    addEntry(catalog, name, schema, layout, pageSize, numSlotsPerPage);
+    catalog->isDirty = true;
+    pthread_mutex_unlock(&catalog->mutex);
+}
+
+//name and next of the copy are NULL
+bool findCatalogTable (RM_Catalog *catalog, char *name, RM_CatalogEntry *entry)
+{
+    pthread_mutex_lock(&catalog->mutex);
+    RM_CatalogEntry **found = findEntry(catalog, name);
+    bool isFound = found && *found;
+    if(isFound)
+    {
+        *entry = **found;
+        entry->name = NULL;
+        entry->next = NULL;
+        ((RM_SchemaRef *) entry->schema)->refCount++;
+    }
+    pthread_mutex_unlock(&catalog->mutex);
+    return isFound;
+}
+
+RC removeCatalogTable (RM_Catalog *catalog, char *name)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&catalog->mutex);
+    RM_CatalogEntry **found = findEntry(catalog, name);
+    if(found && *found)
+    {
+        RM_CatalogEntry *entry = *found;
+        *found = entry->next;
+        catalog->numTables--;
+        freeEntry(catalog, entry);
+        if(catalog->fileName)
+            returnCode = writeCatalog(catalog);
+        if(returnCode == RC_OK)
+            catalog->isDirty = false;
+    }
+    pthread_mutex_unlock(&catalog->mutex);
+    return returnCode;
+}
+
+void releaseSchema (RM_Catalog *catalog, Schema *schema)
+{
+    pthread_mutex_lock(&catalog->mutex);
+    unrefSchema(catalog, schema);
+    pthread_mutex_unlock(&catalog->mutex);
+}
+
+/*********************************************************************
+*
+*                         SCHEMA FUNCTIONS
+*
+*********************************************************************/
+
+//bytes writeSchema writes
+int getSchemaBytes (Schema *schema)
+{
+    int numBytes = (2 + 3*schema->numAttr + schema->keySize) * sizeof(unsigned short);
+    for(int i = 0; i < schema->numAttr; i++)
+        numBytes += strlen(schema->attrNames[i]);
+    return numBytes;
+}
+
+void writeSchema (Schema *schema, char *data)
+{
+    writeUShort(&data, (unsigned short) schema->numAttr);
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        writeUShort(&data, (unsigned short) schema->dataTypes[i]);
+        writeUShort(&data, (unsigned short) schema->typeLength[i]);
+    }
+    writeUShort(&data, (unsigned short) schema->keySize);
+    for(int i = 0; i < schema->keySize; i++)
+        writeUShort(&data, (unsigned short) schema->keyAttrs[i]);
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        unsigned short nameLength = (unsigned short) strlen(schema->attrNames[i]);
+        writeUShort(&data, nameLength);
+        memcpy(data, schema->attrNames[i], nameLength);
+        data += nameLength;
+    }
+}
+
+//reads the schema in one pass from the start
+void readSchema (char *data, Schema *schema)
+{
+    schema->numAttr = readUShort(&data);
+    VALID_CALLOC(char*, attrNames, schema->numAttr, sizeof(char*));
+    VALID_CALLOC(DataType, dataTypes, schema->numAttr, sizeof(DataType));
+    VALID_CALLOC(int, typeLength, schema->numAttr, sizeof(int));
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        unsigned short dataType = readUShort(&data);
+        dataTypes[i] = dataType <= DT_BOOL ? (DataType) dataType : DT_INT;
+        typeLength[i] = readUShort(&data);
+    }
+    schema->keySize = readUShort(&data);
+    VALID_CALLOC(int, keyAttrs, schema->keySize, sizeof(int));
+    for(int i = 0; i < schema->keySize; i++)
+        keyAttrs[i] = readUShort(&data);
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        unsigned short nameLength = readUShort(&data);
+        VALID_CALLOC(char, attrName, nameLength + 1, sizeof(char)); //room for null char
+        memcpy(attrName, data, nameLength);
+        data += nameLength;
+        attrNames[i] = attrName;
+    }
+    schema->attrNames = attrNames;
+    schema->dataTypes = dataTypes;
+    schema->typeLength = typeLength;
+    schema->keyAttrs = keyAttrs;
+}
+
+/*********************************************************************
+*
+*                        PRIVATE FUNCTIONS
+*
+*********************************************************************/
+
+//FNV-1a
+static unsigned int hashBytes(unsigned int hash, const void *bytes, size_t length)
+{
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= ((const unsigned char *) bytes)[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static unsigned int hashSchema(Schema *schema)
+{
+    unsigned int hash = hashBytes(FNV_OFFSET_BASIS, &schema->numAttr, sizeof(int));
+    hash = hashBytes(hash, schema->dataTypes, schema->numAttr * sizeof(DataType));
+    hash = hashBytes(hash, schema->typeLength, schema->numAttr * sizeof(int));
+    hash = hashBytes(hash, schema->keyAttrs, schema->keySize * sizeof(int));
+    for(int i = 0; i < schema->numAttr; i++)
+        hash = hashBytes(hash, schema->attrNames[i], strlen(schema->attrNames[i]) + 1);
+    return hash;
+}
+
+static bool isSameSchema(Schema *schema, Schema *other)
+{
+    if(schema->numAttr != other->numAttr || schema->keySize != other->keySize)
+        return false;
+    if(memcmp(schema->dataTypes, other->dataTypes, schema->numAttr * sizeof(DataType)) != 0 ||
+       memcmp(schema->typeLength, other->typeLength, schema->numAttr * sizeof(int)) != 0 ||
+       memcmp(schema->keyAttrs, other->keyAttrs, schema->keySize * sizeof(int)) != 0)
+        return false;
+    for(int i = 0; i < schema->numAttr; i++)
+        if(strcmp(schema->attrNames[i], other->attrNames[i]) != 0)
+            return false;
+    return true;
+}
+
+/*********************************************************************
+internSchema returns the interned schema equal to schema with a new
+reference, interning a copy if there is none yet.
+*********************************************************************/
+static Schema *internSchema(RM_Catalog *catalog, Schema *schema)
+{
+    unsigned int hash = hashSchema(schema);
+    if(catalog->numSchemaBuckets > 0)
+    {
+        RM_SchemaRef *ref = catalog->schemas[hash % catalog->numSchemaBuckets];
+        for(; ref; ref = ref->next)
+        {
+            if(ref->hash == hash && isSameSchema(&ref->schema, schema))
+            {
+                ref->refCount++;
+                return &ref->schema;
+            }
+        }
+    }
+    if(catalog->numSchemas >= catalog->numSchemaBuckets)
+        growSchemas(catalog);
+    VALID_CALLOC(RM_SchemaRef, ref, 1, sizeof(RM_SchemaRef));
+    VALID_CALLOC(char*, attrNames, schema->numAttr, sizeof(char*));
+    VALID_CALLOC(DataType, dataTypes, schema->numAttr, sizeof(DataType));
+    VALID_CALLOC(int, typeLength, schema->numAttr, sizeof(int));
+    VALID_CALLOC(int, keyAttrs, schema->keySize, sizeof(int));
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        VALID_CALLOC(char, attrName, strlen(schema->attrNames[i]) + 1, sizeof(char));
+        strcpy(attrName, schema->attrNames[i]);
+        attrNames[i] = attrName;
+    }
+    memcpy(dataTypes, schema->dataTypes, schema->numAttr * sizeof(DataType));
+    memcpy(typeLength, schema->typeLength, schema->numAttr * sizeof(int));
+    memcpy(keyAttrs, schema->keyAttrs, schema->keySize * sizeof(int));
+    ref->schema.numAttr = schema->numAttr;
+    ref->schema.attrNames = attrNames;
+    ref->schema.dataTypes = dataTypes;
+    ref->schema.typeLength = typeLength;
+    ref->schema.keyAttrs = keyAttrs;
+    ref->schema.keySize = schema->keySize;
+    ref->hash = hash;
+    ref->refCount = 1;
+    ref->next = catalog->schemas[hash % catalog->numSchemaBuckets];
+    catalog->schemas[hash % catalog->numSchemaBuckets] = ref;
+    catalog->numSchemas++;
+    return &ref->schema;
+}
+
+static void unrefSchema(RM_Catalog *catalog, Schema *schema)
+{
+    RM_SchemaRef *ref = (RM_SchemaRef *) schema;
+    if(--ref->refCount > 0)
+        return;
+    RM_SchemaRef **link = &catalog->schemas[ref->hash % catalog->numSchemaBuckets];
+    while(*link != ref)
+        link = &(*link)->next;
+    *link = ref->next;
+    catalog->numSchemas--;
+    //frees the arrays and ref, the schema is its first member
+    freeSchema(&ref->schema);
+}
+
+//the link to the entry of name, NULL if there are no buckets yet
+static RM_CatalogEntry **findEntry(RM_Catalog *catalog, char *name)
+{
+    if(catalog->numTableBuckets == 0)
+        return NULL;
+    unsigned int hash = hashBytes(FNV_OFFSET_BASIS, name, strlen(name));
+    RM_CatalogEntry **link = &catalog->tables[hash % catalog->numTableBuckets];
+    while(*link && strcmp((*link)->name, name) != 0)
+        link = &(*link)->next;
+    return link;
+}
+
+static void addEntry(RM_Catalog *catalog, char *name, Schema *schema, RM_PageLayout layout,
+                     int pageSize, unsigned short numSlotsPerPage)
+{
+    RM_CatalogEntry **found = findEntry(catalog, name);
+    if(found && *found)
+    {
+        RM_CatalogEntry *old = *found;
+        *found = old->next;
+        catalog->numTables--;
+        freeEntry(catalog, old);
+    }
+    if(catalog->numTables >= catalog->numTableBuckets)
+        growTables(catalog);
+    VALID_CALLOC(RM_CatalogEntry, entry, 1, sizeof(RM_CatalogEntry));
+    VALID_CALLOC(char, entryName, strlen(name) + 1, sizeof(char));
+    strcpy(entryName, name);
+    entry->name = entryName;
+    entry->schema = internSchema(catalog, schema);
+    entry->layout = layout;
+    entry->pageSize = pageSize;
+    entry->numSlotsPerPage = numSlotsPerPage;
+    unsigned int hash = hashBytes(FNV_OFFSET_BASIS, name, strlen(name));
+    entry->next = catalog->tables[hash % catalog->numTableBuckets];
+    catalog->tables[hash % catalog->numTableBuckets] = entry;
+    catalog->numTables++;
+}
+
+static void freeEntry(RM_Catalog *catalog, RM_CatalogEntry *entry)
+{
+    unrefSchema(catalog, entry->schema);
+    free(entry->name);
+    free(entry);
+}
+
+static void clearTables(RM_Catalog *catalog)
+{
+    for(int i = 0; i < catalog->numTableBuckets; i++)
+    {
+        while(catalog->tables[i])
+        {
+            RM_CatalogEntry *entry = catalog->tables[i];
+            catalog->tables[i] = entry->next;
+            freeEntry(catalog, entry);
+        }
+    }
+    free(catalog->tables);
+    catalog->tables = NULL;
+    catalog->numTableBuckets = 0;
+    catalog->numTables = 0;
+}
+
+//doubles the buckets of the tables
+static void growTables(RM_Catalog *catalog)
+{
+    int numBuckets = catalog->numTableBuckets > 0 ? 2*catalog->numTableBuckets : CATALOG_MIN_BUCKETS;
+    VALID_CALLOC(RM_CatalogEntry*, tables, numBuckets, sizeof(RM_CatalogEntry*));
+    for(int i = 0; i < catalog->numTableBuckets; i++)
+    {
+        while(catalog->tables[i])
+        {
+            RM_CatalogEntry *entry = catalog->tables[i];
+            catalog->tables[i] = entry->next;
+            unsigned int hash = hashBytes(FNV_OFFSET_BASIS, entry->name, strlen(entry->name));
+            entry->next = tables[hash % numBuckets];
+            tables[hash % numBuckets] = entry;
+        }
+    }
+    free(catalog->tables);
+    catalog->tables = tables;
+    catalog->numTableBuckets = numBuckets;
+}
+
+//doubles the buckets of the interned schemas
+static void growSchemas(RM_Catalog *catalog)
+{
+    int numBuckets = catalog->numSchemaBuckets > 0 ? 2*catalog->numSchemaBuckets : CATALOG_MIN_BUCKETS;
+    VALID_CALLOC(RM_SchemaRef*, schemas, numBuckets, sizeof(RM_SchemaRef*));
+    for(int i = 0; i < catalog->numSchemaBuckets; i++)
+    {
+        while(catalog->schemas[i])
+        {
+            RM_SchemaRef *ref = catalog->schemas[i];
+            catalog->schemas[i] = ref->next;
+            ref->next = schemas[ref->hash % numBuckets];
+            schemas[ref->hash % numBuckets] = ref;
+        }
+    }
+    free(catalog->schemas);
+    catalog->schemas = schemas;
+    catalog->numSchemaBuckets = numBuckets;
+}
+
+static int getEntryBytes(RM_CatalogEntry *entry)
+{
+    return 3*sizeof(unsigned short) + sizeof(unsigned int) + strlen(entry->name) +
+           getSchemaBytes(entry->schema);
+}
+
+/*********************************************************************
+readCatalog adds the tables of the catalog file, the mutex is held. A
+file without CATALOG_MAGIC, e.g. created by a save that didn't get to
+write it, holds no tables.
+RETURNS: RC_OK, an error of the storage manager, RC_READ_FILE_FAILED if
+         the file is cut short or RC_PAGE_CHECKSUM_FAILED
+*********************************************************************/
+static RC readCatalog(RM_Catalog *catalog)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    ASSERT_RC_OK(openPageFile(catalog->fileName, &fHandle));
+    int dataSize = fHandle.pageSize - PAGE_TRAILER_SIZE;
+    unsigned int numTables = 0, numBytes = 0, checksum = 0;
+    VALID_CALLOC(char, page, 1, fHandle.pageSize);
+    returnCode = readBlock(0, &fHandle, page);
+    bool isCatalog = returnCode == RC_OK && memcmp(page, CATALOG_MAGIC, CATALOG_MAGIC_SIZE) == 0;
+    if(isCatalog)
+    {
+        memcpy(&numTables, page + catNumTablesOffset, sizeof(unsigned int));
+        memcpy(&numBytes, page + catNumBytesOffset, sizeof(unsigned int));
+        memcpy(&checksum, page + catChecksumOffset, sizeof(unsigned int));
+    }
+    free(page);
+    long totalBytes = (long) (catEntriesOffset) + numBytes;
+    int numPages = (int) ((totalBytes + dataSize - 1) / dataSize);
+    if(isCatalog && numPages > fHandle.totalNumPages)
+        returnCode = RC_READ_FILE_FAILED;
+    if(returnCode != RC_OK || !isCatalog)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    VALID_CALLOC(char, data, numPages, fHandle.pageSize);
+    VALID_CALLOC(SM_PageHandle, pages, numPages, sizeof(SM_PageHandle));
+    for(int i = 0; i < numPages; i++)
+        pages[i] = data + (size_t) i * fHandle.pageSize;
+    returnCode = readBlocks(0, numPages, &fHandle, pages);
+    free(pages);
+    closePageFile(&fHandle);
+    //joins the data of the pages, see writeCatalog
+    for(int i = 1; i < numPages; i++)
+        memmove(data + (size_t) i * dataSize, data + (size_t) i * fHandle.pageSize, dataSize);
+    char *entries = data + catEntriesOffset;
+    if(returnCode == RC_OK && crc32c(0, entries, numBytes) != checksum)
+        returnCode = RC_PAGE_CHECKSUM_FAILED;
+    for(unsigned int i = 0; returnCode == RC_OK && i < numTables; i++)
+    {
+        unsigned short nameLength = readUShort(&entries);
+        VALID_CALLOC(char, name, nameLength + 1, sizeof(char));
+        memcpy(name, entries, nameLength);
+        entries += nameLength;
+        unsigned short layout = readUShort(&entries);
+        unsigned int pageSize;
+        memcpy(&pageSize, entries, sizeof(unsigned int));
+        entries += sizeof(unsigned int);
+        unsigned short numSlotsPerPage = readUShort(&entries);
+        VALID_CALLOC(Schema, schema, 1, sizeof(Schema));
+        readSchema(entries, schema);
+        entries += getSchemaBytes(schema);
+        addEntry(catalog, name, schema, (RM_PageLayout) layout, (int) pageSize, numSlotsPerPage);
+        freeSchema(schema);
+        free(name);
+    }
+    free(data);
+    return returnCode;
+}
+
+/*********************************************************************
+writeCatalog rewrites the catalog file, the mutex is held. The header
+and the entries go to the pages in chunks of all but the last
+PAGE_TRAILER_SIZE bytes of a page, the trailers are left to the
+storage manager for the page checksums.
+*********************************************************************/
+static RC writeCatalog(RM_Catalog *catalog)
+{
+    RC returnCode = RC_INIT;
+    unsigned int numBytes = 0;
+    for(int i = 0; i < catalog->numTableBuckets; i++)
+        for(RM_CatalogEntry *entry = catalog->tables[i]; entry; entry = entry->next)
+            numBytes += getEntryBytes(entry);
+    if(!pageFileExists(catalog->fileName))
+    {
+        ASSERT_RC_OK(createPageFile(catalog->fileName));
+    }
+    SM_FileHandle fHandle;
+    ASSERT_RC_OK(openPageFile(catalog->fileName, &fHandle));
+    int dataSize = fHandle.pageSize - PAGE_TRAILER_SIZE;
+    long totalBytes = (long) (catEntriesOffset) + numBytes;
+    int numPages = (int) ((totalBytes + dataSize - 1) / dataSize);
+    VALID_CALLOC(char, data, numPages, fHandle.pageSize);
+    char *entries = data + catEntriesOffset;
+    for(int i = 0; i < catalog->numTableBuckets; i++)
+    {
+        for(RM_CatalogEntry *entry = catalog->tables[i]; entry; entry = entry->next)
+        {
+            unsigned short nameLength = (unsigned short) strlen(entry->name);
+            writeUShort(&entries, nameLength);
+            memcpy(entries, entry->name, nameLength);
+            entries += nameLength;
+            writeUShort(&entries, (unsigned short) entry->layout);
+            unsigned int pageSize = (unsigned int) entry->pageSize;
+            memcpy(entries, &pageSize, sizeof(unsigned int));
+            entries += sizeof(unsigned int);
+            writeUShort(&entries, entry->numSlotsPerPage);
+            writeSchema(entry->schema, entries);
+            entries += getSchemaBytes(entry->schema);
+        }
+    }
+    unsigned int numTables = (unsigned int) catalog->numTables;
+    unsigned int checksum = crc32c(0, data + catEntriesOffset, numBytes);
+    memcpy(data, CATALOG_MAGIC, CATALOG_MAGIC_SIZE);
+    memcpy(data + catNumTablesOffset, &numTables, sizeof(unsigned int));
+    memcpy(data + catNumBytesOffset, &numBytes, sizeof(unsigned int));
+    memcpy(data + catChecksumOffset, &checksum, sizeof(unsigned int));
+    //spreads the data over the pages, last first so none is overwritten
+    for(int i = numPages - 1; i >= 0; i--)
+    {
+        char *pageData = data + (size_t) i * fHandle.pageSize;
+        memmove(pageData, data + (size_t) i * dataSize, dataSize);
+        memset(pageData + dataSize, 0, PAGE_TRAILER_SIZE);
+    }
+    VALID_CALLOC(SM_PageHandle, pages, numPages, sizeof(SM_PageHandle));
+    for(int i = 0; i < numPages; i++)
+        pages[i] = data + (size_t) i * fHandle.pageSize;
+    returnCode = ensureCapacity(numPages, &fHandle);
+    if(returnCode == RC_OK)
+        returnCode = writeBlocks(0, numPages, &fHandle, pages);
+    if(returnCode == RC_OK)
+        returnCode = syncPageFile(&fHandle);
+    RC closeCode = closePageFile(&fHandle);
+    free(pages);
+    free(data);
+    return returnCode != RC_OK ? returnCode : closeCode;
+}
+
+static unsigned short readUShort(char **data)
+{
+    unsigned short value;
+    memcpy(&value, *data, sizeof(unsigned short));
+    *data += sizeof(unsigned short);
+    return value;
+}
+
+static void writeUShort(char **data, unsigned short value)
+{
+    memcpy(*data, &value, sizeof(unsigned short));
+    *data += sizeof(unsigned short);
+}
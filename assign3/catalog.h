@@ -0,0 +1,95 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "dberror.h"
+#include "tables.h"
+#include "record_mgr.h"
+
+/*********************************************************************
+The system catalog describes the tables of the record manager: the
+schema, page layout, page size and slots per page of every table. It
+is a hash map by table name kept in memory, so openTable finds what it
+needs of a table it opened or created before without reading and
+decoding its PageFile header. A table that isn't in the catalog is
+added when it is first opened.
+
+Schemas are interned: all tables with the same attributes, types and
+keys share one Schema, counted by the catalog entries and the open
+tables that use it. It is freed once the last of them lets it go, so
+the Schema of an open table must not be freed or changed by callers.
+
+The catalog can be kept in a page file (catalog_file in config.h, a
+relation of a tablespace works too). It is loaded by initRecordManager,
+saved by shutdownRecordManager, and right away when a table is deleted
+or created over, so the file never describes a table that changed.
+Tables must be created and deleted through the record manager while
+it uses the file. A file that was never written holds no tables, they
+are added again as they are opened, as are those of one that a crash
+during a save left failing its checksum. The pages hold, all but their
+trailers:
+page 0+: char magic[8] | uint numTables | uint numBytes | uint checksum |
+         entries of numBytes bytes, over as many pages as they need
+entry:   ushort nameLength | char name[nameLength] | ushort pageLayout |
+         uint pageSize | ushort numSlotsPerPage | schema
+The checksum is the CRC32C of the entries. Schemas are written like in
+the PageFile header (see preparePFHdr), by writeSchema.
+*********************************************************************/
+#define CATALOG_MAGIC "RMCATLG1"
+#define CATALOG_MAGIC_SIZE 8
+
+// a Schema of the catalog is the first member of its RM_SchemaRef
+typedef struct RM_SchemaRef {
+    Schema schema;
+    unsigned int hash;
+    int refCount;
+    struct RM_SchemaRef *next;
+} RM_SchemaRef;
+
+typedef struct RM_CatalogEntry {
+    char *name;
+    Schema *schema;     //interned
+    RM_PageLayout layout;
+    int pageSize;       //bytes of the pages of the page file
+    unsigned short numSlotsPerPage;
+    struct RM_CatalogEntry *next;
+} RM_CatalogEntry;
+
+typedef struct RM_Catalog {
+    pthread_mutex_t mutex;
+    RM_CatalogEntry **tables; //hash buckets by name
+    int numTableBuckets;
+    int numTables;
+    RM_SchemaRef **schemas;   //hash buckets by contents
+    int numSchemaBuckets;
+    int numSchemas;
+    char *fileName;           //page file of the catalog, NULL to keep it in memory only
+    bool isDirty;             //tables were added since it was saved
+} RM_Catalog;
+
+#define RM_CATALOG_INITIALIZER {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, NULL, 0, 0, NULL, false}
+
+// fileName may be NULL, a missing file gives an empty catalog
+extern RC loadCatalog (RM_Catalog *catalog, char *fileName);
+// saves the catalog if tables were added since it was loaded
+extern RC saveCatalog (RM_Catalog *catalog);
+// forgets the tables, interned schemas stay until they are released
+extern void clearCatalog (RM_Catalog *catalog);
+
+// the catalog interns its own copy of schema
+extern void addCatalogTable (RM_Catalog *catalog, char *name, Schema *schema, RM_PageLayout layout,
+                             int pageSize, unsigned short numSlotsPerPage);
+// copies the entry of name, its schema is acquired and must be released
+extern bool findCatalogTable (RM_Catalog *catalog, char *name, RM_CatalogEntry *entry);
+// saves the catalog if the table was in it
+extern RC removeCatalogTable (RM_Catalog *catalog, char *name);
+extern void releaseSchema (RM_Catalog *catalog, Schema *schema);
+
+// schemas in the format of the PageFile header
+extern int getSchemaBytes (Schema *schema);
+extern void writeSchema (Schema *schema, char *data);
+// allocates the arrays of schema
+extern void readSchema (char *data, Schema *schema);
+
+#endif // CATALOG_H
@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "storage_mgr.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+/**Must declare RC returnCode in function before using ASSERT_RC_OK**/
+#define ASSERT_RC_OK(functionCall)  \
+    returnCode = functionCall;      \
+    if(returnCode != RC_OK )        \
+       return returnCode;
+
+//how long the writer waits before retrying pages that are pinned
+#define PINNED_RETRY_USEC 1000
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static void *checkpointWriter(void *arg);
+static RC writeCheckpointPages(RM_Checkpointer *checkpointer);
+static RC syncCheckpoint(RM_Checkpointer *checkpointer);
+static long long getTime(void);
+
+/*********************************************************************
+*
+*                     CHECKPOINTER FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+startCheckpointer starts the writer thread for the pages of bufferPool
+whose changes are logged in log
+*********************************************************************/
+RC startCheckpointer (RM_Checkpointer *checkpointer, BM_BufferPool *bufferPool,
+                      LM_LogHandle *log, long writeDelay)
+{
+    memset(checkpointer, 0, sizeof(RM_Checkpointer));
+    checkpointer->bufferPool = bufferPool;
+    checkpointer->log = log;
+    checkpointer->writeDelay = writeDelay;
+    checkpointer->returnCode = RC_OK;
+    pthread_mutex_init(&checkpointer->mutex, NULL);
+    pthread_cond_init(&checkpointer->changed, NULL);
+    if(pthread_create(&checkpointer->writer, NULL, checkpointWriter, checkpointer) != 0)
+    {
+        pthread_mutex_destroy(&checkpointer->mutex);
+        pthread_cond_destroy(&checkpointer->changed);
+        return RC_RM_INIT_ERROR;
+    }
+    return RC_OK;
+}
+
+RC stopCheckpointer (RM_Checkpointer *checkpointer)
+{
+    pthread_mutex_lock(&checkpointer->mutex);
+    checkpointer->stop = true;
+    pthread_cond_broadcast(&checkpointer->changed);
+    pthread_mutex_unlock(&checkpointer->mutex);
+    pthread_join(checkpointer->writer, NULL);
+    pthread_mutex_destroy(&checkpointer->mutex);
+    pthread_cond_destroy(&checkpointer->changed);
+    free(checkpointer->pages);
+    checkpointer->pages = NULL;
+    return RC_OK;
+}
+
+/*********************************************************************
+beginCheckpoint takes the dirty pages after the caller took the
+checkpoint LSN, which must not be beyond the last appended record. A
+record up to the LSN has changed its page before it was appended, and
+the page was marked dirty before that and stays pinned until the
+change is done, so the change is either in the page file already or on
+one of the pages. The LSN may be lower,
+e.g. to keep records that recovery needs to undo.
+*********************************************************************/
+RC beginCheckpoint (RM_Checkpointer *checkpointer, LM_LSN lsn)
+{
+    RC returnCode = RC_INIT;
+    pthread_mutex_lock(&checkpointer->mutex);
+    if(checkpointer->isRunning || checkpointer->stop)
+    {
+        pthread_mutex_unlock(&checkpointer->mutex);
+        return RC_OK;
+    }
+    free(checkpointer->pages);
+    checkpointer->pages = NULL;
+    checkpointer->beginTime = getTime();
+    checkpointer->lsn = lsn;
+    returnCode = getDirtyPages(checkpointer->bufferPool, &checkpointer->pages,
+                               &checkpointer->numPages);
+    if(returnCode == RC_OK)
+    {
+        checkpointer->numPagesDone = 0;
+        checkpointer->isRunning = true;
+        pthread_cond_broadcast(&checkpointer->changed);
+    }
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return returnCode;
+}
+
+RC waitForCheckpoint (RM_Checkpointer *checkpointer)
+{
+    pthread_mutex_lock(&checkpointer->mutex);
+    while(checkpointer->isRunning && !checkpointer->stop)
+        pthread_cond_wait(&checkpointer->changed, &checkpointer->mutex);
+    RC returnCode = checkpointer->returnCode;
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return returnCode;
+}
+
+/*********************************************************************
+*
+*                      STATISTICS INTERFACE
+*
+*********************************************************************/
+int getNumCheckpoints (RM_Checkpointer *checkpointer)
+{
+    pthread_mutex_lock(&checkpointer->mutex);
+    int numCheckpoints = checkpointer->numCheckpoints;
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return numCheckpoints;
+}
+
+//microseconds from beginning to completing the last checkpoint
+long long getCheckpointDuration (RM_Checkpointer *checkpointer)
+{
+    pthread_mutex_lock(&checkpointer->mutex);
+    long long duration = checkpointer->lastDuration;
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return duration;
+}
+
+//pages the last checkpoint had to write
+int getNumCheckpointPages (RM_Checkpointer *checkpointer)
+{
+    pthread_mutex_lock(&checkpointer->mutex);
+    int numPages = checkpointer->lastNumPages;
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return numPages;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+
+static void *checkpointWriter(void *arg)
+{
+    RM_Checkpointer *checkpointer = (RM_Checkpointer *) arg;
+    pthread_mutex_lock(&checkpointer->mutex);
+    while(!checkpointer->stop)
+    {
+        if(!checkpointer->isRunning)
+        {
+            pthread_cond_wait(&checkpointer->changed, &checkpointer->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&checkpointer->mutex);
+        RC returnCode = writeCheckpointPages(checkpointer);
+        if(returnCode == RC_OK)
+            returnCode = syncCheckpoint(checkpointer);
+        pthread_mutex_lock(&checkpointer->mutex);
+        //a stopped checkpoint didn't complete
+        if(returnCode == RC_RM_INIT_ERROR && checkpointer->stop)
+            break;
+        checkpointer->returnCode = returnCode;
+        checkpointer->isRunning = false;
+        if(returnCode == RC_OK)
+        {
+            checkpointer->numCheckpoints++;
+            checkpointer->lastDuration = getTime() - checkpointer->beginTime;
+            checkpointer->lastNumPages = checkpointer->numPages;
+        }
+        pthread_cond_broadcast(&checkpointer->changed);
+    }
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return NULL;
+}
+
+/*********************************************************************
+writeCheckpointPages writes the pages of the running checkpoint. Pages
+in use are moved behind the others and retried later.
+RETURNS: RC_RM_INIT_ERROR if the checkpointer is stopped meanwhile
+*********************************************************************/
+static RC writeCheckpointPages(RM_Checkpointer *checkpointer)
+{
+    int numPinned = 0;
+    while(true)
+    {
+        pthread_mutex_lock(&checkpointer->mutex);
+        bool stop = checkpointer->stop;
+        int pageIndex = checkpointer->numPagesDone;
+        bool isDone = pageIndex == checkpointer->numPages;
+        PageNumber pageNum = isDone ? NO_PAGE : checkpointer->pages[pageIndex];
+        pthread_mutex_unlock(&checkpointer->mutex);
+        if(stop)
+            return RC_RM_INIT_ERROR;
+        if(isDone)
+            return RC_OK;
+
+        RC returnCode = writeDirtyPage(checkpointer->bufferPool, pageNum);
+        pthread_mutex_lock(&checkpointer->mutex);
+        if(returnCode == RC_OK)
+        {
+            checkpointer->numPagesDone++;
+            numPinned = 0;
+        }
+        else if(returnCode == RC_BM_PAGE_PINNED)
+        {
+            //swap the page with the last one
+            int last = checkpointer->numPages - 1;
+            checkpointer->pages[pageIndex] = checkpointer->pages[last];
+            checkpointer->pages[last] = pageNum;
+            numPinned++;
+        }
+        int numLeft = checkpointer->numPages - checkpointer->numPagesDone;
+        long writeDelay = checkpointer->writeDelay;
+        pthread_mutex_unlock(&checkpointer->mutex);
+        if(returnCode != RC_OK && returnCode != RC_BM_PAGE_PINNED)
+            return returnCode;
+        if(returnCode == RC_OK && writeDelay > 0)
+            usleep(writeDelay);
+        //every page that is left is in use
+        if(numPinned >= numLeft && numPinned > 0)
+        {
+            usleep(PINNED_RETRY_USEC);
+            numPinned = 0;
+        }
+    }
+}
+
+//makes the written pages durable and lets recovery skip their records
+static RC syncCheckpoint(RM_Checkpointer *checkpointer)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    ASSERT_RC_OK(openPageFile(checkpointer->bufferPool->pageFile, &fHandle));
+    returnCode = syncPageFile(&fHandle);
+    if(returnCode != RC_OK)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    ASSERT_RC_OK(closePageFile(&fHandle));
+    return setRedoLsn(checkpointer->log, checkpointer->lsn);
+}
+
+static long long getTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
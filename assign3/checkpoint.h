@@ -0,0 +1,59 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "dberror.h"
+#include "buffer_mgr.h"
+#include "log_mgr.h"
+
+/*********************************************************************
+A checkpoint bounds the part of the write-ahead log that recovery has
+to redo, without stopping the table to flush the buffer pool. It is
+fuzzy: beginCheckpoint only takes an LSN up to which records are
+appended and the pages of the pool that may hold changes up to it, i.e. the
+dirty or pinned ones. A background writer writes these pages one at a
+time with writeDirtyPage while records are still changed. Once all of
+them are in the page file, it syncs the file and moves the redo LSN of
+the log to the checkpoint LSN. A checkpoint that is stopped before
+that leaves the log as it was.
+
+Every table has a checkpointer with its own writer thread while it is
+open.
+*********************************************************************/
+typedef struct RM_Checkpointer {
+    BM_BufferPool *bufferPool;
+    LM_LogHandle *log;
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;   //signaled when a checkpoint begins or ends
+    bool isRunning;
+    bool stop;
+    LM_LSN lsn;               //redo LSN of the running checkpoint
+    PageNumber *pages;        //pages the running checkpoint has to write
+    int numPages;
+    int numPagesDone;
+    long long beginTime;      //microseconds
+    RC returnCode;            //result of the last checkpoint
+    int numCheckpoints;       //completed checkpoints
+    long long lastDuration;   //microseconds of the last completed checkpoint
+    int lastNumPages;         //pages of the last completed checkpoint
+    long writeDelay;          //microseconds the writer pauses after a page
+} RM_Checkpointer;
+
+// writeDelay throttles the writer, so it takes less IO from the table
+extern RC startCheckpointer (RM_Checkpointer *checkpointer, BM_BufferPool *bufferPool,
+                             LM_LogHandle *log, long writeDelay);
+// stops the writer and gives up a running checkpoint
+extern RC stopCheckpointer (RM_Checkpointer *checkpointer);
+// begins a checkpoint that lets recovery start at lsn, unless one is running
+extern RC beginCheckpoint (RM_Checkpointer *checkpointer, LM_LSN lsn);
+// waits until the running checkpoint has completed
+extern RC waitForCheckpoint (RM_Checkpointer *checkpointer);
+
+// Statistics Interface
+extern int getNumCheckpoints (RM_Checkpointer *checkpointer);
+extern long long getCheckpointDuration (RM_Checkpointer *checkpointer);
+extern int getNumCheckpointPages (RM_Checkpointer *checkpointer);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,472 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "column_codec.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+//dictionaries with more entries than this are not worth building
+#define MAX_DICT_ENTRIES 1024
+//runs are stored in an unsigned short
+#define MAX_RUN_LENGTH 65535
+
+#define encodingOffset 0
+#define blockSizeOffset sizeof(unsigned char)
+#define payloadOffset COLUMN_BLOCK_HDR_SIZE
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static int encodePlain(int typeLength, char *values, int numValues, char *dest, int capacity);
+static int encodeFOR(char *values, int numValues, char *dest, int capacity, int maxSize);
+static int encodeDict(int typeLength, char *values, int numValues, char *dest, int capacity, int maxSize);
+static int encodeRLE(char *values, int numValues, char *dest, int capacity, int maxSize);
+static void setBlockHdr(char *block, RM_ColumnEncoding encoding, int blockSize);
+static int bitsNeeded(unsigned long long maxValue);
+static void packBits(unsigned char *dest, int idx, int bitWidth, unsigned int value);
+static unsigned int unpackBits(unsigned char *src, int idx, int bitWidth);
+static bool compareValue(Value *attrVal, OpType op, bool consOnLeft, Value *cons);
+
+/*********************************************************************
+*
+*                        ENCODING FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+encodeColumn writes the values of one minipage as a column block,
+using the encoding of dt whenever it is smaller than the plain values
+INPUT:
+    dt, typeLength: type of the attribute
+    *values: numValues values of typeLength bytes each
+    *dest: where the block is written
+    capacity: number of bytes available at dest
+RETURNS: size of the block or -1 if it doesn't fit in capacity
+*********************************************************************/
+int encodeColumn (DataType dt, int typeLength, char *values, int numValues,
+                  char *dest, int capacity)
+{
+    int plainSize = COLUMN_BLOCK_HDR_SIZE + numValues*typeLength;
+    int blockSize = -1;
+    switch(dt)
+    {
+    case DT_INT:
+        blockSize = encodeFOR(values, numValues, dest, capacity, plainSize);
+        break;
+    case DT_STRING:
+        blockSize = encodeDict(typeLength, values, numValues, dest, capacity, plainSize);
+        break;
+    case DT_BOOL:
+        blockSize = encodeRLE(values, numValues, dest, capacity, plainSize);
+        break;
+    case DT_FLOAT:
+        break;
+    }
+    if(blockSize > 0)
+        return blockSize;
+    return encodePlain(typeLength, values, numValues, dest, capacity);
+}
+
+static int encodePlain(int typeLength, char *values, int numValues, char *dest, int capacity)
+{
+    int blockSize = COLUMN_BLOCK_HDR_SIZE + numValues*typeLength;
+    if(blockSize > capacity)
+        return -1;
+    setBlockHdr(dest, ENC_PLAIN, blockSize);
+    memcpy(dest + payloadOffset, values, numValues*typeLength);
+    return blockSize;
+}
+
+/*********************************************************************
+Frame of reference: every value is stored as value - base in bitWidth
+bits, where base is the smallest value of the minipage
+*********************************************************************/
+static int encodeFOR(char *values, int numValues, char *dest, int capacity, int maxSize)
+{
+    if(numValues == 0)
+        return -1;
+    int value, base, max;
+    memcpy(&base, values, sizeof(int));
+    max = base;
+    for(int i = 1; i < numValues; i++)
+    {
+        memcpy(&value, values + i*sizeof(int), sizeof(int));
+        if(value < base)
+            base = value;
+        if(value > max)
+            max = value;
+    }
+    unsigned char bitWidth = (unsigned char) bitsNeeded((unsigned long long)((long long)max - base));
+    int blockSize = payloadOffset + sizeof(int) + sizeof(unsigned char) + (numValues*bitWidth + 7)/8;
+    if(blockSize >= maxSize || blockSize > capacity)
+        return -1;
+    setBlockHdr(dest, ENC_FOR, blockSize);
+    char *curOffset = dest + payloadOffset;
+    memcpy(curOffset, &base, sizeof(int));
+    curOffset += sizeof(int);
+    memcpy(curOffset, &bitWidth, sizeof(unsigned char));
+    curOffset += sizeof(unsigned char);
+    memset(curOffset, 0, (numValues*bitWidth + 7)/8);
+    for(int i = 0; i < numValues; i++)
+    {
+        memcpy(&value, values + i*sizeof(int), sizeof(int));
+        packBits((unsigned char *) curOffset, i, bitWidth, (unsigned int)((long long)value - base));
+    }
+    return blockSize;
+}
+
+/*********************************************************************
+Dictionary: the distinct values of the minipage are stored once in
+order of first appearance and every slot stores the code (index) of
+its value in codeBits bits. Distinct values are found with a small
+open addressing hash table.
+*********************************************************************/
+static int encodeDict(int typeLength, char *values, int numValues, char *dest, int capacity, int maxSize)
+{
+    if(numValues == 0)
+        return -1;
+    int tableSize = 2*MAX_DICT_ENTRIES;
+    VALID_CALLOC(int, hashTable, tableSize, sizeof(int)); //entry+1, 0 is empty
+    VALID_CALLOC(int, entries, MAX_DICT_ENTRIES, sizeof(int)); //index of first value
+    VALID_CALLOC(unsigned short, codes, numValues, sizeof(unsigned short));
+    int numEntries = 0;
+    for(int i = 0; i < numValues && numEntries <= MAX_DICT_ENTRIES; i++)
+    {
+        char *value = values + i*typeLength;
+        //FNV-1a hash of the value
+        unsigned int hash = 2166136261u;
+        for(int j = 0; j < typeLength; j++)
+            hash = (hash ^ (unsigned char) value[j]) * 16777619u;
+        int pos = hash & (tableSize - 1);
+        while(hashTable[pos] != 0 &&
+                memcmp(values + entries[hashTable[pos]-1]*typeLength, value, typeLength) != 0)
+            pos = (pos + 1) & (tableSize - 1);
+        if(hashTable[pos] == 0)
+        {
+            if(numEntries == MAX_DICT_ENTRIES)
+            {
+                numEntries++;
+                break;
+            }
+            entries[numEntries] = i;
+            hashTable[pos] = ++numEntries;
+        }
+        codes[i] = hashTable[pos] - 1;
+    }
+    int blockSize = -1;
+    if(numEntries <= MAX_DICT_ENTRIES)
+    {
+        unsigned char codeBits = (unsigned char) bitsNeeded(numEntries - 1);
+        blockSize = payloadOffset + sizeof(unsigned short) + sizeof(unsigned char)
+                    + numEntries*typeLength + (numValues*codeBits + 7)/8;
+        if(blockSize >= maxSize || blockSize > capacity)
+            blockSize = -1;
+        else
+        {
+            unsigned short dictSize = (unsigned short) numEntries;
+            setBlockHdr(dest, ENC_DICT, blockSize);
+            char *curOffset = dest + payloadOffset;
+            memcpy(curOffset, &dictSize, sizeof(unsigned short));
+            curOffset += sizeof(unsigned short);
+            memcpy(curOffset, &codeBits, sizeof(unsigned char));
+            curOffset += sizeof(unsigned char);
+            for(int i = 0; i < numEntries; i++)
+            {
+                memcpy(curOffset, values + entries[i]*typeLength, typeLength);
+                curOffset += typeLength;
+            }
+            memset(curOffset, 0, (numValues*codeBits + 7)/8);
+            for(int i = 0; i < numValues; i++)
+                packBits((unsigned char *) curOffset, i, codeBits, codes[i]);
+        }
+    }
+    free(hashTable);
+    free(entries);
+    free(codes);
+    return blockSize;
+}
+
+/*********************************************************************
+Run-length encoding of bool values
+*********************************************************************/
+static int encodeRLE(char *values, int numValues, char *dest, int capacity, int maxSize)
+{
+    unsigned short numRuns = 0;
+    for(int i = 0; i < numValues; i++)
+    {
+        if(i == 0 || values[i] != values[i-1])
+            numRuns++;
+    }
+    //long runs are split, so count them as they are written
+    int blockSize = payloadOffset + sizeof(unsigned short)
+                    + (numRuns + numValues/MAX_RUN_LENGTH)*(sizeof(unsigned short) + sizeof(char));
+    if(numValues == 0 || blockSize >= maxSize || blockSize > capacity)
+        return -1;
+    char *runs = dest + payloadOffset + sizeof(unsigned short);
+    numRuns = 0;
+    for(int i = 0; i < numValues;)
+    {
+        unsigned short runLength = 0;
+        char value = values[i];
+        while(i < numValues && values[i] == value && runLength < MAX_RUN_LENGTH)
+        {
+            runLength++;
+            i++;
+        }
+        memcpy(runs, &runLength, sizeof(unsigned short));
+        runs += sizeof(unsigned short);
+        *runs++ = value;
+        numRuns++;
+    }
+    memcpy(dest + payloadOffset, &numRuns, sizeof(unsigned short));
+    blockSize = runs - dest;
+    setBlockHdr(dest, ENC_RLE, blockSize);
+    return blockSize;
+}
+
+/*********************************************************************
+*
+*                        DECODING FUNCTIONS
+*
+*********************************************************************/
+void decodeColumn (DataType dt, int typeLength, char *block, int numValues, char *values)
+{
+    if(getColumnEncoding(block) == ENC_PLAIN)
+    {
+        memcpy(values, block + payloadOffset, numValues*typeLength);
+        return;
+    }
+    for(int i = 0; i < numValues; i++)
+        decodeColumnValue(dt, typeLength, block, i, values + i*typeLength);
+}
+
+void decodeColumnValue (DataType dt, int typeLength, char *block, int idx, char *value)
+{
+    char *payload = block + payloadOffset;
+    switch(getColumnEncoding(block))
+    {
+    case ENC_PLAIN:
+        memcpy(value, payload + idx*typeLength, typeLength);
+        break;
+    case ENC_FOR:
+    {
+        int base;
+        unsigned char bitWidth;
+        memcpy(&base, payload, sizeof(int));
+        memcpy(&bitWidth, payload + sizeof(int), sizeof(unsigned char));
+        unsigned char *packed = (unsigned char *) payload + sizeof(int) + sizeof(unsigned char);
+        int result = (int)((long long)base + unpackBits(packed, idx, bitWidth));
+        memcpy(value, &result, sizeof(int));
+        break;
+    }
+    case ENC_DICT:
+    {
+        unsigned short numEntries;
+        unsigned char codeBits;
+        memcpy(&numEntries, payload, sizeof(unsigned short));
+        memcpy(&codeBits, payload + sizeof(unsigned short), sizeof(unsigned char));
+        char *entries = payload + sizeof(unsigned short) + sizeof(unsigned char);
+        unsigned char *codes = (unsigned char *) entries + numEntries*typeLength;
+        memcpy(value, entries + unpackBits(codes, idx, codeBits)*typeLength, typeLength);
+        break;
+    }
+    case ENC_RLE:
+    {
+        unsigned short numRuns, runLength;
+        memcpy(&numRuns, payload, sizeof(unsigned short));
+        char *runs = payload + sizeof(unsigned short);
+        for(int i = 0; i < numRuns; i++)
+        {
+            memcpy(&runLength, runs, sizeof(unsigned short));
+            if(idx < runLength)
+            {
+                *value = runs[sizeof(unsigned short)];
+                break;
+            }
+            idx -= runLength;
+            runs += sizeof(unsigned short) + sizeof(char);
+        }
+        break;
+    }
+    }
+}
+
+RM_ColumnEncoding getColumnEncoding (char *block)
+{
+    return (RM_ColumnEncoding) (unsigned char) block[encodingOffset];
+}
+
+int getColumnBlockSize (char *block)
+{
+    unsigned short blockSize;
+    memcpy(&blockSize, block + blockSizeOffset, sizeof(unsigned short));
+    return blockSize;
+}
+
+/*********************************************************************
+*
+*                      FILTERING ENCODED DATA
+*
+*********************************************************************/
+
+/*********************************************************************
+filterColumn evaluates a comparison between the attribute stored in
+block and a constant for all numValues slots and stores the result in
+matches. It works on the encoded data:
+DICT: the comparison is evaluated once per dictionary entry and the
+      slots look the result up by their code
+FOR:  the constant is moved into the frame (cons - base) and compared
+      with the packed offsets
+RLE:  the comparison is evaluated once per run
+RETURNS: false if the block is PLAIN or the types don't match
+*********************************************************************/
+bool filterColumn (DataType dt, int typeLength, char *block, int numValues,
+                   OpType op, bool consOnLeft, Value *cons, bool *matches)
+{
+    if(cons->dt != dt || (op != OP_COMP_EQUAL && op != OP_COMP_SMALLER))
+        return false;
+    char *payload = block + payloadOffset;
+    switch(getColumnEncoding(block))
+    {
+    case ENC_FOR:
+    {
+        int base;
+        unsigned char bitWidth;
+        memcpy(&base, payload, sizeof(int));
+        memcpy(&bitWidth, payload + sizeof(int), sizeof(unsigned char));
+        unsigned char *packed = (unsigned char *) payload + sizeof(int) + sizeof(unsigned char);
+        long long consOffset = (long long)cons->v.intV - base;
+        for(int i = 0; i < numValues; i++)
+        {
+            long long offset = unpackBits(packed, i, bitWidth);
+            if(op == OP_COMP_EQUAL)
+                matches[i] = (offset == consOffset);
+            else if(consOnLeft)
+                matches[i] = (consOffset < offset);
+            else
+                matches[i] = (offset < consOffset);
+        }
+        return true;
+    }
+    case ENC_DICT:
+    {
+        unsigned short numEntries;
+        unsigned char codeBits;
+        memcpy(&numEntries, payload, sizeof(unsigned short));
+        memcpy(&codeBits, payload + sizeof(unsigned short), sizeof(unsigned char));
+        char *entries = payload + sizeof(unsigned short) + sizeof(unsigned char);
+        unsigned char *codes = (unsigned char *) entries + numEntries*typeLength;
+        VALID_CALLOC(bool, entryMatches, numEntries, sizeof(bool));
+        VALID_CALLOC(char, entry, typeLength + 1, sizeof(char));
+        Value attrVal;
+        attrVal.dt = DT_STRING;
+        attrVal.v.stringV = entry;
+        for(int i = 0; i < numEntries; i++)
+        {
+            memcpy(entry, entries + i*typeLength, typeLength);
+            entryMatches[i] = compareValue(&attrVal, op, consOnLeft, cons);
+        }
+        for(int i = 0; i < numValues; i++)
+            matches[i] = entryMatches[unpackBits(codes, i, codeBits)];
+        free(entry);
+        free(entryMatches);
+        return true;
+    }
+    case ENC_RLE:
+    {
+        unsigned short numRuns, runLength;
+        memcpy(&numRuns, payload, sizeof(unsigned short));
+        char *runs = payload + sizeof(unsigned short);
+        Value attrVal;
+        attrVal.dt = DT_BOOL;
+        for(int i = 0, slot = 0; i < numRuns; i++)
+        {
+            memcpy(&runLength, runs, sizeof(unsigned short));
+            attrVal.v.boolV = runs[sizeof(unsigned short)];
+            bool runMatches = compareValue(&attrVal, op, consOnLeft, cons);
+            for(int j = 0; j < runLength && slot < numValues; j++)
+                matches[slot++] = runMatches;
+            runs += sizeof(unsigned short) + sizeof(char);
+        }
+        return true;
+    }
+    case ENC_PLAIN:
+        break;
+    }
+    return false;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+static void setBlockHdr(char *block, RM_ColumnEncoding encoding, int blockSize)
+{
+    unsigned short size = (unsigned short) blockSize;
+    block[encodingOffset] = (char) encoding;
+    memcpy(block + blockSizeOffset, &size, sizeof(unsigned short));
+}
+
+static int bitsNeeded(unsigned long long maxValue)
+{
+    int bits = 0;
+    while(bits < 32 && (1ULL << bits) <= maxValue)
+        bits++;
+    return bits;
+}
+
+/*********************************************************************
+packBits/unpackBits store the idx-th value of an array of bitWidth bit
+values (bitWidth <= 32), least significant bit first. dest must be
+zeroed before values are packed into it.
+*********************************************************************/
+static void packBits(unsigned char *dest, int idx, int bitWidth, unsigned int value)
+{
+    unsigned long long bitPos = (unsigned long long)idx * bitWidth;
+    unsigned long long bits = value;
+    unsigned char *byte = dest + (bitPos >> 3);
+    bits <<= (bitPos & 7);
+    for(int remaining = (bitPos & 7) + bitWidth; remaining > 0; remaining -= 8)
+    {
+        *byte++ |= (unsigned char) bits;
+        bits >>= 8;
+    }
+}
+
+static unsigned int unpackBits(unsigned char *src, int idx, int bitWidth)
+{
+    if(bitWidth == 0)
+        return 0;
+    unsigned long long bitPos = (unsigned long long)idx * bitWidth;
+    unsigned char *byte = src + (bitPos >> 3);
+    int shift = bitPos & 7;
+    unsigned long long bits = 0;
+    for(int i = 0; i*8 < shift + bitWidth; i++)
+        bits |= ((unsigned long long) byte[i]) << (8*i);
+    return (unsigned int)((bits >> shift) & ((1ULL << bitWidth) - 1));
+}
+
+static bool compareValue(Value *attrVal, OpType op, bool consOnLeft, Value *cons)
+{
+    Value result;
+    if(op == OP_COMP_EQUAL)
+        valueEquals(attrVal, cons, &result);
+    else if(consOnLeft)
+        valueSmaller(cons, attrVal, &result);
+    else
+        valueSmaller(attrVal, cons, &result);
+    return result.v.boolV;
+}
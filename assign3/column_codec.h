@@ -0,0 +1,50 @@
+#ifndef COLUMN_CODEC_H
+#define COLUMN_CODEC_H
+
+#include <stdbool.h>
+#include "dberror.h"
+#include "tables.h"
+#include "expr.h"
+
+/*********************************************************************
+Lightweight column encodings used by compressed PAX pages. Every
+minipage is stored as a column block:
+
+---------------------------------------------------------------------------
+uchar encoding | ushort blockSize | payload ... |
+---------------------------------------------------------------------------
+PLAIN: numValues * typeLength bytes
+DICT:  ushort numEntries | uchar codeBits | entries | packed codes
+FOR:   int base | uchar bitWidth | packed (value - base)
+RLE:   ushort numRuns | (ushort runLength | uchar value) * numRuns
+
+blockSize includes the 3 byte block header.
+*********************************************************************/
+typedef enum RM_ColumnEncoding {
+    ENC_PLAIN = 0,
+    ENC_DICT = 1, // dictionary of distinct values, for DT_STRING
+    ENC_FOR = 2,  // frame-of-reference and bit-packing, for DT_INT
+    ENC_RLE = 3   // run-length encoding, for DT_BOOL
+} RM_ColumnEncoding;
+
+#define COLUMN_BLOCK_HDR_SIZE (sizeof(unsigned char) + sizeof(unsigned short))
+
+// encodes numValues fixed width values into dest using the smallest
+// encoding available for dt. Returns the block size or -1 if the
+// block needs more than capacity bytes
+extern int encodeColumn (DataType dt, int typeLength, char *values, int numValues,
+                         char *dest, int capacity);
+// decodes every value of a column block into values
+extern void decodeColumn (DataType dt, int typeLength, char *block, int numValues, char *values);
+// decodes the idx-th value of a column block into value
+extern void decodeColumnValue (DataType dt, int typeLength, char *block, int idx, char *value);
+extern RM_ColumnEncoding getColumnEncoding (char *block);
+extern int getColumnBlockSize (char *block);
+
+// evaluates "attr op cons" (or "cons op attr" when consOnLeft) for every
+// value of the block without decoding it. Returns false if the encoding
+// doesn't support it and the caller has to decode the values instead
+extern bool filterColumn (DataType dt, int typeLength, char *block, int numValues,
+                          OpType op, bool consOnLeft, Value *cons, bool *matches);
+
+#endif // COLUMN_CODEC_H
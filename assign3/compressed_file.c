@@ -0,0 +1,439 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "compressed_file.h"
+#include "file_io.h"
+#include "lz_codec.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+//slots needed for numBytes
+#define CF_NUM_SLOTS(numBytes) (((numBytes) + CF_SLOT_SIZE - 1) / CF_SLOT_SIZE)
+#define CF_OFFSET(slot) ((off_t) (slot) * CF_SLOT_SIZE)
+
+typedef struct CF_Header {
+    char magic[CF_MAGIC_SIZE];
+    uint32_t numPages;
+    uint32_t mapOffset;
+    uint32_t mapSlots;
+    uint32_t pageChecksums;
+} CF_Header;
+
+/*********************************************************************
+*
+*                        PRIVATE VARIABLES
+*
+*********************************************************************/
+//every compressed file opened so far
+static CF_File *openFiles = NULL;
+static pthread_mutex_t openFilesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*********************************************************************
+*
+*                        PRIVATE FUNCTIONS
+*
+*********************************************************************/
+static RC loadFile(char *fileName, int fd, CF_File **file);
+static void freeFile(CF_File *file);
+static bool growMap(CF_File *file, int numPages);
+static bool findFreeRuns(CF_File *file);
+static int compareRuns(const void *a, const void *b);
+static bool addRun(CF_SlotRun **runs, int *numRuns, uint32_t offset, uint32_t numSlots);
+static uint32_t allocSlots(CF_File *file, uint32_t numSlots);
+static RC saveMap(CF_File *file, bool isDurable);
+static RC readPage(CF_File *file, int pageNum, char *memPage);
+static RC writePage(CF_File *file, int pageNum, char *memPage);
+
+/*********************************************************************
+*
+*                     COMPRESSED FILE FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+createCompressedFile creates fileName with a single page that was
+never written, like createPageFile does with a page of zeros.
+pageChecksums is kept in the header, see setPageChecksums.
+*********************************************************************/
+RC createCompressedFile (char *fileName, bool pageChecksums)
+{
+    dropCompressedFile(fileName);
+    int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd == -1)
+        return RC_FILE_CREATION_FAILED;
+    char header[PAGE_SIZE + CF_SLOT_SIZE] = {0};
+    CF_Header hdr = {CF_MAGIC, 1, CF_HEADER_SLOTS, 1, pageChecksums};
+    memcpy(header, &hdr, sizeof(CF_Header));
+    bool isWritten = writeFully(fd, header, sizeof(header), 0);
+    if(close(fd) != 0 || !isWritten)
+        return RC_WRITE_FAILED;
+    return RC_OK;
+}
+
+/*********************************************************************
+openCompressedFile returns the cached file of fileName or loads its
+header and map. *file is NULL if fileName is a plain page file.
+*********************************************************************/
+RC openCompressedFile (char *fileName, CF_File **file)
+{
+    RC returnCode = RC_OK;
+    *file = NULL;
+    pthread_mutex_lock(&openFilesMutex);
+    CF_File *cached = openFiles;
+    while(cached && strcmp(cached->fileName, fileName) != 0)
+        cached = cached->next;
+    if(cached)
+    {
+        pthread_mutex_lock(&cached->mutex);
+        cached->numHandles++;
+        pthread_mutex_unlock(&cached->mutex);
+        *file = cached;
+    }
+    else
+    {
+        int fd = open(fileName, O_RDWR);
+        char magic[CF_MAGIC_SIZE];
+        if(fd == -1)
+            returnCode = RC_FILE_NOT_FOUND;
+        else if(readFully(fd, magic, CF_MAGIC_SIZE, 0) && memcmp(magic, CF_MAGIC, CF_MAGIC_SIZE) == 0)
+            returnCode = loadFile(fileName, fd, file);
+        else
+            close(fd);
+    }
+    pthread_mutex_unlock(&openFilesMutex);
+    return returnCode;
+}
+
+//the map is saved once the last handle is closed
+RC closeCompressedFile (CF_File *file)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&openFilesMutex);
+    pthread_mutex_lock(&file->mutex);
+    file->numHandles--;
+    if(file->numHandles == 0 && file->isDirty && !file->isDropped)
+        returnCode = saveMap(file, false);
+    bool isUnused = file->numHandles == 0 && file->isDropped;
+    pthread_mutex_unlock(&file->mutex);
+    pthread_mutex_unlock(&openFilesMutex);
+    if(isUnused)
+        freeFile(file);
+    return returnCode;
+}
+
+/*********************************************************************
+dropCompressedFile removes fileName from the cache. A file that still
+has handles is freed when the last of them is closed, its map isn't
+saved anymore.
+*********************************************************************/
+void dropCompressedFile (char *fileName)
+{
+    pthread_mutex_lock(&openFilesMutex);
+    CF_File **link = &openFiles;
+    while(*link && strcmp((*link)->fileName, fileName) != 0)
+        link = &(*link)->next;
+    CF_File *file = *link;
+    bool isUnused = false;
+    if(file)
+    {
+        *link = file->next;
+        pthread_mutex_lock(&file->mutex);
+        file->isDropped = true;
+        isUnused = file->numHandles == 0;
+        pthread_mutex_unlock(&file->mutex);
+    }
+    pthread_mutex_unlock(&openFilesMutex);
+    if(isUnused)
+        freeFile(file);
+}
+
+int getCompressedNumPages (CF_File *file)
+{
+    pthread_mutex_lock(&file->mutex);
+    int numPages = file->numPages;
+    pthread_mutex_unlock(&file->mutex);
+    return numPages;
+}
+
+//the new pages were never written, they read as zeros
+RC growCompressedFile (CF_File *file, int numPages)
+{
+    pthread_mutex_lock(&file->mutex);
+    bool isGrown = growMap(file, numPages);
+    pthread_mutex_unlock(&file->mutex);
+    return isGrown ? RC_OK : RC_BM_MEMORY_ALOC_FAIL;
+}
+
+RC readCompressedPages (CF_File *file, int startPage, int numPages, char **memPages)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&file->mutex);
+    if(startPage < 0 || numPages < 0 || startPage + numPages > file->numPages)
+        returnCode = RC_READ_NON_EXISTING_PAGE;
+    for(int i = 0; i < numPages && returnCode == RC_OK; i++)
+        returnCode = readPage(file, startPage + i, memPages[i]);
+    pthread_mutex_unlock(&file->mutex);
+    return returnCode;
+}
+
+//the file grows to the last page if it is shorter
+RC writeCompressedPages (CF_File *file, int startPage, int numPages, char **memPages)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&file->mutex);
+    if(startPage < 0 || numPages < 0)
+        returnCode = RC_FILE_OFFSET_FAILED;
+    else if(!growMap(file, startPage + numPages))
+        returnCode = RC_BM_MEMORY_ALOC_FAIL;
+    for(int i = 0; i < numPages && returnCode == RC_OK; i++)
+        returnCode = writePage(file, startPage + i, memPages[i]);
+    pthread_mutex_unlock(&file->mutex);
+    return returnCode;
+}
+
+//saves the map and makes the pages and the map durable
+RC syncCompressedFile (CF_File *file)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&file->mutex);
+    if(file->isDirty)
+        returnCode = saveMap(file, true);
+    else if(fdatasync(file->fd) != 0)
+        returnCode = RC_WRITE_FAILED;
+    pthread_mutex_unlock(&file->mutex);
+    return returnCode;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+
+//reads the header and the map and adds the file to openFiles
+static RC loadFile(char *fileName, int fd, CF_File **file)
+{
+    CF_Header hdr;
+    CF_File *loaded = (CF_File *) calloc(1, sizeof(CF_File));
+    if(!loaded)
+    {
+        close(fd);
+        return RC_BM_MEMORY_ALOC_FAIL;
+    }
+    loaded->fd = fd;
+    loaded->fileName = strdup(fileName);
+    pthread_mutex_init(&loaded->mutex, NULL);
+    if(!readFully(fd, &hdr, sizeof(CF_Header), 0) || !growMap(loaded, hdr.numPages)
+            || !readFully(fd, loaded->pages, (size_t) hdr.numPages * sizeof(CF_PageSlots),
+                          CF_OFFSET(hdr.mapOffset)))
+    {
+        freeFile(loaded);
+        return RC_READ_FILE_FAILED;
+    }
+    loaded->mapOffset = hdr.mapOffset;
+    loaded->mapSlots = hdr.mapSlots;
+    loaded->pageChecksums = hdr.pageChecksums != 0;
+    loaded->isDirty = false;
+    if(!findFreeRuns(loaded))
+    {
+        freeFile(loaded);
+        return RC_BM_MEMORY_ALOC_FAIL;
+    }
+    loaded->numHandles = 1;
+    loaded->next = openFiles;
+    openFiles = loaded;
+    *file = loaded;
+    return RC_OK;
+}
+
+static void freeFile(CF_File *file)
+{
+    close(file->fd);
+    pthread_mutex_destroy(&file->mutex);
+    free(file->fileName);
+    free(file->pages);
+    free(file->freeRuns);
+    free(file->pendingRuns);
+    free(file);
+}
+
+static bool growMap(CF_File *file, int numPages)
+{
+    if(numPages <= file->numPages)
+        return true;
+    if(numPages > file->mapCapacity)
+    {
+        int capacity = file->mapCapacity > 0 ? file->mapCapacity : 16;
+        while(capacity < numPages)
+            capacity *= 2;
+        CF_PageSlots *pages = (CF_PageSlots *) realloc(file->pages, capacity * sizeof(CF_PageSlots));
+        if(!pages)
+            return false;
+        file->pages = pages;
+        file->mapCapacity = capacity;
+    }
+    memset(file->pages + file->numPages, 0, (numPages - file->numPages) * sizeof(CF_PageSlots));
+    file->numPages = numPages;
+    file->isDirty = true;
+    return true;
+}
+
+//the gaps between the header, the map and the pages are free
+static bool findFreeRuns(CF_File *file)
+{
+    int numUsed = 0;
+    CF_SlotRun *used = (CF_SlotRun *) calloc(file->numPages + 2, sizeof(CF_SlotRun));
+    if(!used)
+        return false;
+    used[numUsed++] = (CF_SlotRun) {0, CF_HEADER_SLOTS};
+    used[numUsed++] = (CF_SlotRun) {file->mapOffset, file->mapSlots};
+    for(int i = 0; i < file->numPages; i++)
+        if(file->pages[i].numSlots > 0)
+            used[numUsed++] = (CF_SlotRun) {file->pages[i].offset, file->pages[i].numSlots};
+    qsort(used, numUsed, sizeof(CF_SlotRun), compareRuns);
+    uint32_t end = 0;
+    for(int i = 0; i < numUsed; i++)
+    {
+        if(used[i].offset > end)
+            addRun(&file->freeRuns, &file->numFree, end, used[i].offset - end);
+        if(used[i].offset + used[i].numSlots > end)
+            end = used[i].offset + used[i].numSlots;
+    }
+    file->endSlot = end;
+    free(used);
+    return true;
+}
+
+static int compareRuns(const void *a, const void *b)
+{
+    uint32_t left = ((const CF_SlotRun *) a)->offset, right = ((const CF_SlotRun *) b)->offset;
+    return left < right ? -1 : left > right;
+}
+
+//the arrays grow by powers of two
+static bool addRun(CF_SlotRun **runs, int *numRuns, uint32_t offset, uint32_t numSlots)
+{
+    if((*numRuns & (*numRuns - 1)) == 0)
+    {
+        CF_SlotRun *grown = (CF_SlotRun *) realloc(*runs, (*numRuns ? 2 * *numRuns : 1) * sizeof(CF_SlotRun));
+        if(!grown)
+            return false;
+        *runs = grown;
+    }
+    (*runs)[(*numRuns)++] = (CF_SlotRun) {offset, numSlots};
+    return true;
+}
+
+//first fit among the free runs, else at the end of the file
+static uint32_t allocSlots(CF_File *file, uint32_t numSlots)
+{
+    for(int i = 0; i < file->numFree; i++)
+        if(file->freeRuns[i].numSlots >= numSlots)
+        {
+            uint32_t offset = file->freeRuns[i].offset;
+            file->freeRuns[i].offset += numSlots;
+            file->freeRuns[i].numSlots -= numSlots;
+            if(file->freeRuns[i].numSlots == 0)
+                file->freeRuns[i] = file->freeRuns[--file->numFree];
+            return offset;
+        }
+    uint32_t offset = file->endSlot;
+    file->endSlot += numSlots;
+    return offset;
+}
+
+/*********************************************************************
+saveMap writes the map to free slots, then the header that points to
+it. The slots of the old map and those pages moved out of can be
+reused afterwards. isDurable syncs the pages and the map before the
+header and the header before returning.
+*********************************************************************/
+static RC saveMap(CF_File *file, bool isDurable)
+{
+    size_t mapBytes = (size_t) file->numPages * sizeof(CF_PageSlots);
+    uint32_t mapSlots = CF_NUM_SLOTS(mapBytes);
+    uint32_t mapOffset = allocSlots(file, mapSlots);
+    if(!writeFully(file->fd, file->pages, mapBytes, CF_OFFSET(mapOffset))
+            || (isDurable && fdatasync(file->fd) != 0))
+    {
+        addRun(&file->freeRuns, &file->numFree, mapOffset, mapSlots);
+        return RC_WRITE_FAILED;
+    }
+    CF_Header hdr = {CF_MAGIC, file->numPages, mapOffset, mapSlots, file->pageChecksums};
+    if(!writeFully(file->fd, &hdr, sizeof(CF_Header), 0)
+            || (isDurable && fdatasync(file->fd) != 0))
+    {
+        //the header on disk may point at the new map already, its slots
+        //are reused once the next save succeeded
+        addRun(&file->pendingRuns, &file->numPending, mapOffset, mapSlots);
+        return RC_WRITE_FAILED;
+    }
+    addRun(&file->pendingRuns, &file->numPending, file->mapOffset, file->mapSlots);
+    for(int i = 0; i < file->numPending; i++)
+        addRun(&file->freeRuns, &file->numFree, file->pendingRuns[i].offset,
+               file->pendingRuns[i].numSlots);
+    file->numPending = 0;
+    file->mapOffset = mapOffset;
+    file->mapSlots = mapSlots;
+    file->isDirty = false;
+    return RC_OK;
+}
+
+static RC readPage(CF_File *file, int pageNum, char *memPage)
+{
+    CF_PageSlots *slots = &file->pages[pageNum];
+    if(slots->length == 0)
+    {
+        memset(memPage, 0, PAGE_SIZE);
+        return RC_OK;
+    }
+    if(slots->length == PAGE_SIZE)
+        return readFully(file->fd, memPage, PAGE_SIZE, CF_OFFSET(slots->offset))
+               ? RC_OK : RC_READ_FILE_FAILED;
+    char compressed[PAGE_SIZE];
+    if(!readFully(file->fd, compressed, slots->length, CF_OFFSET(slots->offset))
+            || lzDecompress(compressed, slots->length, memPage, PAGE_SIZE) != PAGE_SIZE)
+        return RC_READ_FILE_FAILED;
+    return RC_OK;
+}
+
+/*********************************************************************
+writePage never overwrites the slots of a page: the saved map may
+still point at them with the old length, which must keep reading as
+the old page until the new map is saved. A page that doesn't save a
+slot is stored as it is.
+*********************************************************************/
+static RC writePage(CF_File *file, int pageNum, char *memPage)
+{
+    CF_PageSlots *slots = &file->pages[pageNum];
+    char compressed[PAGE_SIZE];
+    int length = lzCompress(memPage, PAGE_SIZE, compressed, PAGE_SIZE - CF_SLOT_SIZE);
+    char *data = length > 0 ? compressed : memPage;
+    if(length == 0)
+        length = PAGE_SIZE;
+    uint32_t numSlots = CF_NUM_SLOTS(length);
+    uint32_t offset = allocSlots(file, numSlots);
+    if(!writeFully(file->fd, data, length, CF_OFFSET(offset)))
+    {
+        addRun(&file->freeRuns, &file->numFree, offset, numSlots);
+        return RC_WRITE_FAILED;
+    }
+    //the old slots are reused once the map was saved
+    if(slots->numSlots > 0 &&
+            !addRun(&file->pendingRuns, &file->numPending, slots->offset, slots->numSlots))
+    {
+        addRun(&file->freeRuns, &file->numFree, offset, numSlots);
+        return RC_BM_MEMORY_ALOC_FAIL;
+    }
+    slots->offset = offset;
+    slots->numSlots = numSlots;
+    slots->length = length;
+    file->isDirty = true;
+    return RC_OK;
+}
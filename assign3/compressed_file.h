@@ -0,0 +1,82 @@
+#ifndef COMPRESSED_FILE_H
+#define COMPRESSED_FILE_H
+
+#include "dberror.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/*********************************************************************
+A compressed page file stores every page compressed with lz_codec.h
+in a run of 512 byte slots, so a page takes as many slots as its
+compressed size needs. A map from page numbers to slots finds them:
+
+---------------------------------------------------------------------------
+header (8 slots) | page and map slots in any order ...
+---------------------------------------------------------------------------
+header: char magic[8] | uint numPages | uint mapOffset | uint mapSlots |
+        uint pageChecksums
+map:    (uint offset | ushort length | ushort numSlots) * numPages
+
+Offsets count slots. A page with length 0 was never written and reads
+as zeros, one with length PAGE_SIZE didn't compress and is stored as
+it is. A page is never rewritten in its slots, every write moves it to
+free slots or to the end of the file. Slots a page moved out of are
+only reused after the map was saved, so after a crash the saved map
+still points at the contents and lengths saved with it.
+
+The storage manager opens a compressed file for every handle of it,
+handles of the same file share one CF_File. The map is saved when
+the last handle is closed and by syncCompressedFile, which makes the
+file durable. The file stays cached until it is dropped.
+*********************************************************************/
+#define CF_MAGIC "SMCPAGE1"
+#define CF_MAGIC_SIZE 8
+#define CF_SLOT_SIZE 512
+#define CF_HEADER_SLOTS (PAGE_SIZE / CF_SLOT_SIZE)
+
+typedef struct CF_PageSlots {
+    uint32_t offset;
+    uint16_t length;   //bytes of the compressed page
+    uint16_t numSlots; //slots of the page
+} CF_PageSlots;
+
+typedef struct CF_SlotRun {
+    uint32_t offset;
+    uint32_t numSlots;
+} CF_SlotRun;
+
+typedef struct CF_File {
+    char *fileName;
+    int fd;
+    int numHandles;
+    bool isDropped;     //destroyed or recreated while handles were open
+    pthread_mutex_t mutex;
+    int numPages;
+    int mapCapacity;
+    CF_PageSlots *pages;
+    uint32_t mapOffset; //slots of the saved map
+    uint32_t mapSlots;
+    bool pageChecksums; //the pages carry checksums, set when created
+    uint32_t endSlot;   //first slot after every slot in use
+    bool isDirty;       //the map changed since it was saved
+    CF_SlotRun *freeRuns;
+    int numFree;
+    CF_SlotRun *pendingRuns; //freed since the map was saved
+    int numPending;
+    struct CF_File *next;
+} CF_File;
+
+extern RC createCompressedFile (char *fileName, bool pageChecksums);
+// sets *file to NULL if fileName isn't a compressed page file
+extern RC openCompressedFile (char *fileName, CF_File **file);
+extern RC closeCompressedFile (CF_File *file);
+// forgets a cached file before it is destroyed or recreated
+extern void dropCompressedFile (char *fileName);
+extern int getCompressedNumPages (CF_File *file);
+extern RC growCompressedFile (CF_File *file, int numPages);
+extern RC readCompressedPages (CF_File *file, int startPage, int numPages, char **memPages);
+extern RC writeCompressedPages (CF_File *file, int startPage, int numPages, char **memPages);
+extern RC syncCompressedFile (CF_File *file);
+
+#endif // COMPRESSED_FILE_H
@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "config.h"
+#include "storage_mgr.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+#define CONFIG_MAX_LINE 256
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static char *trim(char *string);
+static RM_TableConfig *addSection(RM_Config *config, char *tableName);
+static bool setTableKey(RM_TableConfig *tableConfig, char *key, char *value);
+static bool parseLong(char *value, long *result);
+static bool parseStrategy(char *value, ReplacementStrategy *strategy);
+static bool parseHugePages(char *value, BM_HugePages *hugePages);
+static bool parseSwitch(char *value, bool *result);
+static char *copyString(char *value);
+
+/*********************************************************************
+*
+*                       CONFIGURATION FUNCTIONS
+*
+*********************************************************************/
+void initConfig (RM_Config *config)
+{
+    memset(config, 0, sizeof(RM_Config));
+    config->numPoolFrames = RM_DEFAULT_POOL_FRAMES;
+    config->poolStrategy = RS_LRU;
+    config->hugePages = BM_HUGE_PAGES_NONE;
+    config->directIO = false;
+    config->extentSize = SM_DEFAULT_EXTENT_SIZE;
+    config->pageChecksums = false;
+    config->segmentSize = SM_DEFAULT_SEGMENT_SIZE;
+    config->segmentDirs = NULL;
+    config->catalogFile = NULL;
+    config->tableDefaults.numPoolFrames = 0;
+    config->tableDefaults.poolStrategy = RS_LRU;
+    config->tableDefaults.prefetchDepth = 0;
+    config->tableDefaults.checkpointLogSize = RM_DEFAULT_CHECKPOINT_LOG_SIZE;
+    config->tableDefaults.checkpointWriteDelay = 0;
+    config->tableDefaults.readOnly = false;
+    config->tableDefaults.compressPages = false;
+    config->tableDefaults.pageSize = PAGE_SIZE;
+}
+
+/*********************************************************************
+loadConfig reads the configuration in fileName, see config.h. Keys
+that aren't set keep their defaults, sections start with the defaults
+set before them. config doesn't have to be freed if this fails.
+*********************************************************************/
+RC loadConfig (char *fileName, RM_Config *config)
+{
+    FILE *file = fopen(fileName, "r");
+    if(!file)
+        return RC_FILE_NOT_FOUND;
+    initConfig(config);
+    RM_TableConfig *section = NULL;
+    char buffer[CONFIG_MAX_LINE];
+    bool isValid = true;
+    while(isValid && fgets(buffer, sizeof(buffer), file))
+    {
+        char *comment = strchr(buffer, '#');
+        if(comment)
+            *comment = '\0';
+        char *line = trim(buffer);
+        if(*line == '\0')
+            continue;
+        //[table name] starts the section of a table
+        if(*line == '[')
+        {
+            char *end = strchr(line, ']');
+            isValid = end && end[1] == '\0' && strncmp(line + 1, "table ", 6) == 0;
+            if(isValid)
+            {
+                *end = '\0';
+                char *tableName = trim(line + 7);
+                isValid = *tableName != '\0';
+                if(isValid)
+                    section = addSection(config, tableName);
+            }
+            continue;
+        }
+        char *equals = strchr(line, '=');
+        if(!equals)
+        {
+            isValid = false;
+            continue;
+        }
+        *equals = '\0';
+        char *key = trim(line);
+        char *value = trim(equals + 1);
+        long number;
+        if(section)
+            isValid = setTableKey(section, key, value);
+        else if(strcmp(key, "shared_pool_frames") == 0)
+        {
+            isValid = parseLong(value, &number) && number > 0;
+            config->numPoolFrames = (int) number;
+        }
+        else if(strcmp(key, "shared_pool_strategy") == 0)
+            isValid = parseStrategy(value, &config->poolStrategy);
+        else if(strcmp(key, "huge_pages") == 0)
+            isValid = parseHugePages(value, &config->hugePages);
+        else if(strcmp(key, "direct_io") == 0)
+            isValid = parseSwitch(value, &config->directIO);
+        else if(strcmp(key, "file_extent_size") == 0)
+        {
+            isValid = parseLong(value, &number) && number >= PAGE_SIZE;
+            config->extentSize = number;
+        }
+        else if(strcmp(key, "page_checksums") == 0)
+            isValid = parseSwitch(value, &config->pageChecksums);
+        else if(strcmp(key, "file_segment_size") == 0)
+        {
+            isValid = parseLong(value, &number) && number >= PAGE_SIZE;
+            config->segmentSize = number;
+        }
+        else if(strcmp(key, "segment_dirs") == 0)
+        {
+            free(config->segmentDirs);
+            config->segmentDirs = copyString(value);
+        }
+        else if(strcmp(key, "catalog_file") == 0)
+        {
+            free(config->catalogFile);
+            config->catalogFile = copyString(value);
+        }
+        else
+            isValid = setTableKey(&config->tableDefaults, key, value);
+    }
+    fclose(file);
+    if(!isValid)
+    {
+        freeConfig(config);
+        return RC_RM_CONFIG_ERROR;
+    }
+    return RC_OK;
+}
+
+//dest gets its own copies of the table sections
+void copyConfig (RM_Config *dest, RM_Config *src)
+{
+    *dest = *src;
+    dest->segmentDirs = src->segmentDirs ? copyString(src->segmentDirs) : NULL;
+    dest->catalogFile = src->catalogFile ? copyString(src->catalogFile) : NULL;
+    if(src->numTables == 0)
+    {
+        dest->tables = NULL;
+        return;
+    }
+    VALID_CALLOC(RM_TableSection, tables, src->numTables, sizeof(RM_TableSection));
+    for(int i = 0; i < src->numTables; i++)
+    {
+        VALID_CALLOC(char, tableName, strlen(src->tables[i].tableName) + 1, sizeof(char));
+        strcpy(tableName, src->tables[i].tableName);
+        tables[i].tableName = tableName;
+        tables[i].config = src->tables[i].config;
+    }
+    dest->tables = tables;
+}
+
+void freeConfig (RM_Config *config)
+{
+    for(int i = 0; i < config->numTables; i++)
+        free(config->tables[i].tableName);
+    free(config->tables);
+    config->tables = NULL;
+    config->numTables = 0;
+    free(config->segmentDirs);
+    config->segmentDirs = NULL;
+    free(config->catalogFile);
+    config->catalogFile = NULL;
+}
+
+RM_TableConfig *getTableConfig (RM_Config *config, char *tableName)
+{
+    for(int i = 0; i < config->numTables; i++)
+        if(strcmp(config->tables[i].tableName, tableName) == 0)
+            return &config->tables[i].config;
+    return &config->tableDefaults;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+static char *trim(char *string)
+{
+    while(isspace((unsigned char) *string))
+        string++;
+    char *end = string + strlen(string);
+    while(end > string && isspace((unsigned char) end[-1]))
+        end--;
+    *end = '\0';
+    return string;
+}
+
+//a table named twice keeps its first section
+static RM_TableConfig *addSection(RM_Config *config, char *tableName)
+{
+    RM_TableConfig *existing = getTableConfig(config, tableName);
+    if(existing != &config->tableDefaults)
+        return existing;
+    config->tables = (RM_TableSection *) realloc(config->tables,
+                     (config->numTables + 1) * sizeof(RM_TableSection));
+    if(!config->tables)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    VALID_CALLOC(char, name, strlen(tableName) + 1, sizeof(char));
+    strcpy(name, tableName);
+    RM_TableSection *section = &config->tables[config->numTables++];
+    section->tableName = name;
+    section->config = config->tableDefaults;
+    return &section->config;
+}
+
+static bool setTableKey(RM_TableConfig *tableConfig, char *key, char *value)
+{
+    long number;
+    if(strcmp(key, "pool_strategy") == 0)
+        return parseStrategy(value, &tableConfig->poolStrategy);
+    if(strcmp(key, "read_only") == 0)
+        return parseSwitch(value, &tableConfig->readOnly);
+    if(strcmp(key, "compress_pages") == 0)
+        return parseSwitch(value, &tableConfig->compressPages);
+    if(!parseLong(value, &number) || number < 0)
+        return false;
+    if(strcmp(key, "pool_frames") == 0)
+        tableConfig->numPoolFrames = (int) number;
+    else if(strcmp(key, "prefetch_depth") == 0)
+        tableConfig->prefetchDepth = (int) number;
+    else if(strcmp(key, "checkpoint_log_size") == 0)
+        tableConfig->checkpointLogSize = number;
+    else if(strcmp(key, "checkpoint_write_delay") == 0)
+        tableConfig->checkpointWriteDelay = number;
+    else if(strcmp(key, "page_size") == 0)
+    {
+        //createPageFileEx takes powers of two in this range
+        if(number < SM_MIN_PAGE_SIZE || number > SM_MAX_PAGE_SIZE || (number & (number - 1)))
+            return false;
+        tableConfig->pageSize = (int) number;
+    }
+    else
+        return false;
+    return true;
+}
+
+static bool parseLong(char *value, long *result)
+{
+    char *end;
+    *result = strtol(value, &end, 10);
+    return *value != '\0' && *end == '\0';
+}
+
+static bool parseStrategy(char *value, ReplacementStrategy *strategy)
+{
+    char *names[] = {"fifo", "lru", "clock", "lfu"};
+    ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU};
+    for(int i = 0; i < 4; i++)
+        if(strcmp(value, names[i]) == 0)
+        {
+            *strategy = strategies[i];
+            return true;
+        }
+    return false;
+}
+
+static bool parseHugePages(char *value, BM_HugePages *hugePages)
+{
+    char *names[] = {"none", "transparent", "explicit"};
+    BM_HugePages modes[] = {BM_HUGE_PAGES_NONE, BM_HUGE_PAGES_TRANSPARENT, BM_HUGE_PAGES_EXPLICIT};
+    for(int i = 0; i < 3; i++)
+        if(strcmp(value, names[i]) == 0)
+        {
+            *hugePages = modes[i];
+            return true;
+        }
+    return false;
+}
+
+static bool parseSwitch(char *value, bool *result)
+{
+    if(strcmp(value, "on") != 0 && strcmp(value, "off") != 0)
+        return false;
+    *result = strcmp(value, "on") == 0;
+    return true;
+}
+
+//RETURNS: a copy of value, to be freed
+static char *copyString(char *value)
+{
+    VALID_CALLOC(char, copy, strlen(value) + 1, sizeof(char));
+    strcpy(copy, value);
+    return copy;
+}
@@ -0,0 +1,89 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+/*********************************************************************
+The configuration of the record manager, passed to initRecordManager.
+It sizes the buffer pool all tables share and holds the settings of
+the tables: a table gets the settings of its own section if there is
+one, the defaults otherwise. openTableEx takes the settings directly.
+
+loadConfig reads a configuration from a text file of key = value
+lines. Keys before the first section set the shared pool and the
+defaults of the tables, a [table name] section the settings of the
+table with that page file name:
+
+    # comments start with '#'
+    shared_pool_frames = 4000
+    shared_pool_strategy = clock
+    huge_pages = transparent     # none, transparent or explicit
+    direct_io = on               # page files bypass the page cache
+    file_extent_size = 8388608   # bytes page files grow by at once
+    page_checksums = on          # CRC32C in the trailer of every page
+    file_segment_size = 268435456  # bytes of the segment files of a page file
+    segment_dirs = /disk1:/disk2 # directories segments 1 and up go to
+    catalog_file = catalog.db    # page file the system catalog is kept in
+    prefetch_depth = 4
+    [table orders]
+    pool_frames = 500            # private pool instead of the shared one
+    pool_strategy = lru
+    checkpoint_log_size = 262144
+    checkpoint_write_delay = 100
+    [table countries]
+    read_only = on               # served from a mapping of the page file
+    [table events]
+    compress_pages = on          # page file created compressed
+    [table history]
+    page_size = 65536            # bytes of the pages createTable makes
+
+Strategies are fifo, lru, clock and lfu. stratData can't be set in a
+file, it is NULL.
+*********************************************************************/
+#define RM_DEFAULT_POOL_FRAMES 1000
+#define RM_DEFAULT_CHECKPOINT_LOG_SIZE (16*PAGE_SIZE)
+
+typedef struct RM_TableConfig {
+    int numPoolFrames;          //frames of a private pool, 0 to use the shared pool
+    ReplacementStrategy poolStrategy;
+    void *poolStratData;
+    int prefetchDepth;          //pages scans read ahead in one go, 0 for none
+    long checkpointLogSize;     //log bytes that begin a checkpoint
+    long checkpointWriteDelay;  //microseconds the checkpoint writer pauses after a page
+    bool readOnly;              //pages are read from a mapping of the page file, no pool
+    bool compressPages;         //createTable makes a compressed page file
+    int pageSize;               //bytes of the pages createTable makes, 0 for PAGE_SIZE
+} RM_TableConfig;
+
+typedef struct RM_TableSection {
+    char *tableName;
+    RM_TableConfig config;
+} RM_TableSection;
+
+typedef struct RM_Config {
+    int numPoolFrames;          //frames of the pool the tables share
+    ReplacementStrategy poolStrategy;
+    void *poolStratData;
+    BM_HugePages hugePages;     //backing of the frames of all pools
+    bool directIO;              //page files bypass the kernel's page cache
+    long extentSize;            //bytes page files grow by at once
+    bool pageChecksums;         //pages are checksummed when written, checked when read
+    long segmentSize;           //bytes of the segment files, 0 for SM_DEFAULT_SEGMENT_SIZE
+    char *segmentDirs;          //':' separated directories of the segments, NULL for none
+    char *catalogFile;          //page file of the system catalog, NULL to keep it in memory only
+    RM_TableConfig tableDefaults;
+    RM_TableSection *tables;
+    int numTables;
+} RM_Config;
+
+// sets the defaults, without table sections
+extern void initConfig (RM_Config *config);
+// RC_RM_CONFIG_ERROR if a line can't be parsed
+extern RC loadConfig (char *fileName, RM_Config *config);
+extern void copyConfig (RM_Config *dest, RM_Config *src);
+extern void freeConfig (RM_Config *config);
+// the section of tableName, or the defaults
+extern RM_TableConfig *getTableConfig (RM_Config *config, char *tableName);
+
+#endif // CONFIG_H
@@ -0,0 +1,133 @@
+#include <string.h>
+#include <pthread.h>
+
+#include "crc32c.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC_HAVE_SSE42
+#include <nmmintrin.h>
+#endif
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+//reversed Castagnoli polynomial
+#define CRC32C_POLY 0x82F63B78
+
+/*********************************************************************
+*
+*                        PRIVATE VARIABLES
+*
+*********************************************************************/
+//crcTable[k][b]: crc of byte b followed by k zero bytes
+static uint32_t crcTable[8][256];
+static uint32_t (*crcFunction)(uint32_t crc, const unsigned char *data, size_t length);
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+
+/*********************************************************************
+*
+*                        PRIVATE FUNCTIONS
+*
+*********************************************************************/
+static void initCrc(void);
+static uint32_t crcSlicing(uint32_t crc, const unsigned char *data, size_t length);
+#ifdef CRC_HAVE_SSE42
+static uint32_t crcHardware(uint32_t crc, const unsigned char *data, size_t length);
+#endif
+
+/*********************************************************************
+*
+*                        CRC32C FUNCTIONS
+*
+*********************************************************************/
+uint32_t crc32c (uint32_t crc, const void *data, size_t length)
+{
+    pthread_once(&crcOnce, initCrc);
+    return ~crcFunction(~crc, data, length);
+}
+
+uint32_t crc32cPortable (uint32_t crc, const void *data, size_t length)
+{
+    pthread_once(&crcOnce, initCrc);
+    return ~crcSlicing(~crc, data, length);
+}
+
+bool crc32cIsHardware (void)
+{
+    pthread_once(&crcOnce, initCrc);
+    return crcFunction != crcSlicing;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+
+//fills the tables and picks the implementation crc32c uses
+static void initCrc(void)
+{
+    for(int b = 0; b < 256; b++)
+    {
+        uint32_t crc = b;
+        for(int bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        crcTable[0][b] = crc;
+    }
+    for(int b = 0; b < 256; b++)
+        for(int k = 1; k < 8; k++)
+            crcTable[k][b] = (crcTable[k - 1][b] >> 8) ^ crcTable[0][crcTable[k - 1][b] & 0xff];
+    crcFunction = crcSlicing;
+#ifdef CRC_HAVE_SSE42
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.2"))
+        crcFunction = crcHardware;
+#endif
+}
+
+//eight bytes per step, one table lookup for each of them
+static uint32_t crcSlicing(uint32_t crc, const unsigned char *data, size_t length)
+{
+    for(; length > 0 && ((uintptr_t) data & 7); length--)
+        crc = crcTable[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for(; length >= 8; length -= 8, data += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(uint64_t));
+        word ^= crc;
+        crc = crcTable[7][word & 0xff] ^ crcTable[6][(word >> 8) & 0xff]
+              ^ crcTable[5][(word >> 16) & 0xff] ^ crcTable[4][(word >> 24) & 0xff]
+              ^ crcTable[3][(word >> 32) & 0xff] ^ crcTable[2][(word >> 40) & 0xff]
+              ^ crcTable[1][(word >> 48) & 0xff] ^ crcTable[0][word >> 56];
+    }
+#endif
+    for(; length > 0; length--)
+        crc = crcTable[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef CRC_HAVE_SSE42
+//the crc32 instruction, eight bytes at a time
+__attribute__((target("sse4.2")))
+static uint32_t crcHardware(uint32_t crc, const unsigned char *data, size_t length)
+{
+    for(; length > 0 && ((uintptr_t) data & 7); length--)
+        crc = _mm_crc32_u8(crc, *data++);
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+    for(; length >= 8; length -= 8, data += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(uint64_t));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t) crc64;
+#endif
+    for(; length > 0; length--)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+#endif
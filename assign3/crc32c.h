@@ -0,0 +1,20 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*********************************************************************
+CRC32C (Castagnoli polynomial, as used by iSCSI and ext4) of length
+bytes at data, continuing crc (0 for a new checksum). crc32c uses the
+SSE4.2 crc32 instruction if the processor has it, slicing-by-8 tables
+otherwise; crc32cPortable always uses the tables. Both give the same
+result, crc32c(0, "123456789", 9) is 0xE3069283.
+*********************************************************************/
+extern uint32_t crc32c (uint32_t crc, const void *data, size_t length);
+extern uint32_t crc32cPortable (uint32_t crc, const void *data, size_t length);
+// true if crc32c uses the crc32 instruction
+extern bool crc32cIsHardware (void);
+
+#endif
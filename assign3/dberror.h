@@ -5,6 +5,9 @@
 
 /* module wide constants */
 #define PAGE_SIZE 4096
+/* the last bytes of a page hold its checksum, see storage_mgr.h */
+#define PAGE_TRAILER_SIZE 4
+#define PAGE_DATA_SIZE (PAGE_SIZE - PAGE_TRAILER_SIZE)
 
 /* return code definitions */
 typedef int RC;
@@ -23,11 +26,16 @@ typedef int RC;
 #define RC_INCOMPATIBLE_BLOCKSIZE 10
 #define RC_READ_FILE_FAILED 11
 #define RC_INVALID_PAGE_NUMBER 12
+#define RC_PAGE_CHECKSUM_FAILED 13
+#define RC_PAGE_FILE_COMPRESSED 14
+#define RC_NOT_A_TABLESPACE 15
+#define RC_NOT_A_PAGE_FILE 16
 
 #define RC_BM_PAGE_NOT_FOUND 100
 #define RC_BM_NOT_ALLOCATED 101
 #define RC_BM_MEMORY_ALOC_FAIL 102
 #define RC_BM_NO_FRAME_AVAIL 103
+#define RC_BM_PAGE_PINNED 104
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
@@ -38,6 +46,11 @@ typedef int RC;
 #define RC_RM_INIT_ERROR 206
 #define RC_RM_NO_FREE_PAGES 207
 #define RC_RM_FILE_ALREADY_EXISTS 208
+#define RC_RM_PAGE_FULL 209
+#define RC_RM_WRITE_CONFLICT 210
+#define RC_RM_RECORD_NOT_FOUND 211
+#define RC_RM_CONFIG_ERROR 212
+#define RC_RM_READ_ONLY 213
 
 #define RC_IM_KEY_NOT_FOUND 300
 #define RC_IM_KEY_ALREADY_EXISTS 301
@@ -47,6 +60,15 @@ typedef int RC;
 
 #define RC_RS_UNKNOWN 400;
 
+#define RC_LM_LOG_NOT_OPEN 500
+#define RC_LM_WRITE_FAILED 501
+#define RC_LM_SYNC_FAILED 502
+
+#define RC_LK_DEADLOCK 600
+
+#define RC_AIO_INIT_FAILED 700
+#define RC_AIO_ENTER_FAILED 701
+
 /* holder for error messages */
 extern char *RC_message;
 
@@ -0,0 +1,35 @@
+#include <unistd.h>
+
+#include "file_io.h"
+
+/*********************************************************************
+*
+*                         FILE IO FUNCTIONS
+*
+*********************************************************************/
+
+bool readFully (int fd, void *buffer, size_t numBytes, off_t offset)
+{
+    size_t done = 0;
+    while(done < numBytes)
+    {
+        ssize_t numRead = pread(fd, (char *) buffer + done, numBytes - done, offset + done);
+        if(numRead <= 0)
+            return false;
+        done += numRead;
+    }
+    return true;
+}
+
+bool writeFully (int fd, const void *buffer, size_t numBytes, off_t offset)
+{
+    size_t done = 0;
+    while(done < numBytes)
+    {
+        ssize_t numWritten = pwrite(fd, (const char *) buffer + done, numBytes - done, offset + done);
+        if(numWritten <= 0)
+            return false;
+        done += numWritten;
+    }
+    return true;
+}
@@ -0,0 +1,16 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/*********************************************************************
+readFully and writeFully transfer numBytes at offset of fd with
+pread and pwrite, again for the rest after a short transfer. Both are
+false if a call fails or readFully reaches the end of the file first.
+*********************************************************************/
+extern bool readFully (int fd, void *buffer, size_t numBytes, off_t offset);
+extern bool writeFully (int fd, const void *buffer, size_t numBytes, off_t offset);
+
+#endif // FILE_IO_H
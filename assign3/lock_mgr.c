@@ -0,0 +1,552 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lock_mgr.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+#define LK_NUM_PARTITIONS 16
+#define LK_NUM_BUCKETS 256
+//how often the deadlock detector looks for cycles
+#define LK_DETECT_INTERVAL_USEC 10000
+
+// an owner waiting for a lock another owner holds or waits for first
+typedef struct LK_Edge {
+    int waiter;
+    int holder;
+} LK_Edge;
+
+static const bool compatible[5][5] = {
+    //          IS     IX     S      SIX    X
+    /* IS  */ {true,  true,  true,  true,  false},
+    /* IX  */ {true,  true,  false, false, false},
+    /* S   */ {true,  false, true,  false, false},
+    /* SIX */ {true,  false, false, false, false},
+    /* X   */ {false, false, false, false, false}
+};
+
+//weakest mode that covers both modes
+static const LK_LockMode supremum[5][5] = {
+    /* IS  */ {LOCK_IS,  LOCK_IX,  LOCK_S,   LOCK_SIX, LOCK_X},
+    /* IX  */ {LOCK_IX,  LOCK_IX,  LOCK_SIX, LOCK_SIX, LOCK_X},
+    /* S   */ {LOCK_S,   LOCK_SIX, LOCK_S,   LOCK_SIX, LOCK_X},
+    /* SIX */ {LOCK_SIX, LOCK_SIX, LOCK_SIX, LOCK_SIX, LOCK_X},
+    /* X   */ {LOCK_X,   LOCK_X,   LOCK_X,   LOCK_X,   LOCK_X}
+};
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static unsigned int hashResource(LK_ResourceId id);
+static LK_Partition *getPartition(LK_LockManager *lockManager, LK_ResourceId id);
+static LK_Lock **findLock(LK_Partition *partition, LK_ResourceId id);
+static bool isBlockedBy(LK_Request *request, LK_Request *other, bool isBefore);
+static bool canGrant(LK_Lock *lock, LK_Request *request);
+static void removeRequest(LK_Partition *partition, LK_ResourceId id, int owner);
+static void addHeld(LK_Owner *owner, LK_ResourceId id);
+static void addWaiting(LK_LockManager *lockManager, int delta);
+static void *deadlockDetector(void *arg);
+static void detectDeadlocks(LK_LockManager *lockManager);
+static bool findVictim(LK_Edge *edges, int numEdges, int *victim);
+static int findWaiter(LK_Edge *edges, int numEdges, int owner);
+static int compareEdges(const void *a, const void *b);
+
+/*********************************************************************
+*
+*                      LOCK MANAGER FUNCTIONS
+*
+*********************************************************************/
+RC startLockManager (LK_LockManager *lockManager)
+{
+    if(lockManager->isRunning)
+        return RC_OK;
+    memset(lockManager, 0, sizeof(LK_LockManager));
+    lockManager->numPartitions = LK_NUM_PARTITIONS;
+    VALID_CALLOC(LK_Partition, partitions, lockManager->numPartitions, sizeof(LK_Partition));
+    for(int i = 0; i < lockManager->numPartitions; i++)
+    {
+        pthread_mutex_init(&partitions[i].mutex, NULL);
+        pthread_cond_init(&partitions[i].changed, NULL);
+        partitions[i].numBuckets = LK_NUM_BUCKETS;
+        VALID_CALLOC(LK_Lock *, buckets, LK_NUM_BUCKETS, sizeof(LK_Lock *));
+        partitions[i].buckets = buckets;
+    }
+    lockManager->partitions = partitions;
+    pthread_mutex_init(&lockManager->mutex, NULL);
+    pthread_cond_init(&lockManager->stopped, NULL);
+    if(pthread_create(&lockManager->detector, NULL, deadlockDetector, lockManager) != 0)
+    {
+        lockManager->isRunning = true;
+        stopLockManager(lockManager);
+        return RC_RM_INIT_ERROR;
+    }
+    lockManager->isRunning = true;
+    return RC_OK;
+}
+
+/*********************************************************************
+stopLockManager stops the deadlock detector and drops the lock table.
+No owner may wait for a lock meanwhile.
+*********************************************************************/
+RC stopLockManager (LK_LockManager *lockManager)
+{
+    if(!lockManager->isRunning)
+        return RC_OK;
+    pthread_mutex_lock(&lockManager->mutex);
+    lockManager->stop = true;
+    pthread_cond_broadcast(&lockManager->stopped);
+    pthread_mutex_unlock(&lockManager->mutex);
+    if(lockManager->detector)
+        pthread_join(lockManager->detector, NULL);
+    for(int i = 0; i < lockManager->numPartitions; i++)
+    {
+        LK_Partition *partition = &lockManager->partitions[i];
+        for(int j = 0; j < partition->numBuckets; j++)
+        {
+            LK_Lock *lock = partition->buckets[j];
+            while(lock)
+            {
+                LK_Lock *next = lock->next;
+                while(lock->requests)
+                {
+                    LK_Request *request = lock->requests;
+                    lock->requests = request->next;
+                    free(request);
+                }
+                free(lock);
+                lock = next;
+            }
+        }
+        free(partition->buckets);
+        pthread_mutex_destroy(&partition->mutex);
+        pthread_cond_destroy(&partition->changed);
+    }
+    free(lockManager->partitions);
+    pthread_mutex_destroy(&lockManager->mutex);
+    pthread_cond_destroy(&lockManager->stopped);
+    memset(lockManager, 0, sizeof(LK_LockManager));
+    return RC_OK;
+}
+
+//gives owner a new id, younger than all owners before
+void initLockOwner (LK_LockManager *lockManager, LK_Owner *owner)
+{
+    memset(owner, 0, sizeof(LK_Owner));
+    pthread_mutex_lock(&lockManager->mutex);
+    owner->id = ++lockManager->lastOwner;
+    pthread_mutex_unlock(&lockManager->mutex);
+}
+
+/*********************************************************************
+lockResource locks resource id in mode for owner. If owner holds a
+lock on id already, the lock is converted to the stronger mode of
+both. Conversions are granted before requests that wait for a new
+lock.
+RETURNS: RC_LK_DEADLOCK if owner was chosen to break a deadlock, the
+         locks it held before are kept
+*********************************************************************/
+RC lockResource (LK_LockManager *lockManager, LK_Owner *owner, LK_ResourceId id,
+                 LK_LockMode mode)
+{
+    RC returnCode = RC_OK;
+    LK_Partition *partition = getPartition(lockManager, id);
+    pthread_mutex_lock(&partition->mutex);
+    LK_Lock **link = findLock(partition, id);
+    if(!*link)
+    {
+        VALID_CALLOC(LK_Lock, newLock, 1, sizeof(LK_Lock));
+        newLock->id = id;
+        *link = newLock;
+    }
+    LK_Lock *lock = *link;
+    LK_Request **requestLink = &lock->requests;
+    while(*requestLink && (*requestLink)->owner != owner->id)
+        requestLink = &(*requestLink)->next;
+    LK_Request *request = *requestLink;
+    bool isNew = !request;
+    if(isNew)
+    {
+        VALID_CALLOC(LK_Request, newRequest, 1, sizeof(LK_Request));
+        newRequest->owner = owner->id;
+        newRequest->waitMode = mode;
+        *requestLink = newRequest;
+        request = newRequest;
+    }
+    else if(supremum[request->mode][mode] == request->mode)
+    {
+        pthread_mutex_unlock(&partition->mutex);
+        return RC_OK;
+    }
+    else
+        request->waitMode = supremum[request->mode][mode];
+    request->isWaiting = true;
+
+    bool hasWaited = false;
+    if(!canGrant(lock, request))
+    {
+        hasWaited = true;
+        addWaiting(lockManager, 1);
+        while(!request->isVictim && !canGrant(lock, request))
+            pthread_cond_wait(&partition->changed, &partition->mutex);
+        addWaiting(lockManager, -1);
+    }
+    request->isWaiting = false;
+    if(request->isVictim)
+    {
+        returnCode = RC_LK_DEADLOCK;
+        request->isVictim = false;
+        if(isNew)
+            removeRequest(partition, id, owner->id);
+    }
+    else
+    {
+        request->mode = request->waitMode;
+        request->isGranted = true;
+    }
+    //requests queued behind this one may be granted now
+    if(hasWaited)
+        pthread_cond_broadcast(&partition->changed);
+    pthread_mutex_unlock(&partition->mutex);
+    if(returnCode == RC_OK && isNew)
+        addHeld(owner, id);
+    return returnCode;
+}
+
+RC releaseLocks (LK_LockManager *lockManager, LK_Owner *owner)
+{
+    for(int i = 0; i < owner->numHeld; i++)
+    {
+        LK_Partition *partition = getPartition(lockManager, owner->held[i]);
+        pthread_mutex_lock(&partition->mutex);
+        removeRequest(partition, owner->held[i], owner->id);
+        pthread_cond_broadcast(&partition->changed);
+        pthread_mutex_unlock(&partition->mutex);
+    }
+    free(owner->held);
+    owner->held = NULL;
+    owner->numHeld = 0;
+    owner->capacity = 0;
+    return RC_OK;
+}
+
+/*********************************************************************
+*
+*                      STATISTICS INTERFACE
+*
+*********************************************************************/
+int getNumLockWaits (LK_LockManager *lockManager)
+{
+    pthread_mutex_lock(&lockManager->mutex);
+    int numWaits = lockManager->numWaits;
+    pthread_mutex_unlock(&lockManager->mutex);
+    return numWaits;
+}
+
+int getNumDeadlocks (LK_LockManager *lockManager)
+{
+    pthread_mutex_lock(&lockManager->mutex);
+    int numDeadlocks = lockManager->numDeadlocks;
+    pthread_mutex_unlock(&lockManager->mutex);
+    return numDeadlocks;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+static unsigned int hashResource(LK_ResourceId id)
+{
+    uint64_t hash = (uint64_t) id.table * 0x9E3779B97F4A7C15ull;
+    hash ^= (uint64_t)(unsigned int) id.page * 2654435761u;
+    hash ^= (uint64_t)(unsigned int) id.slot * 40503u;
+    return (unsigned int)(hash ^ (hash >> 32));
+}
+
+static LK_Partition *getPartition(LK_LockManager *lockManager, LK_ResourceId id)
+{
+    return &lockManager->partitions[hashResource(id) % lockManager->numPartitions];
+}
+
+//RETURNS: the link to the lock on id, which points to NULL if there is none
+static LK_Lock **findLock(LK_Partition *partition, LK_ResourceId id)
+{
+    unsigned int bucket = (hashResource(id) / LK_NUM_PARTITIONS) % partition->numBuckets;
+    LK_Lock **link = &partition->buckets[bucket];
+    while(*link && ((*link)->id.table != id.table || (*link)->id.page != id.page
+                    || (*link)->id.slot != id.slot))
+        link = &(*link)->next;
+    return link;
+}
+
+/*********************************************************************
+isBlockedBy tells whether a waiting request has to wait for other.
+New requests also queue behind incompatible requests that arrived
+before them, so they don't starve those.
+*********************************************************************/
+static bool isBlockedBy(LK_Request *request, LK_Request *other, bool isBefore)
+{
+    if(other->owner == request->owner)
+        return false;
+    if(other->isGranted && !compatible[other->mode][request->waitMode])
+        return true;
+    return !request->isGranted && isBefore && other->isWaiting
+           && !compatible[other->waitMode][request->waitMode];
+}
+
+static bool canGrant(LK_Lock *lock, LK_Request *request)
+{
+    bool isBefore = true;
+    for(LK_Request *other = lock->requests; other; other = other->next)
+    {
+        if(other == request)
+            isBefore = false;
+        else if(isBlockedBy(request, other, isBefore))
+            return false;
+    }
+    return true;
+}
+
+//removes the request of owner on id and the lock once it has none
+static void removeRequest(LK_Partition *partition, LK_ResourceId id, int owner)
+{
+    LK_Lock **link = findLock(partition, id);
+    LK_Lock *lock = *link;
+    if(!lock)
+        return;
+    LK_Request **requestLink = &lock->requests;
+    while(*requestLink && (*requestLink)->owner != owner)
+        requestLink = &(*requestLink)->next;
+    if(*requestLink)
+    {
+        LK_Request *request = *requestLink;
+        *requestLink = request->next;
+        free(request);
+    }
+    if(!lock->requests)
+    {
+        *link = lock->next;
+        free(lock);
+    }
+}
+
+static void addHeld(LK_Owner *owner, LK_ResourceId id)
+{
+    if(owner->numHeld == owner->capacity)
+    {
+        owner->capacity = owner->capacity ? 2*owner->capacity : 8;
+        owner->held = (LK_ResourceId *) realloc(owner->held, owner->capacity * sizeof(LK_ResourceId));
+        if(!owner->held)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+    }
+    owner->held[owner->numHeld++] = id;
+}
+
+static void addWaiting(LK_LockManager *lockManager, int delta)
+{
+    pthread_mutex_lock(&lockManager->mutex);
+    lockManager->numWaiting += delta;
+    if(delta > 0)
+        lockManager->numWaits++;
+    pthread_mutex_unlock(&lockManager->mutex);
+}
+
+static void *deadlockDetector(void *arg)
+{
+    LK_LockManager *lockManager = (LK_LockManager *) arg;
+    pthread_mutex_lock(&lockManager->mutex);
+    while(!lockManager->stop)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LK_DETECT_INTERVAL_USEC * 1000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&lockManager->stopped, &lockManager->mutex, &deadline);
+        //a cycle needs at least two waiting owners
+        if(lockManager->stop || lockManager->numWaiting < 2)
+            continue;
+        pthread_mutex_unlock(&lockManager->mutex);
+        detectDeadlocks(lockManager);
+        pthread_mutex_lock(&lockManager->mutex);
+    }
+    pthread_mutex_unlock(&lockManager->mutex);
+    return NULL;
+}
+
+/*********************************************************************
+detectDeadlocks builds the waits-for graph with every partition locked,
+so it is consistent, and chooses victims until it has no cycle left
+*********************************************************************/
+static void detectDeadlocks(LK_LockManager *lockManager)
+{
+    LK_Edge *edges = NULL;
+    int numEdges = 0, capacity = 0, numVictims = 0, victim;
+    for(int i = 0; i < lockManager->numPartitions; i++)
+        pthread_mutex_lock(&lockManager->partitions[i].mutex);
+    for(int i = 0; i < lockManager->numPartitions; i++)
+        for(int j = 0; j < lockManager->partitions[i].numBuckets; j++)
+            for(LK_Lock *lock = lockManager->partitions[i].buckets[j]; lock; lock = lock->next)
+                for(LK_Request *request = lock->requests; request; request = request->next)
+                {
+                    if(!request->isWaiting || request->isVictim)
+                        continue;
+                    bool isBefore = true;
+                    for(LK_Request *other = lock->requests; other; other = other->next)
+                    {
+                        if(other == request)
+                        {
+                            isBefore = false;
+                            continue;
+                        }
+                        if(!isBlockedBy(request, other, isBefore))
+                            continue;
+                        if(numEdges == capacity)
+                        {
+                            capacity = capacity ? 2*capacity : 16;
+                            edges = (LK_Edge *) realloc(edges, capacity * sizeof(LK_Edge));
+                            if(!edges)
+                            {
+                                printError(RC_BM_MEMORY_ALOC_FAIL);
+                                exit(-1);
+                            }
+                        }
+                        edges[numEdges].waiter = request->owner;
+                        edges[numEdges].holder = other->owner;
+                        numEdges++;
+                    }
+                }
+
+    while(findVictim(edges, numEdges, &victim))
+    {
+        //the victim stops waiting, which breaks its cycles
+        for(int i = 0; i < lockManager->numPartitions; i++)
+            for(int j = 0; j < lockManager->partitions[i].numBuckets; j++)
+                for(LK_Lock *lock = lockManager->partitions[i].buckets[j]; lock; lock = lock->next)
+                    for(LK_Request *request = lock->requests; request; request = request->next)
+                        if(request->owner == victim && request->isWaiting)
+                            request->isVictim = true;
+        int numLeft = 0;
+        for(int i = 0; i < numEdges; i++)
+            if(edges[i].waiter != victim)
+                edges[numLeft++] = edges[i];
+        numEdges = numLeft;
+        numVictims++;
+    }
+
+    if(numVictims > 0)
+    {
+        pthread_mutex_lock(&lockManager->mutex);
+        lockManager->numDeadlocks += numVictims;
+        pthread_mutex_unlock(&lockManager->mutex);
+        for(int i = 0; i < lockManager->numPartitions; i++)
+            pthread_cond_broadcast(&lockManager->partitions[i].changed);
+    }
+    for(int i = lockManager->numPartitions - 1; i >= 0; i--)
+        pthread_mutex_unlock(&lockManager->partitions[i].mutex);
+    free(edges);
+}
+
+/*********************************************************************
+findVictim searches the waits-for graph depth first for a cycle. Every
+waiting owner is a node, represented by the index of its first edge
+once the edges are sorted by waiter. Owners that don't wait can't be
+on a cycle.
+RETURNS: true and the youngest owner of a cycle in victim, if there is
+         a cycle
+*********************************************************************/
+static bool findVictim(LK_Edge *edges, int numEdges, int *victim)
+{
+    if(numEdges == 0)
+        return false;
+    qsort(edges, numEdges, sizeof(LK_Edge), compareEdges);
+    VALID_CALLOC(char, state, numEdges, sizeof(char)); //0 new, 1 on the stack, 2 done
+    VALID_CALLOC(int, stack, numEdges, sizeof(int));   //nodes on the path
+    VALID_CALLOC(int, nextEdge, numEdges, sizeof(int)); //next edge of every node on the path
+    bool isFound = false;
+    for(int start = 0; start < numEdges && !isFound; start++)
+    {
+        if(state[start] != 0 || (start > 0 && edges[start].waiter == edges[start - 1].waiter))
+            continue;
+        int depth = 0;
+        state[start] = 1;
+        stack[depth] = start;
+        nextEdge[depth++] = start;
+        while(depth > 0 && !isFound)
+        {
+            int node = stack[depth - 1];
+            int edge = nextEdge[depth - 1];
+            if(edge == numEdges || edges[edge].waiter != edges[node].waiter)
+            {
+                state[node] = 2;
+                depth--;
+                continue;
+            }
+            nextEdge[depth - 1]++;
+            int holder = findWaiter(edges, numEdges, edges[edge].holder);
+            if(holder < 0 || state[holder] == 2)
+                continue;
+            if(state[holder] == 1)
+            {
+                //the cycle is the path from holder on
+                int i = depth - 1;
+                *victim = edges[stack[i]].waiter;
+                while(stack[i] != holder)
+                {
+                    i--;
+                    if(edges[stack[i]].waiter > *victim)
+                        *victim = edges[stack[i]].waiter;
+                }
+                isFound = true;
+                continue;
+            }
+            state[holder] = 1;
+            stack[depth] = holder;
+            nextEdge[depth++] = holder;
+        }
+    }
+    free(state);
+    free(stack);
+    free(nextEdge);
+    return isFound;
+}
+
+//RETURNS: the index of the first edge of owner, -1 if owner doesn't wait
+static int findWaiter(LK_Edge *edges, int numEdges, int owner)
+{
+    int low = 0, high = numEdges;
+    while(low < high)
+    {
+        int mid = (low + high) / 2;
+        if(edges[mid].waiter < owner)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return (low < numEdges && edges[low].waiter == owner) ? low : -1;
+}
+
+static int compareEdges(const void *a, const void *b)
+{
+    const LK_Edge *edgeA = (const LK_Edge *) a;
+    const LK_Edge *edgeB = (const LK_Edge *) b;
+    if(edgeA->waiter != edgeB->waiter)
+        return edgeA->waiter < edgeB->waiter ? -1 : 1;
+    return (edgeA->holder > edgeB->holder) - (edgeA->holder < edgeB->holder);
+}
@@ -0,0 +1,105 @@
+#ifndef LOCK_MGR_H
+#define LOCK_MGR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "dberror.h"
+
+/*********************************************************************
+The lock manager grants locks on tables and records to lock owners,
+i.e. transactions or single record calls. Records are locked in
+shared or exclusive mode, tables also in the intention modes that
+announce record locks: IS before S record locks, IX before X record
+locks and SIX for reading the whole table while changing some records.
+
+            IS    IX    S     SIX   X
+      IS    yes   yes   yes   yes   no
+      IX    yes   yes   no    no    no
+      S     yes   no    yes   no    no
+      SIX   yes   no    no    no    no
+      X     no    no    no    no    no
+
+The lock table is a hash table split into partitions with a mutex each,
+so owners locking different resources rarely wait for the same mutex.
+Requests that can't be granted wait in the queue of their resource,
+in arrival order. A lock an owner already holds is converted to the
+stronger of both modes. A background thread periodically builds the
+waits-for graph of the waiting owners and breaks every cycle in it by
+failing the request of the youngest owner in the cycle with
+RC_LK_DEADLOCK. That owner should release its locks, e.g. by aborting.
+*********************************************************************/
+typedef enum LK_LockMode {
+    LOCK_IS = 0,
+    LOCK_IX = 1,
+    LOCK_S = 2,
+    LOCK_SIX = 3,
+    LOCK_X = 4
+} LK_LockMode;
+
+// a table (page and slot -1) or a record of it
+typedef struct LK_ResourceId {
+    uintptr_t table;
+    int page;
+    int slot;
+} LK_ResourceId;
+
+typedef struct LK_Request {
+    int owner;
+    LK_LockMode mode;     //granted mode
+    LK_LockMode waitMode; //mode the owner waits for
+    bool isGranted;
+    bool isWaiting;
+    bool isVictim;        //chosen to break a deadlock
+    struct LK_Request *next;
+} LK_Request;
+
+typedef struct LK_Lock {
+    LK_ResourceId id;
+    LK_Request *requests; //in arrival order
+    struct LK_Lock *next; //next lock in the same bucket
+} LK_Lock;
+
+typedef struct LK_Partition {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed; //signaled when a lock is released or a victim chosen
+    LK_Lock **buckets;
+    int numBuckets;
+} LK_Partition;
+
+typedef struct LK_LockManager {
+    LK_Partition *partitions;
+    int numPartitions;
+    pthread_t detector;
+    pthread_mutex_t mutex;
+    pthread_cond_t stopped;
+    bool isRunning;
+    bool stop;
+    int lastOwner;
+    int numWaiting;   //requests waiting right now
+    int numWaits;     //requests that had to wait
+    int numDeadlocks; //victims chosen
+} LK_LockManager;
+
+// the locks an owner holds, only used by the owner's thread
+typedef struct LK_Owner {
+    int id;
+    LK_ResourceId *held;
+    int numHeld;
+    int capacity;
+} LK_Owner;
+
+// Lock Manager Interface
+extern RC startLockManager (LK_LockManager *lockManager);
+extern RC stopLockManager (LK_LockManager *lockManager);
+extern void initLockOwner (LK_LockManager *lockManager, LK_Owner *owner);
+// waits until the lock is granted, RC_LK_DEADLOCK if the owner is a victim
+extern RC lockResource (LK_LockManager *lockManager, LK_Owner *owner, LK_ResourceId id,
+                        LK_LockMode mode);
+extern RC releaseLocks (LK_LockManager *lockManager, LK_Owner *owner);
+
+// Statistics Interface
+extern int getNumLockWaits (LK_LockManager *lockManager);
+extern int getNumDeadlocks (LK_LockManager *lockManager);
+
+#endif // LOCK_MGR_H
@@ -0,0 +1,661 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "log_mgr.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+/**Must declare RC returnCode in function before using ASSERT_RC_OK**/
+#define ASSERT_RC_OK(functionCall)  \
+    returnCode = functionCall;      \
+    if(returnCode != RC_OK )        \
+       return returnCode;
+
+/*********************************************************************
+Offset Macros for the log file and its records
+*********************************************************************/
+#define startLsnOffset 0
+#define redoLsnOffset sizeof(LM_LSN)
+#define LOG_HDR_SIZE (2 * sizeof(LM_LSN))
+#define recordLengthOffset 0
+#define checksumOffset sizeof(uint32_t)
+#define typeOffset checksumOffset + sizeof(uint32_t)
+#define txIdOffset typeOffset + sizeof(unsigned char)
+#define pageNumOffset txIdOffset + sizeof(uint32_t)
+#define slotNumOffset pageNumOffset + sizeof(uint32_t)
+#define dataLengthOffset slotNumOffset + sizeof(unsigned short)
+#define undoLengthOffset dataLengthOffset + sizeof(unsigned short)
+#define dataOffset undoLengthOffset + sizeof(unsigned short)
+#define LOG_RECORD_HDR_SIZE (dataOffset)
+
+//position of lsn in the log file
+#define fileOffset(info, lsn) ((off_t)(LOG_HDR_SIZE + ((lsn) - (info)->startLsn)))
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static uint32_t calcChecksum(char *record, uint32_t recordLength);
+static int parseLogRecord(char *record, size_t remaining, LM_LogRecord *logRecord);
+static RC readLogFile(int fd, off_t from, char **content, size_t *size);
+static RC writeAll(int fd, char *data, size_t size, off_t offset);
+static void freeLogInfo(LM_LogInfo *info);
+static void waitForFlush(LM_LogInfo *info);
+static RC recycleLog(LM_LogInfo *info);
+static void requeueRecords(LM_LogInfo *info, char *records, size_t size, size_t capacity);
+
+/*********************************************************************
+*
+*                    LOG MANAGER INTERFACE
+*
+*********************************************************************/
+
+/*********************************************************************
+openLog opens the log file fileName and creates it if it doesn't exist.
+A torn record at the end of the log, left by a crash while it was
+written, is cut off.
+*********************************************************************/
+RC openLog (LM_LogHandle *log, char *fileName)
+{
+    RC returnCode = RC_INIT;
+    if(!log || !fileName)
+        return RC_NO_FILENAME;
+    int fd = open(fileName, O_RDWR | O_CREAT, 0644);
+    if(fd < 0)
+        return RC_FILE_NOT_FOUND;
+    LM_LSN header[2] = {0, 0};
+    char *content = NULL;
+    size_t size = 0, fileSize = 0;
+    bool hasHeader = pread(fd, header, LOG_HDR_SIZE, startLsnOffset) == LOG_HDR_SIZE;
+    if(!hasHeader)
+        header[0] = header[1] = 0;
+    //records before redoLsn needn't be read
+    size_t validEnd = LOG_HDR_SIZE + (header[1] - header[0]);
+    returnCode = readLogFile(fd, validEnd, &content, &size);
+    if(returnCode != RC_OK)
+    {
+        close(fd);
+        return returnCode;
+    }
+    fileSize = hasHeader ? validEnd + size : 0;
+    LM_LSN startLsn = header[0];
+    LM_LSN redoLsn = header[1];
+    LM_LogRecord logRecord;
+    int recordLength;
+    size_t offset = 0;
+    while((recordLength = parseLogRecord(content + offset, size - offset, &logRecord)) > 0)
+        offset += recordLength;
+    validEnd += offset;
+    free(content);
+    //new logs get a header, torn logs lose their last record
+    if(!hasHeader)
+        returnCode = writeAll(fd, (char *) header, LOG_HDR_SIZE, 0);
+    else if(validEnd < fileSize && ftruncate(fd, validEnd) != 0)
+        returnCode = RC_LM_WRITE_FAILED;
+    if(returnCode == RC_OK && (!hasHeader || validEnd != fileSize) && fdatasync(fd) != 0)
+        returnCode = RC_LM_SYNC_FAILED;
+    if(returnCode != RC_OK)
+    {
+        close(fd);
+        return returnCode;
+    }
+
+    VALID_CALLOC(LM_LogInfo, info, 1, sizeof(LM_LogInfo));
+    info->fd = fd;
+    info->startLsn = startLsn;
+    info->redoLsn = redoLsn;
+    info->appendLsn = startLsn + (validEnd - LOG_HDR_SIZE);
+    info->flushedLsn = info->appendLsn;
+    info->bufferCapacity = PAGE_SIZE;
+    info->buffer = (char *) malloc(info->bufferCapacity);
+    info->flushCapacity = PAGE_SIZE;
+    info->flushBuffer = (char *) malloc(info->flushCapacity);
+    if(!info->buffer || !info->flushBuffer)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    pthread_mutex_init(&info->mutex, NULL);
+    pthread_cond_init(&info->flushDone, NULL);
+    log->fileName = fileName;
+    log->mgmtData = info;
+    return RC_OK;
+}
+
+/*********************************************************************
+closeLog makes all appended records durable and closes the log
+*********************************************************************/
+RC closeLog (LM_LogHandle *log)
+{
+    if(!log || !log->mgmtData)
+        return RC_LM_LOG_NOT_OPEN;
+    RC returnCode = flushLog(log, log->mgmtData->appendLsn);
+    if(close(log->mgmtData->fd) != 0 && returnCode == RC_OK)
+        returnCode = RC_FILE_NOT_CLOSED;
+    freeLogInfo(log->mgmtData);
+    log->mgmtData = NULL;
+    return returnCode;
+}
+
+RC destroyLog (char *fileName)
+{
+    if(!fileName)
+        return RC_NO_FILENAME;
+    if(unlink(fileName) != 0)
+        return RC_FILE_NOT_FOUND;
+    return RC_OK;
+}
+
+/*********************************************************************
+appendLogRecord adds a record to the log buffer. The record isn't
+durable before flushLog(log, *lsn) returns.
+INPUT:
+    *logRecord: type, txId, pageNum, slotNum, data and undoData of the
+                change, data and undoData may be NULL if their length is 0
+    *lsn: set to the LSN of the record
+*********************************************************************/
+RC appendLogRecord (LM_LogHandle *log, LM_LogRecord *logRecord, LM_LSN *lsn)
+{
+    if(!log || !log->mgmtData)
+        return RC_LM_LOG_NOT_OPEN;
+    int dataLength = logRecord->dataLength;
+    int undoLength = logRecord->undoLength;
+    //the lengths are kept as unsigned shorts, records of large pages fit
+    if(dataLength < 0 || dataLength > USHRT_MAX || (dataLength > 0 && !logRecord->data))
+        return RC_LM_WRITE_FAILED;
+    if(undoLength < 0 || undoLength > USHRT_MAX || (undoLength > 0 && !logRecord->undoData))
+        return RC_LM_WRITE_FAILED;
+    LM_LogInfo *info = log->mgmtData;
+    uint32_t recordLength = LOG_RECORD_HDR_SIZE + dataLength + undoLength;
+    unsigned char recordType = (unsigned char) logRecord->type;
+    uint32_t txId = (uint32_t) logRecord->txId;
+    uint32_t page = (uint32_t) logRecord->pageNum;
+    unsigned short slot = (unsigned short) logRecord->slotNum;
+    unsigned short length = (unsigned short) dataLength;
+    unsigned short undo = (unsigned short) undoLength;
+
+    pthread_mutex_lock(&info->mutex);
+    if(info->bufferSize + recordLength > info->bufferCapacity)
+    {
+        size_t capacity = info->bufferCapacity;
+        while(info->bufferSize + recordLength > capacity)
+            capacity *= 2;
+        char *buffer = (char *) realloc(info->buffer, capacity);
+        if(!buffer)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+        info->buffer = buffer;
+        info->bufferCapacity = capacity;
+    }
+    char *record = info->buffer + info->bufferSize;
+    memcpy(record + recordLengthOffset, &recordLength, sizeof(uint32_t));
+    memcpy(record + typeOffset, &recordType, sizeof(unsigned char));
+    memcpy(record + txIdOffset, &txId, sizeof(uint32_t));
+    memcpy(record + pageNumOffset, &page, sizeof(uint32_t));
+    memcpy(record + slotNumOffset, &slot, sizeof(unsigned short));
+    memcpy(record + dataLengthOffset, &length, sizeof(unsigned short));
+    memcpy(record + undoLengthOffset, &undo, sizeof(unsigned short));
+    if(dataLength > 0)
+        memcpy(record + dataOffset, logRecord->data, dataLength);
+    if(undoLength > 0)
+        memcpy(record + dataOffset + dataLength, logRecord->undoData, undoLength);
+    uint32_t checksum = calcChecksum(record, recordLength);
+    memcpy(record + checksumOffset, &checksum, sizeof(uint32_t));
+    info->bufferSize += recordLength;
+    info->appendLsn += recordLength;
+    info->numRecords++;
+    if(lsn)
+        *lsn = info->appendLsn;
+    pthread_mutex_unlock(&info->mutex);
+    return RC_OK;
+}
+
+/*********************************************************************
+flushLog returns once every record up to lsn is durable. If no other
+caller is flushing, this caller writes all records appended so far and
+syncs the log once for all of them. Otherwise it waits for the flushing
+caller, whose write may already include lsn. Records whose write or
+sync failed stay in the buffer, ahead of those appended meanwhile, so
+the next flush writes them again.
+*********************************************************************/
+RC flushLog (LM_LogHandle *log, LM_LSN lsn)
+{
+    if(!log || !log->mgmtData)
+        return RC_LM_LOG_NOT_OPEN;
+    LM_LogInfo *info = log->mgmtData;
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&info->mutex);
+    if(lsn > info->appendLsn)
+        lsn = info->appendLsn;
+    while(info->flushedLsn < lsn && returnCode == RC_OK)
+    {
+        if(info->isFlushing)
+        {
+            pthread_cond_wait(&info->flushDone, &info->mutex);
+            continue;
+        }
+        //take everything appended so far, later appends go to the other buffer
+        info->isFlushing = true;
+        char *flushBuffer = info->buffer;
+        size_t flushSize = info->bufferSize;
+        size_t flushCapacity = info->bufferCapacity;
+        info->buffer = info->flushBuffer;
+        info->bufferCapacity = info->flushCapacity;
+        info->bufferSize = 0;
+        LM_LSN fromLsn = info->flushedLsn;
+        LM_LSN toLsn = info->appendLsn;
+        off_t offset = fileOffset(info, fromLsn);
+        pthread_mutex_unlock(&info->mutex);
+
+        returnCode = writeAll(info->fd, flushBuffer, flushSize, offset);
+        if(returnCode == RC_OK && fdatasync(info->fd) != 0)
+            returnCode = RC_LM_SYNC_FAILED;
+
+        pthread_mutex_lock(&info->mutex);
+        info->isFlushing = false;
+        if(returnCode == RC_OK)
+        {
+            info->flushBuffer = flushBuffer;
+            info->flushCapacity = flushCapacity;
+            info->flushedLsn = toLsn;
+            info->numFlushes++;
+        }
+        else
+            requeueRecords(info, flushBuffer, flushSize, flushCapacity);
+        pthread_cond_broadcast(&info->flushDone);
+    }
+    pthread_mutex_unlock(&info->mutex);
+    return returnCode;
+}
+
+/*********************************************************************
+redoLog calls redo for every record in the log file after the redo
+LSN, oldest first. It stops at the first error redo returns.
+*********************************************************************/
+RC redoLog (LM_LogHandle *log, LM_RedoFunc redo, void *context)
+{
+    RC returnCode = RC_INIT;
+    if(!log || !log->mgmtData)
+        return RC_LM_LOG_NOT_OPEN;
+    LM_LogInfo *info = log->mgmtData;
+    ASSERT_RC_OK(flushLog(log, info->appendLsn));
+    char *content = NULL;
+    size_t size = 0;
+    LM_LSN redoLsn = getRedoLsn(log);
+    ASSERT_RC_OK(readLogFile(info->fd, fileOffset(info, redoLsn), &content, &size));
+    size_t offset = 0;
+    LM_LogRecord logRecord;
+    int recordLength;
+    returnCode = RC_OK;
+    while(returnCode == RC_OK
+            && (recordLength = parseLogRecord(content + offset, size - offset, &logRecord)) > 0)
+    {
+        offset += recordLength;
+        logRecord.lsn = redoLsn + offset;
+        returnCode = redo(context, &logRecord);
+        pthread_mutex_lock(&info->mutex);
+        info->numRedoRecords++;
+        pthread_mutex_unlock(&info->mutex);
+    }
+    free(content);
+    return returnCode;
+}
+
+/*********************************************************************
+setRedoLsn is called by a checkpoint once the changes of all records up
+to lsn are durable in the page file, so redoLog skips them. The file
+drops them once they take more room than the records after lsn, see
+recycleLog, so the log of a table that stays open doesn't keep growing.
+*********************************************************************/
+RC setRedoLsn (LM_LogHandle *log, LM_LSN lsn)
+{
+    RC returnCode = RC_INIT;
+    if(!log || !log->mgmtData)
+        return RC_LM_LOG_NOT_OPEN;
+    LM_LogInfo *info = log->mgmtData;
+    //the header may only point to durable records
+    ASSERT_RC_OK(flushLog(log, lsn));
+    pthread_mutex_lock(&info->mutex);
+    if(lsn <= info->redoLsn || lsn < info->startLsn)
+    {
+        pthread_mutex_unlock(&info->mutex);
+        return RC_OK;
+    }
+    returnCode = writeAll(info->fd, (char *) &lsn, sizeof(LM_LSN), redoLsnOffset);
+    if(returnCode == RC_OK && fdatasync(info->fd) != 0)
+        returnCode = RC_LM_SYNC_FAILED;
+    if(returnCode == RC_OK)
+    {
+        info->redoLsn = lsn;
+        returnCode = recycleLog(info);
+    }
+    pthread_mutex_unlock(&info->mutex);
+    return returnCode;
+}
+
+/*********************************************************************
+truncateLog empties the log once the changes of all its records are
+durable in the page file. It holds the latch of the log throughout, so
+no records are appended meanwhile: those appended before are dropped,
+the records not written yet with them, those appended after go to the
+emptied log.
+*********************************************************************/
+RC truncateLog (LM_LogHandle *log)
+{
+    RC returnCode = RC_OK;
+    if(!log || !log->mgmtData)
+        return RC_LM_LOG_NOT_OPEN;
+    LM_LogInfo *info = log->mgmtData;
+    pthread_mutex_lock(&info->mutex);
+    waitForFlush(info);
+    //the records still in the buffer needn't be written any more
+    info->bufferSize = 0;
+    info->flushedLsn = info->appendLsn;
+    pthread_cond_broadcast(&info->flushDone);
+    if(info->appendLsn == info->startLsn)
+    {
+        pthread_mutex_unlock(&info->mutex);
+        return RC_OK;
+    }
+    LM_LSN header[2] = {info->appendLsn, info->appendLsn};
+    if(ftruncate(info->fd, LOG_HDR_SIZE) != 0)
+        returnCode = RC_LM_WRITE_FAILED;
+    if(returnCode == RC_OK)
+        returnCode = writeAll(info->fd, (char *) header, LOG_HDR_SIZE, startLsnOffset);
+    if(returnCode == RC_OK && fdatasync(info->fd) != 0)
+        returnCode = RC_LM_SYNC_FAILED;
+    if(returnCode == RC_OK)
+    {
+        info->startLsn = info->appendLsn;
+        info->redoLsn = info->appendLsn;
+    }
+    pthread_mutex_unlock(&info->mutex);
+    return returnCode;
+}
+
+//true if no record of the log has to be redone
+bool isLogEmpty (LM_LogHandle *log)
+{
+    return getRedoSize(log) == 0;
+}
+
+/*********************************************************************
+*
+*                      STATISTICS INTERFACE
+*
+*********************************************************************/
+LM_LSN getFlushedLsn (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    LM_LSN flushedLsn = log->mgmtData->flushedLsn;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return flushedLsn;
+}
+
+int getNumLogRecords (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    int numRecords = log->mgmtData->numRecords;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return numRecords;
+}
+
+int getNumLogFlushes (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    int numFlushes = log->mgmtData->numFlushes;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return numFlushes;
+}
+
+LM_LSN getAppendLsn (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    LM_LSN appendLsn = log->mgmtData->appendLsn;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return appendLsn;
+}
+
+LM_LSN getRedoLsn (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    LM_LSN redoLsn = log->mgmtData->redoLsn;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return redoLsn;
+}
+
+/*********************************************************************
+getRedoSize returns the bytes of records a recovery would redo now
+*********************************************************************/
+size_t getRedoSize (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    size_t redoSize = log->mgmtData->appendLsn - log->mgmtData->redoLsn;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return redoSize;
+}
+
+//records redone by redoLog since the log was opened
+int getNumRedoRecords (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    int numRedoRecords = log->mgmtData->numRedoRecords;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return numRedoRecords;
+}
+
+//times checkpoints dropped records from the file since the log was opened
+int getNumLogRecycles (LM_LogHandle *log)
+{
+    pthread_mutex_lock(&log->mgmtData->mutex);
+    int numRecycles = log->mgmtData->numRecycles;
+    pthread_mutex_unlock(&log->mgmtData->mutex);
+    return numRecycles;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+
+//FNV-1a over the record without its checksum field
+static uint32_t calcChecksum(char *record, uint32_t recordLength)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for(uint32_t i = 0; i < recordLength; i++)
+    {
+        if(i == checksumOffset)
+            i += sizeof(uint32_t);
+        hash ^= (unsigned char) record[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/*********************************************************************
+parseLogRecord reads the record at the start of record
+RETURNS: length of the record or -1 if it is torn or corrupt
+*********************************************************************/
+static int parseLogRecord(char *record, size_t remaining, LM_LogRecord *logRecord)
+{
+    uint32_t recordLength, checksum, txId, pageNum;
+    unsigned char type;
+    unsigned short slotNum, dataLength, undoLength;
+    if(remaining < LOG_RECORD_HDR_SIZE)
+        return -1;
+    memcpy(&recordLength, record + recordLengthOffset, sizeof(uint32_t));
+    if(recordLength < LOG_RECORD_HDR_SIZE || recordLength > remaining)
+        return -1;
+    memcpy(&checksum, record + checksumOffset, sizeof(uint32_t));
+    memcpy(&type, record + typeOffset, sizeof(unsigned char));
+    memcpy(&txId, record + txIdOffset, sizeof(uint32_t));
+    memcpy(&pageNum, record + pageNumOffset, sizeof(uint32_t));
+    memcpy(&slotNum, record + slotNumOffset, sizeof(unsigned short));
+    memcpy(&dataLength, record + dataLengthOffset, sizeof(unsigned short));
+    memcpy(&undoLength, record + undoLengthOffset, sizeof(unsigned short));
+    if(recordLength != LOG_RECORD_HDR_SIZE + dataLength + undoLength
+            || checksum != calcChecksum(record, recordLength))
+        return -1;
+    if(type < LOG_INSERT || type > LOG_ABORT)
+        return -1;
+    logRecord->type = (LM_LogRecordType) type;
+    logRecord->txId = (int) txId;
+    logRecord->pageNum = (int) pageNum;
+    logRecord->slotNum = slotNum;
+    logRecord->dataLength = dataLength;
+    logRecord->data = record + dataOffset;
+    logRecord->undoLength = undoLength;
+    logRecord->undoData = record + dataOffset + dataLength;
+    logRecord->lsn = 0;
+    return (int) recordLength;
+}
+
+//reads the log file from offset from to its end
+static RC readLogFile(int fd, off_t from, char **content, size_t *size)
+{
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+        return RC_FILE_NOT_INITIALIZED;
+    *size = st.st_size > from ? st.st_size - from : 0;
+    *content = (char *) malloc(*size + 1);
+    if(!*content)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    size_t done = 0;
+    while(done < *size)
+    {
+        ssize_t numRead = pread(fd, *content + done, *size - done, from + done);
+        if(numRead <= 0)
+        {
+            free(*content);
+            *content = NULL;
+            return RC_READ_FILE_FAILED;
+        }
+        done += numRead;
+    }
+    return RC_OK;
+}
+
+static RC writeAll(int fd, char *data, size_t size, off_t offset)
+{
+    while(size > 0)
+    {
+        ssize_t numWritten = pwrite(fd, data, size, offset);
+        if(numWritten <= 0)
+            return RC_LM_WRITE_FAILED;
+        data += numWritten;
+        size -= numWritten;
+        offset += numWritten;
+    }
+    return RC_OK;
+}
+
+/*********************************************************************
+requeueRecords puts the size bytes of records a flush failed to write
+back in front of the records appended since, records becomes the
+buffer and the buffer the flush buffer. The mutex must be held.
+*********************************************************************/
+static void requeueRecords(LM_LogInfo *info, char *records, size_t size, size_t capacity)
+{
+    if(size + info->bufferSize > capacity)
+    {
+        while(size + info->bufferSize > capacity)
+            capacity *= 2;
+        records = (char *) realloc(records, capacity);
+        if(!records)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+    }
+    memcpy(records + size, info->buffer, info->bufferSize);
+    info->flushBuffer = info->buffer;
+    info->flushCapacity = info->bufferCapacity;
+    info->buffer = records;
+    info->bufferCapacity = capacity;
+    info->bufferSize += size;
+}
+
+//waits until no caller is writing records outside the mutex, which is held
+static void waitForFlush(LM_LogInfo *info)
+{
+    while(info->isFlushing)
+        pthread_cond_wait(&info->flushDone, &info->mutex);
+}
+
+/*********************************************************************
+recycleLog moves the durable records from redoLsn on to the start of
+the file and cuts off the rest, once the records before redoLsn take
+more room than them. Every byte moved is matched by more bytes dropped,
+so moving costs no more than appending did. The mutex must be held.
+The records are moved and synced before the header points to them, and
+their end is marked, so a crash at any point leaves a log that redoes
+the same records. Neither the moved records nor the mark overwrite a
+record that hasn't been moved yet.
+*********************************************************************/
+static RC recycleLog(LM_LogInfo *info)
+{
+    uint32_t endMark = 0;
+    waitForFlush(info);
+    size_t dropSize = info->redoLsn - info->startLsn;
+    size_t keepSize = info->flushedLsn - info->redoLsn;
+    if(dropSize < keepSize + sizeof(endMark))
+        return RC_OK;
+    char *records = NULL;
+    size_t size = 0;
+    LM_LSN header[2] = {info->redoLsn, info->redoLsn};
+    RC returnCode = readLogFile(info->fd, fileOffset(info, info->redoLsn), &records, &size);
+    if(returnCode == RC_OK && size < keepSize)
+        returnCode = RC_READ_FILE_FAILED;
+    if(returnCode == RC_OK)
+        returnCode = writeAll(info->fd, records, keepSize, LOG_HDR_SIZE);
+    if(returnCode == RC_OK)
+        returnCode = writeAll(info->fd, (char *) &endMark, sizeof(endMark), LOG_HDR_SIZE + keepSize);
+    if(returnCode == RC_OK && fdatasync(info->fd) != 0)
+        returnCode = RC_LM_SYNC_FAILED;
+    if(returnCode == RC_OK)
+        returnCode = writeAll(info->fd, (char *) header, LOG_HDR_SIZE, startLsnOffset);
+    if(returnCode == RC_OK && fdatasync(info->fd) != 0)
+        returnCode = RC_LM_SYNC_FAILED;
+    if(returnCode == RC_OK)
+    {
+        info->startLsn = info->redoLsn;
+        info->numRecycles++;
+        if(ftruncate(info->fd, LOG_HDR_SIZE + keepSize) != 0)
+            returnCode = RC_LM_WRITE_FAILED;
+    }
+    free(records);
+    return returnCode;
+}
+
+static void freeLogInfo(LM_LogInfo *info)
+{
+    pthread_mutex_destroy(&info->mutex);
+    pthread_cond_destroy(&info->flushDone);
+    free(info->buffer);
+    free(info->flushBuffer);
+    free(info);
+}
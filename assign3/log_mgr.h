@@ -0,0 +1,108 @@
+#ifndef LOG_MGR_H
+#define LOG_MGR_H
+
+// Include return codes and methods for logging errors
+#include "dberror.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/*********************************************************************
+The log manager keeps a write-ahead log of redo records for a page
+file. Records are appended to an in-memory buffer and made durable by
+flushLog. Callers that flush at the same time share one write and
+fdatasync (group commit): the first caller writes everything appended
+so far, the others wait for it and return if their record was included.
+
+Log file layout:
+---------------------------------------------------------------------------
+LM_LSN startLsn | LM_LSN redoLsn | record | record | ...
+---------------------------------------------------------------------------
+record: uint recordLength | uint checksum | uchar type | uint txId |
+        uint pageNum | ushort slotNum | ushort dataLength |
+        ushort undoLength | data | undoData
+
+The LSN of a record is the position right after it, counted from the
+first record ever appended, so LSNs keep growing when the log is
+truncated. A record with a bad length or checksum ends the log.
+Records before redoLsn are durable in the page file since the last
+checkpoint, so recovery starts at redoLsn, and the checkpoint drops
+them from the file, moving startLsn up to redoLsn.
+*********************************************************************/
+typedef uint64_t LM_LSN;
+
+typedef enum LM_LogRecordType {
+    LOG_INSERT = 1, // data is the new record
+    LOG_UPDATE = 2, // data is the new record, undoData the old one
+    LOG_DELETE = 3, // undoData is the old record
+    LOG_COMMIT = 4, // transaction txId committed
+    LOG_ABORT = 5   // the changes of transaction txId were undone
+} LM_LogRecordType;
+
+/*********************************************************************
+Changes made outside of a transaction have txId 0 and are committed by
+themselves. Changes of transactions carry their undoData, so recovery
+can undo the ones of transactions that neither committed nor aborted.
+*********************************************************************/
+typedef struct LM_LogRecord {
+    LM_LogRecordType type;
+    int txId;
+    int pageNum;
+    int slotNum;
+    int dataLength;
+    char *data;
+    int undoLength;
+    char *undoData;
+    LM_LSN lsn;
+} LM_LogRecord;
+
+typedef struct LM_LogInfo {
+    int fd;
+    LM_LSN startLsn;   //LSN of the start of the first record in the file
+    LM_LSN redoLsn;    //LSN of the first record that has to be redone
+    LM_LSN appendLsn;  //end of the last appended record
+    LM_LSN flushedLsn; //end of the last durable record
+    char *buffer;      //records appended since the last flush
+    size_t bufferSize;
+    size_t bufferCapacity;
+    char *flushBuffer; //records being written by the flushing caller
+    size_t flushCapacity;
+    bool isFlushing;
+    pthread_mutex_t mutex;
+    pthread_cond_t flushDone;
+    int numRecords;    //records appended since the log was opened
+    int numFlushes;    //fdatasyncs since the log was opened
+    int numRedoRecords; //records redone since the log was opened
+    int numRecycles;   //times the records before redoLsn were dropped
+} LM_LogInfo;
+
+typedef struct LM_LogHandle {
+    char *fileName;
+    LM_LogInfo *mgmtData;
+} LM_LogHandle;
+
+// called by redoLog for every record in the log
+typedef RC (*LM_RedoFunc)(void *context, LM_LogRecord *logRecord);
+
+// Log Manager Interface
+extern RC openLog (LM_LogHandle *log, char *fileName);
+extern RC closeLog (LM_LogHandle *log);
+extern RC destroyLog (char *fileName);
+extern RC appendLogRecord (LM_LogHandle *log, LM_LogRecord *logRecord, LM_LSN *lsn);
+extern RC flushLog (LM_LogHandle *log, LM_LSN lsn);
+extern RC redoLog (LM_LogHandle *log, LM_RedoFunc redo, void *context);
+extern RC setRedoLsn (LM_LogHandle *log, LM_LSN lsn);
+extern RC truncateLog (LM_LogHandle *log);
+extern bool isLogEmpty (LM_LogHandle *log);
+
+// Statistics Interface
+extern LM_LSN getFlushedLsn (LM_LogHandle *log);
+extern int getNumLogRecords (LM_LogHandle *log);
+extern int getNumLogFlushes (LM_LogHandle *log);
+extern LM_LSN getAppendLsn (LM_LogHandle *log);
+extern LM_LSN getRedoLsn (LM_LogHandle *log);
+extern size_t getRedoSize (LM_LogHandle *log);
+extern int getNumRedoRecords (LM_LogHandle *log);
+extern int getNumLogRecycles (LM_LogHandle *log);
+
+#endif // LOG_MGR_H
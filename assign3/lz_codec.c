@@ -0,0 +1,182 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "lz_codec.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5
+//a match starts at least this many bytes before the end of the block
+#define LZ_MATCH_LIMIT 12
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+#define LZ_RUN_MASK 15
+
+/*********************************************************************
+*
+*                        PRIVATE FUNCTIONS
+*
+*********************************************************************/
+static uint32_t read32(const char *p);
+static int hashSequence(uint32_t sequence);
+static bool emitSequence(char *dest, int *op, int capacity, const char *literals, int numLiterals,
+                         int offset, int matchLength);
+static bool emitLength(char *dest, int *op, int capacity, int length);
+static int readLength(const unsigned char *src, int srcSize, int *ip, int length);
+
+/*********************************************************************
+*
+*                         CODEC FUNCTIONS
+*
+*********************************************************************/
+
+//greedy: every position is looked up in a hash table of the last
+//position a 4 byte sequence was seen at
+int lzCompress (const char *src, int srcSize, char *dest, int capacity)
+{
+    int table[1 << LZ_HASH_BITS];
+    memset(table, -1, sizeof(table));
+    int ip = 0, anchor = 0, op = 0;
+    int matchEnd = srcSize - LZ_LAST_LITERALS;
+    while(ip <= srcSize - LZ_MATCH_LIMIT)
+    {
+        uint32_t sequence = read32(src + ip);
+        int h = hashSequence(sequence);
+        int ref = table[h];
+        table[h] = ip;
+        if(ref < 0 || ip - ref > LZ_MAX_OFFSET || read32(src + ref) != sequence)
+        {
+            ip++;
+            continue;
+        }
+        int matchLength = LZ_MIN_MATCH;
+        while(ip + matchLength < matchEnd && src[ref + matchLength] == src[ip + matchLength])
+            matchLength++;
+        //the literals before the match may belong to it
+        while(ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+        {
+            ip--;
+            ref--;
+            matchLength++;
+        }
+        if(!emitSequence(dest, &op, capacity, src + anchor, ip - anchor, ip - ref, matchLength))
+            return 0;
+        ip += matchLength;
+        anchor = ip;
+    }
+    if(!emitSequence(dest, &op, capacity, src + anchor, srcSize - anchor, 0, 0))
+        return 0;
+    return op;
+}
+
+int lzDecompress (const char *src, int srcSize, char *dest, int capacity)
+{
+    const unsigned char *in = (const unsigned char *) src;
+    int ip = 0, op = 0;
+    while(ip < srcSize)
+    {
+        int token = in[ip++];
+        int numLiterals = readLength(in, srcSize, &ip, token >> 4);
+        if(numLiterals < 0 || numLiterals > srcSize - ip || numLiterals > capacity - op)
+            return -1;
+        memcpy(dest + op, src + ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+        //the last sequence has no match
+        if(ip == srcSize)
+            break;
+        if(srcSize - ip < 2)
+            return -1;
+        int offset = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        int matchLength = readLength(in, srcSize, &ip, token & LZ_RUN_MASK);
+        if(offset == 0 || offset > op || matchLength < 0)
+            return -1;
+        matchLength += LZ_MIN_MATCH;
+        if(matchLength > capacity - op)
+            return -1;
+        //byte by byte, the match may overlap the bytes it produces
+        for(int i = 0; i < matchLength; i++)
+            dest[op + i] = dest[op - offset + i];
+        op += matchLength;
+    }
+    return op;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+
+static uint32_t read32(const char *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(uint32_t));
+    return value;
+}
+
+static int hashSequence(uint32_t sequence)
+{
+    return (int) ((sequence * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+//a match length of 0 writes the literals of the last sequence only
+static bool emitSequence(char *dest, int *op, int capacity, const char *literals, int numLiterals,
+                         int offset, int matchLength)
+{
+    if(*op >= capacity)
+        return false;
+    int matchCode = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+    int token = (numLiterals < LZ_RUN_MASK ? numLiterals : LZ_RUN_MASK) << 4;
+    token |= matchCode < LZ_RUN_MASK ? matchCode : LZ_RUN_MASK;
+    dest[(*op)++] = (char) token;
+    if(!emitLength(dest, op, capacity, numLiterals) || numLiterals > capacity - *op)
+        return false;
+    memcpy(dest + *op, literals, numLiterals);
+    *op += numLiterals;
+    if(matchLength == 0)
+        return true;
+    if(capacity - *op < 2)
+        return false;
+    dest[(*op)++] = (char) (offset & 0xff);
+    dest[(*op)++] = (char) (offset >> 8);
+    return emitLength(dest, op, capacity, matchCode);
+}
+
+//the bytes that follow a 4 bit length of 15
+static bool emitLength(char *dest, int *op, int capacity, int length)
+{
+    if(length < LZ_RUN_MASK)
+        return true;
+    for(length -= LZ_RUN_MASK; ; length -= 255)
+    {
+        if(*op >= capacity)
+            return false;
+        dest[(*op)++] = (char) (length >= 255 ? 255 : length);
+        if(length < 255)
+            return true;
+    }
+}
+
+//adds the bytes that follow a 4 bit length of 15, -1 past the end
+static int readLength(const unsigned char *src, int srcSize, int *ip, int length)
+{
+    if(length < LZ_RUN_MASK)
+        return length;
+    int b;
+    do
+    {
+        if(*ip >= srcSize)
+            return -1;
+        b = src[(*ip)++];
+        length += b;
+    }
+    while(b == 255);
+    return length;
+}
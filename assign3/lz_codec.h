@@ -0,0 +1,26 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+/*********************************************************************
+A fast LZ77 codec in the LZ4 block format, used to compress pages.
+A block is a list of sequences:
+
+---------------------------------------------------------------------------
+uchar token | literal length bytes | literals | ushort offset |
+match length bytes |
+---------------------------------------------------------------------------
+The high 4 bits of token are the number of literals, the low 4 bits
+the match length minus 4; 15 means bytes follow that add to it until
+one isn't 255. The match copies match length bytes from offset bytes
+back, it may overlap itself. The last sequence has literals only and
+the last 5 bytes of a block are always literals.
+*********************************************************************/
+
+// compresses srcSize bytes of src into dest. Returns the size of the
+// block or 0 if it needs more than capacity bytes
+extern int lzCompress (const char *src, int srcSize, char *dest, int capacity);
+// decompresses a block into dest. Returns the number of bytes decoded
+// or -1 if the block is corrupt or decodes to more than capacity bytes
+extern int lzDecompress (const char *src, int srcSize, char *dest, int capacity);
+
+#endif // LZ_CODEC_H
@@ -0,0 +1,326 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "mvcc.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+#define MVCC_NUM_BUCKETS 256
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static unsigned int hashRID(RID id, int numBuckets);
+static void growChainsPerPage(RM_VersionStore *store, unsigned int pageNum);
+static void freeVersions(RM_Version *version);
+static bool isVisible(RM_Version *version, int txId, RM_Timestamp snapshotTs);
+static RM_Timestamp getOldestSnapshotTs(RM_VersionStore *store);
+
+/*********************************************************************
+*
+*                      VERSION STORE FUNCTIONS
+*
+*********************************************************************/
+void initVersionStore (RM_VersionStore *store)
+{
+    memset(store, 0, sizeof(RM_VersionStore));
+    store->numBuckets = MVCC_NUM_BUCKETS;
+    VALID_CALLOC(RM_VersionChain *, buckets, store->numBuckets, sizeof(RM_VersionChain *));
+    store->buckets = buckets;
+}
+
+void freeVersionStore (RM_VersionStore *store)
+{
+    for(int i = 0; i < store->numBuckets; i++)
+    {
+        RM_VersionChain *chain = store->buckets[i];
+        while(chain)
+        {
+            RM_VersionChain *next = chain->next;
+            freeVersions(chain->newest);
+            free(chain);
+            chain = next;
+        }
+    }
+    free(store->buckets);
+    free(store->numChainsPerPage);
+    free(store->snapshots);
+    memset(store, 0, sizeof(RM_VersionStore));
+}
+
+/*********************************************************************
+*
+*                        SNAPSHOT FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+beginSnapshot registers a snapshot of the versions committed so far
+RETURNS: the transaction id of the snapshot
+*********************************************************************/
+int beginSnapshot (RM_VersionStore *store, RM_Timestamp *snapshotTs)
+{
+    if(store->numSnapshots == store->snapshotCapacity)
+    {
+        store->snapshotCapacity = store->snapshotCapacity ? 2*store->snapshotCapacity : 4;
+        store->snapshots = (RM_Snapshot *) realloc(store->snapshots,
+                           store->snapshotCapacity * sizeof(RM_Snapshot));
+        if(!store->snapshots)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+    }
+    RM_Snapshot *snapshot = &store->snapshots[store->numSnapshots++];
+    snapshot->txId = ++store->lastTxId;
+    snapshot->snapshotTs = store->lastCommitTs;
+    snapshot->firstLsn = 0;
+    snapshot->hasLogged = false;
+    *snapshotTs = snapshot->snapshotTs;
+    return snapshot->txId;
+}
+
+void endSnapshot (RM_VersionStore *store, int txId)
+{
+    for(int i = 0; i < store->numSnapshots; i++)
+        if(store->snapshots[i].txId == txId)
+        {
+            store->snapshots[i] = store->snapshots[--store->numSnapshots];
+            return;
+        }
+}
+
+bool hasSnapshots (RM_VersionStore *store)
+{
+    return store->numSnapshots > 0;
+}
+
+//remembers where the first log record of txId starts
+void setFirstLsn (RM_VersionStore *store, int txId, LM_LSN lsn)
+{
+    for(int i = 0; i < store->numSnapshots; i++)
+        if(store->snapshots[i].txId == txId && !store->snapshots[i].hasLogged)
+        {
+            store->snapshots[i].firstLsn = lsn;
+            store->snapshots[i].hasLogged = true;
+            return;
+        }
+}
+
+bool getOldestFirstLsn (RM_VersionStore *store, LM_LSN *lsn)
+{
+    bool found = false;
+    for(int i = 0; i < store->numSnapshots; i++)
+        if(store->snapshots[i].hasLogged && (!found || store->snapshots[i].firstLsn < *lsn))
+        {
+            *lsn = store->snapshots[i].firstLsn;
+            found = true;
+        }
+    return found;
+}
+
+/*********************************************************************
+*
+*                     VERSION CHAIN FUNCTIONS
+*
+*********************************************************************/
+RM_VersionChain *findVersionChain (RM_VersionStore *store, RID id)
+{
+    if(store->numChains == 0)
+        return NULL;
+    RM_VersionChain *chain = store->buckets[hashRID(id, store->numBuckets)];
+    while(chain && (chain->id.page != id.page || chain->id.slot != id.slot))
+        chain = chain->next;
+    return chain;
+}
+
+RM_VersionChain *getVersionChain (RM_VersionStore *store, RID id, bool slotInUse)
+{
+    RM_VersionChain *chain = findVersionChain(store, id);
+    if(chain)
+        return chain;
+
+    VALID_CALLOC(RM_Version, base, 1, sizeof(RM_Version));
+    base->commitTs = 0;
+    base->isDeleted = !slotInUse;
+    VALID_CALLOC(RM_VersionChain, newChain, 1, sizeof(RM_VersionChain));
+    newChain->id = id;
+    newChain->newest = base;
+    unsigned int bucket = hashRID(id, store->numBuckets);
+    newChain->next = store->buckets[bucket];
+    store->buckets[bucket] = newChain;
+    store->numChains++;
+    growChainsPerPage(store, id.page);
+    store->numChainsPerPage[id.page]++;
+    return newChain;
+}
+
+bool pageHasVersions (RM_VersionStore *store, unsigned int pageNum)
+{
+    return pageNum < store->numPages && store->numChainsPerPage[pageNum] > 0;
+}
+
+//RETURNS: the newest version the snapshot sees, NULL if there is none
+RM_Version *getVisibleVersion (RM_VersionChain *chain, int txId, RM_Timestamp snapshotTs)
+{
+    RM_Version *version = chain->newest;
+    while(version && !isVisible(version, txId, snapshotTs))
+        version = version->older;
+    return version;
+}
+
+RC checkWrite (RM_VersionChain *chain, int txId, RM_Timestamp snapshotTs)
+{
+    RM_Version *newest = chain->newest;
+    if(!isVisible(newest, txId, snapshotTs))
+        return RC_RM_WRITE_CONFLICT;
+    if(newest->isDeleted)
+        return RC_RM_RECORD_NOT_FOUND;
+    return RC_OK;
+}
+
+void pushVersion (RM_VersionChain *chain, int txId, RM_Timestamp commitTs, bool isDeleted,
+                  char *pageData, int recordSize)
+{
+    RM_Version *older = chain->newest;
+    if(!older->data && !older->isDeleted)
+    {
+        VALID_CALLOC(char, data, recordSize, sizeof(char));
+        memcpy(data, pageData, recordSize);
+        older->data = data;
+    }
+    VALID_CALLOC(RM_Version, version, 1, sizeof(RM_Version));
+    version->commitTs = commitTs;
+    version->txId = txId;
+    version->isDeleted = isDeleted;
+    version->older = older;
+    chain->newest = version;
+}
+
+/*********************************************************************
+popVersion drops the newest version of a change that is undone. The
+version before it becomes the newest again, so its data belongs into
+the page.
+*********************************************************************/
+char *popVersion (RM_VersionChain *chain)
+{
+    RM_Version *newest = chain->newest;
+    chain->newest = newest->older;
+    free(newest->data);
+    free(newest);
+    char *data = chain->newest->data;
+    chain->newest->data = NULL;
+    return data;
+}
+
+void commitVersions (RM_VersionChain *chain, int txId, RM_Timestamp commitTs)
+{
+    for(RM_Version *version = chain->newest; version; version = version->older)
+        if(version->txId == txId && version->commitTs == TS_UNCOMMITTED)
+            version->commitTs = commitTs;
+}
+
+/*********************************************************************
+pruneVersions frees the versions that no active snapshot can see
+anymore, i.e. those older than the newest version committed before the
+oldest snapshot. Chains whose newest version everyone sees are removed.
+*********************************************************************/
+void pruneVersions (RM_VersionStore *store)
+{
+    RM_Timestamp oldestTs = getOldestSnapshotTs(store);
+    for(int i = 0; i < store->numBuckets && store->numChains > 0; i++)
+    {
+        RM_VersionChain **link = &store->buckets[i];
+        while(*link)
+        {
+            RM_VersionChain *chain = *link;
+            RM_Version *version = chain->newest;
+            while(version && version->commitTs > oldestTs)
+                version = version->older;
+            if(version == chain->newest)
+            {
+                *link = chain->next;
+                store->numChains--;
+                store->numChainsPerPage[chain->id.page]--;
+                freeVersions(chain->newest);
+                free(chain);
+                continue;
+            }
+            if(version)
+            {
+                freeVersions(version->older);
+                version->older = NULL;
+            }
+            link = &chain->next;
+        }
+    }
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+static unsigned int hashRID(RID id, int numBuckets)
+{
+    unsigned int hash = (unsigned int) id.page * 2654435761u + (unsigned int) id.slot;
+    return hash % numBuckets;
+}
+
+static void growChainsPerPage(RM_VersionStore *store, unsigned int pageNum)
+{
+    if(pageNum < store->numPages)
+        return;
+    unsigned int numPages = store->numPages ? store->numPages : 16;
+    while(numPages <= pageNum)
+        numPages *= 2;
+    store->numChainsPerPage = (int *) realloc(store->numChainsPerPage, numPages * sizeof(int));
+    if(!store->numChainsPerPage)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    memset(store->numChainsPerPage + store->numPages, 0,
+           (numPages - store->numPages) * sizeof(int));
+    store->numPages = numPages;
+}
+
+static void freeVersions(RM_Version *version)
+{
+    while(version)
+    {
+        RM_Version *older = version->older;
+        free(version->data);
+        free(version);
+        version = older;
+    }
+}
+
+static bool isVisible(RM_Version *version, int txId, RM_Timestamp snapshotTs)
+{
+    if(version->commitTs == TS_UNCOMMITTED)
+        return txId != 0 && version->txId == txId;
+    return version->commitTs <= snapshotTs || (txId != 0 && version->txId == txId);
+}
+
+//snapshots taken from now on see every committed version
+static RM_Timestamp getOldestSnapshotTs(RM_VersionStore *store)
+{
+    RM_Timestamp oldestTs = store->lastCommitTs;
+    for(int i = 0; i < store->numSnapshots; i++)
+        if(store->snapshots[i].snapshotTs < oldestTs)
+            oldestTs = store->snapshots[i].snapshotTs;
+    return oldestTs;
+}
@@ -0,0 +1,92 @@
+#ifndef MVCC_H
+#define MVCC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "dberror.h"
+#include "tables.h"
+#include "log_mgr.h"
+
+/*********************************************************************
+The version store keeps the older versions of records that snapshots
+may still have to read. Pages always hold the newest version of a
+record, which may not be committed yet. Records changed while a
+snapshot or transaction was active get a version chain, newest first:
+a version is visible to a snapshot if its writer is the snapshot's own
+transaction or if it committed before the snapshot was taken. Slots
+without a chain are visible to everyone as they are in the page.
+
+Only the newest version of a chain may lack data, its data then is the
+content of the page. Chains are pruned once every active snapshot sees
+their newest version.
+*********************************************************************/
+typedef uint64_t RM_Timestamp;
+
+#define TS_UNCOMMITTED UINT64_MAX
+
+typedef struct RM_Version {
+    RM_Timestamp commitTs; //TS_UNCOMMITTED until the writer commits
+    int txId;              //writer, 0 for changes outside transactions
+    bool isDeleted;        //the slot is empty in this version
+    char *data;            //copy of the record, NULL if it is in the page
+    struct RM_Version *older;
+} RM_Version;
+
+typedef struct RM_VersionChain {
+    RID id;
+    RM_Version *newest;
+    struct RM_VersionChain *next; //next chain in the same bucket
+} RM_VersionChain;
+
+typedef struct RM_Snapshot {
+    int txId;
+    RM_Timestamp snapshotTs; //sees versions committed up to this
+    LM_LSN firstLsn;         //start of the first log record of the transaction
+    bool hasLogged;
+} RM_Snapshot;
+
+typedef struct RM_VersionStore {
+    RM_VersionChain **buckets;
+    int numBuckets;
+    int numChains;
+    int *numChainsPerPage;
+    unsigned int numPages;
+    RM_Timestamp lastCommitTs;
+    int lastTxId;
+    RM_Snapshot *snapshots;  //active transactions and scans
+    int numSnapshots;
+    int snapshotCapacity;
+} RM_VersionStore;
+
+extern void initVersionStore (RM_VersionStore *store);
+extern void freeVersionStore (RM_VersionStore *store);
+
+// snapshots
+extern int beginSnapshot (RM_VersionStore *store, RM_Timestamp *snapshotTs);
+extern void endSnapshot (RM_VersionStore *store, int txId);
+extern bool hasSnapshots (RM_VersionStore *store);
+extern void setFirstLsn (RM_VersionStore *store, int txId, LM_LSN lsn);
+// returns false if no active transaction has logged a change
+extern bool getOldestFirstLsn (RM_VersionStore *store, LM_LSN *lsn);
+
+// version chains
+extern RM_VersionChain *findVersionChain (RM_VersionStore *store, RID id);
+// returns the chain of id, a new chain starts with the page content
+// as a version everyone sees
+extern RM_VersionChain *getVersionChain (RM_VersionStore *store, RID id, bool slotInUse);
+extern bool pageHasVersions (RM_VersionStore *store, unsigned int pageNum);
+extern RM_Version *getVisibleVersion (RM_VersionChain *chain, int txId, RM_Timestamp snapshotTs);
+// RC_RM_WRITE_CONFLICT if another transaction wrote the newest version
+// after snapshotTs, RC_RM_RECORD_NOT_FOUND if it is deleted
+extern RC checkWrite (RM_VersionChain *chain, int txId, RM_Timestamp snapshotTs);
+// pageData is the current content of the slot, it is kept with the
+// version that stops being the newest
+extern void pushVersion (RM_VersionChain *chain, int txId, RM_Timestamp commitTs, bool isDeleted,
+                         char *pageData, int recordSize);
+// RETURNS: the copy of the data of the version that is the newest again,
+// the caller puts it back into the page and frees it
+extern char *popVersion (RM_VersionChain *chain);
+extern void commitVersions (RM_VersionChain *chain, int txId, RM_Timestamp commitTs);
+extern void pruneVersions (RM_VersionStore *store);
+
+#endif // MVCC_H
@@ -2,11 +2,14 @@
 #include <string.h>
 #include <stddef.h>
 #include <unistd.h>
+#include <limits.h>
 
 #include "bitmap.h"
 #include "record_mgr.h"
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
+#include "column_codec.h"
+#include "catalog.h"
 
 /*********************************************************************
 *
@@ -34,21 +37,60 @@ Offset Macros for retrieving data from the PageFile header
 #define pageNumOffset sizeof(unsigned int)
 #define nextFreePageOffset numTuplesOffset + sizeof(unsigned int)
 #define numSlotsPerPageOffset nextFreePageOffset + pageNumOffset
-#define schemaSizeOffset numSlotsPerPageOffset + sizeof(unsigned short)
+#define pageLayoutOffset numSlotsPerPageOffset + sizeof(unsigned short)
+#define schemaSizeOffset pageLayoutOffset + sizeof(unsigned short)
 #define schemaOffset schemaSizeOffset + sizeof(unsigned short)
-#define numAttrOffset schemaOffset
-#define dataTypeOffset(i) schemaOffset + ((2*i)+1)*sizeof(unsigned short)
-#define typeLengthOffset(i) schemaOffset + 2*(i+1)*sizeof(unsigned short)
-/**keySizeOffset requires defining numAttr**/
-#define keySizeOffset schemaOffset + ((2*numAttr)+1)*sizeof(unsigned short)
-#define keyAttrOffset(i) keySizeOffset + i*sizeof(unsigned short)
-/**firstNameOffset requires defining keySize**/
-#define attrNamesOffset keySizeOffset + keySize*sizeof(unsigned short)
 
 /*********************************************************************
 Offset Macros for retrieving data from the Page header
 *********************************************************************/
+#define pageLsnOffset 2*pageNumOffset //LSN of the last logged change
+#define bitmapHdrOffset pageLsnOffset + sizeof(LM_LSN)
 #define bitmapOffset(i) i*sizeof(bitmap_type) //i is the bitmap->words
+#define slotsOffset bitmapHdrOffset + 2*sizeof(int) //slots follow the bitmap
+
+/*********************************************************************
+Offset Macros for the slot area of compressed PAX pages
+*********************************************************************/
+#define numSlotsUsedOffset 0
+#define pageFlagsOffset sizeof(unsigned short)
+#define columnBlocksOffset 2*sizeof(unsigned short)
+#define PAGE_FULL 1
+
+//compressed pages hold at most this many times the slots of a PAX page
+#define RM_MAX_COMPRESSION_RATIO 4
+//bytes inserts leave free on compressed pages, so updates can grow them
+#define RM_COMPRESSED_PAGE_RESERVE(pageSize) ((pageSize)/32)
+
+//write-ahead log of a table
+#define LOG_SUFFIX ".wal"
+
+/*********************************************************************
+Recovery keeps the records of every transaction that hasn't committed
+or aborted in the log read so far, so they can be undone after redo
+*********************************************************************/
+typedef struct RM_RecoveryTx {
+    int txId;
+    LM_LogRecord *records; //only type, slot and undoData are kept
+    int numRecords;
+    int capacity;
+} RM_RecoveryTx;
+
+typedef struct RM_Recovery {
+    RM_TableData *rel;
+    RM_RecoveryTx *txs;
+    int numTxs;
+    int capacity;
+} RM_Recovery;
+
+//locks of all tables, started by initRecordManager
+static LK_LockManager lockManager;
+//frames of all tables, created by initRecordManager
+static BM_BufferPool sharedPool;
+//settings of the pool and the tables, set by initRecordManager
+static RM_Config managerConfig;
+//tables opened or created so far, loaded by initRecordManager
+static RM_Catalog catalog = RM_CATALOG_INITIALIZER;
 
 /*********************************************************************
 *
@@ -57,12 +99,73 @@ Offset Macros for retrieving data from the Page header
 *********************************************************************/
 // Prototypes for helper functions
 int static findFreeSlot(bitmap * bitMap);
-static RC preparePFHdr(Schema *schema, char *pHandle);
+static void resetManagerConfig(void);
+static RC preparePFHdr(Schema *schema, RM_PageLayout layout, int pageSize, char *pHandle);
 static RC deleteFromFreeLinkedList(char* pfhr,char *phr, BM_BufferPool*bm);
 static RC appendToFreeLinkedList(char * pfhr, char * phr,BM_BufferPool * bm);
 static int getAttrOffset(Schema *schema, int attrNum);
 static RC findNewPageNum(RM_TableData * rel, unsigned int * nextFreePage);
-static unsigned short calcNumSlotsPerPage(unsigned short recordSize);
+static unsigned short calcNumSlotsPerPage(unsigned short recordSize, int pageSize);
+static unsigned short calcMaxSlotsPerPage(unsigned short recordSize, int pageSize);
+static RC findTable(char *name, RM_CatalogEntry *entry);
+static RC initTableInfo(RM_TableData *rel, RM_CatalogEntry *entry);
+static void freeTableInfo(RM_TableData *rel);
+static char* getSlotsPH(char *phrFrame);
+static void readSlot(RM_TableData *rel, char *phrFrame, int slotNum, char *data);
+static void readSlotAttr(RM_TableData *rel, char *phrFrame, int slotNum, int attrNum, char *data);
+static RC writeSlot(RM_TableData *rel, char *phrFrame, int slotNum, char *data, int reserve);
+static char* getColumnBlock(RM_TableData *rel, char *phrFrame, int attrNum);
+static void decodePage(RM_TableData *rel, char *phrFrame, char *columns);
+static RC encodePage(RM_TableData *rel, char *phrFrame, char *columns, int numSlotsUsed, int reserve);
+static bool isPageFull(RM_TableData *rel, char *phrFrame, bitmap *b);
+static void markAttrRefs(Expr *expr, bool *attrRefs);
+static bool isSimplePredicate(Expr *cond, int *attrNum, OpType *op, bool *consOnLeft, Value **cons);
+static bool filterPage(RM_ScanHandle *scan, char *phrFrame);
+static char* getSideFileName(char *name, char *suffix);
+static void destroySideFiles(char *name);
+static void destroySidePageFile(char *name, char *suffix);
+static RC openPageSummaries(RM_TableData *rel);
+static RC savePageSummaries(RM_TableData *rel, bool isClean);
+static RC rebuildPageSummaries(RM_TableData *rel);
+static void rebuildPageSummary(RM_TableData *rel, unsigned int pageNum, char *phrFrame);
+static RC applyInsert(RM_TableData *rel, Record *record, int txId, LM_LSN *lsn);
+static RC applyDelete(RM_TableData *rel, RID id, int txId, LM_LSN *lsn);
+static RC applyUpdate(RM_TableData *rel, Record *record, int txId, LM_LSN *lsn);
+static RC moveRecord(RM_TableData *rel, Record *record, LM_LSN *lsn);
+static RC moveRecordTx(RM_Transaction *tx, Record *record);
+static RC applyRestore(RM_TableData *rel, Record *record, int txId, LM_LSN *lsn);
+static RC readVisible(RM_TableData *rel, RID id, int txId, RM_Timestamp snapshotTs, Record *record);
+static RC readSlotState(RM_TableData *rel, RID id, char *data, bool *inUse);
+static RC pushSlotVersion(RM_TableData *rel, RID id, int txId, RM_Timestamp snapshotTs, bool isDeleted);
+static void addWrite(RM_Transaction *tx, RID id, RM_WriteKind kind);
+static RC lockRecord(LK_Owner *locks, RM_TableData *rel, RID *id, LK_LockMode mode);
+static RC undoTransaction(RM_Transaction *tx);
+static void endTransaction(RM_Transaction *tx);
+static RC initScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+static RC nextVisible(RM_ScanHandle *scan, Record *record);
+static RC logChange(RM_TableData *rel, LM_LogRecordType type, int txId, RID id, char *data,
+                    char *undoData, char *phrFrame, LM_LSN *lsn);
+static LM_LSN getCheckpointLsn(RM_TableData *rel);
+static RC flushLogForPage(void *context, BM_PageHandle *page);
+static RC recoverTable(RM_TableData *rel);
+static RC redoLogRecord(void *context, LM_LogRecord *logRecord);
+static void trackLoserRecord(RM_Recovery *recovery, LM_LogRecord *logRecord);
+static RC undoLoserRecords(RM_Recovery *recovery);
+static void freeRecovery(RM_Recovery *recovery);
+static RC pinRedoPage(RM_TableData *rel, int pageNum, BM_PageHandle *page);
+static RC repairTable(RM_TableData *rel);
+static void initDataPage(RM_TableData *rel, char *phrFrame);
+static RC syncTable(RM_TableData *rel);
+static RC openMappedTable(RM_TableData *rel, char *name);
+static RC closeMappedTable(RM_TableData *rel);
+static RC pinTablePage(RM_TableData *rel, BM_PageHandle *page, int pageNum);
+static RC unpinTablePage(RM_TableData *rel, BM_PageHandle *page);
+static void pinBeforeLatch(RM_TableData *rel, BM_PageHandle *page, int pageNum);
+static void unpinAfterLatch(RM_TableData *rel, BM_PageHandle *page);
+static void pinWritePages(RM_Transaction *tx, bool onlyDeletes);
+static int getFreePageHint(RM_TableData *rel, char *pfHdrFrame);
+static RC getTableNumPages(RM_TableData *rel, int *numPages);
+static void adviseMappedScans(RM_TableData *rel, int delta);
 
 // Prototypes for getters and setters for pagefile header data
 static unsigned short getRecordSizePF(char *pfHdrFrame);
@@ -71,15 +174,8 @@ static void setNumTuplesPF(char *pfHdrFrame, unsigned int numTuples);
 static unsigned int getNextFreePage(char *pfHdrFrame);
 static void setNextFreePage(char *pfHdrFrame, unsigned int nextFreePage);
 static unsigned short getNumSlotsPerPage(char *pfHdrFrame);
+static RM_PageLayout getPageLayout(char *pfHdrFrame);
 static unsigned short getSchemaSize(char *pfHdrFrame);
-static void getSchema(char *pfHdrFrame, Schema *schema);
-static unsigned short getNumAttr(char *pfHdrFrame);
-static DataType getIthDataType(char *pfHdrFrame, int ithSlot);
-static unsigned short getIthTypeLength(char *pfHdrFrame, int ithSlot);
-static unsigned short getKeySize(char *pfHdrFrame);
-static unsigned short getIthKeyAttr(char *pfHdrFrame, int ithSlot);
-static unsigned short getIthNameLength(char *pfHdrFrame, int ithSlot);
-static char* getIthAttrName(char *pfHdrFrame, int ithSlot);
 
 //prototypes for getters and setters for page header
 static bitmap* getBitMapPH(char * phrFrame);
@@ -91,6 +187,11 @@ static unsigned int getPrevFreePagePH(char *phrFrame);
 static unsigned int getNextFreePagePH(char *phrFrame);
 static void setPrevFreePagePH(char * phrFrame, unsigned int pageNum);
 static void setNextFreePagePH(char * phrFrame, unsigned int pageNum);
+static LM_LSN getPageLsnPH(char *phrFrame);
+static void setPageLsnPH(char *phrFrame, LM_LSN pageLsn);
+static unsigned short getNumSlotsUsedPH(char *phrFrame);
+static void setNumSlotsUsedPH(char *phrFrame, unsigned short numSlotsUsed);
+static void setPageFullPH(char *phrFrame, bool isFull);
 
 /*********************************************************************
 * Notes:
@@ -106,50 +207,151 @@ static void setNextFreePagePH(char * phrFrame, unsigned int pageNum);
 *********************************************************************/
 
 /*********************************************************************
-initRecordManager doesn't seem to do anything. test_assign3_1.c just
-passes NULL in mgmtData
+initRecordManager starts the lock manager and creates the buffer pool
+shared by all tables. mgmtData may point to an RM_Config (see config.h,
+e.g. read by loadConfig) that sets the size and replacement strategy of
+the pool and the settings openTable uses for the tables. The record
+manager keeps a copy of it. The system catalog is loaded from the
+catalog file of the configuration, if it has one (see catalog.h). A
+catalog file that can't be opened is an error, one that is cut short
+or fails its checksum gives an empty catalog. If a step fails, those
+before it are undone.
+test_assign3_1.c just passes NULL in mgmtData
 *********************************************************************/
 RC initRecordManager (void *mgmtData)
 {
-    return RC_OK;
+    RC returnCode = RC_INIT;
+    if(sharedPool.mgmtData)
+        return RC_OK;
+    if(mgmtData)
+        copyConfig(&managerConfig, (RM_Config *) mgmtData);
+    else
+        initConfig(&managerConfig);
+    setHugePages(managerConfig.hugePages);
+    setDirectIO(managerConfig.directIO);
+    setExtentSize(managerConfig.extentSize);
+    setPageChecksums(managerConfig.pageChecksums);
+    setSegmentSize(managerConfig.segmentSize);
+    setSegmentDirs(managerConfig.segmentDirs);
+    returnCode = loadCatalog(&catalog, managerConfig.catalogFile);
+    if(returnCode == RC_OK)
+    {
+        returnCode = initSharedPool(&sharedPool, managerConfig.numPoolFrames,
+                                    managerConfig.poolStrategy, managerConfig.poolStratData);
+        if(returnCode == RC_OK)
+        {
+            returnCode = startLockManager(&lockManager);
+            if(returnCode != RC_OK)
+            {
+                shutdownBufferPool(&sharedPool);
+                sharedPool.mgmtData = NULL;
+            }
+        }
+        if(returnCode != RC_OK)
+            clearCatalog(&catalog);
+    }
+    if(returnCode != RC_OK)
+        resetManagerConfig();
+    return returnCode;
 }
 
 /*********************************************************************
-shutdownRecordManager also doesn't seem to need to do anything.
+shutdownRecordManager stops the lock manager, frees the shared buffer
+pool and saves the catalog, all tables should be closed before.
 Does not need to free RID or table (freed in test_assign3_1.C)
 *********************************************************************/
 RC shutdownRecordManager ()
 {
-    return RC_OK;
+    RC returnCode = RC_INIT;
+    if(sharedPool.mgmtData)
+    {
+        ASSERT_RC_OK(shutdownBufferPool(&sharedPool));
+        sharedPool.mgmtData = NULL;
+        ASSERT_RC_OK(saveCatalog(&catalog));
+        clearCatalog(&catalog);
+        resetManagerConfig();
+    }
+    return stopLockManager(&lockManager);
+}
+
+//the buffer pool the tables share, for its statistics
+BM_BufferPool *getSharedPool (void)
+{
+    return &sharedPool;
+}
+
+//the lock manager of the record manager, for its statistics
+LK_LockManager *getLockManager (void)
+{
+    return &lockManager;
 }
 
 /*********************************************************************
 createTable creates the underlying page file and stores information
 about the schema, free-space, ... and so on in the Table Information
-page(s).
+page(s). Records are stored row by row (RM_LAYOUT_NSM).
 INPUT:
     name: valid string file name
     schema: fully initialized schema
 *********************************************************************/
 RC createTable (char *name, Schema *schema)
+{
+    return createTableEx(name, schema, RM_LAYOUT_NSM);
+}
+
+/*********************************************************************
+createTableEx works like createTable, but lets the caller choose how
+records are laid out inside the data pages. RM_LAYOUT_PAX stores every
+attribute of the records on a page in its own contiguous minipage, so
+scans that only look at a few attributes touch less memory.
+RM_LAYOUT_PAX_COMPRESSED additionally encodes every minipage with the
+smallest encoding for its values (see column_codec.h), so more records
+fit on a page. The pages are as large as page_size in the configuration
+of the table says, see createPageFileEx.
+INPUT:
+    name: valid string file name
+    schema: fully initialized schema
+    layout: RM_LAYOUT_NSM, RM_LAYOUT_PAX or RM_LAYOUT_PAX_COMPRESSED
+*********************************************************************/
+RC createTableEx (char *name, Schema *schema, RM_PageLayout layout)
 {
     RC returnCode = RC_INIT;
     //validate input
     if(!name || !schema)
         return RC_RM_INIT_ERROR;
+    if(layout != RM_LAYOUT_NSM && layout != RM_LAYOUT_PAX && layout != RM_LAYOUT_PAX_COMPRESSED)
+        return RC_RM_INIT_ERROR;
     //make sure a page file with that name doesn't already exist
 //TODO: uncomment the file existence check when testing is complete
 //    if(!access(name, F_OK))
 //        return RC_RM_FILE_ALREADY_EXISTS;
-    //create a page file
-    ASSERT_RC_OK(createPageFile(name));
+    //the catalog must not describe a table that is replaced
+    ASSERT_RC_OK(removeCatalogTable(&catalog, name));
+    //create a page file, compressed if the configuration says so
+    RM_TableConfig *config = getTableConfig(&managerConfig, name);
+    int pageSize = config->pageSize > 0 ? config->pageSize : PAGE_SIZE;
+    if(config->compressPages)
+    {
+        //compressed page files only hold pages of PAGE_SIZE bytes
+        if(pageSize != PAGE_SIZE)
+            return RC_INCOMPATIBLE_BLOCKSIZE;
+        ASSERT_RC_OK(createCompressedPageFile(name));
+    }
+    else
+    {
+        ASSERT_RC_OK(createPageFileEx(name, pageSize));
+    }
+    //side files left behind by an older table with that name are stale
+    destroySideFiles(name);
     //open the page file
     SM_FileHandle fHandle;
     ASSERT_RC_OK(openPageFile(name, &fHandle));
     //write page file header
-    VALID_CALLOC(char, pHandle, 1, PAGE_SIZE);
-    ASSERT_RC_OK(preparePFHdr(schema, pHandle));
+    VALID_CALLOC(char, pHandle, 1, fHandle.pageSize);
+    ASSERT_RC_OK(preparePFHdr(schema, layout, fHandle.pageSize, pHandle));
     ASSERT_RC_OK(writeBlock(0, &fHandle, pHandle));
+    //the table is hot right after it was created
+    addCatalogTable(&catalog, name, schema, layout, fHandle.pageSize, getNumSlotsPerPage(pHandle));
     //close the page file
     ASSERT_RC_OK(closePageFile(&fHandle));
     //free allocated memory
@@ -159,40 +361,98 @@ RC createTable (char *name, Schema *schema)
 }
 
 /*********************************************************************
-openTable initializes the RM_TableData struct
+openTable initializes the RM_TableData struct with the settings the
+configuration of the record manager has for the table
 INPUT:
     *rel: pointer to allocated memory of an uninitialized RM_TableData
     *name: valid string file name
 *********************************************************************/
 RC openTable (RM_TableData *rel, char *name)
+{
+    return openTableEx(rel, name, NULL);
+}
+
+/*********************************************************************
+openTableEx works like openTable with the settings in config instead,
+e.g. a private buffer pool sized for the working set of the table.
+The schema and the PageFile header values come from the catalog, the
+header is only read for a table the catalog doesn't have yet. Tables
+with the same schema share it.
+A table whose pages don't fit the frames of the shared pool gets a
+private pool of as much memory as RM_DEFAULT_POOL_FRAMES frames of
+PAGE_SIZE bytes instead.
+INPUT:
+    *rel: pointer to allocated memory of an uninitialized RM_TableData
+    *name: valid string file name
+    *config: settings of the table, NULL for those of the configuration
+*********************************************************************/
+RC openTableEx (RM_TableData *rel, char *name, RM_TableConfig *config)
 {
     RC returnCode = RC_INIT;
     // validate input
     if(!rel || !name)
         return RC_RM_INIT_ERROR;
-    // open the page file
-    SM_FileHandle fHandle;
-    ASSERT_RC_OK(openPageFile(name, &fHandle));
-    // initialize a buffer pool
+    if(!config)
+        config = getTableConfig(&managerConfig, name);
+    // read-only tables are served from a mapping of the page file
+    if(config->readOnly)
+        return openMappedTable(rel, name);
+    // look the table up in the catalog
+    RM_CatalogEntry entry;
+    ASSERT_RC_OK(findTable(name, &entry));
+    // cache the pages in a pool of the table's own or in the shared one
     VALID_CALLOC(BM_BufferPool, bm, 1, sizeof(BM_BufferPool));
-    ASSERT_RC_OK(initBufferPool(bm, name, 1000, RS_LRU, NULL));
-    // pin page with pageFile header
-    BM_PageHandle pfHdr;
-    ASSERT_RC_OK(pinPage(bm, &pfHdr, 0));
-    // create a pointer and allocate memory for a schema struct
-    VALID_CALLOC(Schema, schema, 1, sizeof(Schema));
-    // populate the schema struct with the schema from disk
-    getSchema(pfHdr.data, schema);
-    // initialize RM_TableData
+    if(config->numPoolFrames > 0)
+        returnCode = initBufferPool(bm, name, config->numPoolFrames, config->poolStrategy,
+                                    config->poolStratData);
+    else if(entry.pageSize != getFrameSize(&sharedPool))
+        returnCode = initBufferPool(bm, name, RM_DEFAULT_POOL_FRAMES*PAGE_SIZE/entry.pageSize,
+                                    config->poolStrategy, config->poolStratData);
+    else
+        returnCode = attachBufferPool(bm, &sharedPool, name);
+    bool hasPool = returnCode == RC_OK, hasCheckpointer = false;
+    // initialize RM_TableData with the interned schema
     rel->name = name;
-    rel->schema = schema;
+    rel->schema = entry.schema;
     rel->bufferPool = bm;
-    // close the page file
-    ASSERT_RC_OK(closePageFile(&fHandle));
-    // unpin page with pageFile header
-    ASSERT_RC_OK(unpinPage(bm, &pfHdr));
-
-    return RC_OK;
+    rel->mgmtData = NULL;
+    if(returnCode == RC_OK)
+        returnCode = initTableInfo(rel, &entry);
+    if(returnCode == RC_OK)
+    {
+        rel->mgmtData->prefetchDepth = config->prefetchDepth;
+        rel->mgmtData->checkpointLogSize = config->checkpointLogSize;
+        // redo the changes in the write-ahead log that didn't reach the page file
+        returnCode = recoverTable(rel);
+    }
+    // start the writer for checkpoints
+    if(returnCode == RC_OK)
+    {
+        returnCode = startCheckpointer(&rel->mgmtData->checkpointer, bm, &rel->mgmtData->log,
+                                       config->checkpointWriteDelay);
+        hasCheckpointer = returnCode == RC_OK;
+    }
+    // load the zone maps and bloom filters, or rebuild them if they
+    // weren't saved cleanly
+    if(returnCode == RC_OK)
+        returnCode = openPageSummaries(rel);
+    if(returnCode == RC_OK)
+        return RC_OK;
+    // undo what was set up, in reverse order. The pool goes before the
+    // log, its before-write hook may still flush the log.
+    if(hasCheckpointer)
+        stopCheckpointer(&rel->mgmtData->checkpointer);
+    if(hasPool)
+        shutdownBufferPool(bm);
+    if(rel->mgmtData && rel->mgmtData->log.mgmtData)
+        closeLog(&rel->mgmtData->log);
+    if(rel->mgmtData)
+        freeTableInfo(rel);
+    releaseSchema(&catalog, entry.schema);
+    free(bm);
+    rel->bufferPool = NULL;
+    rel->schema = NULL;
+    return returnCode;
 }
 
 /*********************************************************************
@@ -205,11 +465,22 @@ RC closeTable (RM_TableData *rel)
     // validate input
     if(!rel)
         return RC_RM_INIT_ERROR;
-    // shutdown the buffer pool (which forces a pool flush)
+    if(rel->mgmtData && rel->mgmtData->mapping.pages)
+        return closeMappedTable(rel);
+    // detach from the shared pool (which forces a flush of the table's pages)
     RC returnCode = RC_INIT;
+    // a running checkpoint is given up, the pool is flushed anyway
+    ASSERT_RC_OK(stopCheckpointer(&rel->mgmtData->checkpointer));
+    // save the zone maps and bloom filters
+    ASSERT_RC_OK(savePageSummaries(rel, true));
     ASSERT_RC_OK(shutdownBufferPool(rel->bufferPool));
-    // free memory allocated for arrays in schema
-    ASSERT_RC_OK(freeSchema(rel->schema));
+    // the log isn't needed once the pages are durable
+    ASSERT_RC_OK(syncTable(rel));
+    ASSERT_RC_OK(closeLog(&rel->mgmtData->log));
+    // free the bookkeeping cached at openTable
+    freeTableInfo(rel);
+    // the schema is freed once no table uses it
+    releaseSchema(&catalog, rel->schema);
     // free BM_BufferPool pointer
     free(rel->bufferPool);
     // don't free rel->name since it's allocated by the caller
@@ -217,7 +488,8 @@ RC closeTable (RM_TableData *rel)
 }
 
 /*********************************************************************
-deleteTable deletes the underlying page file
+deleteTable deletes the underlying page file and removes the table
+from the catalog
 INPUT: name of the pageFile where the table is stored
 *********************************************************************/
 RC deleteTable (char *name)
@@ -227,7 +499,9 @@ RC deleteTable (char *name)
         return RC_RM_INIT_ERROR;
     // destroyPageFile(name)
     destroyPageFile(name);
-    return RC_OK;
+    // the side files only exist once the table was opened
+    destroySideFiles(name);
+    return removeCatalogTable(&catalog, name);
 }
 
 /*********************************************************************
@@ -242,15 +516,61 @@ int getNumTuples (RM_TableData *rel)
     // pin the page with the pageFile header
     BM_PageHandle pfHdr;
     RC returnCode = RC_INIT;
-    ASSERT_RC_OK(pinPage(rel->bufferPool, &pfHdr, 0));
+    ASSERT_RC_OK(pinTablePage(rel, &pfHdr, 0));
     // read numTuples from the header
     int numTuples = getNumTuplesPF(pfHdr.data);
     // unpin the page with the pageFile header
-    ASSERT_RC_OK(unpinPage(rel->bufferPool, &pfHdr));
+    ASSERT_RC_OK(unpinTablePage(rel, &pfHdr));
     // return numTuples
     return numTuples;
 }
 
+/*********************************************************************
+addBloomFilter adds a bloom filter on attribute attrNum to every data
+page of the table, so scans comparing it to a constant can skip pages.
+The filters of the existing pages are built right away, the filter
+stays on the table until it is deleted.
+INPUT:
+    rel: opened table
+    attrNum: attribute to filter on
+*********************************************************************/
+RC addBloomFilter (RM_TableData *rel, int attrNum)
+{
+    RC returnCode = RC_INIT;
+    // validate input
+    if(!rel || !rel->mgmtData)
+        return RC_RM_INIT_ERROR;
+    ASSERT_RC_OK(addBloomFilterAttr(&rel->mgmtData->bloomFilters, attrNum));
+    ASSERT_RC_OK(rebuildPageSummaries(rel));
+    // remember the filter even if the table isn't closed cleanly
+    return savePageSummaries(rel, false);
+}
+
+/*********************************************************************
+checkpointTable runs a checkpoint and waits for it, so a recovery only
+redoes the changes made after it. Checkpoints also run on their own
+once the log has grown by checkpointLogSize bytes (see RM_TableConfig)
+since the last one.
+INPUT: opened table
+*********************************************************************/
+RC checkpointTable (RM_TableData *rel)
+{
+    RC returnCode = RC_INIT;
+    // validate input
+    if(!rel || !rel->mgmtData)
+        return RC_RM_INIT_ERROR;
+    // read-only tables have no log
+    if(rel->mgmtData->mapping.pages)
+        return RC_OK;
+    // let a running checkpoint finish, it may have missed later changes
+    ASSERT_RC_OK(waitForCheckpoint(&rel->mgmtData->checkpointer));
+    pthread_mutex_lock(&rel->mgmtData->latch);
+    LM_LSN lsn = getCheckpointLsn(rel);
+    pthread_mutex_unlock(&rel->mgmtData->latch);
+    ASSERT_RC_OK(beginCheckpoint(&rel->mgmtData->checkpointer, lsn));
+    return waitForCheckpoint(&rel->mgmtData->checkpointer);
+}
+
 /*********************************************************************
 *
 *                        RECORD FUNCTIONS
@@ -265,88 +585,42 @@ INPUT:
 *********************************************************************/
 RC insertRecord (RM_TableData *rel, Record *record)
 {
-    RC returnCode = RC_INIT;
-    bool newPageCreated = false;
-
     //validate input
-    if(!rel)
+    if(!rel || !rel->mgmtData)
         return RC_RM_INIT_ERROR;
     if(!record)
         return RC_RM_INIT_ERROR;
-    //create two local BM_PageHandles
-    BM_PageHandle pageFileHeader;
-    BM_PageHandle pageToInsert;
-    BM_BufferPool* bm = rel->bufferPool;
-    //pin the page with the pageFile header
-    ASSERT_RC_OK(pinPage(bm,&pageFileHeader,0));
-    //find the first page with free slot from pageFile header
-    unsigned int freePageNum = getNextFreePage(pageFileHeader.data);
-    if(freePageNum==0)
-    {
-        ASSERT_RC_OK(findNewPageNum(rel, &freePageNum));
-        newPageCreated=true;
-    }
-    //update record->id.page
-    record->id.page = freePageNum;
-    //pin the first page with a free slot
-    ASSERT_RC_OK(pinPage(bm,&pageToInsert,freePageNum));
-    //setup page header if it is a new page
-    if(newPageCreated)
-    {
-        ASSERT_RC_OK(forcePage(bm, &pageToInsert));
-        //set up pages
-        setNextFreePagePH(pageToInsert.data, 0);
-        setPrevFreePagePH(pageToInsert.data, freePageNum);
-        appendToFreeLinkedList(pageFileHeader.data, pageToInsert.data, bm);
-        bitmap * b = bitmap_allocate((int) getNumSlotsPerPage(pageFileHeader.data));
-        setBitMapPH(pageToInsert.data, b);
-        bitmap_deallocate(b);
-    }
-    //find free slot using pageHeader bitMap
-    bitmap * b = getBitMapPH(pageToInsert.data);
-    unsigned short nextFreeSlot = findFreeSlot(b);
-    if(nextFreeSlot==getNumSlotsPerPage(pageFileHeader.data))
-        return RC_RM_NO_FREE_PAGES;
-    //update record->id.slot
-    record->id.slot = nextFreeSlot;
-    //read location of next free slot from current slot
-    int recordSize = getRecordSize(rel->schema);
-    //maybe put this into a macro
-    char * slotPtr = pageToInsert.data;
-    slotPtr+= 2*pageNumOffset + 2* sizeof(int);
-    slotPtr+= bitmapOffset(getBitMapWordsPH(pageToInsert.data)); // add the bitMap size offset
-    slotPtr+= (nextFreeSlot * recordSize );
-    //write record->data to current slot
-    //maybe we don't need to do recordSize +1 because we don't want the null char
-    //at the end of the record data array
-    memcpy(slotPtr, record->data,recordSize);
-    //update the bitMap
-    bitmap_set(b, nextFreeSlot);
-    setBitMapArrayPH(pageToInsert.data, b);
-
-    //check if the page doesn't have anymore slots
-    //so the page will be removed from the linked list
-    if(findFreeSlot(b)==getNumSlotsPerPage(pageFileHeader.data))
+    if(rel->mgmtData->mapping.pages)
+        return RC_RM_READ_ONLY;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    RM_VersionStore *versions = &tableInfo->versions;
+    LM_LSN lsn;
+    BM_PageHandle header, freePage;
+    LK_Owner locks;
+    initLockOwner(&lockManager, &locks);
+    //nobody else can lock the free slot
+    RC returnCode = lockRecord(&locks, rel, NULL, LOCK_X);
+    if(returnCode == RC_OK)
     {
-        ASSERT_RC_OK(deleteFromFreeLinkedList(pageFileHeader.data,pageToInsert.data,bm));
+        pinBeforeLatch(rel, &header, 0);
+        pinBeforeLatch(rel, &freePage, header.data ? getFreePageHint(rel, header.data) : NO_PAGE);
+        pthread_mutex_lock(&tableInfo->latch);
+        returnCode = applyInsert(rel, record, 0, &lsn);
+        //snapshots taken before must not see the record
+        if(returnCode == RC_OK && (hasSnapshots(versions) || findVersionChain(versions, record->id)))
+            pushVersion(getVersionChain(versions, record->id, false), 0, ++versions->lastCommitTs,
+                        false, NULL, tableInfo->recordSize);
+        pthread_mutex_unlock(&tableInfo->latch);
+        unpinAfterLatch(rel, &freePage);
+        unpinAfterLatch(rel, &header);
     }
-    //free bitmap
-    bitmap_deallocate(b);
-    //increment numTuples in the pageFile header
-    setNumTuplesPF(pageFileHeader.data, getNumTuplesPF(pageToInsert.data)+1);
-    //mark pages as dirty
-    ASSERT_RC_OK(markDirty(bm, &pageFileHeader));
-    ASSERT_RC_OK(markDirty(bm, &pageToInsert));
-    //unpin the pageFile header and the page we inserted the record into
-    ASSERT_RC_OK(unpinPage(bm,&pageFileHeader));
-    ASSERT_RC_OK(unpinPage(bm,&pageToInsert));
-    //we shouldn't need to worry about writing it back to disk
-    //that will be handled by page replacement
-    return RC_OK;
+    //the insert is durable once it is in the log
+    if(returnCode == RC_OK)
+        returnCode = flushLog(&tableInfo->log, lsn);
+    releaseLocks(&lockManager, &locks);
+    return returnCode;
 }
 
-
-
 /*********************************************************************
 deleteRecord deletes the record identified by id from *rel
 INPUT:
@@ -355,105 +629,104 @@ INPUT:
 *********************************************************************/
 RC deleteRecord (RM_TableData *rel, RID id)
 {
-    RC returnCode = RC_INIT;
-    //get location
-    int pageNum = id.page;
-    short slotNum = id.slot;
-    //create two local BM_PageHandle
-    //create two local BM_PageHandles
-    BM_PageHandle pageFileHeader;
-    BM_PageHandle pageToDelete;
-    BM_BufferPool* bm = rel->bufferPool;
-    //pin the page with the pageFile header
-    ASSERT_RC_OK(pinPage(bm,&pageFileHeader,0));
-    char* pfhr = pageFileHeader.data;
-    ASSERT_RC_OK(pinPage(bm,&pageToDelete,pageNum));
-    //find free slot using pageHeader bitMap
-    char * phr = pageToDelete.data;
-    int recordSize =  getRecordSize(rel->schema);
-    //delete the record at id.slot
-    //(offset by slot*recordSize+sizeof(short))
-    char * slotPtr = phr;
-    slotPtr+= 2*pageNumOffset + 2* sizeof(int);
-    slotPtr+= bitmapOffset(getBitMapWordsPH(phr)); // add the bitMap size offset
-    slotPtr+= (slotNum * recordSize );
-
-    //**if the page didn't previously have a free slot, check
-    //to see if it is now the first page with a free slot
-    //and update pageFile header appropriately
-    bitmap * b = getBitMapPH(phr);
-    if(findFreeSlot(b)==getNumSlotsPerPage(pageFileHeader.data))
+    //validate input
+    if(!rel || !rel->mgmtData)
+        return RC_RM_INIT_ERROR;
+    if(rel->mgmtData->mapping.pages)
+        return RC_RM_READ_ONLY;
+    RC returnCode = RC_OK;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    RM_VersionStore *versions = &tableInfo->versions;
+    bool isVersioned = false;
+    LM_LSN lsn;
+    LK_Owner locks;
+    initLockOwner(&lockManager, &locks);
+    //waits for transactions that changed the record
+    returnCode = lockRecord(&locks, rel, &id, LOCK_X);
+    if(returnCode == RC_OK)
     {
-        //save the current pageNum into the prev ptr
-        setPrevFreePagePH(phr,0);
-        ASSERT_RC_OK(appendToFreeLinkedList(pfhr,phr,bm));
+        BM_PageHandle header, page;
+        pinBeforeLatch(rel, &header, 0);
+        pinBeforeLatch(rel, &page, id.page);
+        pthread_mutex_lock(&tableInfo->latch);
+        //snapshots taken before still see the record
+        if(hasSnapshots(versions) || findVersionChain(versions, id))
+        {
+            returnCode = pushSlotVersion(rel, id, 0, versions->lastCommitTs, true);
+            isVersioned = returnCode == RC_OK;
+        }
+        if(returnCode == RC_OK)
+            returnCode = applyDelete(rel, id, 0, &lsn);
+        //the record is still in the page
+        if(returnCode != RC_OK && isVersioned)
+            free(popVersion(findVersionChain(versions, id)));
+        pthread_mutex_unlock(&tableInfo->latch);
+        unpinAfterLatch(rel, &page);
+        unpinAfterLatch(rel, &header);
     }
-    //update bitMap
-    bitmap_clear(b, slotNum);
-    setBitMapPH(phr, b);
-    bitmap_deallocate(b);
-    //Not sure if this is truly necessary
-    //if we update the bitMap then we won't read from that slot anymore
-    //this is just for safety and can be taken out
-    memset(slotPtr, 0,recordSize);
-    //decrement numTuples
-    setNumTuplesPF(pfhr,getNumTuplesPF(pfhr)-1);
-    //mark pages as dirty
-    ASSERT_RC_OK(markDirty(bm, &pageFileHeader));
-    ASSERT_RC_OK(markDirty(bm, &pageToDelete));
-    //unpin the pageFile header and the page we inserted the record into
-    ASSERT_RC_OK(unpinPage(bm,&pageFileHeader));
-    ASSERT_RC_OK(unpinPage(bm,&pageToDelete));
-    //we shouldn't need to worry about writing it back to disk
-    //that will be handled by page replacement
-    return RC_OK;
+    if(returnCode == RC_OK)
+        returnCode = flushLog(&tableInfo->log, lsn);
+    releaseLocks(&lockManager, &locks);
+    return returnCode;
 }
 
 /*********************************************************************
-updateRecord replaces the data in a slot with the data in *record
+updateRecord replaces the data in a slot with the data in *record. A
+record that no longer fits on its compressed page after it was encoded
+again moves to a free slot of another page, see moveRecord.
 INPUT:
     *rel: initialized RM_TableData to update the record of
-    *record: id contains page and slot, *data contains record to insert
+    *record: id contains page and slot, *data contains record to insert,
+             id is set to the new slot if the record moved
 *********************************************************************/
 RC updateRecord (RM_TableData *rel, Record *record)
 {
-    RC returnCode = RC_INIT;
     //validate input
-    if(!rel)
+    if(!rel || !rel->mgmtData)
         return RC_RM_INIT_ERROR;
     if(!record)
         return RC_RM_INIT_ERROR;
-
-    int pageNum = record->id.page;
-    int slotNum = record->id.slot;
-    //create two local BM_PageHandles
-    BM_PageHandle pageToUpdate;
-    BM_BufferPool* bm = rel->bufferPool;
-    //pin the first page with a free slot
-    ASSERT_RC_OK(pinPage(bm,&pageToUpdate,pageNum));
-    char * phr = pageToUpdate.data;
-    //read location of next free slot from current slot
-    int recordSize = getRecordSize(rel->schema);
-    //maybe put this into a macro
-    char * slotPtr = phr;
-    slotPtr+= 2*pageNumOffset + 2* sizeof(int);
-    slotPtr+= bitmapOffset(getBitMapWordsPH(phr)); // add the bitMap size offset
-    slotPtr+= (slotNum * recordSize );
-    //write record->data to current slot
-    //maybe we don't need to do recordSize +1 because we don't want the null char
-    //at the end of the record data array
-    memcpy(slotPtr,record->data,recordSize);
-    //mark pages as dirty
-    ASSERT_RC_OK(markDirty(bm, &pageToUpdate));
-    //unpin the pageFile header and the page we inserted the record into
-    ASSERT_RC_OK(unpinPage(bm,&pageToUpdate));
-    //we shouldn't need to worry about writing it back to disk
-    //that will be handled by page replacement
-    return RC_OK;
+    if(rel->mgmtData->mapping.pages)
+        return RC_RM_READ_ONLY;
+    RC returnCode = RC_OK;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    RM_VersionStore *versions = &tableInfo->versions;
+    bool isVersioned = false;
+    LM_LSN lsn;
+    LK_Owner locks;
+    initLockOwner(&lockManager, &locks);
+    //waits for transactions that changed the record
+    returnCode = lockRecord(&locks, rel, &record->id, LOCK_X);
+    if(returnCode == RC_OK)
+    {
+        BM_PageHandle page;
+        pinBeforeLatch(rel, &page, record->id.page);
+        pthread_mutex_lock(&tableInfo->latch);
+        //snapshots taken before still see the old record
+        if(hasSnapshots(versions) || findVersionChain(versions, record->id))
+        {
+            returnCode = pushSlotVersion(rel, record->id, 0, versions->lastCommitTs, false);
+            isVersioned = returnCode == RC_OK;
+        }
+        if(returnCode == RC_OK)
+            returnCode = applyUpdate(rel, record, 0, &lsn);
+        //the old record is still in the page
+        if(returnCode != RC_OK && isVersioned)
+            free(popVersion(findVersionChain(versions, record->id)));
+        if(returnCode == RC_RM_PAGE_FULL)
+            returnCode = moveRecord(rel, record, &lsn);
+        pthread_mutex_unlock(&tableInfo->latch);
+        unpinAfterLatch(rel, &page);
+    }
+    if(returnCode == RC_OK)
+        returnCode = flushLog(&tableInfo->log, lsn);
+    releaseLocks(&lockManager, &locks);
+    return returnCode;
 }
 
 /*********************************************************************
 getRecord retrieves the data id.page and id.slot and initializes *record
+with the last committed version of the record
 INPUT:
     *rel: initialized RM_TableData to retrieve the record from
     id: contains the page and slot of the record of interest
@@ -461,42 +734,272 @@ INPUT:
 *********************************************************************/
 RC getRecord (RM_TableData *rel, RID id, Record *record)
 {
-    RC returnCode = RC_INIT;
     //validate input
-    if(!rel)
+    if(!rel || !rel->mgmtData)
         return RC_RM_INIT_ERROR;
     if(!record)
         return RC_RM_INIT_ERROR;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    LK_Owner locks;
+    initLockOwner(&lockManager, &locks);
+    //the committed version is read without waiting for writers
+    RC returnCode = lockRecord(&locks, rel, NULL, LOCK_S);
+    if(returnCode == RC_OK)
+    {
+        BM_PageHandle page;
+        pinBeforeLatch(rel, &page, id.page);
+        pthread_mutex_lock(&tableInfo->latch);
+        returnCode = readVisible(rel, id, 0, tableInfo->versions.lastCommitTs, record);
+        pthread_mutex_unlock(&tableInfo->latch);
+        unpinAfterLatch(rel, &page);
+    }
+    releaseLocks(&lockManager, &locks);
+    return returnCode;
+}
 
-    int pageNum = id.page;
-    int slotNum = id.slot;
-    //create local BM_PageHandles
-    BM_PageHandle pageToGet;
-    BM_BufferPool* bm = rel->bufferPool;
-    //pin the page of interest
-    ASSERT_RC_OK(pinPage(bm,&pageToGet,pageNum));
-    //find free slot using pageHeader bitMap
-    char * phr = pageToGet.data;
-    //read location of next free slot from current slot
-    int recordSize = getRecordSize(rel->schema);
-    //maybe put this into a macro
-    char * slotPtr = phr;
-    slotPtr+= 2*pageNumOffset + 2* sizeof(int);
-    slotPtr+= bitmapOffset(getBitMapWordsPH(phr)); // add the bitMap size offset
-    slotPtr+= (slotNum * recordSize );
-    //write record->data to current slot
-    //maybe we don't need to do recordSize +1 because we don't want the null char
-    //at the end of the record data array
-    memcpy(record->data,slotPtr,recordSize);
-    record->id.page = pageNum;
-    record->id.slot = slotNum;
-    //unpin the page we of the record we got
-    ASSERT_RC_OK(unpinPage(bm,&pageToGet));
-    //we shouldn't need to worry about writing it back to disk
-    //that will be handled by page replacement
+/*********************************************************************
+*
+*                      TRANSACTION FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+Transactions run under snapshot isolation on a single table. Reads see
+the records committed before beginTransaction plus the transaction's
+own changes (multi-version concurrency control, see mvcc.h), so they
+never wait for writers. Inserts and updates reach the page right away,
+deletes only at commit, so the slot isn't reused before. Changes lock
+the record exclusively until commit or abort (see lock_mgr.h), so a
+change of a record another transaction changed waits for it to end. A
+record that another transaction changed after the snapshot can't be
+changed (first updater wins): the call returns RC_RM_WRITE_CONFLICT and
+the transaction should be aborted, as on RC_LK_DEADLOCK.
+
+The changes are logged with the transaction id, commitTransaction
+returns once its commit record is durable. abortTransaction undoes the
+changes and logs them as well. Changes of transactions that neither
+committed nor aborted before a crash are undone by recovery. Every
+transaction has to end before the table is closed.
+*********************************************************************/
+RC beginTransaction (RM_TableData *rel, RM_Transaction *tx)
+{
+    //validate input
+    if(!rel || !rel->mgmtData || !tx)
+        return RC_RM_INIT_ERROR;
+    memset(tx, 0, sizeof(RM_Transaction));
+    tx->rel = rel;
+    initLockOwner(&lockManager, &tx->locks);
+    pthread_mutex_lock(&rel->mgmtData->latch);
+    tx->txId = beginSnapshot(&rel->mgmtData->versions, &tx->snapshotTs);
+    pthread_mutex_unlock(&rel->mgmtData->latch);
     return RC_OK;
 }
 
+/*********************************************************************
+commitTransaction deletes the records the transaction deleted and
+logs the commit. Its versions become visible to snapshots taken after
+the commit record is durable. If a delete or the commit record fails,
+the transaction is aborted, including the deletes that reached the
+page, and the error returned. A commit record that can't be flushed
+stays in the log buffer for the next flush: the transaction is
+committed, but the error is returned because it isn't durable yet.
+The locks of the transaction are released in every case.
+*********************************************************************/
+RC commitTransaction (RM_Transaction *tx)
+{
+    //validate input
+    if(!tx || !tx->rel)
+        return RC_RM_INIT_ERROR;
+    RC returnCode = RC_OK;
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    RM_VersionStore *versions = &tableInfo->versions;
+    RID noRecord = {0, 0};
+    LM_LSN lsn;
+    pinWritePages(tx, true);
+    pthread_mutex_lock(&tableInfo->latch);
+    for(int i = 0; i < tx->numWrites && returnCode == RC_OK; i++)
+        if(tx->writes[i].kind == RM_WRITE_DELETE)
+        {
+            returnCode = applyDelete(tx->rel, tx->writes[i].id, tx->txId, &lsn);
+            tx->writes[i].isApplied = returnCode == RC_OK;
+        }
+    if(returnCode == RC_OK && tx->numWrites > 0)
+        returnCode = logChange(tx->rel, LOG_COMMIT, tx->txId, noRecord, NULL, NULL, NULL, &lsn);
+    if(returnCode != RC_OK)
+    {
+        //still under the latch, so nobody took the slots of the deletes
+        undoTransaction(tx);
+        pthread_mutex_unlock(&tableInfo->latch);
+        releaseLocks(&lockManager, &tx->locks);
+        return returnCode;
+    }
+    pthread_mutex_unlock(&tableInfo->latch);
+    //other commits are synced together with this one
+    RC flushCode = RC_OK;
+    if(tx->numWrites > 0)
+        flushCode = flushLog(&tableInfo->log, lsn);
+    pthread_mutex_lock(&tableInfo->latch);
+    RM_Timestamp commitTs = ++versions->lastCommitTs;
+    for(int i = 0; i < tx->numWrites; i++)
+    {
+        RM_VersionChain *chain = findVersionChain(versions, tx->writes[i].id);
+        if(chain)
+            commitVersions(chain, tx->txId, commitTs);
+    }
+    endTransaction(tx);
+    pthread_mutex_unlock(&tableInfo->latch);
+    returnCode = releaseLocks(&lockManager, &tx->locks);
+    return flushCode != RC_OK ? flushCode : returnCode;
+}
+
+/*********************************************************************
+abortTransaction undoes the changes of the transaction, newest first.
+The pages get the record of the version before each change back, the
+undo is logged like any other change of the transaction, followed by
+the abort record. Recovery undoes what is left if the abort record
+doesn't reach the log, which is left out if an undo failed. The
+transaction ends and its locks are released even then, the first error
+is returned.
+*********************************************************************/
+RC abortTransaction (RM_Transaction *tx)
+{
+    //validate input
+    if(!tx || !tx->rel)
+        return RC_RM_INIT_ERROR;
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    pinWritePages(tx, false);
+    pthread_mutex_lock(&tableInfo->latch);
+    RC returnCode = undoTransaction(tx);
+    pthread_mutex_unlock(&tableInfo->latch);
+    RC lockCode = releaseLocks(&lockManager, &tx->locks);
+    return returnCode != RC_OK ? returnCode : lockCode;
+}
+
+RC insertRecordTx (RM_Transaction *tx, Record *record)
+{
+    //validate input
+    if(!tx || !tx->rel || !record)
+        return RC_RM_INIT_ERROR;
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    if(tableInfo->mapping.pages)
+        return RC_RM_READ_ONLY;
+    LM_LSN lsn;
+    RC returnCode = lockRecord(&tx->locks, tx->rel, NULL, LOCK_X);
+    if(returnCode != RC_OK)
+        return returnCode;
+    BM_PageHandle header, freePage;
+    pinBeforeLatch(tx->rel, &header, 0);
+    pinBeforeLatch(tx->rel, &freePage, header.data ? getFreePageHint(tx->rel, header.data) : NO_PAGE);
+    pthread_mutex_lock(&tableInfo->latch);
+    returnCode = applyInsert(tx->rel, record, tx->txId, &lsn);
+    if(returnCode == RC_OK)
+    {
+        RM_VersionChain *chain = getVersionChain(&tableInfo->versions, record->id, false);
+        pushVersion(chain, tx->txId, TS_UNCOMMITTED, false, NULL, tableInfo->recordSize);
+        addWrite(tx, record->id, RM_WRITE_INSERT);
+    }
+    pthread_mutex_unlock(&tableInfo->latch);
+    unpinAfterLatch(tx->rel, &freePage);
+    unpinAfterLatch(tx->rel, &header);
+    if(returnCode != RC_OK)
+        return returnCode;
+    //nobody waits for the new record yet, the lock is granted at once
+    return lockRecord(&tx->locks, tx->rel, &record->id, LOCK_X);
+}
+
+RC deleteRecordTx (RM_Transaction *tx, RID id)
+{
+    //validate input
+    if(!tx || !tx->rel)
+        return RC_RM_INIT_ERROR;
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    if(tableInfo->mapping.pages)
+        return RC_RM_READ_ONLY;
+    //waits for the transaction that changed the record
+    RC returnCode = lockRecord(&tx->locks, tx->rel, &id, LOCK_X);
+    if(returnCode != RC_OK)
+        return returnCode;
+    BM_PageHandle page;
+    pinBeforeLatch(tx->rel, &page, id.page);
+    pthread_mutex_lock(&tableInfo->latch);
+    returnCode = pushSlotVersion(tx->rel, id, tx->txId, tx->snapshotTs, true);
+    if(returnCode == RC_OK)
+        addWrite(tx, id, RM_WRITE_DELETE);
+    pthread_mutex_unlock(&tableInfo->latch);
+    unpinAfterLatch(tx->rel, &page);
+    return returnCode;
+}
+
+RC updateRecordTx (RM_Transaction *tx, Record *record)
+{
+    //validate input
+    if(!tx || !tx->rel || !record)
+        return RC_RM_INIT_ERROR;
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    if(tableInfo->mapping.pages)
+        return RC_RM_READ_ONLY;
+    LM_LSN lsn;
+    RC returnCode = lockRecord(&tx->locks, tx->rel, &record->id, LOCK_X);
+    if(returnCode != RC_OK)
+        return returnCode;
+    BM_PageHandle page;
+    pinBeforeLatch(tx->rel, &page, record->id.page);
+    pthread_mutex_lock(&tableInfo->latch);
+    returnCode = pushSlotVersion(tx->rel, record->id, tx->txId, tx->snapshotTs, false);
+    bool isMoved = false;
+    if(returnCode == RC_OK)
+    {
+        returnCode = applyUpdate(tx->rel, record, tx->txId, &lsn);
+        if(returnCode == RC_OK)
+            addWrite(tx, record->id, RM_WRITE_UPDATE);
+        else
+            free(popVersion(findVersionChain(&tableInfo->versions, record->id)));
+        if(returnCode == RC_RM_PAGE_FULL)
+        {
+            returnCode = moveRecordTx(tx, record);
+            isMoved = returnCode == RC_OK;
+        }
+    }
+    pthread_mutex_unlock(&tableInfo->latch);
+    unpinAfterLatch(tx->rel, &page);
+    if(returnCode != RC_OK || !isMoved)
+        return returnCode;
+    //nobody waits for the new slot yet, the lock is granted at once
+    return lockRecord(&tx->locks, tx->rel, &record->id, LOCK_X);
+}
+
+RC getRecordTx (RM_Transaction *tx, RID id, Record *record)
+{
+    //validate input
+    if(!tx || !tx->rel || !record)
+        return RC_RM_INIT_ERROR;
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    RC returnCode = lockRecord(&tx->locks, tx->rel, NULL, LOCK_S);
+    if(returnCode != RC_OK)
+        return returnCode;
+    BM_PageHandle page;
+    pinBeforeLatch(tx->rel, &page, id.page);
+    pthread_mutex_lock(&tableInfo->latch);
+    returnCode = readVisible(tx->rel, id, tx->txId, tx->snapshotTs, record);
+    pthread_mutex_unlock(&tableInfo->latch);
+    unpinAfterLatch(tx->rel, &page);
+    return returnCode;
+}
+
+/*********************************************************************
+lockTable locks the whole table for the rest of the transaction, e.g.
+LOCK_X before changing most of its records, so they don't need a lock
+each. The call waits for transactions holding conflicting record locks.
+*********************************************************************/
+RC lockTable (RM_Transaction *tx, LK_LockMode mode)
+{
+    //validate input
+    if(!tx || !tx->rel || (mode != LOCK_S && mode != LOCK_SIX && mode != LOCK_X))
+        return RC_RM_INIT_ERROR;
+    LK_ResourceId table = {(uintptr_t) tx->rel->mgmtData, -1, -1};
+    return lockResource(&lockManager, &tx->locks, table, mode);
+}
+
 /*********************************************************************
 *
 *                        SCAN FUNCTIONS
@@ -509,14 +1012,41 @@ RETURNS: RC_OK
 *********************************************************************/
 RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
 {
+    RC returnCode = RC_INIT;
     //Validation of inputs
-    if(!rel || !scan || !cond)  //If input is invalid then return error code
+    if(!rel || !rel->mgmtData || !scan || !cond)  //If input is invalid then return error code
         return RC_RM_INIT_ERROR;
+    //locked first, initScan allocates and counts the mapped scans
+    initLockOwner(&lockManager, &scan->locks);
+    ASSERT_RC_OK(lockRecord(&scan->locks, rel, NULL, LOCK_S));
+    returnCode = initScan(rel, scan, cond);
+    if(returnCode != RC_OK)
+    {
+        releaseLocks(&lockManager, &scan->locks);
+        return returnCode;
+    }
+    //the scan reads the records committed before it started
+    pthread_mutex_lock(&rel->mgmtData->latch);
+    scan->txId = beginSnapshot(&rel->mgmtData->versions, &scan->snapshotTs);
+    scan->ownsSnapshot = true;
+    pthread_mutex_unlock(&rel->mgmtData->latch);
+    return RC_OK;
+}
 
-    scan->mgmtData = cond;  //Store the condition into the mgmtData field
-    scan->rel = rel;        //Store the relation into the rel field
-    scan->slotNum = 0;
-    scan->pageNum = 1;
+/*********************************************************************
+startScanTx starts a scan that reads what transaction tx sees
+*********************************************************************/
+RC startScanTx (RM_Transaction *tx, RM_ScanHandle *scan, Expr *cond)
+{
+    RC returnCode = RC_INIT;
+    //Validation of inputs
+    if(!tx || !tx->rel || !scan || !cond)
+        return RC_RM_INIT_ERROR;
+    ASSERT_RC_OK(lockRecord(&tx->locks, tx->rel, NULL, LOCK_S));
+    ASSERT_RC_OK(initScan(tx->rel, scan, cond));
+    scan->txId = tx->txId;
+    scan->snapshotTs = tx->snapshotTs;
+    scan->ownsSnapshot = false;
     return RC_OK;
 }
 
@@ -530,61 +1060,14 @@ Return: RC_RM_NO_MORE_TUPLES once scan is completed
 *********************************************************************/
 RC next (RM_ScanHandle *scan, Record *record)
 {
-    RC returnCode = RC_INIT;
-    SM_FileHandle fHandle;
-    BM_PageHandle pageFileHeader;
-    BM_PageHandle curPage;//used to pin page to BufferPool
-    BM_BufferPool* bm = scan->rel->bufferPool;
     //Validation of inputs
-    if(!record)    //If input is invalid then return error code
+    if(!scan || !record)    //If input is invalid then return error code
         return RC_RM_INIT_ERROR;
-
-    // open the page file
-    ASSERT_RC_OK(openPageFile(scan->rel->name, &fHandle));
-    //store number of pages in the fHandle into numPages
-    int numPages = fHandle.totalNumPages;
-    ASSERT_RC_OK(closePageFile(&fHandle));
-    //pin the pageFile header to bufferpool
-    //Only need to do once
-    ASSERT_RC_OK(pinPage(bm,&pageFileHeader,0));
-    char* pfhr = pageFileHeader.data;
-    Value *result;
-    //Iterate through the pages on disk and pin to bufferpool and search over bitmap of that page
-    for(; scan->pageNum<numPages; scan->pageNum++)
-    {
-        ASSERT_RC_OK(pinPage(bm,&curPage,scan->pageNum));
-        char * phr = curPage.data;//used to find used slot
-        //point to bitmap in the current page
-        //TODO: have address of bitmap be pointed by a variable (lets call it bitmap just for use in while loop)
-        bitmap * b = getBitMapPH(phr);
-        //while we did not reach the end of the slot
-        for(; scan->slotNum < getNumSlotsPerPage(pfhr); ++scan->slotNum)
-        {
-            //utilize bitmap_read(bitmap, int n) to retrieve bit
-            //if bit = 1, then store the data (record) at that position in the page into record->id.slot
-            if(bitmap_read(b,scan->slotNum)==1)
-            {
-                RID rid;
-                rid.page = scan->pageNum;
-                rid.slot = scan->slotNum;
-                ASSERT_RC_OK(getRecord(scan->rel,rid,record));
-                ASSERT_RC_OK(evalExpr(record, scan->rel->schema, scan->mgmtData, &result));
-                if(result->v.boolV || scan->mgmtData == NULL)
-                {
-                    //return record
-                    record->id.page = scan->pageNum;
-                    record->id.slot = scan->slotNum;
-                    freeVal(result);
-                    bitmap_deallocate(b);
-                    ++scan->slotNum;
-                    return RC_OK;
-                }
-            }
-        }
-        bitmap_deallocate(b);
-    }
-    freeVal(result);
-    return RC_RM_NO_MORE_TUPLES;
+    RM_TableInfo *tableInfo = scan->rel->mgmtData;
+    pthread_mutex_lock(&tableInfo->latch);
+    RC returnCode = nextVisible(scan, record);
+    pthread_mutex_unlock(&tableInfo->latch);
+    return returnCode;
 }
 
 /*********************************************************************
@@ -596,7 +1079,24 @@ RC closeScan (RM_ScanHandle *scan)
 {
     /*free(scan->mgmtData);
     scan->mgmtData = NULL;*/
-    return RC_OK;
+    //attrRefs is only set while the scan is open
+    if(scan->attrRefs)
+        adviseMappedScans(scan->rel, -1);
+    free(scan->attrRefs);
+    scan->attrRefs = NULL;
+    free(scan->filter);
+    scan->filter = NULL;
+    //the versions only the scan could see can go
+    if(scan->ownsSnapshot)
+    {
+        RM_TableInfo *tableInfo = scan->rel->mgmtData;
+        pthread_mutex_lock(&tableInfo->latch);
+        endSnapshot(&tableInfo->versions, scan->txId);
+        pruneVersions(&tableInfo->versions);
+        pthread_mutex_unlock(&tableInfo->latch);
+        scan->ownsSnapshot = false;
+    }
+    return releaseLocks(&lockManager, &scan->locks);
 }
 
 /*********************************************************************
@@ -834,6 +1334,18 @@ int static findFreeSlot(bitmap * bitMap)
 /********************************************************************
 find the page number for the next page to be allocated upon creation
 ********************************************************************/
+//frees the configuration and sets the storage defaults again
+static void resetManagerConfig(void)
+{
+    freeConfig(&managerConfig);
+    setHugePages(BM_HUGE_PAGES_NONE);
+    setDirectIO(false);
+    setExtentSize(SM_DEFAULT_EXTENT_SIZE);
+    setPageChecksums(false);
+    setSegmentSize(SM_DEFAULT_SEGMENT_SIZE);
+    setSegmentDirs(NULL);
+}
+
 static RC findNewPageNum(RM_TableData * rel, unsigned int * nextFreePage)
 {
     RC returnCode = RC_INIT;
@@ -848,7 +1360,9 @@ preparePFHdr populates a PageHandle with the data for the PageFile Hdr
 Assumes initial generation of pageFile, so no tuples have been added
 INPUT:
     *schema: fully initialized Schema struct
-    *pHandle: uninitialized PageHandle with PAGE_SIZE memory alloc'd
+    layout: how records are laid out in the data pages
+    pageSize: bytes of the pages of the table
+    *pHandle: uninitialized PageHandle with pageSize memory alloc'd
 FORMAT:
 DataType and TypeLength pairs are repeated numAttr times
 keyAttr is repeated keySize times
@@ -858,7 +1372,9 @@ strlen and attrName pairs are repeated numAttr times
 ---------------------------------------------------------------------------
 ushort recordSize | uint numTuples | uint nextFreePage |
 ---------------------------------------------------------------------------
-ushort numSlotsPerPage | ushort schemaSize | ushort numAttr |
+ushort numSlotsPerPage | ushort pageLayout | ushort schemaSize |
+---------------------------------------------------------------------------
+ushort numAttr |
 ---------------------------------------------------------------------------
 ushort DataType | ushort TypeLength | ushort DataType | ushort TypeLength |
 ---------------------------------------------------------------------------
@@ -871,8 +1387,9 @@ OFFSETS:
     numTuples: sizeof(ushort)
     nextFreePage: sizeof(ushort) + sizeof(uint)
     numSlotsPerPage: sizeof(ushort) + 2*sizeof(uint)
-    schemaSize: 2*( sizeof(ushort) + sizeof(uint) )
-    schema: 3*sizeof(ushort) + 2*sizeof(uint)
+    pageLayout: 2*( sizeof(ushort) + sizeof(uint) )
+    schemaSize: 3*sizeof(ushort) + 2*sizeof(uint)
+    schema: 4*sizeof(ushort) + 2*sizeof(uint)
 
 SCHEMA OFFSETS FROM START OF SCHEMA
     numAttr: 0
@@ -884,7 +1401,7 @@ SCHEMA OFFSETS FROM START OF SCHEMA
     Offset to a specific attribute's name will need to be calculated
         using the strlen's
 *********************************************************************/
-static RC preparePFHdr(Schema *schema, char *pHandle)
+static RC preparePFHdr(Schema *schema, RM_PageLayout layout, int pageSize, char *pHandle)
 {
     //validate input
     if(!schema || !pHandle)
@@ -894,26 +1411,12 @@ static RC preparePFHdr(Schema *schema, char *pHandle)
     unsigned int numTuples = 0;
     unsigned int nextFreePage = 0;
     //numSlotsPerPage accounts for the bitmap and next and prev pointers
-    unsigned short numSlotsPerPage = calcNumSlotsPerPage(recordSize);
-    //Retrieve existing data from schema
-    unsigned short numAttr = (unsigned short) schema->numAttr;
-    unsigned short keySize = (unsigned short) schema->keySize;
-    //Allocate memory for the schema arrays
-    VALID_CALLOC(unsigned short, typeAndLength, 2*numAttr, sizeof(unsigned short));
-    VALID_CALLOC(unsigned short, keyAttrs, keySize, sizeof(unsigned short));
-    //Initialize variables to use for retrieving string data from schema
-    unsigned short sizeOfAttrNames = 0;
-    VALID_CALLOC(unsigned short, strLen, numAttr, sizeof(unsigned short));
-    //Retrieve data from arrays and format how we want
-    for(int i = 0; i < numAttr; i++)
-    {
-        typeAndLength[2*i] = (unsigned short) schema->dataTypes[i];
-        typeAndLength[(2*i)+1] = (unsigned short) schema->typeLength[i];
-        strLen[i] = (unsigned short) strlen(schema->attrNames[i]);
-        sizeOfAttrNames += strLen[i];
-    }
+    unsigned short numSlotsPerPage = calcNumSlotsPerPage(recordSize, pageSize);
+    if(layout == RM_LAYOUT_PAX_COMPRESSED)
+        numSlotsPerPage = calcMaxSlotsPerPage(recordSize, pageSize);
+    unsigned short pageLayout = (unsigned short) layout;
     //Calculate the schema size from its components
-    unsigned short schemaSize = (2 + 3*numAttr + keySize) * sizeof(unsigned short) + sizeOfAttrNames;
+    unsigned short schemaSize = (unsigned short) getSchemaBytes(schema);
     //Initialize an offset pointer for the write location
     char* curOffset = (char*) pHandle;
     //Populating the pageHandle with the data
@@ -925,38 +1428,12 @@ static RC preparePFHdr(Schema *schema, char *pHandle)
     curOffset += sizeof(nextFreePage);
     memcpy(curOffset, &numSlotsPerPage, sizeof(numSlotsPerPage));
     curOffset += sizeof(numSlotsPerPage);
+    memcpy(curOffset, &pageLayout, sizeof(pageLayout));
+    curOffset += sizeof(pageLayout);
     memcpy(curOffset, &schemaSize, sizeof(schemaSize));
     curOffset += sizeof(schemaSize);
-    memcpy(curOffset, &numAttr, sizeof(numAttr));
-    curOffset += sizeof(numAttr);
-    //Populating the pageHandle with array data
-    for(int i = 0; i < 2*numAttr; i++)
-    {
-        memcpy(curOffset, &typeAndLength[i], sizeof(typeAndLength[i]));
-        curOffset += sizeof(typeAndLength[i]);
-    }
-    //Populating the pageHandle with data
-    memcpy(curOffset, &keySize, sizeof(keySize));
-    curOffset += sizeof(keySize);
-    //Populating the pageHandle with array data
-    unsigned short keyAttr;
-    for(int i = 0; i < keySize; i++)
-    {
-        keyAttr = (unsigned short)schema->keyAttrs[i];
-        memcpy(curOffset, &keyAttr, sizeof(keyAttr));
-        curOffset += sizeof(keyAttr);
-    }
-    for(int i = 0; i < numAttr; i++)
-    {
-        memcpy(curOffset, &strLen[i], sizeof(strLen[i]));
-        curOffset += sizeof(strLen[i]);
-        memcpy(curOffset, &schema->attrNames[i], strLen[i]);
-        curOffset += strLen[i];
-    }
-    //Freeing memory
-    free(typeAndLength);
-    free(keyAttrs);
-    free(strLen);
+    //Populating the pageHandle with the schema, see writeSchema
+    writeSchema(schema, curOffset);
     return RC_OK;
 }
 
@@ -973,9 +1450,9 @@ static RC appendToFreeLinkedList(char * pfhr,
     setNextFreePagePH(phr,getNextFreePage(pfhr));
     //update pageFileHeader
     setNextFreePage(pfhr, getPrevFreePagePH(phr));//current page Number
-    //if the list isn't empty
+    //if the list wasn't empty
     //update ref of the old head
-    if(getNextFreePage(pfhr) != 0)
+    if(getNextFreePagePH(phr) != 0)
     {
         //update next page Header
         ASSERT_RC_OK(pinPage(bm, &nextPageHandle, getNextFreePagePH(phr)));
@@ -1046,251 +1523,1907 @@ static int getAttrOffset(Schema *schema, int attrNum)
     return offset;
 }
 /*********************************************************************
-calcNumSlotsPerPage solves the following equation iteratively
-
-PAGE_SIZE >= 4*i + floor((n+31)/32)/4 + n*r
-where i is sizeof(unsigned int) to account for ints in header
-where r is the size of a record for a given schema
-where n is the number of slots per page
-
-floor((n+31)/32) is used since the bitmap is stored in word-sized chunks
-floor((n+31)/32) is divided by 4 to convert from words to bytes
-Calculation assumes 32 bit words
-
-INPUT: recordSize: size of a record for a given schema
+findTable looks the table name up in the catalog. A table the catalog
+doesn't have yet is added from its PageFile header, read straight from
+the page file: the values in the catalog never change once the table
+was created. The schema of entry was acquired, closeTable releases it.
 *********************************************************************/
-static unsigned short calcNumSlotsPerPage(unsigned short recordSize)
+static RC findTable(char *name, RM_CatalogEntry *entry)
 {
-    //Calculates numSlotsPerPage assuming the number of bits in the
-    //bitmap exactly equals the numSlotsPerPage.
-    //Solves: PAGE_SIZE >= 4*i + n + n*r
-    unsigned short numSlotsPerPage = (PAGE_SIZE - 4*sizeof(unsigned int)) / (recordSize + 0.125);
-    //Rounds the number of bytes used by the bitmap up to the next word
-    unsigned short numBytesForBitmap = ((numSlotsPerPage+31)/32)*4;
-    //Recalculates numSlotsPerPage with the larger header
-    numSlotsPerPage = (PAGE_SIZE - 4*sizeof(unsigned int) - numBytesForBitmap) / recordSize;
-    return numSlotsPerPage;
+    RC returnCode = RC_INIT;
+    if(findCatalogTable(&catalog, name, entry))
+        return RC_OK;
+    SM_FileHandle fHandle;
+    ASSERT_RC_OK(openPageFile(name, &fHandle));
+    VALID_CALLOC(char, pfHdrFrame, 1, fHandle.pageSize);
+    returnCode = readBlock(0, &fHandle, pfHdrFrame);
+    if(returnCode == RC_OK)
+    {
+        VALID_CALLOC(Schema, schema, 1, sizeof(Schema));
+        readSchema(pfHdrFrame + schemaOffset, schema);
+        addCatalogTable(&catalog, name, schema, getPageLayout(pfHdrFrame), fHandle.pageSize,
+                        getNumSlotsPerPage(pfHdrFrame));
+        freeSchema(schema);
+    }
+    free(pfHdrFrame);
+    RC closeCode = closePageFile(&fHandle);
+    if(returnCode != RC_OK)
+        return returnCode;
+    if(closeCode != RC_OK)
+        return closeCode;
+    //deleted again in the meantime
+    if(!findCatalogTable(&catalog, name, entry))
+        return RC_FILE_NOT_FOUND;
+    return RC_OK;
 }
+
 /*********************************************************************
-*
-*               PAGE HEADER GETTERS AND SETTERS
-*
+initTableInfo caches the PageFile header values every record operation
+needs in rel->mgmtData, so they don't have to be re-read from page 0
+INPUT:
+    *rel: RM_TableData with an initialized schema
+    *entry: the table in the catalog
 *********************************************************************/
-static unsigned int getPrevFreePagePH(char *phrFrame)
+static RC initTableInfo(RM_TableData *rel, RM_CatalogEntry *entry)
 {
-    unsigned int prevFreePage;
-    memcpy(&prevFreePage, phrFrame + 0, pageNumOffset);
-    return prevFreePage;
+    VALID_CALLOC(RM_TableInfo, tableInfo, 1, sizeof(RM_TableInfo));
+    VALID_CALLOC(int, attrOffsets, rel->schema->numAttr, sizeof(int));
+    tableInfo->pageSize = entry->pageSize;
+    tableInfo->layout = entry->layout;
+    tableInfo->recordSize = (unsigned short) getRecordSize(rel->schema);
+    tableInfo->numSlotsPerPage = entry->numSlotsPerPage;
+    for(int i = 0; i < rel->schema->numAttr; i++)
+        attrOffsets[i] = getAttrOffset(rel->schema, i);
+    tableInfo->attrOffsets = attrOffsets;
+    pthread_mutex_init(&tableInfo->latch, NULL);
+    initVersionStore(&tableInfo->versions);
+    rel->mgmtData = tableInfo;
+    RC returnCode = RC_INIT;
+    ASSERT_RC_OK(initZoneMap(&tableInfo->zoneMap, rel->schema, attrOffsets));
+    return initBloomFilters(&tableInfo->bloomFilters, rel->schema, attrOffsets,
+                            tableInfo->numSlotsPerPage);
 }
 
-static unsigned int getNextFreePagePH(char *phrFrame)
+static void freeTableInfo(RM_TableData *rel)
 {
-    unsigned int nextFreePage;
-    memcpy(&nextFreePage, phrFrame + pageNumOffset, pageNumOffset);
-    return nextFreePage;
+    freeZoneMap(&rel->mgmtData->zoneMap);
+    freeBloomFilters(&rel->mgmtData->bloomFilters);
+    free(rel->mgmtData->attrOffsets);
+    freeVersionStore(&rel->mgmtData->versions);
+    pthread_mutex_destroy(&rel->mgmtData->latch);
+    free(rel->mgmtData);
+    rel->mgmtData = NULL;
 }
 
-static void setPrevFreePagePH(char * phrFrame, unsigned int pageNum)
+/*********************************************************************
+Slot access for both page layouts. Slots start right after the bitmap.
+NSM: slot i holds the whole record at slots + i*recordSize
+PAX: the slot area is split into one minipage per attribute. The
+     minipage of attribute j starts at slots + numSlots*attrOffset(j)
+     and holds the value of attribute j for every slot, in slot order.
+PAX_COMPRESSED: the slot area starts with the number of slots that are
+     encoded and the page flags, followed by one column block per
+     attribute (see column_codec.h) that encodes numSlotsUsed values.
+data is always a record in row format, so getAttr/setAttr work the
+same for all layouts.
+*********************************************************************/
+static char* getSlotsPH(char *phrFrame)
 {
-    memcpy(phrFrame + 0, &pageNum,pageNumOffset);
+    return phrFrame + slotsOffset + bitmapOffset(getBitMapWordsPH(phrFrame));
 }
 
-static void setNextFreePagePH(char * phrFrame, unsigned int pageNum)
+static void readSlot(RM_TableData *rel, char *phrFrame, int slotNum, char *data)
 {
-    memcpy(phrFrame + pageNumOffset, &pageNum,pageNumOffset);
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    if(tableInfo->layout == RM_LAYOUT_NSM)
+    {
+        memcpy(data, getSlotsPH(phrFrame) + slotNum*tableInfo->recordSize, tableInfo->recordSize);
+        return;
+    }
+    for(int i = 0; i < rel->schema->numAttr; i++)
+        readSlotAttr(rel, phrFrame, slotNum, i, data);
 }
 
-static bitmap* getBitMapPH(char * phrFrame)
+static void readSlotAttr(RM_TableData *rel, char *phrFrame, int slotNum, int attrNum, char *data)
 {
-    VALID_CALLOC(bitmap, b,1,sizeof(bitmap));
-    char * curOff = phrFrame + 2 * pageNumOffset;
-    //set number of bits
-    memcpy(&b->bits,curOff, sizeof(int));
-    curOff+=sizeof(int);
-    //set number of words
-    memcpy(&b->words,curOff, sizeof(int));
-    curOff +=sizeof(int);
-    //set bit Array
-    VALID_CALLOC(bitmap_type *, bitArray, b->words,sizeof(bitmap_type));
-    memcpy(bitArray,curOff, sizeof(bitmap_type)* b->words);
-    b->array =(bitmap_type*) bitArray;
-    return b;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    int attrOffset = tableInfo->attrOffsets[attrNum];
+    int typeLength = rel->schema->typeLength[attrNum];
+    char *attrPtr = getSlotsPH(phrFrame);
+    switch(tableInfo->layout)
+    {
+    case RM_LAYOUT_NSM:
+        attrPtr += slotNum*tableInfo->recordSize + attrOffset;
+        break;
+    case RM_LAYOUT_PAX:
+        attrPtr += tableInfo->numSlotsPerPage*attrOffset + slotNum*typeLength;
+        break;
+    case RM_LAYOUT_PAX_COMPRESSED:
+        decodeColumnValue(rel->schema->dataTypes[attrNum], typeLength,
+                          getColumnBlock(rel, phrFrame, attrNum), slotNum, data + attrOffset);
+        return;
+    }
+    memcpy(data + attrOffset, attrPtr, typeLength);
 }
 
-static int getBitMapWordsPH(char* phrFrame)
+/*********************************************************************
+writeSlot stores data in slot slotNum. Compressed pages are decoded,
+changed and encoded again. The write fails with RC_RM_PAGE_FULL if the
+encoded page would leave less than reserve bytes free.
+*********************************************************************/
+static RC writeSlot(RM_TableData *rel, char *phrFrame, int slotNum, char *data, int reserve)
 {
-    int words;
-    memcpy(&words, phrFrame + sizeof(int)+ 2 * pageNumOffset, sizeof(int));
-    return words;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    char *slots = getSlotsPH(phrFrame);
+    if(tableInfo->layout == RM_LAYOUT_NSM)
+    {
+        memcpy(slots + slotNum*tableInfo->recordSize, data, tableInfo->recordSize);
+        return RC_OK;
+    }
+    char *columns = slots;
+    int numSlotsUsed = 0;
+    if(tableInfo->layout == RM_LAYOUT_PAX_COMPRESSED)
+    {
+        columns = (char *) calloc(tableInfo->numSlotsPerPage, tableInfo->recordSize);
+        if(!columns)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+        decodePage(rel, phrFrame, columns);
+        numSlotsUsed = getNumSlotsUsedPH(phrFrame);
+    }
+    for(int i = 0; i < rel->schema->numAttr; i++)
+    {
+        int attrOffset = tableInfo->attrOffsets[i];
+        int typeLength = rel->schema->typeLength[i];
+        memcpy(columns + tableInfo->numSlotsPerPage*attrOffset + slotNum*typeLength,
+               data + attrOffset, typeLength);
+    }
+    if(columns == slots)
+        return RC_OK;
+    if(slotNum >= numSlotsUsed)
+        numSlotsUsed = slotNum + 1;
+    RC returnCode = encodePage(rel, phrFrame, columns, numSlotsUsed, reserve);
+    free(columns);
+    return returnCode;
 }
 
-static int getBitMapBitsPH(char* phrFrame)
+/*********************************************************************
+getColumnBlock returns the column block of attribute attrNum on a
+compressed page
+*********************************************************************/
+static char* getColumnBlock(RM_TableData *rel, char *phrFrame, int attrNum)
 {
-    int bits;
-    memcpy(&bits, phrFrame+ 2 * pageNumOffset, sizeof(int));
-    return bits;
+    char *block = getSlotsPH(phrFrame) + columnBlocksOffset;
+    for(int i = 0; i < attrNum; i++)
+        block += getColumnBlockSize(block);
+    return block;
 }
 
-static void setBitMapPH(char * phrFrame, bitmap* b)
+/*********************************************************************
+decodePage decodes all minipages of a compressed page into columns,
+which has the layout of the slot area of an uncompressed PAX page
+*********************************************************************/
+static void decodePage(RM_TableData *rel, char *phrFrame, char *columns)
 {
-    char * curOff = phrFrame + 2 * pageNumOffset;
-
-    //set number of bits
-    memcpy(curOff,&b->bits, sizeof(int));
-    curOff+=sizeof(int);
-    //set number of words
-    memcpy(curOff,&b->words, sizeof(int));
-    curOff +=sizeof(int);
-    //set bit Array
-    memcpy(curOff, b->array, sizeof(bitmap_type)* b->words);
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    int numSlotsUsed = getNumSlotsUsedPH(phrFrame);
+    if(numSlotsUsed == 0)
+        return;
+    char *block = getSlotsPH(phrFrame) + columnBlocksOffset;
+    for(int i = 0; i < rel->schema->numAttr; i++)
+    {
+        decodeColumn(rel->schema->dataTypes[i], rel->schema->typeLength[i], block, numSlotsUsed,
+                     columns + tableInfo->numSlotsPerPage*tableInfo->attrOffsets[i]);
+        block += getColumnBlockSize(block);
+    }
 }
 
-static void setBitMapArrayPH(char* phrFrame, bitmap * b)
+/*********************************************************************
+encodePage encodes the first numSlotsUsed slots of columns into the
+minipages of a compressed page. The page is only changed if all column
+blocks fit and leave reserve bytes free.
+RETURNS: RC_OK or RC_RM_PAGE_FULL
+*********************************************************************/
+static RC encodePage(RM_TableData *rel, char *phrFrame, char *columns, int numSlotsUsed, int reserve)
 {
-    char * curOff = phrFrame + 2 * pageNumOffset + 2 * sizeof(int);
-    memcpy(curOff, b->array, sizeof(bitmap_type)* b->words);
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    char *blocks = getSlotsPH(phrFrame) + columnBlocksOffset;
+    int capacity = tableInfo->pageSize - PAGE_TRAILER_SIZE - (blocks - phrFrame) - reserve;
+    if(capacity <= 0)
+        return RC_RM_PAGE_FULL;
+    VALID_CALLOC(char, encoded, capacity, sizeof(char));
+    int size = 0;
+    for(int i = 0; i < rel->schema->numAttr; i++)
+    {
+        int blockSize = encodeColumn(rel->schema->dataTypes[i], rel->schema->typeLength[i],
+                                     columns + tableInfo->numSlotsPerPage*tableInfo->attrOffsets[i],
+                                     numSlotsUsed, encoded + size, capacity - size);
+        if(blockSize < 0)
+        {
+            free(encoded);
+            return RC_RM_PAGE_FULL;
+        }
+        size += blockSize;
+    }
+    memcpy(blocks, encoded, size);
+    setNumSlotsUsedPH(phrFrame, (unsigned short) numSlotsUsed);
+    free(encoded);
+    return RC_OK;
 }
 
 /*********************************************************************
-*
-*               PAGEFILE HEADER GETTERS AND SETTERS
-*
+isPageFull checks if a page is taken off the free list. Compressed
+pages can be full while they still have free slots.
 *********************************************************************/
-static unsigned short getRecordSizePF(char *pfHdrFrame)
+static bool isPageFull(RM_TableData *rel, char *phrFrame, bitmap *b)
 {
-    unsigned short recordSize;
-    memcpy(&recordSize, pfHdrFrame + recordSizeOffset, sizeof(unsigned short));
-    return recordSize;
+    if(rel->mgmtData->layout == RM_LAYOUT_PAX_COMPRESSED)
+    {
+        unsigned short pageFlags;
+        memcpy(&pageFlags, getSlotsPH(phrFrame) + pageFlagsOffset, sizeof(unsigned short));
+        return (pageFlags & PAGE_FULL) != 0;
+    }
+    return findFreeSlot(b) == rel->mgmtData->numSlotsPerPage;
 }
-static unsigned int getNumTuplesPF(char *pfHdrFrame)
+
+/*********************************************************************
+markAttrRefs sets attrRefs[i] for every EXPR_ATTRREF in expr
+*********************************************************************/
+static void markAttrRefs(Expr *expr, bool *attrRefs)
 {
-    unsigned int numTuples;
-    memcpy(&numTuples, pfHdrFrame + numTuplesOffset, sizeof(unsigned int));
-    return numTuples;
+    switch(expr->type)
+    {
+    case EXPR_OP:
+        markAttrRefs(expr->expr.op->args[0], attrRefs);
+        if(expr->expr.op->type != OP_BOOL_NOT)
+            markAttrRefs(expr->expr.op->args[1], attrRefs);
+        break;
+    case EXPR_ATTRREF:
+        attrRefs[expr->expr.attrRef] = true;
+        break;
+    case EXPR_CONST:
+        break;
+    }
 }
-static void setNumTuplesPF(char *pfHdrFrame, unsigned int numTuples)
+
+/*********************************************************************
+isSimplePredicate checks if cond compares an attribute with a constant,
+which is the kind of condition that can be evaluated on compressed
+minipages
+*********************************************************************/
+static bool isSimplePredicate(Expr *cond, int *attrNum, OpType *op, bool *consOnLeft, Value **cons)
 {
-    memcpy(pfHdrFrame + numTuplesOffset, &numTuples, sizeof(unsigned int));
+    if(cond->type != EXPR_OP)
+        return false;
+    *op = cond->expr.op->type;
+    if(*op != OP_COMP_EQUAL && *op != OP_COMP_SMALLER)
+        return false;
+    Expr *left = cond->expr.op->args[0];
+    Expr *right = cond->expr.op->args[1];
+    if(left->type == EXPR_ATTRREF && right->type == EXPR_CONST)
+    {
+        *attrNum = left->expr.attrRef;
+        *cons = right->expr.cons;
+        *consOnLeft = false;
+        return true;
+    }
+    if(left->type == EXPR_CONST && right->type == EXPR_ATTRREF)
+    {
+        *attrNum = right->expr.attrRef;
+        *cons = left->expr.cons;
+        *consOnLeft = true;
+        return true;
+    }
+    return false;
 }
-static unsigned int getNextFreePage(char *pfHdrFrame)
+
+/*********************************************************************
+filterPage evaluates the scan condition for every slot of a compressed
+page on the encoded minipage and stores the results in scan->filter.
+scan->filterPage is only set if the condition and encoding allow it,
+otherwise next() evaluates the condition slot by slot.
+*********************************************************************/
+static bool filterPage(RM_ScanHandle *scan, char *phrFrame)
 {
-    unsigned int nextFreePage;
-    memcpy(&nextFreePage, pfHdrFrame + nextFreePageOffset, sizeof(unsigned int));
-    return nextFreePage;
+    int attrNum;
+    OpType op;
+    bool consOnLeft;
+    Value *cons;
+    Schema *schema = scan->rel->schema;
+    if(!isSimplePredicate(scan->mgmtData, &attrNum, &op, &consOnLeft, &cons))
+        return false;
+    if(!filterColumn(schema->dataTypes[attrNum], schema->typeLength[attrNum],
+                     getColumnBlock(scan->rel, phrFrame, attrNum), getNumSlotsUsedPH(phrFrame),
+                     op, consOnLeft, cons, scan->filter))
+        return false;
+    scan->filterPage = scan->pageNum;
+    return true;
 }
-static void setNextFreePage(char *pfHdrFrame, unsigned int nextFreePage)
+
+/*********************************************************************
+getSideFileName returns the name of the side file of table name with
+suffix, e.g. the zone map file. The caller frees it.
+*********************************************************************/
+static char* getSideFileName(char *name, char *suffix)
 {
-    memcpy(pfHdrFrame + nextFreePageOffset, &nextFreePage, sizeof(unsigned int));
+    VALID_CALLOC(char, fileName, strlen(name) + strlen(suffix) + 1, sizeof(char));
+    strcpy(fileName, name);
+    strcat(fileName, suffix);
+    return fileName;
 }
-static unsigned short getNumSlotsPerPage(char *pfHdrFrame)
+
+static void destroySideFiles(char *name)
 {
-    unsigned short numSlotsPerPage;
-    memcpy(&numSlotsPerPage, pfHdrFrame + numSlotsPerPageOffset, sizeof(unsigned short));
-    return numSlotsPerPage;
+    destroySidePageFile(name, ZONE_MAP_SUFFIX);
+    destroySidePageFile(name, BLOOM_FILTER_SUFFIX);
+    char *fileName = getSideFileName(name, LOG_SUFFIX);
+    if(access(fileName, F_OK) == 0)
+        destroyLog(fileName);
+    free(fileName);
 }
-static unsigned short getSchemaSize(char *pfHdrFrame)
+
+//destroys the page file of table name with suffix, if the table has one
+static void destroySidePageFile(char *name, char *suffix)
 {
-    unsigned short schemaSize;
-    memcpy(&schemaSize, pfHdrFrame + schemaSizeOffset, sizeof(unsigned short));
-    return schemaSize;
+    char *fileName = getSideFileName(name, suffix);
+    if(pageFileExists(fileName))
+        destroyPageFile(fileName);
+    free(fileName);
 }
-static void getSchema(char *pfHdrFrame, Schema *schema)
-{
-    //store values of non-array variables
-    schema->numAttr = getNumAttr(pfHdrFrame);
-    schema->keySize = getKeySize(pfHdrFrame);
-    // allocate memory for variable length arrays in schema struct
-    VALID_CALLOC(char*, attrNames, schema->numAttr, sizeof(char*));
-    VALID_CALLOC(DataType, dataTypes, schema->numAttr, sizeof(DataType));
-    VALID_CALLOC(int, typeLength, schema->numAttr, sizeof(int));
-    VALID_CALLOC(int, keyAttrs, schema->keySize, sizeof(int));
-    //store values and pointers in schema struct
-    schema->attrNames = attrNames;
-    schema->dataTypes = dataTypes;
-    schema->typeLength = typeLength;
-    schema->keyAttrs = keyAttrs;
-    //Populate arrays in the schema
-    for(int i = 0; i < schema->numAttr; i++)
-    {
-        schema->dataTypes[i] = getIthDataType(pfHdrFrame, i);
-        schema->typeLength[i] = getIthTypeLength(pfHdrFrame, i);
-        schema->attrNames[i] = getIthAttrName(pfHdrFrame, i);
-    }
-    for(int i = 0; i < schema->keySize; i++)
+
+/*********************************************************************
+openPageSummaries loads the zone maps and bloom filters saved by
+closeTable. They are rebuilt from the data pages if a file is missing
+or wasn't closed cleanly. A table only has a bloom filter file once
+addBloomFilter was called. The files are marked as not clean until the
+table is closed again.
+*********************************************************************/
+static RC openPageSummaries(RM_TableData *rel)
+{
+    RC returnCode = RC_INIT;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    bool isClean = false, isBloomClean = true;
+    char *fileName = getSideFileName(rel->name, ZONE_MAP_SUFFIX);
+    if(readZoneMap(&tableInfo->zoneMap, fileName, &isClean) != RC_OK)
+        isClean = false;
+    free(fileName);
+    fileName = getSideFileName(rel->name, BLOOM_FILTER_SUFFIX);
+    if(pageFileExists(fileName)
+            && readBloomFilters(&tableInfo->bloomFilters, fileName, &isBloomClean) != RC_OK)
+        isBloomClean = false;
+    free(fileName);
+    if(!isClean || !isBloomClean)
     {
-        keyAttrs[i] = getIthKeyAttr(pfHdrFrame, i);
+        ASSERT_RC_OK(rebuildPageSummaries(rel));
     }
+    return savePageSummaries(rel, false);
 }
-static unsigned short getNumAttr(char *pfHdrFrame)
+
+static RC savePageSummaries(RM_TableData *rel, bool isClean)
 {
-    unsigned short numAttr;
-    memcpy(&numAttr, pfHdrFrame + numAttrOffset, sizeof(unsigned short));
-    return numAttr;
+    RC returnCode = RC_INIT;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    char *fileName = getSideFileName(rel->name, ZONE_MAP_SUFFIX);
+    returnCode = writeZoneMap(&tableInfo->zoneMap, fileName, isClean);
+    free(fileName);
+    if(returnCode != RC_OK || tableInfo->bloomFilters.numFilters == 0)
+        return returnCode;
+    fileName = getSideFileName(rel->name, BLOOM_FILTER_SUFFIX);
+    returnCode = writeBloomFilters(&tableInfo->bloomFilters, fileName, isClean);
+    free(fileName);
+    return returnCode;
 }
-static DataType getIthDataType(char *pfHdrFrame, int ithSlot)
+
+static RC rebuildPageSummaries(RM_TableData *rel)
 {
-    unsigned short dataType;
-    memcpy(&dataType, pfHdrFrame + dataTypeOffset(ithSlot), sizeof(unsigned short));
-    switch(dataType)
+    RC returnCode = RC_INIT;
+    BM_PageHandle page;
+    int numPages;
+    ASSERT_RC_OK(getTableNumPages(rel, &numPages));
+    for(int pageNum = 1; pageNum < numPages; pageNum++)
     {
-    case 0:
-        return DT_INT;
-    case 1:
-        return DT_STRING;
-    case 2:
-        return DT_FLOAT;
-    case 3:
-        return DT_BOOL;
-    default:
-        return DT_INT;
+        ASSERT_RC_OK(pinTablePage(rel, &page, pageNum));
+        rebuildPageSummary(rel, pageNum, page.data);
+        ASSERT_RC_OK(unpinTablePage(rel, &page));
     }
+    return RC_OK;
 }
-static unsigned short getIthTypeLength(char *pfHdrFrame, int ithSlot)
-{
-    unsigned short typeLength;
-    memcpy(&typeLength, pfHdrFrame + typeLengthOffset(ithSlot), sizeof(unsigned short));
-    return typeLength;
-}
-static unsigned short getKeySize(char *pfHdrFrame)
-{
-    unsigned short keySize;
-    unsigned short numAttr = getNumAttr(pfHdrFrame);
-    memcpy(&keySize, pfHdrFrame + keySizeOffset, sizeof(unsigned short));
-    return keySize;
-}
-static unsigned short getIthKeyAttr(char *pfHdrFrame, int ithSlot)
-{
-    unsigned short keyAttr;
-    unsigned short numAttr = getNumAttr(pfHdrFrame);
-    memcpy(&keyAttr, pfHdrFrame + keyAttrOffset(ithSlot), sizeof(unsigned short));
-    return keyAttr;
-}
-static unsigned short getIthNameLength(char *pfHdrFrame, int ithSlot)
+
+//recomputes the zone map and bloom filters of a pinned page from its records
+static void rebuildPageSummary(RM_TableData *rel, unsigned int pageNum, char *phrFrame)
 {
-    unsigned short nameLength = 0;
-    unsigned short numAttr = getNumAttr(pfHdrFrame);
-    unsigned short keySize = getKeySize(pfHdrFrame);
-    char *ptr = pfHdrFrame + attrNamesOffset;
-    for(int i = 0; i <= ithSlot; i++)
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    clearZoneMapPage(&tableInfo->zoneMap, pageNum);
+    clearBloomFilterPage(&tableInfo->bloomFilters, pageNum);
+    VALID_CALLOC(char, data, 1, tableInfo->recordSize);
+    bitmap *b = getBitMapPH(phrFrame);
+    for(int slotNum = 0; slotNum < tableInfo->numSlotsPerPage; slotNum++)
     {
-        memcpy(&nameLength, ptr, sizeof(unsigned short));
-        ptr = ptr + nameLength + sizeof(unsigned short);
+        if(bitmap_read(b, slotNum) == 0)
+            continue;
+        readSlot(rel, phrFrame, slotNum, data);
+        extendZoneMap(&tableInfo->zoneMap, pageNum, data);
+        extendBloomFilter(&tableInfo->bloomFilters, pageNum, data);
     }
-    return nameLength;
+    bitmap_deallocate(b);
+    free(data);
 }
-static char* getIthAttrName(char *pfHdrFrame, int ithSlot)
+
+/*********************************************************************
+applyInsert writes the record into a free slot and appends its log
+record for transaction txId, lsn is set to its LSN. If it fails the
+slot is left free. The table latch has to be held.
+*********************************************************************/
+static RC applyInsert(RM_TableData *rel, Record *record, int txId, LM_LSN *lsn)
 {
-    unsigned short nameLength;
-    unsigned short numAttr = getNumAttr(pfHdrFrame);
-    unsigned short keySize = getKeySize(pfHdrFrame);
-    char *ptr = pfHdrFrame + attrNamesOffset + sizeof(unsigned short);
-    for(int i = 0; i < ithSlot; i++)
+    RC returnCode = RC_INIT;
+
+    //create two local BM_PageHandles
+    BM_PageHandle pageFileHeader;
+    BM_PageHandle pageToInsert;
+    BM_BufferPool* bm = rel->bufferPool;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    bitmap * b = NULL;
+    bool isPinned = false;
+    bool isSlotSet = false;
+    bool isListed = true;
+    //pin the page with the pageFile header
+    ASSERT_RC_OK(pinPage(bm,&pageFileHeader,0));
+    //compressed pages can run out of space before they run out of
+    //slots, so keep trying free pages until the record fits
+    while(true)
+    {
+        bool newPageCreated = false;
+        //find the first page with free slot from pageFile header
+        unsigned int freePageNum = getNextFreePage(pageFileHeader.data);
+        if(freePageNum==0)
+        {
+            returnCode = findNewPageNum(rel, &freePageNum);
+            if(returnCode != RC_OK)
+                break;
+            newPageCreated=true;
+        }
+        //update record->id.page
+        record->id.page = freePageNum;
+        //pin the first page with a free slot
+        returnCode = pinPage(bm,&pageToInsert,freePageNum);
+        if(returnCode != RC_OK)
+            break;
+        isPinned = true;
+        //setup page header if it is a new page
+        if(newPageCreated)
+        {
+            //the frame may still hold the page it cached before
+            memset(pageToInsert.data, 0, tableInfo->pageSize);
+            returnCode = forcePage(bm, &pageToInsert);
+            if(returnCode != RC_OK)
+                break;
+            //set up pages
+            setNextFreePagePH(pageToInsert.data, 0);
+            setPrevFreePagePH(pageToInsert.data, freePageNum);
+            appendToFreeLinkedList(pageFileHeader.data, pageToInsert.data, bm);
+            bitmap * b = bitmap_allocate((int) getNumSlotsPerPage(pageFileHeader.data));
+            setBitMapPH(pageToInsert.data, b);
+            bitmap_deallocate(b);
+            if(tableInfo->layout == RM_LAYOUT_PAX_COMPRESSED)
+            {
+                setNumSlotsUsedPH(pageToInsert.data, 0);
+                setPageFullPH(pageToInsert.data, false);
+            }
+        }
+        //find free slot using pageHeader bitMap
+        b = getBitMapPH(pageToInsert.data);
+        unsigned short nextFreeSlot = findFreeSlot(b);
+        if(nextFreeSlot==tableInfo->numSlotsPerPage)
+        {
+            returnCode = RC_RM_NO_FREE_PAGES;
+            break;
+        }
+        //write record->data to current slot
+        returnCode = writeSlot(rel, pageToInsert.data, nextFreeSlot, record->data,
+                               RM_COMPRESSED_PAGE_RESERVE(tableInfo->pageSize));
+        if(returnCode == RC_RM_PAGE_FULL && !newPageCreated)
+        {
+            //the page is out of space, take it off the free list and try the next one
+            setPageFullPH(pageToInsert.data, true);
+            bitmap_deallocate(b);
+            b = NULL;
+            returnCode = deleteFromFreeLinkedList(pageFileHeader.data,pageToInsert.data,bm);
+            if(returnCode == RC_OK)
+                returnCode = markDirty(bm, &pageToInsert);
+            if(returnCode != RC_OK)
+                break;
+            isPinned = false;
+            returnCode = unpinPage(bm,&pageToInsert);
+            if(returnCode != RC_OK)
+                break;
+            continue;
+        }
+        if(returnCode != RC_OK)
+            break;
+        //update record->id.slot
+        record->id.slot = nextFreeSlot;
+        //update the bitMap
+        bitmap_set(b, nextFreeSlot);
+        setBitMapArrayPH(pageToInsert.data, b);
+        isSlotSet = true;
+
+        //check if the page doesn't have anymore slots
+        //so the page will be removed from the linked list
+        if(findFreeSlot(b)==tableInfo->numSlotsPerPage)
+        {
+            if(tableInfo->layout == RM_LAYOUT_PAX_COMPRESSED)
+                setPageFullPH(pageToInsert.data, true);
+            returnCode = deleteFromFreeLinkedList(pageFileHeader.data,pageToInsert.data,bm);
+            isListed = returnCode != RC_OK;
+        }
+        break;
+    }
+    //the page is dirty before its record is appended, see logChange
+    if(returnCode == RC_OK)
+        returnCode = markDirty(bm, &pageToInsert);
+    if(returnCode == RC_OK)
+        returnCode = logChange(rel, LOG_INSERT, txId, record->id, record->data, NULL,
+                               pageToInsert.data, lsn);
+    if(returnCode == RC_OK)
     {
-        nameLength = getIthNameLength(pfHdrFrame, i);
-        ptr = ptr + nameLength + sizeof(unsigned short);
+        extendZoneMap(&tableInfo->zoneMap, record->id.page, record->data);
+        extendBloomFilter(&tableInfo->bloomFilters, record->id.page, record->data);
+        //increment numTuples in the pageFile header
+        setNumTuplesPF(pageFileHeader.data, getNumTuplesPF(pageFileHeader.data)+1);
+        //mark the pageFile header as dirty
+        returnCode = markDirty(bm, &pageFileHeader);
     }
-    nameLength = getIthNameLength(pfHdrFrame, ithSlot);
-    VALID_CALLOC(char, attrName, 1, nameLength+1); //room for null char
-    memcpy(attrName, ptr, nameLength);
-    return attrName;
+    else if(isSlotSet)
+    {
+        //nothing logged the record, free its slot again
+        bitmap_clear(b, record->id.slot);
+        setBitMapArrayPH(pageToInsert.data, b);
+        if(!isListed)
+        {
+            if(tableInfo->layout == RM_LAYOUT_PAX_COMPRESSED)
+                setPageFullPH(pageToInsert.data, false);
+            //the prev pointer tells appendToFreeLinkedList the page number
+            setPrevFreePagePH(pageToInsert.data, record->id.page);
+            appendToFreeLinkedList(pageFileHeader.data, pageToInsert.data, bm);
+        }
+    }
+    if(b)
+        bitmap_deallocate(b);
+    //unpin the pageFile header and the page we inserted the record into
+    if(isPinned)
+        unpinPage(bm,&pageToInsert);
+    unpinPage(bm,&pageFileHeader);
+    //we shouldn't need to worry about writing it back to disk
+    //that will be handled by page replacement
+    return returnCode;
+}
+
+/*********************************************************************
+applyDelete empties slot id and appends its log record for transaction
+txId, lsn is set to its LSN. If it fails the record is left in its
+slot. The table latch has to be held.
+*********************************************************************/
+static RC applyDelete(RM_TableData *rel, RID id, int txId, LM_LSN *lsn)
+{
+    RC returnCode = RC_INIT;
+    //get location
+    int pageNum = id.page;
+    short slotNum = id.slot;
+    //create two local BM_PageHandle
+    //create two local BM_PageHandles
+    BM_PageHandle pageFileHeader;
+    BM_PageHandle pageToDelete;
+    BM_BufferPool* bm = rel->bufferPool;
+    //pin the page with the pageFile header
+    ASSERT_RC_OK(pinPage(bm,&pageFileHeader,0));
+    char* pfhr = pageFileHeader.data;
+    returnCode = pinPage(bm,&pageToDelete,pageNum);
+    if(returnCode != RC_OK)
+    {
+        unpinPage(bm,&pageFileHeader);
+        return returnCode;
+    }
+    //find free slot using pageHeader bitMap
+    char * phr = pageToDelete.data;
+    int recordSize =  getRecordSize(rel->schema);
+    //the zone map of the page only narrows if the record was on a bound
+    VALID_CALLOC(char, oldData, 1, recordSize);
+    readSlot(rel, phr, slotNum, oldData);
+    bool isBound = isZoneMapBound(&rel->mgmtData->zoneMap, pageNum, oldData);
+
+    //**if the page didn't previously have a free slot, check
+    //to see if it is now the first page with a free slot
+    //and update pageFile header appropriately
+    bitmap * b = getBitMapPH(phr);
+    bool wasFull = isPageFull(rel, phr, b);
+    bool isCleared = false;
+    returnCode = RC_OK;
+    if(wasFull)
+    {
+        //save the current pageNum into the prev ptr
+        setPrevFreePagePH(phr,0);
+        returnCode = appendToFreeLinkedList(pfhr,phr,bm);
+        if(rel->mgmtData->layout == RM_LAYOUT_PAX_COMPRESSED)
+            setPageFullPH(phr, false);
+    }
+    if(returnCode == RC_OK)
+    {
+        //update bitMap
+        bitmap_clear(b, slotNum);
+        setBitMapPH(phr, b);
+        isCleared = true;
+        //Not sure if this is truly necessary
+        //if we update the bitMap then we won't read from that slot anymore
+        //this is just for safety and can be taken out
+        //(compressed pages keep the old value, re-encoding could only grow them)
+        if(rel->mgmtData->layout != RM_LAYOUT_PAX_COMPRESSED)
+        {
+            VALID_CALLOC(char, emptySlot, 1, recordSize);
+            writeSlot(rel, phr, slotNum, emptySlot, 0);
+            free(emptySlot);
+        }
+        if(isBound)
+            rebuildPageSummary(rel, pageNum, phr);
+        //the page is dirty before its record is appended, see logChange
+        returnCode = markDirty(bm, &pageToDelete);
+    }
+    //transactions log the old record to undo the delete
+    if(returnCode == RC_OK)
+        returnCode = logChange(rel, LOG_DELETE, txId, id, NULL, txId ? oldData : NULL, phr, lsn);
+    if(returnCode == RC_OK)
+    {
+        //decrement numTuples
+        setNumTuplesPF(pfhr,getNumTuplesPF(pfhr)-1);
+        //mark the pageFile header as dirty
+        returnCode = markDirty(bm, &pageFileHeader);
+    }
+    else if(isCleared)
+    {
+        //nothing logged the delete, put the record back
+        if(rel->mgmtData->layout != RM_LAYOUT_PAX_COMPRESSED)
+            writeSlot(rel, phr, slotNum, oldData, 0);
+        bitmap_set(b, slotNum);
+        setBitMapArrayPH(phr, b);
+        if(wasFull)
+        {
+            if(rel->mgmtData->layout == RM_LAYOUT_PAX_COMPRESSED)
+                setPageFullPH(phr, true);
+            deleteFromFreeLinkedList(pfhr, phr, bm);
+        }
+        if(isBound)
+            rebuildPageSummary(rel, pageNum, phr);
+    }
+    bitmap_deallocate(b);
+    free(oldData);
+    //unpin the pageFile header and the page we deleted the record from
+    unpinPage(bm,&pageFileHeader);
+    unpinPage(bm,&pageToDelete);
+    //we shouldn't need to worry about writing it back to disk
+    //that will be handled by page replacement
+    return returnCode;
+}
+
+/*********************************************************************
+applyUpdate writes record into its slot and appends its log record for
+transaction txId, lsn is set to its LSN. If it fails the old record is
+left in the slot. The table latch has to be held.
+*********************************************************************/
+static RC applyUpdate(RM_TableData *rel, Record *record, int txId, LM_LSN *lsn)
+{
+    RC returnCode = RC_INIT;
+    int pageNum = record->id.page;
+    int slotNum = record->id.slot;
+    //create two local BM_PageHandles
+    BM_PageHandle pageToUpdate;
+    BM_BufferPool* bm = rel->bufferPool;
+    //pin the first page with a free slot
+    ASSERT_RC_OK(pinPage(bm,&pageToUpdate,pageNum));
+    char * phr = pageToUpdate.data;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    VALID_CALLOC(char, oldData, 1, tableInfo->recordSize);
+    readSlot(rel, phr, slotNum, oldData);
+    bool isBound = isZoneMapBound(&tableInfo->zoneMap, pageNum, oldData);
+    //write record->data to current slot
+    returnCode = writeSlot(rel, phr, slotNum, record->data, 0);
+    if(returnCode != RC_OK)
+    {
+        free(oldData);
+        unpinPage(bm,&pageToUpdate);
+        return returnCode;
+    }
+    //the bounds only narrow if the old record was on one of them
+    if(isBound)
+        rebuildPageSummary(rel, pageNum, phr);
+    else
+    {
+        extendZoneMap(&tableInfo->zoneMap, pageNum, record->data);
+        extendBloomFilter(&tableInfo->bloomFilters, pageNum, record->data);
+    }
+    //the page is dirty before its record is appended, see logChange
+    returnCode = markDirty(bm, &pageToUpdate);
+    //transactions log the old record to undo the update
+    if(returnCode == RC_OK)
+        returnCode = logChange(rel, LOG_UPDATE, txId, record->id, record->data,
+                               txId ? oldData : NULL, pageToUpdate.data, lsn);
+    if(returnCode != RC_OK)
+    {
+        //nothing logged the update, put the old record back. It had
+        //room before, so it fits again
+        writeSlot(rel, phr, slotNum, oldData, 0);
+        rebuildPageSummary(rel, pageNum, phr);
+    }
+    free(oldData);
+    //unpin the page we updated the record in
+    unpinPage(bm,&pageToUpdate);
+    //we shouldn't need to worry about writing it back to disk
+    //that will be handled by page replacement
+    return returnCode;
+}
+
+/*********************************************************************
+moveRecord takes record out of its compressed page, which it no longer
+fits on, and inserts it into a free slot of another page, record->id is
+set to it. Snapshots taken before still see the old record in the old
+slot and not the new one, as after deleteRecord and insertRecord. The
+record is inserted before the old one is deleted, so a crash between
+the two log records leaves both rather than none. If the move fails
+record->id and the table are as before. The table latch has to be held.
+*********************************************************************/
+static RC moveRecord(RM_TableData *rel, Record *record, LM_LSN *lsn)
+{
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    RM_VersionStore *versions = &tableInfo->versions;
+    RID oldId = record->id;
+    bool isVersioned = false;
+    RC returnCode = applyInsert(rel, record, 0, lsn);
+    if(returnCode != RC_OK)
+    {
+        record->id = oldId;
+        return returnCode;
+    }
+    if(hasSnapshots(versions) || findVersionChain(versions, oldId))
+    {
+        returnCode = pushSlotVersion(rel, oldId, 0, versions->lastCommitTs, true);
+        isVersioned = returnCode == RC_OK;
+    }
+    if(returnCode == RC_OK)
+        returnCode = applyDelete(rel, oldId, 0, lsn);
+    if(returnCode != RC_OK)
+    {
+        if(isVersioned)
+            free(popVersion(findVersionChain(versions, oldId)));
+        //the new copy goes again, the old record never left its slot
+        LM_LSN undoLsn;
+        applyDelete(rel, record->id, 0, &undoLsn);
+        record->id = oldId;
+        return returnCode;
+    }
+    if(hasSnapshots(versions) || findVersionChain(versions, record->id))
+        pushVersion(getVersionChain(versions, record->id, false), 0, ++versions->lastCommitTs,
+                    false, NULL, tableInfo->recordSize);
+    return RC_OK;
+}
+
+/*********************************************************************
+moveRecordTx moves record like moveRecord within transaction tx: the
+old record is deleted like deleteRecordTx does and the record inserted
+into another page like insertRecordTx does, record->id is set to its
+new slot. The table latch has to be held, the caller locks the new
+slot once it is released.
+*********************************************************************/
+static RC moveRecordTx(RM_Transaction *tx, Record *record)
+{
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    RID oldId = record->id;
+    LM_LSN lsn;
+    RC returnCode = pushSlotVersion(tx->rel, oldId, tx->txId, tx->snapshotTs, true);
+    if(returnCode != RC_OK)
+        return returnCode;
+    returnCode = applyInsert(tx->rel, record, tx->txId, &lsn);
+    if(returnCode != RC_OK)
+    {
+        free(popVersion(findVersionChain(&tableInfo->versions, oldId)));
+        record->id = oldId;
+        return returnCode;
+    }
+    addWrite(tx, oldId, RM_WRITE_DELETE);
+    RM_VersionChain *chain = getVersionChain(&tableInfo->versions, record->id, false);
+    pushVersion(chain, tx->txId, TS_UNCOMMITTED, false, NULL, tableInfo->recordSize);
+    addWrite(tx, record->id, RM_WRITE_INSERT);
+    return RC_OK;
+}
+
+/*********************************************************************
+applyRestore puts record back into its slot, which a delete of
+transaction txId emptied, and appends its log record for transaction
+txId, lsn is set to its LSN. It undoes a delete that reached the page,
+so the page is on the free list. The table latch has to be held.
+*********************************************************************/
+static RC applyRestore(RM_TableData *rel, Record *record, int txId, LM_LSN *lsn)
+{
+    RC returnCode = RC_INIT;
+    BM_PageHandle pageFileHeader;
+    BM_PageHandle pageToRestore;
+    BM_BufferPool* bm = rel->bufferPool;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    ASSERT_RC_OK(pinPage(bm,&pageFileHeader,0));
+    returnCode = pinPage(bm,&pageToRestore,record->id.page);
+    if(returnCode != RC_OK)
+    {
+        unpinPage(bm,&pageFileHeader);
+        return returnCode;
+    }
+    char *phr = pageToRestore.data;
+    returnCode = writeSlot(rel, phr, record->id.slot, record->data, 0);
+    if(returnCode == RC_OK)
+    {
+        bitmap *b = getBitMapPH(phr);
+        bitmap_set(b, record->id.slot);
+        setBitMapArrayPH(phr, b);
+        //the page leaves the free list if the slot was its last free one
+        if(findFreeSlot(b) == tableInfo->numSlotsPerPage)
+        {
+            if(tableInfo->layout == RM_LAYOUT_PAX_COMPRESSED)
+                setPageFullPH(phr, true);
+            returnCode = deleteFromFreeLinkedList(pageFileHeader.data, phr, bm);
+        }
+        bitmap_deallocate(b);
+    }
+    if(returnCode == RC_OK)
+    {
+        extendZoneMap(&tableInfo->zoneMap, record->id.page, record->data);
+        extendBloomFilter(&tableInfo->bloomFilters, record->id.page, record->data);
+        //the page is dirty before its record is appended, see logChange
+        returnCode = markDirty(bm, &pageToRestore);
+    }
+    //logged like an insert into the slot, recovery redoes and undoes it so
+    if(returnCode == RC_OK)
+        returnCode = logChange(rel, LOG_INSERT, txId, record->id, record->data, NULL, phr, lsn);
+    if(returnCode == RC_OK)
+    {
+        setNumTuplesPF(pageFileHeader.data, getNumTuplesPF(pageFileHeader.data)+1);
+        returnCode = markDirty(bm, &pageFileHeader);
+    }
+    unpinPage(bm,&pageFileHeader);
+    unpinPage(bm,&pageToRestore);
+    return returnCode;
+}
+
+/*********************************************************************
+readVisible copies the version of record id that the snapshot of
+transaction txId sees into record. Slots without versions are read
+from the page. The table latch has to be held.
+RETURNS: RC_RM_RECORD_NOT_FOUND if the snapshot sees no record there
+*********************************************************************/
+static RC readVisible(RM_TableData *rel, RID id, int txId, RM_Timestamp snapshotTs, Record *record)
+{
+    RC returnCode = RC_INIT;
+    RM_VersionChain *chain = findVersionChain(&rel->mgmtData->versions, id);
+    RM_Version *version = chain ? getVisibleVersion(chain, txId, snapshotTs) : NULL;
+    if(chain && (!version || version->isDeleted))
+        return RC_RM_RECORD_NOT_FOUND;
+    if(version && version->data)
+    {
+        memcpy(record->data, version->data, rel->mgmtData->recordSize);
+        record->id = id;
+        return RC_OK;
+    }
+    int pageNum = id.page;
+    int slotNum = id.slot;
+    //create local BM_PageHandles
+    BM_PageHandle pageToGet;
+    //pin the page of interest
+    ASSERT_RC_OK(pinTablePage(rel,&pageToGet,pageNum));
+    char * phr = pageToGet.data;
+    //copy the slot into record->data, rebuilding the row for PAX pages
+    readSlot(rel, phr, slotNum, record->data);
+    record->id.page = pageNum;
+    record->id.slot = slotNum;
+    //unpin the page we of the record we got
+    ASSERT_RC_OK(unpinTablePage(rel,&pageToGet));
+    //we shouldn't need to worry about writing it back to disk
+    //that will be handled by page replacement
+    return RC_OK;
+}
+
+/*********************************************************************
+readSlotState reads slot id from its page and whether it holds a
+record
+*********************************************************************/
+static RC readSlotState(RM_TableData *rel, RID id, char *data, bool *inUse)
+{
+    RC returnCode = RC_INIT;
+    BM_PageHandle page;
+    if(id.page < 1 || id.slot < 0 || id.slot >= rel->mgmtData->numSlotsPerPage)
+        return RC_RM_RECORD_NOT_FOUND;
+    ASSERT_RC_OK(pinPage(rel->bufferPool, &page, id.page));
+    bitmap *b = getBitMapPH(page.data);
+    *inUse = bitmap_read(b, id.slot);
+    bitmap_deallocate(b);
+    readSlot(rel, page.data, id.slot, data);
+    return unpinPage(rel->bufferPool, &page);
+}
+
+/*********************************************************************
+pushSlotVersion adds the version a change of slot id is about to make
+to the chain of the slot, keeping the record in the slot for the
+snapshots that still see it. Changes outside of transactions (txId 0)
+commit right away. The table latch has to be held.
+RETURNS: RC_RM_WRITE_CONFLICT if another transaction changed the record
+         after snapshotTs or hasn't committed its change yet
+*********************************************************************/
+static RC pushSlotVersion(RM_TableData *rel, RID id, int txId, RM_Timestamp snapshotTs, bool isDeleted)
+{
+    RC returnCode = RC_INIT;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    RM_VersionStore *versions = &tableInfo->versions;
+    bool inUse = false;
+    VALID_CALLOC(char, data, 1, tableInfo->recordSize);
+    returnCode = readSlotState(rel, id, data, &inUse);
+    if(returnCode == RC_OK)
+    {
+        RM_VersionChain *chain = getVersionChain(versions, id, inUse);
+        returnCode = checkWrite(chain, txId, snapshotTs);
+        if(returnCode == RC_OK)
+            pushVersion(chain, txId, txId ? TS_UNCOMMITTED : ++versions->lastCommitTs,
+                        isDeleted, data, tableInfo->recordSize);
+    }
+    free(data);
+    return returnCode;
+}
+
+static void addWrite(RM_Transaction *tx, RID id, RM_WriteKind kind)
+{
+    if(tx->numWrites == tx->writeCapacity)
+    {
+        tx->writeCapacity = tx->writeCapacity ? 2*tx->writeCapacity : 8;
+        tx->writes = (RM_Write *) realloc(tx->writes, tx->writeCapacity * sizeof(RM_Write));
+        if(!tx->writes)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+    }
+    tx->writes[tx->numWrites].id = id;
+    tx->writes[tx->numWrites].kind = kind;
+    tx->writes[tx->numWrites].isApplied = false;
+    tx->numWrites++;
+}
+
+/*********************************************************************
+lockRecord locks the record id in mode, after the intention lock on its
+table, IX for changes and IS for reads. Without id only the table gets
+the intention lock. Must not be called with the table latch held.
+*********************************************************************/
+static RC lockRecord(LK_Owner *locks, RM_TableData *rel, RID *id, LK_LockMode mode)
+{
+    RC returnCode = RC_INIT;
+    LK_ResourceId table = {(uintptr_t) rel->mgmtData, -1, -1};
+    ASSERT_RC_OK(lockResource(&lockManager, locks, table, mode == LOCK_X ? LOCK_IX : LOCK_IS));
+    if(!id)
+        return RC_OK;
+    LK_ResourceId record = {table.table, id->page, id->slot};
+    return lockResource(&lockManager, locks, record, mode);
+}
+
+/*********************************************************************
+undoTransaction undoes the writes of tx newest first, logs the abort
+if they all succeeded and ends tx. It goes on after an error, so every
+version of tx is dropped, and returns the first one. The table latch
+has to be held.
+*********************************************************************/
+static RC undoTransaction(RM_Transaction *tx)
+{
+    RC returnCode = RC_OK;
+    RM_TableInfo *tableInfo = tx->rel->mgmtData;
+    RID noRecord = {0, 0};
+    LM_LSN lsn;
+    for(int i = tx->numWrites - 1; i >= 0; i--)
+    {
+        RM_Write *write = &tx->writes[i];
+        char *data = popVersion(findVersionChain(&tableInfo->versions, write->id));
+        Record oldRecord = {write->id, data};
+        RC undoCode = RC_OK;
+        if(write->kind == RM_WRITE_INSERT)
+            undoCode = applyDelete(tx->rel, write->id, tx->txId, &lsn);
+        else if(write->kind == RM_WRITE_UPDATE)
+            undoCode = applyUpdate(tx->rel, &oldRecord, tx->txId, &lsn);
+        //deletes only reach the page when the commit applies them
+        else if(write->isApplied)
+            undoCode = applyRestore(tx->rel, &oldRecord, tx->txId, &lsn);
+        if(returnCode == RC_OK)
+            returnCode = undoCode;
+        free(data);
+    }
+    if(returnCode == RC_OK && tx->numWrites > 0)
+        returnCode = logChange(tx->rel, LOG_ABORT, tx->txId, noRecord, NULL, NULL, NULL, &lsn);
+    endTransaction(tx);
+    return returnCode;
+}
+
+//drops the snapshot of tx and the versions nobody needs anymore
+static void endTransaction(RM_Transaction *tx)
+{
+    RM_VersionStore *versions = &tx->rel->mgmtData->versions;
+    endSnapshot(versions, tx->txId);
+    pruneVersions(versions);
+    free(tx->writes);
+    tx->writes = NULL;
+    tx->numWrites = 0;
+    tx->writeCapacity = 0;
+    tx->rel = NULL;
+}
+
+//sets up scan without a snapshot
+static RC initScan(RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+{
+
+    scan->mgmtData = cond;  //Store the condition into the mgmtData field
+    scan->rel = rel;        //Store the relation into the rel field
+    scan->slotNum = 0;
+    scan->pageNum = 1;
+    //remember which attributes the condition looks at, so PAX pages
+    //only have to read those minipages to evaluate it
+    VALID_CALLOC(bool, attrRefs, rel->schema->numAttr, sizeof(bool));
+    markAttrRefs(cond, attrRefs);
+    scan->attrRefs = attrRefs;
+    //per slot results of conditions evaluated on compressed minipages
+    VALID_CALLOC(bool, filter, rel->mgmtData->numSlotsPerPage, sizeof(bool));
+    scan->filter = filter;
+    scan->filterPage = 0;
+    scan->prefetchEnd = 0;
+    memset(&scan->locks, 0, sizeof(LK_Owner));
+    adviseMappedScans(rel, 1);
+    return RC_OK;
+}
+
+/*********************************************************************
+nextVisible does the work of next with the table latch held. Slots
+with versions return the version the scan's snapshot sees. The latch
+is released while the page file is opened and while a page is read or
+prefetched, so other calls can use the table meanwhile.
+*********************************************************************/
+static RC nextVisible(RM_ScanHandle *scan, Record *record)
+{
+    RC returnCode = RC_INIT;
+    BM_PageHandle curPage;//used to pin page to BufferPool
+    RM_TableData *rel = scan->rel;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    RM_VersionStore *versions = &tableInfo->versions;
+
+    int numPages;
+    pthread_mutex_unlock(&tableInfo->latch);
+    returnCode = getTableNumPages(rel, &numPages);
+    pthread_mutex_lock(&tableInfo->latch);
+    if(returnCode != RC_OK)
+        return returnCode;
+    Value *result;
+    //Iterate through the pages on disk and pin to bufferpool and search over bitmap of that page
+    for(; scan->pageNum<numPages; scan->pageNum++, scan->slotNum = 0)
+    {
+        //the summaries only describe the records in the page, older
+        //versions may still match
+        bool hasVersions = pageHasVersions(versions, scan->pageNum);
+        //skip pages whose zone maps or bloom filters rule out the condition
+        //without pinning them
+        if(!hasVersions && (!zoneMapCanMatch(&tableInfo->zoneMap, scan->pageNum, scan->mgmtData)
+                || !bloomFilterCanMatch(&tableInfo->bloomFilters, scan->pageNum, scan->mgmtData)))
+            continue;
+        //read the next pages with a single open of the page file, the
+        //kernel reads ahead in mappings itself
+        bool isPrefetched = false;
+        if(tableInfo->prefetchDepth > 0 && scan->pageNum >= scan->prefetchEnd
+                && !tableInfo->mapping.pages)
+        {
+            scan->prefetchEnd = scan->pageNum + tableInfo->prefetchDepth;
+            if(scan->prefetchEnd > numPages)
+                scan->prefetchEnd = numPages;
+            isPrefetched = true;
+        }
+        pthread_mutex_unlock(&tableInfo->latch);
+        returnCode = RC_OK;
+        if(isPrefetched)
+            returnCode = prefetchPages(rel->bufferPool, scan->pageNum, scan->prefetchEnd - scan->pageNum);
+        if(returnCode == RC_OK)
+            returnCode = pinTablePage(rel,&curPage,scan->pageNum);
+        pthread_mutex_lock(&tableInfo->latch);
+        if(returnCode != RC_OK)
+            return returnCode;
+        //a change made while the latch was released may have added versions
+        hasVersions = pageHasVersions(versions, scan->pageNum);
+        char * phr = curPage.data;//used to find used slot
+        //compressed pages evaluate simple conditions on the encoded
+        //minipage once for the whole page
+        if(hasVersions)
+            scan->filterPage = 0;
+        else if(tableInfo->layout == RM_LAYOUT_PAX_COMPRESSED && scan->filterPage != scan->pageNum)
+            filterPage(scan, phr);
+        bitmap * b = getBitMapPH(phr);
+        //while we did not reach the end of the slot
+        for(; scan->slotNum < tableInfo->numSlotsPerPage; ++scan->slotNum)
+        {
+            RM_VersionChain *chain = NULL;
+            if(hasVersions)
+            {
+                RID id = {scan->pageNum, scan->slotNum};
+                chain = findVersionChain(versions, id);
+            }
+            bool matches = true;
+            bool isRead = false; //record->data holds the whole record
+            if(chain)
+            {
+                //the snapshot may see another version than the page holds
+                RM_Version *version = getVisibleVersion(chain, scan->txId, scan->snapshotTs);
+                if(!version || version->isDeleted)
+                    continue;
+                if(version->data)
+                    memcpy(record->data, version->data, tableInfo->recordSize);
+                else
+                    readSlot(rel, phr, scan->slotNum, record->data);
+                isRead = true;
+                if(scan->mgmtData != NULL)
+                {
+                    ASSERT_RC_OK(evalExpr(record, rel->schema, scan->mgmtData, &result));
+                    matches = result->v.boolV;
+                    freeVal(result);
+                }
+            }
+            else if(bitmap_read(b,scan->slotNum)==0)
+                continue;
+            else if(scan->filterPage == scan->pageNum)
+                matches = scan->filter[scan->slotNum];
+            else if(scan->mgmtData != NULL)
+            {
+                //PAX pages only gather the attributes used by the condition
+                //and rebuild the whole record once it matches
+                if(tableInfo->layout != RM_LAYOUT_NSM)
+                {
+                    for(int i = 0; i < rel->schema->numAttr; i++)
+                        if(scan->attrRefs[i])
+                            readSlotAttr(rel, phr, scan->slotNum, i, record->data);
+                }
+                else
+                {
+                    readSlot(rel, phr, scan->slotNum, record->data);
+                    isRead = true;
+                }
+                ASSERT_RC_OK(evalExpr(record, rel->schema, scan->mgmtData, &result));
+                matches = result->v.boolV;
+                freeVal(result);
+            }
+            if(matches)
+            {
+                //return record
+                if(!isRead)
+                    readSlot(rel, phr, scan->slotNum, record->data);
+                record->id.page = scan->pageNum;
+                record->id.slot = scan->slotNum;
+                bitmap_deallocate(b);
+                ++scan->slotNum;
+                ASSERT_RC_OK(unpinTablePage(rel,&curPage));
+                return RC_OK;
+            }
+        }
+        bitmap_deallocate(b);
+        ASSERT_RC_OK(unpinTablePage(rel,&curPage));
+    }
+    return RC_RM_NO_MORE_TUPLES;
+}
+
+/*********************************************************************
+logChange appends a log record for a change of slot id by transaction
+txId and stamps its LSN on the page in phrFrame, if there is one. The
+callers flush the log up to lsn once they release the table latch;
+changes flushed at the same time by other callers are synced together.
+The page itself is written whenever the buffer pool evicts it,
+flushLogForPage keeps that from happening before its records are
+durable. The page in phrFrame has to be pinned and marked dirty
+already: the checkpoint this may begin must find it among the dirty
+pages, or it could let recovery start beyond the change.
+*********************************************************************/
+static RC logChange(RM_TableData *rel, LM_LogRecordType type, int txId, RID id, char *data,
+                    char *undoData, char *phrFrame, LM_LSN *lsn)
+{
+    RC returnCode = RC_INIT;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    LM_LogHandle *log = &tableInfo->log;
+    LM_LogRecord logRecord = {type, txId, id.page, id.slot, 0, data, 0, undoData, 0};
+    logRecord.dataLength = data ? tableInfo->recordSize : 0;
+    logRecord.undoLength = undoData ? tableInfo->recordSize : 0;
+    //recovery may have to undo the transaction from its first record on
+    if(txId != 0)
+        setFirstLsn(&tableInfo->versions, txId, getAppendLsn(log));
+    ASSERT_RC_OK(appendLogRecord(log, &logRecord, lsn));
+    if(phrFrame)
+        setPageLsnPH(phrFrame, *lsn);
+    //keep the part of the log a recovery has to redo short. The change
+    //is logged either way, a checkpoint that can't begin is tried again
+    //by the next change
+    if(getRedoSize(log) > tableInfo->checkpointLogSize)
+        beginCheckpoint(&tableInfo->checkpointer, getCheckpointLsn(rel));
+    return RC_OK;
+}
+
+/*********************************************************************
+getCheckpointLsn returns the LSN a checkpoint may let recovery start
+at: the last appended record, unless an active transaction logged
+changes before, which recovery has to see to undo them
+*********************************************************************/
+static LM_LSN getCheckpointLsn(RM_TableData *rel)
+{
+    LM_LSN lsn = getAppendLsn(&rel->mgmtData->log);
+    LM_LSN firstLsn;
+    if(getOldestFirstLsn(&rel->mgmtData->versions, &firstLsn) && firstLsn < lsn)
+        return firstLsn;
+    return lsn;
+}
+
+/*********************************************************************
+flushLogForPage is called by the buffer pool before it writes a page.
+The log has to be durable up to the LSN of the page (write-ahead
+logging), since the page may hold changes that are lost otherwise
+if the page file is recovered. The page file header isn't logged.
+*********************************************************************/
+static RC flushLogForPage(void *context, BM_PageHandle *page)
+{
+    RM_TableData *rel = (RM_TableData *) context;
+    if(page->pageNum == 0)
+        return RC_OK;
+    return flushLog(&rel->mgmtData->log, getPageLsnPH(page->data));
+}
+
+/*********************************************************************
+recoverTable opens the log of the table and redoes its records. Records
+whose LSN isn't beyond the page LSN already are in the page file and
+are skipped. The changes of transactions that neither committed nor
+aborted are undone afterwards, newest first. The free page list and
+numTuples aren't logged and are rebuilt from the pages at the end. The
+log is emptied once the recovered pages are durable.
+*********************************************************************/
+static RC recoverTable(RM_TableData *rel)
+{
+    RC returnCode = RC_INIT;
+    LM_LogHandle *log = &rel->mgmtData->log;
+    char *fileName = getSideFileName(rel->name, LOG_SUFFIX);
+    returnCode = openLog(log, fileName);
+    free(log->fileName);
+    log->fileName = NULL;
+    if(returnCode != RC_OK)
+        return returnCode;
+    ASSERT_RC_OK(setBeforeWriteHook(rel->bufferPool, flushLogForPage, rel));
+    if(isLogEmpty(log))
+        return RC_OK;
+    RM_Recovery recovery = {rel, NULL, 0, 0};
+    returnCode = redoLog(log, redoLogRecord, &recovery);
+    if(returnCode == RC_OK)
+        returnCode = undoLoserRecords(&recovery);
+    freeRecovery(&recovery);
+    if(returnCode != RC_OK)
+        return returnCode;
+    ASSERT_RC_OK(repairTable(rel));
+    ASSERT_RC_OK(forceFlushPool(rel->bufferPool));
+    return syncTable(rel);
+}
+
+static RC redoLogRecord(void *context, LM_LogRecord *logRecord)
+{
+    RC returnCode = RC_INIT;
+    RM_Recovery *recovery = (RM_Recovery *) context;
+    RM_TableData *rel = recovery->rel;
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    BM_PageHandle page;
+    if(logRecord->type == LOG_COMMIT || logRecord->type == LOG_ABORT)
+    {
+        trackLoserRecord(recovery, logRecord);
+        return RC_OK;
+    }
+    if(logRecord->slotNum >= tableInfo->numSlotsPerPage)
+        return RC_RM_INIT_ERROR;
+    if(logRecord->type != LOG_DELETE && logRecord->dataLength != tableInfo->recordSize)
+        return RC_RM_INIT_ERROR;
+    if(logRecord->undoLength != 0 && logRecord->undoLength != tableInfo->recordSize)
+        return RC_RM_INIT_ERROR;
+    if(logRecord->txId != 0)
+        trackLoserRecord(recovery, logRecord);
+    ASSERT_RC_OK(pinRedoPage(rel, logRecord->pageNum, &page));
+    if(getPageLsnPH(page.data) >= logRecord->lsn)
+        return unpinPage(rel->bufferPool, &page);
+    setPageLsnPH(page.data, logRecord->lsn);
+    bitmap *b = getBitMapPH(page.data);
+    if(logRecord->type == LOG_DELETE)
+        bitmap_clear(b, logRecord->slotNum);
+    else
+    {
+        returnCode = writeSlot(rel, page.data, logRecord->slotNum, logRecord->data, 0);
+        bitmap_set(b, logRecord->slotNum);
+    }
+    setBitMapArrayPH(page.data, b);
+    bitmap_deallocate(b);
+    if(returnCode != RC_OK && returnCode != RC_INIT)
+    {
+        unpinPage(rel->bufferPool, &page);
+        return returnCode;
+    }
+    ASSERT_RC_OK(markDirty(rel->bufferPool, &page));
+    return unpinPage(rel->bufferPool, &page);
+}
+
+/*********************************************************************
+trackLoserRecord keeps the undo part of a change of a transaction, or
+forgets the transaction once its commit or abort record shows up
+*********************************************************************/
+static void trackLoserRecord(RM_Recovery *recovery, LM_LogRecord *logRecord)
+{
+    int i = 0;
+    while(i < recovery->numTxs && recovery->txs[i].txId != logRecord->txId)
+        i++;
+    if(logRecord->type == LOG_COMMIT || logRecord->type == LOG_ABORT)
+    {
+        if(i == recovery->numTxs)
+            return;
+        RM_RecoveryTx *tx = &recovery->txs[i];
+        for(int j = 0; j < tx->numRecords; j++)
+            free(tx->records[j].undoData);
+        free(tx->records);
+        recovery->txs[i] = recovery->txs[--recovery->numTxs];
+        return;
+    }
+    if(i == recovery->numTxs)
+    {
+        if(recovery->numTxs == recovery->capacity)
+        {
+            recovery->capacity = recovery->capacity ? 2*recovery->capacity : 4;
+            recovery->txs = (RM_RecoveryTx *) realloc(recovery->txs,
+                            recovery->capacity * sizeof(RM_RecoveryTx));
+            if(!recovery->txs)
+            {
+                printError(RC_BM_MEMORY_ALOC_FAIL);
+                exit(-1);
+            }
+        }
+        memset(&recovery->txs[i], 0, sizeof(RM_RecoveryTx));
+        recovery->txs[i].txId = logRecord->txId;
+        recovery->numTxs++;
+    }
+    RM_RecoveryTx *tx = &recovery->txs[i];
+    if(tx->numRecords == tx->capacity)
+    {
+        tx->capacity = tx->capacity ? 2*tx->capacity : 8;
+        tx->records = (LM_LogRecord *) realloc(tx->records, tx->capacity * sizeof(LM_LogRecord));
+        if(!tx->records)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+    }
+    //the record only points into the log while it is redone
+    LM_LogRecord *undoRecord = &tx->records[tx->numRecords++];
+    *undoRecord = *logRecord;
+    undoRecord->data = NULL;
+    undoRecord->dataLength = 0;
+    undoRecord->undoData = NULL;
+    if(logRecord->undoLength > 0)
+    {
+        VALID_CALLOC(char, undoData, 1, logRecord->undoLength);
+        memcpy(undoData, logRecord->undoData, logRecord->undoLength);
+        undoRecord->undoData = undoData;
+    }
+}
+
+/*********************************************************************
+undoLoserRecords undoes the changes of the transactions that didn't
+end before the crash. Their records were redone, so the pages hold
+the changes no matter the page LSN.
+*********************************************************************/
+static RC undoLoserRecords(RM_Recovery *recovery)
+{
+    RC returnCode = RC_INIT;
+    RM_TableData *rel = recovery->rel;
+    BM_PageHandle page;
+    for(int i = 0; i < recovery->numTxs; i++)
+    {
+        RM_RecoveryTx *tx = &recovery->txs[i];
+        for(int j = tx->numRecords - 1; j >= 0; j--)
+        {
+            LM_LogRecord *logRecord = &tx->records[j];
+            if(logRecord->type != LOG_INSERT && !logRecord->undoData)
+                return RC_RM_INIT_ERROR;
+            ASSERT_RC_OK(pinRedoPage(rel, logRecord->pageNum, &page));
+            bitmap *b = getBitMapPH(page.data);
+            returnCode = RC_OK;
+            if(logRecord->type == LOG_INSERT)
+                bitmap_clear(b, logRecord->slotNum);
+            else
+            {
+                returnCode = writeSlot(rel, page.data, logRecord->slotNum, logRecord->undoData, 0);
+                bitmap_set(b, logRecord->slotNum);
+            }
+            setBitMapArrayPH(page.data, b);
+            bitmap_deallocate(b);
+            if(returnCode != RC_OK)
+            {
+                unpinPage(rel->bufferPool, &page);
+                return returnCode;
+            }
+            ASSERT_RC_OK(markDirty(rel->bufferPool, &page));
+            ASSERT_RC_OK(unpinPage(rel->bufferPool, &page));
+        }
+    }
+    return RC_OK;
+}
+
+static void freeRecovery(RM_Recovery *recovery)
+{
+    for(int i = 0; i < recovery->numTxs; i++)
+    {
+        for(int j = 0; j < recovery->txs[i].numRecords; j++)
+            free(recovery->txs[i].records[j].undoData);
+        free(recovery->txs[i].records);
+    }
+    free(recovery->txs);
+    recovery->txs = NULL;
+    recovery->numTxs = 0;
+}
+
+//pins page pageNum, which may not have reached the page file yet
+static RC pinRedoPage(RM_TableData *rel, int pageNum, BM_PageHandle *page)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    if(pageNum < 1)
+        return RC_READ_NON_EXISTING_PAGE;
+    ASSERT_RC_OK(openPageFile(rel->name, &fHandle));
+    returnCode = ensureCapacity(pageNum + 1, &fHandle);
+    if(returnCode != RC_OK)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    ASSERT_RC_OK(closePageFile(&fHandle));
+    ASSERT_RC_OK(pinPage(rel->bufferPool, page, pageNum));
+    if(getBitMapBitsPH(page->data) == 0)
+        initDataPage(rel, page->data);
+    return RC_OK;
+}
+
+/*********************************************************************
+repairTable rebuilds the free page list and numTuples from the bitmaps
+of the data pages after recovery
+*********************************************************************/
+static RC repairTable(RM_TableData *rel)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    BM_PageHandle pfHdr, page;
+    BM_BufferPool *bm = rel->bufferPool;
+    ASSERT_RC_OK(openPageFile(rel->name, &fHandle));
+    int numPages = fHandle.totalNumPages;
+    ASSERT_RC_OK(closePageFile(&fHandle));
+    ASSERT_RC_OK(pinPage(bm, &pfHdr, 0));
+    setNextFreePage(pfHdr.data, 0);
+    unsigned int numTuples = 0;
+    //append from the back, so the list starts with the first page
+    for(int pageNum = numPages - 1; pageNum >= 1; pageNum--)
+    {
+        ASSERT_RC_OK(pinPage(bm, &page, pageNum));
+        if(getBitMapBitsPH(page.data) == 0)
+            initDataPage(rel, page.data);
+        bitmap *b = getBitMapPH(page.data);
+        for(int slotNum = 0; slotNum < rel->mgmtData->numSlotsPerPage; slotNum++)
+            numTuples += bitmap_read(b, slotNum);
+        setNextFreePagePH(page.data, 0);
+        setPrevFreePagePH(page.data, 0);
+        if(!isPageFull(rel, page.data, b))
+        {
+            //save the current pageNum into the prev ptr
+            setPrevFreePagePH(page.data, pageNum);
+            ASSERT_RC_OK(appendToFreeLinkedList(pfHdr.data, page.data, bm));
+        }
+        bitmap_deallocate(b);
+        ASSERT_RC_OK(markDirty(bm, &page));
+        ASSERT_RC_OK(unpinPage(bm, &page));
+    }
+    setNumTuplesPF(pfHdr.data, numTuples);
+    ASSERT_RC_OK(markDirty(bm, &pfHdr));
+    return unpinPage(bm, &pfHdr);
+}
+
+//sets up the header of an empty data page
+static void initDataPage(RM_TableData *rel, char *phrFrame)
+{
+    memset(phrFrame, 0, rel->mgmtData->pageSize);
+    bitmap *b = bitmap_allocate(rel->mgmtData->numSlotsPerPage);
+    setBitMapPH(phrFrame, b);
+    bitmap_deallocate(b);
+    if(rel->mgmtData->layout == RM_LAYOUT_PAX_COMPRESSED)
+    {
+        setNumSlotsUsedPH(phrFrame, 0);
+        setPageFullPH(phrFrame, false);
+    }
+}
+
+/*********************************************************************
+syncTable empties the log once the page file holds every change in it.
+The pages have to be written to the page file before.
+*********************************************************************/
+static RC syncTable(RM_TableData *rel)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    //a checkpoint already synced the changes of the records left
+    if(isLogEmpty(&rel->mgmtData->log))
+        return truncateLog(&rel->mgmtData->log);
+    ASSERT_RC_OK(openPageFile(rel->name, &fHandle));
+    returnCode = syncPageFile(&fHandle);
+    if(returnCode != RC_OK)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    ASSERT_RC_OK(closePageFile(&fHandle));
+    return truncateLog(&rel->mgmtData->log);
+}
+
+/*********************************************************************
+openMappedTable opens a table read only: the page file is mapped
+instead of cached in a buffer pool, so pinning a page is pointer
+arithmetic and records are read without copying pages into frames.
+Changes return RC_RM_READ_ONLY. A log with changes that didn't reach
+the page file yet is recovered by opening the table for writing once.
+The table gets neither a log nor a checkpoint writer.
+*********************************************************************/
+static RC openMappedTable(RM_TableData *rel, char *name)
+{
+    RC returnCode = RC_INIT;
+    LM_LogHandle log = {NULL, NULL};
+    char *fileName = getSideFileName(name, LOG_SUFFIX);
+    returnCode = openLog(&log, fileName);
+    bool isClean = returnCode == RC_OK && isLogEmpty(&log);
+    if(returnCode == RC_OK)
+        returnCode = closeLog(&log);
+    free(fileName);
+    if(returnCode != RC_OK)
+        return returnCode;
+    if(!isClean)
+    {
+        RM_TableConfig config = *getTableConfig(&managerConfig, name);
+        config.readOnly = false;
+        ASSERT_RC_OK(openTableEx(rel, name, &config));
+        ASSERT_RC_OK(closeTable(rel));
+    }
+    RM_CatalogEntry entry;
+    ASSERT_RC_OK(findTable(name, &entry));
+    SM_MappedFile mapping;
+    ASSERT_RC_OK(mapPageFile(name, &mapping));
+    rel->name = name;
+    rel->schema = entry.schema;
+    rel->bufferPool = NULL;
+    ASSERT_RC_OK(initTableInfo(rel, &entry));
+    rel->mgmtData->mapping = mapping;
+    return openPageSummaries(rel);
+}
+
+static RC closeMappedTable(RM_TableData *rel)
+{
+    RC returnCode = RC_INIT;
+    ASSERT_RC_OK(savePageSummaries(rel, true));
+    ASSERT_RC_OK(unmapPageFile(&rel->mgmtData->mapping));
+    freeTableInfo(rel);
+    releaseSchema(&catalog, rel->schema);
+    return RC_OK;
+}
+
+//pins a page of the table, a page of a mapped table needs no frame
+static RC pinTablePage(RM_TableData *rel, BM_PageHandle *page, int pageNum)
+{
+    SM_MappedFile *mapping = &rel->mgmtData->mapping;
+    if(!mapping->pages)
+        return pinPage(rel->bufferPool, page, pageNum);
+    if(pageNum < 0 || pageNum >= mapping->totalNumPages)
+        return RC_READ_NON_EXISTING_PAGE;
+    page->pageNum = pageNum;
+    page->data = mapping->pages + (size_t) pageNum * mapping->pageSize;
+    return RC_OK;
+}
+
+static RC unpinTablePage(RM_TableData *rel, BM_PageHandle *page)
+{
+    if(rel->mgmtData->mapping.pages)
+        return RC_OK;
+    return unpinPage(rel->bufferPool, page);
+}
+
+/*********************************************************************
+pinBeforeLatch pins page pageNum of the table before the table latch
+is taken, so a page that isn't in the pool is read while other calls
+use the table. The functions called under the latch then find it in
+the pool. A page that can't be pinned is left to them, they return the
+error. Negative page numbers pin nothing.
+*********************************************************************/
+static void pinBeforeLatch(RM_TableData *rel, BM_PageHandle *page, int pageNum)
+{
+    page->data = NULL;
+    if(pageNum < 0 || pinTablePage(rel, page, pageNum) != RC_OK)
+        page->data = NULL;
+}
+
+static void unpinAfterLatch(RM_TableData *rel, BM_PageHandle *page)
+{
+    if(page->data)
+        unpinTablePage(rel, page);
+}
+
+//reads the pages commit (only the deletes) or abort change into the
+//pool before they take the table latch. They aren't kept pinned, a
+//transaction may change more pages than the pool has frames
+static void pinWritePages(RM_Transaction *tx, bool onlyDeletes)
+{
+    BM_PageHandle page;
+    int lastPage = 0;
+    for(int i = 0; i < tx->numWrites; i++)
+    {
+        if((onlyDeletes && tx->writes[i].kind != RM_WRITE_DELETE) || tx->writes[i].id.page == lastPage)
+            continue;
+        lastPage = tx->writes[i].id.page;
+        pinBeforeLatch(tx->rel, &page, lastPage);
+        unpinAfterLatch(tx->rel, &page);
+    }
+}
+
+//RETURNS: the page an insert will probably use, NO_PAGE if it needs a
+//new one
+static int getFreePageHint(RM_TableData *rel, char *pfHdrFrame)
+{
+    pthread_mutex_lock(&rel->mgmtData->latch);
+    int pageNum = getNextFreePage(pfHdrFrame);
+    pthread_mutex_unlock(&rel->mgmtData->latch);
+    return pageNum > 0 ? pageNum : NO_PAGE;
+}
+
+static RC getTableNumPages(RM_TableData *rel, int *numPages)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    if(rel->mgmtData->mapping.pages)
+    {
+        *numPages = rel->mgmtData->mapping.totalNumPages;
+        return RC_OK;
+    }
+    ASSERT_RC_OK(openPageFile(rel->name, &fHandle));
+    *numPages = fHandle.totalNumPages;
+    return closePageFile(&fHandle);
+}
+
+/*********************************************************************
+adviseMappedScans counts the open scans of a mapped table. The kernel
+reads the mapping ahead while a scan is open and expects the random
+reads of getRecord otherwise.
+*********************************************************************/
+static void adviseMappedScans(RM_TableData *rel, int delta)
+{
+    RM_TableInfo *tableInfo = rel->mgmtData;
+    if(!tableInfo->mapping.pages)
+        return;
+    pthread_mutex_lock(&tableInfo->latch);
+    int numScans = tableInfo->numMappedScans;
+    tableInfo->numMappedScans += delta;
+    if(numScans == 0 || tableInfo->numMappedScans == 0)
+        adviseMappedFile(&tableInfo->mapping, tableInfo->numMappedScans > 0);
+    pthread_mutex_unlock(&tableInfo->latch);
+}
+
+/*********************************************************************
+calcNumSlotsPerPage solves the following equation iteratively
+
+d >= 4*i + l + floor((n+31)/32)/4 + n*r
+where d is the page size less the checksum trailer
+where i is sizeof(unsigned int) to account for ints in header
+where l is sizeof(LM_LSN) to account for the page LSN
+where r is the size of a record for a given schema
+where n is the number of slots per page
+
+floor((n+31)/32) is used since the bitmap is stored in word-sized chunks
+floor((n+31)/32) is divided by 4 to convert from words to bytes
+Calculation assumes 32 bit words
+
+INPUT: recordSize: size of a record for a given schema
+       pageSize: bytes of a page of the table
+*********************************************************************/
+static unsigned short calcNumSlotsPerPage(unsigned short recordSize, int pageSize)
+{
+    int dataSize = pageSize - PAGE_TRAILER_SIZE;
+    //Calculates numSlotsPerPage assuming the number of bits in the
+    //bitmap exactly equals the numSlotsPerPage.
+    //Solves: d >= 4*i + l + n + n*r
+    unsigned short numSlotsPerPage = (dataSize - 4*sizeof(unsigned int) - sizeof(LM_LSN)) / (recordSize + 0.125);
+    //Rounds the number of bytes used by the bitmap up to the next word
+    unsigned short numBytesForBitmap = ((numSlotsPerPage+31)/32)*4;
+    //Recalculates numSlotsPerPage with the larger header
+    numSlotsPerPage = (dataSize - 4*sizeof(unsigned int) - sizeof(LM_LSN) - numBytesForBitmap) / recordSize;
+    return numSlotsPerPage;
+}
+/*********************************************************************
+calcMaxSlotsPerPage returns the number of slots of a compressed page.
+How many of them can be used depends on how well the records compress.
+The bitmap is limited to a bit per byte of the page, and the slot
+numbers to unsigned shorts.
+*********************************************************************/
+static unsigned short calcMaxSlotsPerPage(unsigned short recordSize, int pageSize)
+{
+    int maxSlotsPerPage = calcNumSlotsPerPage(recordSize, pageSize) * RM_MAX_COMPRESSION_RATIO;
+    if(maxSlotsPerPage > pageSize)
+        maxSlotsPerPage = pageSize;
+    if(maxSlotsPerPage > USHRT_MAX)
+        maxSlotsPerPage = USHRT_MAX;
+    return (unsigned short) maxSlotsPerPage;
+}
+/*********************************************************************
+*
+*               PAGE HEADER GETTERS AND SETTERS
+*
+*********************************************************************/
+static unsigned int getPrevFreePagePH(char *phrFrame)
+{
+    unsigned int prevFreePage;
+    memcpy(&prevFreePage, phrFrame + 0, pageNumOffset);
+    return prevFreePage;
+}
+
+static unsigned int getNextFreePagePH(char *phrFrame)
+{
+    unsigned int nextFreePage;
+    memcpy(&nextFreePage, phrFrame + pageNumOffset, pageNumOffset);
+    return nextFreePage;
+}
+
+static void setPrevFreePagePH(char * phrFrame, unsigned int pageNum)
+{
+    memcpy(phrFrame + 0, &pageNum,pageNumOffset);
+}
+
+static void setNextFreePagePH(char * phrFrame, unsigned int pageNum)
+{
+    memcpy(phrFrame + pageNumOffset, &pageNum,pageNumOffset);
+}
+
+static LM_LSN getPageLsnPH(char *phrFrame)
+{
+    LM_LSN pageLsn;
+    memcpy(&pageLsn, phrFrame + pageLsnOffset, sizeof(LM_LSN));
+    return pageLsn;
+}
+
+static void setPageLsnPH(char *phrFrame, LM_LSN pageLsn)
+{
+    memcpy(phrFrame + pageLsnOffset, &pageLsn, sizeof(LM_LSN));
+}
+
+static unsigned short getNumSlotsUsedPH(char *phrFrame)
+{
+    unsigned short numSlotsUsed;
+    memcpy(&numSlotsUsed, getSlotsPH(phrFrame) + numSlotsUsedOffset, sizeof(unsigned short));
+    return numSlotsUsed;
+}
+
+static void setNumSlotsUsedPH(char *phrFrame, unsigned short numSlotsUsed)
+{
+    memcpy(getSlotsPH(phrFrame) + numSlotsUsedOffset, &numSlotsUsed, sizeof(unsigned short));
+}
+
+static void setPageFullPH(char *phrFrame, bool isFull)
+{
+    unsigned short pageFlags = isFull ? PAGE_FULL : 0;
+    memcpy(getSlotsPH(phrFrame) + pageFlagsOffset, &pageFlags, sizeof(unsigned short));
+}
+
+static bitmap* getBitMapPH(char * phrFrame)
+{
+    VALID_CALLOC(bitmap, b,1,sizeof(bitmap));
+    char * curOff = phrFrame + bitmapHdrOffset;
+    //set number of bits
+    memcpy(&b->bits,curOff, sizeof(int));
+    curOff+=sizeof(int);
+    //set number of words
+    memcpy(&b->words,curOff, sizeof(int));
+    curOff +=sizeof(int);
+    //set bit Array
+    VALID_CALLOC(bitmap_type *, bitArray, b->words,sizeof(bitmap_type));
+    memcpy(bitArray,curOff, sizeof(bitmap_type)* b->words);
+    b->array =(bitmap_type*) bitArray;
+    return b;
+}
+
+static int getBitMapWordsPH(char* phrFrame)
+{
+    int words;
+    memcpy(&words, phrFrame + sizeof(int)+ bitmapHdrOffset, sizeof(int));
+    return words;
+}
+
+static int getBitMapBitsPH(char* phrFrame)
+{
+    int bits;
+    memcpy(&bits, phrFrame+ bitmapHdrOffset, sizeof(int));
+    return bits;
+}
+
+static void setBitMapPH(char * phrFrame, bitmap* b)
+{
+    char * curOff = phrFrame + bitmapHdrOffset;
+
+    //set number of bits
+    memcpy(curOff,&b->bits, sizeof(int));
+    curOff+=sizeof(int);
+    //set number of words
+    memcpy(curOff,&b->words, sizeof(int));
+    curOff +=sizeof(int);
+    //set bit Array
+    memcpy(curOff, b->array, sizeof(bitmap_type)* b->words);
+}
+
+static void setBitMapArrayPH(char* phrFrame, bitmap * b)
+{
+    char * curOff = phrFrame + bitmapHdrOffset + 2 * sizeof(int);
+    memcpy(curOff, b->array, sizeof(bitmap_type)* b->words);
+}
+
+/*********************************************************************
+*
+*               PAGEFILE HEADER GETTERS AND SETTERS
+*
+*********************************************************************/
+static unsigned short getRecordSizePF(char *pfHdrFrame)
+{
+    unsigned short recordSize;
+    memcpy(&recordSize, pfHdrFrame + recordSizeOffset, sizeof(unsigned short));
+    return recordSize;
+}
+static unsigned int getNumTuplesPF(char *pfHdrFrame)
+{
+    unsigned int numTuples;
+    memcpy(&numTuples, pfHdrFrame + numTuplesOffset, sizeof(unsigned int));
+    return numTuples;
+}
+static void setNumTuplesPF(char *pfHdrFrame, unsigned int numTuples)
+{
+    memcpy(pfHdrFrame + numTuplesOffset, &numTuples, sizeof(unsigned int));
+}
+static unsigned int getNextFreePage(char *pfHdrFrame)
+{
+    unsigned int nextFreePage;
+    memcpy(&nextFreePage, pfHdrFrame + nextFreePageOffset, sizeof(unsigned int));
+    return nextFreePage;
+}
+static void setNextFreePage(char *pfHdrFrame, unsigned int nextFreePage)
+{
+    memcpy(pfHdrFrame + nextFreePageOffset, &nextFreePage, sizeof(unsigned int));
+}
+static unsigned short getNumSlotsPerPage(char *pfHdrFrame)
+{
+    unsigned short numSlotsPerPage;
+    memcpy(&numSlotsPerPage, pfHdrFrame + numSlotsPerPageOffset, sizeof(unsigned short));
+    return numSlotsPerPage;
+}
+static RM_PageLayout getPageLayout(char *pfHdrFrame)
+{
+    unsigned short pageLayout;
+    memcpy(&pageLayout, pfHdrFrame + pageLayoutOffset, sizeof(unsigned short));
+    switch(pageLayout)
+    {
+    case RM_LAYOUT_PAX:
+        return RM_LAYOUT_PAX;
+    case RM_LAYOUT_PAX_COMPRESSED:
+        return RM_LAYOUT_PAX_COMPRESSED;
+    default:
+        return RM_LAYOUT_NSM;
+    }
+}
+static unsigned short getSchemaSize(char *pfHdrFrame)
+{
+    unsigned short schemaSize;
+    memcpy(&schemaSize, pfHdrFrame + schemaSizeOffset, sizeof(unsigned short));
+    return schemaSize;
 }
@@ -6,8 +6,23 @@
 #include "expr.h"
 #include "tables.h"
 #include "bitmap.h"
+#include "zone_map.h"
+#include "bloom_filter.h"
+#include "log_mgr.h"
+#include "checkpoint.h"
+#include "mvcc.h"
+#include "lock_mgr.h"
+#include "config.h"
+#include "storage_mgr.h"
 
 // Data structures
+// page layouts that can be chosen at createTableEx
+typedef enum RM_PageLayout {
+    RM_LAYOUT_NSM = 0, // records are stored row by row in slots
+    RM_LAYOUT_PAX = 1, // records are stored column by column, one minipage per attribute
+    RM_LAYOUT_PAX_COMPRESSED = 2 // PAX with every minipage encoded per page
+} RM_PageLayout;
+
 //headers
 typedef struct RM_Schema {
     unsigned short numAttr;
@@ -22,6 +37,7 @@ typedef struct RM_PageFileHeader {
     unsigned int numTuples;
     unsigned int nextFreePage;
     unsigned short numSlotsPerPage;
+    unsigned short pageLayout;
     unsigned short schemaSize;
     char* schema;
 } RM_PageFileHeader;
@@ -32,6 +48,48 @@ typedef struct RM_PageHeader {
     bitmap* freeBitMap;
 } RM_PageHeader;
 
+// Bookkeeping for an open table, cached from the PageFile header
+typedef struct RM_TableInfo {
+    RM_PageLayout layout;
+    int pageSize; //bytes of the pages of the page file
+    unsigned short recordSize;
+    unsigned short numSlotsPerPage;
+    int *attrOffsets; //byte offset of every attribute in the record
+    RM_ZoneMap zoneMap; //min/max of the attributes of every data page
+    RM_BloomFilters bloomFilters; //filters of the selected attributes
+    LM_LogHandle log; //write-ahead log of the changes since the last sync
+    RM_Checkpointer checkpointer; //writes pages in the background for checkpoints
+    pthread_mutex_t latch; //held while a record or scan call uses pages in the pool, not while they are read
+    RM_VersionStore versions; //versions the active snapshots may still read
+    int prefetchDepth; //pages scans read ahead, see RM_TableConfig
+    long checkpointLogSize; //log bytes that begin a checkpoint
+    SM_MappedFile mapping; //page file of a read-only table, pages is NULL otherwise
+    int numMappedScans; //open scans of a read-only table, they read sequentially
+} RM_TableInfo;
+
+// kinds of changes a transaction keeps track of
+typedef enum RM_WriteKind {
+    RM_WRITE_INSERT = 0,
+    RM_WRITE_UPDATE = 1,
+    RM_WRITE_DELETE = 2 // reaches the page at commit
+} RM_WriteKind;
+
+typedef struct RM_Write {
+    RID id;
+    RM_WriteKind kind;
+    bool isApplied; // a delete reached the page, set by the commit
+} RM_Write;
+
+// A transaction on one table, see beginTransaction
+typedef struct RM_Transaction {
+    RM_TableData *rel;
+    int txId;
+    RM_Timestamp snapshotTs; //reads see the commits up to this
+    RM_Write *writes; //changes in the order they were made
+    int numWrites;
+    int writeCapacity;
+    LK_Owner locks; //held until commit or abort
+} RM_Transaction;
 
 // Bookkeeping for scans
 typedef struct RM_ScanHandle {
@@ -39,25 +97,52 @@ typedef struct RM_ScanHandle {
     unsigned int pageNum;
     unsigned short slotNum;
     Expr *mgmtData;
+    bool *attrRefs; //attributes referenced by the scan condition
+    bool *filter; //condition results for the slots of page filterPage
+    unsigned int filterPage;
+    int txId; //transaction or snapshot the scan reads for
+    RM_Timestamp snapshotTs;
+    bool ownsSnapshot; //the snapshot ends with the scan
+    unsigned int prefetchEnd; //first page the scan hasn't read ahead
+    LK_Owner locks; //table lock of a scan outside transactions
 } RM_ScanHandle;
 
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableEx (char *name, Schema *schema, RM_PageLayout layout);
 extern RC openTable (RM_TableData *rel, char *name);
+extern RC openTableEx (RM_TableData *rel, char *name, RM_TableConfig *config);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
 extern int getNumTuples (RM_TableData *rel);
+extern RC addBloomFilter (RM_TableData *rel, int attrNum);
+extern RC checkpointTable (RM_TableData *rel);
+extern LK_LockManager *getLockManager (void);
+extern BM_BufferPool *getSharedPool (void);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
 extern RC deleteRecord (RM_TableData *rel, RID id);
+// sets record->id if the record moves off a full compressed page
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
 
+// transactions
+extern RC beginTransaction (RM_TableData *rel, RM_Transaction *tx);
+extern RC commitTransaction (RM_Transaction *tx);
+extern RC abortTransaction (RM_Transaction *tx);
+extern RC insertRecordTx (RM_Transaction *tx, Record *record);
+extern RC deleteRecordTx (RM_Transaction *tx, RID id);
+extern RC updateRecordTx (RM_Transaction *tx, Record *record);
+extern RC getRecordTx (RM_Transaction *tx, RID id, Record *record);
+// locks the whole table, LOCK_S, LOCK_SIX or LOCK_X
+extern RC lockTable (RM_Transaction *tx, LK_LockMode mode);
+
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+extern RC startScanTx (RM_Transaction *tx, RM_ScanHandle *scan, Expr *cond);
 extern RC next (RM_ScanHandle *scan, Record *record);
 extern RC closeScan (RM_ScanHandle *scan);
 
@@ -17,6 +17,7 @@ You should have the following functions implemented
 -repNameInit()
 -repNameFree()
 -repNameReplace()
+-repNameResize()
 
 See LRU below as example
 *********************************************************************/
@@ -75,12 +76,11 @@ void fifoPin(BM_BufferPool *bm, int frameNum) {
 
 BM_Frame * fifoReplace(BM_BufferPool *const bm) {
     RS_FIFOInfo *fifoInfo = bm->mgmtData->rplcStratStruct;
-    BM_Frame *framePtr = bm->mgmtData->poolMem_ptr;
     listNode *node = fifoInfo->head;
 
     //check if head can be replaced
-    if(bm->mgmtData->fixCountArray[node->frameNum] == 0) {
-        framePtr += node->frameNum;
+    if(bm->mgmtData->frames[node->frameNum].fixCount == 0) {
+        BM_Frame *framePtr = getFrame(bm->mgmtData, node->frameNum);
         fifoInfo->head = node->nextNode;
         free(node);
         node = NULL;
@@ -89,8 +89,8 @@ BM_Frame * fifoReplace(BM_BufferPool *const bm) {
 
     //check if internal nodes can be replaced
     while(node->nextNode != fifoInfo->tail) {
-        if(bm->mgmtData->fixCountArray[node->nextNode->frameNum] == 0) {
-            framePtr += node->nextNode->frameNum;
+        if(bm->mgmtData->frames[node->nextNode->frameNum].fixCount == 0) {
+            BM_Frame *framePtr = getFrame(bm->mgmtData, node->nextNode->frameNum);
             listNode *temp = node->nextNode;
             node->nextNode = node->nextNode->nextNode;
             free(temp);
@@ -101,8 +101,8 @@ BM_Frame * fifoReplace(BM_BufferPool *const bm) {
     }
 
     //check if tail node can be replaced
-    if(bm->mgmtData->fixCountArray[fifoInfo->tail->frameNum] == 0) {
-        framePtr += fifoInfo->tail->frameNum;
+    if(bm->mgmtData->frames[fifoInfo->tail->frameNum].fixCount == 0) {
+        BM_Frame *framePtr = getFrame(bm->mgmtData, fifoInfo->tail->frameNum);
         free(fifoInfo->tail);
         fifoInfo->tail = node;
         node->nextNode = NULL;
@@ -112,6 +112,23 @@ BM_Frame * fifoReplace(BM_BufferPool *const bm) {
     return NULL;
 }
 
+//bm->numPages is still the old size, frames from newNumPages on are gone
+void fifoResize(BM_BufferPool *bm, int newNumPages) {
+    RS_FIFOInfo *fifoInfo = bm->mgmtData->rplcStratStruct;
+    listNode **link = &fifoInfo->head;
+    fifoInfo->tail = NULL;
+    while(*link != NULL) {
+        listNode *node = *link;
+        if(node->frameNum >= newNumPages) {
+            *link = node->nextNode;
+            free(node);
+        } else {
+            fifoInfo->tail = node;
+            link = &node->nextNode;
+        }
+    }
+}
+
 /*********************************************************************
 *
 *                     LRU Replacement Functions
@@ -122,12 +139,10 @@ By Andrew S. Tanenbaum. Check Link Below:
 http://www.informit.com/articles/article.aspx?p=25260&seqNum=7
 *********************************************************************/
 BM_Frame * lruReplace(BM_BufferPool *const bm) {
-    BM_Frame* frame = bm->mgmtData->poolMem_ptr;
     int PageNumber = lruFindToReplace(bm);
     if(PageNumber==NO_PAGE)
         return NULL;
-    frame+=PageNumber;
-    return frame;
+    return getFrame(bm->mgmtData, PageNumber);
 }
 
 void lruInit(BM_BufferPool * bm) {
@@ -171,6 +186,32 @@ void lruFree(BM_BufferPool * bm) {
     matrix = NULL;
 }
 
+//new frames get rows and columns of 0, they are used before the others
+void lruResize(BM_BufferPool *bm, int newNumPages) {
+    int **matrix = (int **) bm->mgmtData->rplcStratStruct;
+    for(int i = newNumPages; i<bm->numPages; i++) {
+        free(matrix[i]);
+    }
+    matrix = (int**) realloc(matrix, newNumPages*sizeof(int *));
+    if(!matrix) {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    for(int i = 0; i<newNumPages; i++) {
+        //rows of new frames start empty
+        int oldSize = i<bm->numPages ? bm->numPages : 0;
+        matrix[i] = (int*) realloc(oldSize ? matrix[i] : NULL, newNumPages*sizeof(int));
+        if(!matrix[i]) {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+        for(int j = oldSize; j<newNumPages; j++) {
+            matrix[i][j] = 0;
+        }
+    }
+    bm->mgmtData->rplcStratStruct = matrix;
+}
+
 //debug function
 void printtMatrix(int**matrix, int dim) {
     for(int i = 0; i<dim; i++) {
@@ -189,7 +230,7 @@ static int lruFindToReplace(BM_BufferPool *const bm) {
     for(int i=0; i<bm->numPages; i++) {
         //Skip rows that are pinned by users
         //i.e don't have fixCount ==0
-        if( bm->mgmtData->fixCountArray[i]!=0)
+        if( bm->mgmtData->frames[i].fixCount!=0)
             continue;
         int rowMin = bm->numPages;
         for(int j=0; j<bm->numPages; j++) {
@@ -254,9 +295,9 @@ BM_Frame * clockReplace(BM_BufferPool *const bm) {
     //search through the poolInfo arrays to find a page with fixCount=0 and ref=false
     while(true) {
         //returns a pointer to the first frame that has fixCount=0 and ref=false
-        if (bm->mgmtData->fixCountArray[clockInfo->curFrame] == 0 && clockInfo->wasReferencedArray[clockInfo->curFrame] == false) {
+        if (bm->mgmtData->frames[clockInfo->curFrame].fixCount == 0 && clockInfo->wasReferencedArray[clockInfo->curFrame] == false) {
 
-            BM_Frame *pframe = bm->mgmtData->poolMem_ptr + clockInfo->curFrame;
+            BM_Frame *pframe = getFrame(bm->mgmtData, clockInfo->curFrame);
             //increment curFrame to prevent always replacing the same page
             clockInfo->curFrame = (clockInfo->curFrame + 1) % bm->numPages;
             //return the frame pointer
@@ -270,6 +311,19 @@ BM_Frame * clockReplace(BM_BufferPool *const bm) {
     }
 }
 
+void clockResize(BM_BufferPool *bm, int newNumPages) {
+    RS_ClockInfo *clockInfo = bm->mgmtData->rplcStratStruct;
+    clockInfo->wasReferencedArray = (bool *) realloc(clockInfo->wasReferencedArray,
+                                    newNumPages * sizeof(bool));
+    if(clockInfo->wasReferencedArray == NULL) {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    for(int i = bm->numPages; i < newNumPages; i++)
+        clockInfo->wasReferencedArray[i] = false;
+    clockInfo->curFrame = clockInfo->curFrame % newNumPages;
+}
+
 /*********************************************************************
 *
 *                     LFU Replacement Functions
@@ -346,13 +400,12 @@ void lfuPin(BM_BufferPool *const bm, int frameNum) {
 
 BM_Frame * lfuReplace(BM_BufferPool *const bm) {
     RS_LFUInfo *lfuInfo = bm->mgmtData->rplcStratStruct;
-    BM_Frame* framePtr = bm->mgmtData->poolMem_ptr;
     //Iterate through the linked list to find the smallest frequency value
     LFUnode *node = lfuInfo->head; //used as node we want to return
     int frequency = 2147483647; //INT_MAX
     int frameNum = -1;
     while(node != NULL) { //Compare the nodes frequency with the head and find the smallest frequency
-        if (node->frequency < frequency && bm->mgmtData->fixCountArray[node->frameNumber] == 0) {
+        if (node->frequency < frequency && bm->mgmtData->frames[node->frameNumber].fixCount == 0) {
             frameNum = node->frameNumber;
             frequency = node->frequency;
         }
@@ -369,7 +422,7 @@ BM_Frame * lfuReplace(BM_BufferPool *const bm) {
         lfuInfo->head = node->nextNode; //moves the head pointer to the second node
         free(node); //frees the memory allocated to the node we're replacing
         node = NULL;
-        return framePtr + frameNum; //returns a pageHandle of the frame we're offering for replacement
+        return getFrame(bm->mgmtData, frameNum); //returns a pageHandle of the frame we're offering for replacement
     }
     //If head node wasn't the right frameNumber
     //Iterate through the linked list till we find the correct frame.
@@ -379,7 +432,7 @@ BM_Frame * lfuReplace(BM_BufferPool *const bm) {
             node->nextNode = node->nextNode->nextNode;	//move the next nextnode to take place of the node we're removing
             free(temp);	//Free node we want to remove
             temp=NULL;
-            return framePtr + frameNum;
+            return getFrame(bm->mgmtData, frameNum);
         } else
             node = node->nextNode;	//If the correct node isn't found, then move to the next node and compare
     }
@@ -392,9 +445,25 @@ BM_Frame * lfuReplace(BM_BufferPool *const bm) {
         node->nextNode = NULL; //remove the reference to the last node
         free(temp); //free memory held by the last node
         temp = NULL; //for safety to ensure that temp is no longer pointing at deallocated memory
-        return framePtr + frameNum; //returns a pageHandle of the frame we're offering for replacement
+        return getFrame(bm->mgmtData, frameNum); //returns a pageHandle of the frame we're offering for replacement
     }
 
     printf("\nERROR: frame %d not found for removal from linked list in LFUReplace()\n", frameNum);
-    return framePtr + frameNum;
+    return getFrame(bm->mgmtData, frameNum);
+}
+
+void lfuResize(BM_BufferPool *bm, int newNumPages) {
+    RS_LFUInfo *lfuInfo = bm->mgmtData->rplcStratStruct;
+    LFUnode **link = &lfuInfo->head;
+    lfuInfo->tail = NULL;
+    while(*link != NULL) {
+        LFUnode *node = *link;
+        if(node->frameNumber >= newNumPages) {
+            *link = node->nextNode;
+            free(node);
+        } else {
+            lfuInfo->tail = node;
+            link = &node->nextNode;
+        }
+    }
 }
@@ -5,24 +5,28 @@ void fifoInit(BM_BufferPool *bm);
 void fifoFree(BM_BufferPool *const bm);
 void fifoPin(BM_BufferPool *bm, int frameNum);
 BM_Frame * fifoReplace(BM_BufferPool *const bm);
+void fifoResize(BM_BufferPool *bm, int newNumPages);
 
 //LRU
 void lruFree(BM_BufferPool *const bm);
 void lruPin(BM_BufferPool * bm,int frameNumber);
 BM_Frame * lruReplace(BM_BufferPool *const bm);
 void lruInit(BM_BufferPool * bm);
+void lruResize(BM_BufferPool *bm, int newNumPages);
 
 //Clock
 void clockInit(BM_BufferPool *bm);
 void clockFree(BM_BufferPool *const bm);
 void clockPin(BM_BufferPool *const bm, int frameNum);
 BM_Frame * clockReplace(BM_BufferPool *const bm);
+void clockResize(BM_BufferPool *bm, int newNumPages);
 
 //LFU
 void lfuInit(BM_BufferPool *bm);
 void lfuFree(BM_BufferPool *const bm);
 void lfuPin(BM_BufferPool *const bm, int frameNum);
 BM_Frame * lfuReplace(BM_BufferPool *const bm);
+void lfuResize(BM_BufferPool *bm, int newNumPages);
 
 typedef struct listNode {
     int frameNum;
@@ -1,33 +1,496 @@
+#define _GNU_SOURCE
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "crc32c.h"
+#include "compressed_file.h"
+#include "tablespace.h"
+#include "file_io.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <math.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+#define SM_DIRECT_ALIGNMENT 4096
+//pages a single preadv or pwritev transfers at most
+#define SM_MAX_IOVS 1024
+//a headerless file is copied behind a header in chunks of this many pages
+#define SM_UPGRADE_PAGES 256
+#define SM_UPGRADE_SUFFIX ".upgrade"
+
+/***********************************************************
+A segment file of a page file. Its descriptors are opened
+when its pages are first read or written. In direct IO mode
+pages are read and written through directFd, opened with
+O_DIRECT, so they bypass the kernel's page cache and the
+buffer pool alone decides which pages are in memory.
+directFd is -1 if direct IO is off or the file system
+refused it, then fd is used. allocatedPages counts the
+pages of the segment the file system reserved, see
+ensureCapacity. The first page of the segment starts at
+byte base of the file.
+*/
+typedef struct SM_Segment {
+    int fd;
+    int directFd;
+    int allocatedPages;
+    off_t base;
+} SM_Segment;
+
+/***********************************************************
+The open file of a handle, kept in mgmtInfo. A page file is
+split into segment files of segmentPages pages each, see
+setSegmentSize: segment 0 is the file itself, segment k the
+file getSegmentName names. O_DIRECT needs aligned buffers;
+pages that aren't aligned are copied through bounce. The
+pages of a compressed file are read and written through
+compressed instead, it has a single segment. A relation of
+a tablespace, see tablespace.h, has a segment for every
+extent, whose descriptor is the tablespace's.
+Page 0 of a plain page file starts after its header, see
+createPageFileEx.
+*/
+typedef struct SM_FileInfo {
+    SM_Segment *segments;
+    int numSegments; //entries of segments, opened or not
+    int fileSegments; //segment files of the header, see SM_FileHeader
+    int segmentPages;
+    bool isDirect; //direct IO wasn't refused
+    bool pageChecksums; //its pages carry checksums, see setPageChecksums
+    char *bounce;
+    CF_File *compressed; //NULL for a plain page file
+    TBS_Tablespace *space; //NULL unless a relation of a tablespace
+    TBS_Relation *relation;
+} SM_FileInfo;
+
+static bool directIO = false;
+//pages of the files created from now on carry a CRC32C in the trailer
+static bool pageChecksums = false;
+//bytes the files grow by at once
+static long extentBytes = SM_DEFAULT_EXTENT_SIZE;
+//bytes of a segment file, see setSegmentSize
+static long segmentBytes = SM_DEFAULT_SEGMENT_SIZE;
+//directories segments 1 and up go to in turn, see setSegmentDirs
+static char **segmentDirs = NULL;
+static int numSegmentDirs = 0;
+
+//the files openPageFile takes, told apart by the magic they start with
+typedef enum SM_FileFormat {
+    SM_FORMAT_NONE,
+    SM_FORMAT_PLAIN,
+    SM_FORMAT_COMPRESSED
+} SM_FileFormat;
+
+/***********************************************************
+The start of the header of a plain page file, see
+createPageFileEx. numSegments counts the segment files the
+page file created, only those are its own and removed
+with it. It is raised before a segment file is created, so
+it never misses one. segmentPages is the size of every
+segment but the last once there are several, 0 before.
+pageChecksums is 1 if the pages carry checksums, set when
+the file is created, see setPageChecksums.
+*/
+typedef struct SM_FileHeader {
+    char magic[SM_FILE_MAGIC_SIZE];
+    int pageSize;
+    int numSegments;
+    int segmentPages;
+    int pageChecksums;
+} SM_FileHeader;
+
+//handles of the same file raise numSegments in turn
+static pthread_mutex_t segmentMutex = PTHREAD_MUTEX_INITIALIZER;
+//segment files syncPageFile has fdatasynced, see getNumSegmentSyncs
+static long numSegmentSyncs = 0;
+
+static RC writePage(SM_FileHandle *fHandle, int pageNum, SM_PageHandle memPage);
+static RC readPage(SM_FileHandle *fHandle, int pageNum, SM_PageHandle memPage);
+static char *alignedPage(SM_FileInfo *info, SM_PageHandle memPage, int pageSize);
+static void closeDirect(SM_FileInfo *info);
+static RC transferPages(SM_FileHandle *fHandle, bool isWrite, int startPage, int numPages,
+                        SM_PageHandle *memPages);
+static ssize_t transferVector(int fd, bool isWrite, struct iovec *iovs, int numIovs, off_t offset);
+static RC growSegment(SM_FileHandle *fHandle, int segment, int numPages);
+static void reserveExtents(SM_FileHandle *fHandle, int segment, int numPages);
+static SM_Segment *getSegment(SM_FileHandle *fHandle, int segment, bool create);
+static off_t getSegmentOffset(SM_FileHandle *fHandle, int pageNum);
+static char *getSegmentName(char *fileName, int segment);
+static int countSegments(char *fileName, SM_FileHeader *header);
+static void removeSegments(char *fileName);
+static off_t getFileSize(char *fileName, int segment);
+static int createSegment(SM_FileHandle *fHandle, int segment, char *name);
+static RC countPages(char *fileName, int pageSize, SM_FileHeader *header, SM_FileInfo *info,
+                     long *totalNumPages);
+static RC openRelationFile(char *fileName, SM_FileHandle *fHandle);
+static RC mapRelation(char *fileName, SM_MappedFile *map);
+static SM_FileFormat readFileFormat(int fd, SM_FileHeader *header);
+static RC upgradePageFile(char *fileName, int fd);
+static bool isValidPageSize(int pageSize);
 
 void initStorageManager()
 {
     return;
 }
 
+/***********************************************************
+Page files opened after this bypass the page cache, see
+SM_FileInfo
+*/
+void setDirectIO (bool enabled)
+{
+    directIO = enabled;
+}
+
+/***********************************************************
+Page files grow by whole extents of extentSize bytes,
+rounded down to pages, see ensureCapacity. 0 or less
+reserves no space ahead, the file grows page by page.
+*/
+void setExtentSize (long extentSize)
+{
+    extentBytes = extentSize > 0 ? extentSize : 0;
+}
+
+/***********************************************************
+Page files created or grown after this are split into
+segment files of segmentSize bytes, rounded down to pages,
+at least one page. 0 or less sets SM_DEFAULT_SEGMENT_SIZE.
+A page file that already has several segments keeps the
+size it was written with, kept in its header.
+*/
+void setSegmentSize (long segmentSize)
+{
+    segmentBytes = segmentSize > 0 ? segmentSize : SM_DEFAULT_SEGMENT_SIZE;
+}
+
+/***********************************************************
+dirs is a list of directories separated by ':'. Segment k
+of a page file, k >= 1, goes to directory (k - 1) modulo
+their number, named after the last part of the file name,
+so the segments of a large file are spread over several
+disks. NULL or "" keeps the segments next to segment 0.
+The directories must be the same whenever the file is
+opened.
+*/
+void setSegmentDirs (const char *dirs)
+{
+    for (int i = 0; i < numSegmentDirs; i++)
+        free(segmentDirs[i]);
+    free(segmentDirs);
+    segmentDirs = NULL;
+    numSegmentDirs = 0;
+    if (!dirs || !*dirs)
+        return;
+    int maxDirs = 1;
+    for (const char *c = dirs; *c; c++)
+        maxDirs += *c == ':';
+    segmentDirs = (char **) calloc(maxDirs, sizeof(char *));
+    if (!segmentDirs)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    for (const char *dir = dirs; *dir; )
+    {
+        size_t length = strcspn(dir, ":");
+        if (length > 0 && !(segmentDirs[numSegmentDirs++] = strndup(dir, length)))
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+        dir += length;
+        if (*dir == ':')
+            dir++;
+    }
+}
+
+/***********************************************************
+Page files, compressed page files and tablespaces created
+after this checksum their pages, or stop doing so. The
+setting is kept in the header of the file, so a file keeps
+the one it was created with whatever is set when it is
+opened. In a file with checksums every page written gets
+the CRC32C of all but its last PAGE_TRAILER_SIZE bytes in
+that trailer, and every page read is checked against it,
+so a torn or corrupted page is reported as
+RC_PAGE_CHECKSUM_FAILED instead of being used. Callers
+must leave the trailer to the storage manager.
+*/
+void setPageChecksums (bool enabled)
+{
+    pageChecksums = enabled;
+}
+
+//true if the pages of the file carry checksums
+bool hasPageChecksums (SM_FileHandle *fHandle)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    return info && info->pageChecksums;
+}
+
+//writes the checksum of page, a page of the file, into its trailer
+void stampPageChecksum (SM_FileHandle *fHandle, SM_PageHandle page)
+{
+    if (!hasPageChecksums(fHandle))
+        return;
+    int pageSize = fHandle->pageSize;
+    int dataSize = pageSize - PAGE_TRAILER_SIZE;
+    uint32_t crc = crc32c(0, page, dataSize);
+    memcpy(page + dataSize, &crc, sizeof(uint32_t));
+}
+
+/***********************************************************
+RC_PAGE_CHECKSUM_FAILED if the trailer of page doesn't
+match its data. Pages that were never written, e.g. those
+appended by ensureCapacity, are all zeros and pass.
+*/
+RC checkPageChecksum (SM_FileHandle *fHandle, SM_PageHandle page)
+{
+    if (!hasPageChecksums(fHandle))
+        return RC_OK;
+    int pageSize = fHandle->pageSize;
+    int dataSize = pageSize - PAGE_TRAILER_SIZE;
+    uint32_t stored;
+    memcpy(&stored, page + dataSize, sizeof(uint32_t));
+    if (stored == crc32c(0, page, dataSize))
+        return RC_OK;
+    if (stored == 0 && page[0] == 0 && memcmp(page, page + 1, pageSize - 1) == 0)
+        return RC_OK;
+    return RC_PAGE_CHECKSUM_FAILED;
+}
+
+//true if the pages of the file are stored compressed
+bool isCompressedPageFile (SM_FileHandle *fHandle)
+{
+    return fHandle->mgmtInfo && ((SM_FileInfo *)fHandle->mgmtInfo)->compressed;
+}
+
+//true if the pages of the file bypass the page cache
+bool isDirectIO (SM_FileHandle *fHandle)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    return info && info->isDirect && info->segments[0].directFd != -1;
+}
+
+/***********************************************************
+The descriptor to read and write the pages of segment 0
+with pread and pwrite, see getPageFd. -1 for a compressed
+file, whose pages can only be read and written through the
+storage manager.
+*/
+int getPageFileFd (SM_FileHandle *fHandle)
+{
+    off_t fileOffset;
+    return getPageFd(fHandle, 0, &fileOffset);
+}
+
+/***********************************************************
+The descriptor of the segment file page pageNum is in, e.g.
+for async_io.h. The page starts at byte fileOffset +
+pageNum * pageSize of it, as do the other pages of the
+segment, see getSegmentPages. fileOffset is negative for
+segments after the first. The segment must exist, it does
+for pages below totalNumPages.
+RETURNS: -1 for a compressed file or if the segment can't
+         be opened
+*/
+int getPageFd (SM_FileHandle *fHandle, int pageNum, off_t *fileOffset)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    if (info->compressed)
+        return -1;
+    int segment = pageNum / info->segmentPages;
+    SM_Segment *seg = getSegment(fHandle, segment, false);
+    if (!seg)
+        return -1;
+    *fileOffset = getSegmentOffset(fHandle, pageNum) - (off_t) pageNum * fHandle->pageSize;
+    return seg->directFd != -1 ? seg->directFd : seg->fd;
+}
+
+//RETURNS: the pages of a segment, runs of pages read or written with
+//one request must not cross a multiple of it
+int getSegmentPages (SM_FileHandle *fHandle)
+{
+    return ((SM_FileInfo *)fHandle->mgmtInfo)->segmentPages;
+}
+
+//RETURNS: the segment files of plain page files syncPageFile has
+//fdatasynced so far, by all handles
+long getNumSegmentSyncs (void)
+{
+    return __atomic_load_n(&numSegmentSyncs, __ATOMIC_RELAXED);
+}
+
+/***********************************************************
+mapPageFile maps the whole page file read only, so its
+pages are read straight from the kernel's page cache
+without being copied. The segments are mapped one after
+the other into a single reserved range, so the pages are
+contiguous in memory as well. The mapping doesn't see
+pages appended later. The kernel is told to expect random
+reads, see adviseMappedFile.
+*/
+RC mapPageFile (char *fileName, SM_MappedFile *map)
+{
+    if(!fileName || !*fileName)
+        return RC_NO_FILENAME;
+    if(isRelationName(fileName))
+        return mapRelation(fileName, map);
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0)
+        return RC_FILE_NOT_FOUND;
+    SM_FileHeader header;
+    SM_FileFormat format = readFileFormat(fd, &header);
+    RC returnCode = format == SM_FORMAT_NONE ? upgradePageFile(fileName, fd) : RC_OK;
+    close(fd);
+    if(returnCode != RC_OK)
+        return returnCode;
+    //the pages of a compressed file aren't where a mapping has them
+    if(format == SM_FORMAT_COMPRESSED)
+        return RC_PAGE_FILE_COMPRESSED;
+    map->pageSize = header.pageSize;
+    off_t headerSize = SM_FILE_HEADER_SIZE;
+    off_t size = getFileSize(fileName, 0);
+    if(!isValidPageSize(map->pageSize) || size < headerSize + map->pageSize)
+        return RC_READ_NON_EXISTING_PAGE;
+    int numSegments = countSegments(fileName, &header);
+    off_t segmentSize = numSegments > 1 ? (off_t) header.segmentPages * map->pageSize : size - headerSize;
+    off_t lastBytes = numSegments > 1 ? getFileSize(fileName, numSegments - 1) : segmentSize;
+    if(lastBytes < 0)
+        return RC_FILE_NOT_FOUND;
+    off_t pagesBytes = (numSegments - 1) * segmentSize + lastBytes - lastBytes % map->pageSize;
+    map->totalNumPages = (int) (pagesBytes / map->pageSize);
+    map->bytes = headerSize + pagesBytes;
+    map->memory = mmap(NULL, map->bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(map->memory == MAP_FAILED)
+    {
+        map->memory = NULL;
+        map->pages = NULL;
+        return RC_FILE_NOT_INITIALIZED;
+    }
+    for(int segment = 0; segment < numSegments; segment++)
+    {
+        off_t start = segment == 0 ? 0 : headerSize + segment * segmentSize;
+        off_t end = segment == numSegments - 1 ? (off_t) map->bytes : headerSize + (segment + 1) * segmentSize;
+        char *name = getSegmentName(fileName, segment);
+        fd = name ? open(name, O_RDONLY) : -1;
+        free(name);
+        //the mapping stays valid without the descriptor
+        void *pages = fd < 0 ? MAP_FAILED : mmap(map->memory + start, end - start, PROT_READ,
+                      MAP_SHARED | MAP_FIXED, fd, 0);
+        if(fd >= 0)
+            close(fd);
+        if(pages == MAP_FAILED)
+        {
+            munmap(map->memory, map->bytes);
+            map->memory = NULL;
+            map->pages = NULL;
+            return RC_FILE_NOT_INITIALIZED;
+        }
+    }
+    map->pages = map->memory + headerSize;
+    map->fileName = fileName;
+    return adviseMappedFile(map, false);
+}
+
+RC unmapPageFile (SM_MappedFile *map)
+{
+    if(!map->pages)
+        return RC_FILE_NOT_INITIALIZED;
+    int unmapped = munmap(map->memory, map->bytes);
+    map->memory = NULL;
+    map->pages = NULL;
+    map->fileName = NULL;
+    return unmapped == 0 ? RC_OK : RC_FILE_NOT_CLOSED;
+}
+
+/***********************************************************
+Sequential reads let the kernel read far ahead and drop
+pages behind them, random reads turn the read ahead off.
+*/
+RC adviseMappedFile (SM_MappedFile *map, bool isSequential)
+{
+    if(!map->pages)
+        return RC_FILE_NOT_INITIALIZED;
+    //a hint only, the pages are read either way
+    madvise(map->memory, map->bytes, isSequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    return RC_OK;
+}
+
+//true if fileName names a page file, or a relation of a tablespace
+bool pageFileExists (char *fileName)
+{
+    if(isRelationName(fileName))
+        return relationExists(fileName);
+    return access(fileName, R_OK | W_OK) == 0;
+}
+
 RC createPageFile(char *fileName)
+{
+    return createPageFileEx(fileName, PAGE_SIZE);
+}
+
+/***********************************************************
+Create a page file of pages of pageSize bytes, a power of
+two from SM_MIN_PAGE_SIZE to SM_MAX_PAGE_SIZE. Large pages
+take fewer reads to scan a file, small ones less to read
+a single record. Every page file starts with a header of
+SM_FILE_HEADER_SIZE bytes before page 0:
+char magic[SM_FILE_MAGIC_SIZE] | int pageSize | int numSegments |
+int segmentPages | int pageChecksums
+No page is ever at the start of the file, so what the pages
+hold can't be taken for a header. Files without it are
+taken for page files from before the header, see
+upgradePageFile. The segments of an older
+page file of the same name are removed, see SM_FileHeader.
+RETURNS: RC_OK, RC_NO_FILENAME, RC_INCOMPATIBLE_BLOCKSIZE,
+         RC_FILE_CREATION_FAILED or RC_WRITE_FAILED
+*/
+RC createPageFileEx(char *fileName, int pageSize)
 {
     if(!*fileName)
     {
         return RC_NO_FILENAME;
     }
+    if(!isValidPageSize(pageSize))
+        return RC_INCOMPATIBLE_BLOCKSIZE;
+    //relations have pages of the tablespace's size
+    if(isRelationName(fileName))
+        return pageSize == PAGE_SIZE ? createRelation(fileName) : RC_INCOMPATIBLE_BLOCKSIZE;
+    dropCompressedFile(fileName);
+    dropTablespace(fileName);
+    removeSegments(fileName);
     FILE * file_ptr = fopen(fileName, "wb");
     if(!file_ptr)
     {
         return RC_FILE_CREATION_FAILED;
     }
-    //creates an array of null elements equal to PAGE_SIZE bytes
-    char buffer[PAGE_SIZE] = {0};
+    //creates an array of null elements, the header and a page
+    size_t size = SM_FILE_HEADER_SIZE + pageSize;
+    char *buffer = (char *) calloc(1, size);
+    if(!buffer)
+    {
+        fclose(file_ptr);
+        return RC_BM_MEMORY_ALOC_FAIL;
+    }
+    SM_FileHeader header = {SM_FILE_MAGIC, pageSize, 1, 0, pageChecksums};
+    memcpy(buffer, &header, sizeof(header));
     //writes the buffer to the file
-    if (fwrite(buffer, PAGE_SIZE, 1, file_ptr) != 1)
+    size_t numWritten = fwrite(buffer, size, 1, file_ptr);
+    free(buffer);
+    if (numWritten != 1)
+    {
+        fclose(file_ptr);
         return RC_WRITE_FAILED;
+    }
     if(fclose(file_ptr) == EOF)
     {
         return RC_FILE_NOT_CLOSED;
@@ -35,42 +498,176 @@ RC createPageFile(char *fileName)
     return RC_OK;
 }
 
+/***********************************************************
+Create a page file that stores its pages compressed, see
+compressed_file.h. It is opened, read and written like a
+plain page file, except that its pages can't be mapped or
+read and written through getPageFileFd, and direct IO and
+extents don't apply to it.
+*/
+RC createCompressedPageFile (char *fileName)
+{
+    if(!*fileName)
+        return RC_NO_FILENAME;
+    if(isRelationName(fileName))
+        return RC_FILE_CREATION_FAILED;
+    dropTablespace(fileName);
+    return createCompressedFile(fileName, pageChecksums);
+}
+
+/***********************************************************
+Opens the page file and finds its segments. A file of
+several segments keeps the segment size of its segment 0,
+a file of one segment gets the one of setSegmentSize, or
+its own size if that is larger. Only the descriptors of
+segment 0 are opened here, see getSegment. A page file
+from before page files had headers is given one first, see
+upgradePageFile. A file with more pages than an int
+numbers gives RC_INVALID_PAGE_NUMBER.
+*/
 RC openPageFile(char * fileName, SM_FileHandle *fHandle)
 {
     if(!*fileName)
     {
         return RC_NO_FILENAME;
     }
-    FILE * file_ptr = fopen(fileName, "rb+");
-    if(!file_ptr)
+    if(isRelationName(fileName))
+        return openRelationFile(fileName, fHandle);
+    int fd = open(fileName, O_RDWR);
+    if(fd < 0)
     {
         return RC_FILE_NOT_FOUND;
     }
+    SM_FileHeader header;
+    SM_FileFormat format = readFileFormat(fd, &header);
+    if(format == SM_FORMAT_NONE)
+    {
+        RC upgradeCode = upgradePageFile(fileName, fd);
+        //fd still is the file from before the upgrade
+        close(fd);
+        if(upgradeCode != RC_OK)
+            return upgradeCode;
+        fd = open(fileName, O_RDWR);
+        if(fd < 0)
+            return RC_FILE_NOT_FOUND;
+        format = readFileFormat(fd, &header);
+    }
+    SM_FileInfo *info = (SM_FileInfo *) calloc(1, sizeof(SM_FileInfo));
+    SM_Segment *segments = (SM_Segment *) calloc(1, sizeof(SM_Segment));
+    if(!info || !segments)
+    {
+        close(fd);
+        free(info);
+        free(segments);
+        return RC_BM_MEMORY_ALOC_FAIL;
+    }
+    segments[0].fd = fd;
+    segments[0].directFd = -1;
+    info->segments = segments;
+    info->numSegments = 1;
+    info->segmentPages = INT_MAX;
+    RC returnCode = RC_OK;
+    fHandle->pageSize = header.pageSize;
+    if(format == SM_FORMAT_COMPRESSED)
+        returnCode = openCompressedFile(fileName, &info->compressed);
+    else if(format == SM_FORMAT_NONE)
+        returnCode = RC_NOT_A_PAGE_FILE;
+    else if(!isValidPageSize(fHandle->pageSize))
+        returnCode = RC_INCOMPATIBLE_BLOCKSIZE;
+    long totalNumPages = 0;
+    if(returnCode == RC_OK && info->compressed)
+    {
+        info->pageChecksums = info->compressed->pageChecksums;
+        totalNumPages = getCompressedNumPages(info->compressed);
+    }
+    else if(returnCode == RC_OK)
+    {
+        info->pageChecksums = header.pageChecksums != 0;
+        segments[0].base = SM_FILE_HEADER_SIZE;
+        //falls back to fd if the file system refuses O_DIRECT
+        info->isDirect = directIO;
+        if(directIO)
+            segments[0].directFd = open(fileName, O_RDWR | O_DIRECT);
+        returnCode = countPages(fileName, fHandle->pageSize, &header, info, &totalNumPages);
+    }
+    //page numbers are ints
+    if(returnCode == RC_OK && totalNumPages > INT_MAX)
+        returnCode = RC_INVALID_PAGE_NUMBER;
+    if(returnCode != RC_OK)
+    {
+        if(info->compressed)
+            closeCompressedFile(info->compressed);
+        closeDirect(info);
+        close(fd);
+        free(segments);
+        free(info);
+        return returnCode;
+    }
     fHandle->fileName = fileName;
-    fHandle->mgmtInfo = file_ptr;
+    fHandle->mgmtInfo = info;
     fHandle->curPagePos = 0;
-    //struct to maintain file stats
+    fHandle->totalNumPages = (int) totalNumPages;
+    return RC_OK;
+}
+
+/***********************************************************
+Sets the segment size of a plain page file opened by
+openPageFile and counts its pages, see openPageFile.
+RETURNS: RC_OK or RC_FILE_NOT_INITIALIZED if a segment file
+         can't be read
+*/
+static RC countPages(char *fileName, int pageSize, SM_FileHeader *header, SM_FileInfo *info,
+                     long *totalNumPages)
+{
     struct stat st;
-    if(stat(fileName,&st)!=0)
-    {
+    if(fstat(info->segments[0].fd, &st) != 0)
         return RC_FILE_NOT_INITIALIZED;
+    long firstPages = (long) ceil((st.st_size - SM_FILE_HEADER_SIZE) / (double) pageSize);
+    long segmentPages = segmentBytes / pageSize;
+    info->fileSegments = header->numSegments;
+    int numSegments = countSegments(fileName, header);
+    if(numSegments > 1)
+        segmentPages = header->segmentPages;
+    else if(firstPages > segmentPages)
+        segmentPages = firstPages;
+    info->segmentPages = segmentPages < 1 ? 1 : segmentPages > INT_MAX ? INT_MAX : (int) segmentPages;
+    info->segments[0].allocatedPages = firstPages > INT_MAX ? INT_MAX : (int) firstPages;
+    *totalNumPages = firstPages;
+    if(numSegments > 1)
+    {
+        off_t lastSize = getFileSize(fileName, numSegments - 1);
+        if(lastSize < 0)
+            return RC_FILE_NOT_INITIALIZED;
+        *totalNumPages = (long) (numSegments - 1) * info->segmentPages
+                         + (long) ceil(lastSize / (double) pageSize);
     }
-    int totalNumPages = st.st_size;
-    totalNumPages  = ceil(totalNumPages /(double) PAGE_SIZE);
-    fHandle->totalNumPages = totalNumPages;
     return RC_OK;
 }
 
 RC closePageFile(SM_FileHandle* fHandle)
 {
-    FILE* fp = (FILE *)fHandle->mgmtInfo;
     //check that the file handle exists
     if (!(fHandle->fileName) || !(fHandle->totalNumPages))
         return RC_FILE_HANDLE_NOT_INIT;
     //check that the file the file handle points to exists
     if (!fHandle->mgmtInfo)
         return RC_FILE_NOT_INITIALIZED;
-    if(fclose(fp)<0)
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    closeDirect(info);
+    RC returnCode = info->compressed ? closeCompressedFile(info->compressed) : RC_OK;
+    if(info->space)
+        returnCode = closeRelation(info->space, info->relation);
+    int closed = 0;
+    //the segments of a relation share the descriptor of its tablespace
+    for(int i = 0; i < info->numSegments && !info->space; i++)
+        if(info->segments[i].fd != -1 && close(info->segments[i].fd) != 0)
+            closed = -1;
+    free(info->segments);
+    free(info);
+    fHandle->mgmtInfo = NULL;
+    if(returnCode != RC_OK)
+        return returnCode;
+    if(closed<0)
     {
         return RC_FILE_NOT_CLOSED;
     }
@@ -83,6 +680,11 @@ RC destroyPageFile (char *fileName)
     {
         return RC_NO_FILENAME;
     }
+    if(isRelationName(fileName))
+        return destroyRelation(fileName);
+    dropCompressedFile(fileName);
+    dropTablespace(fileName);
+    removeSegments(fileName);
     if(remove(fileName)!=0)
     {
         printf("FILE NOT CLOSED, we will try unlink.\n");
@@ -112,10 +714,12 @@ RC destroyPageFile (char *fileName)
 Write a page to disk using absolute position
 pageNum: The page in the file referred to by fHandle at
          which the data is to be written. Must be >= 0.
-fHandle: Struct which contains the FILE *stream destination
-         stored in ->mgmtInfo
+fHandle: Struct whose ->mgmtInfo holds the descriptors of
+         the file's segments, the page is written with pwrite
+         to the segment it falls in
 memPage: The page in main memory that is to be written to disk.
-         Only writes the first PAGE_SIZE bytes to disk
+         Only writes the first pageSize bytes to disk, its
+         trailer gets the checksum if checksums are on
 RETURNS: RC_OK, RC_FILE_HANDLE_NOT_INIT, RC_FILE_NOT_INITIALIZED,
          RC_FILE_OFFSET_FAILED, RC_INCOMPATIBLE_BLOCKSIZE,
          or RC_FILE_WRITE_FAILED
@@ -136,24 +740,84 @@ RC writeBlock(int pageNum, SM_FileHandle* fHandle, SM_PageHandle memPage)
     //expands the file if necessary to write at pageNum
     if ((returnCode = ensureCapacity(pageNum+1, fHandle)) != RC_OK)
         return returnCode;
-    //moves the write pointer to the correct page
-    if (fseek(fHandle->mgmtInfo, pageNum*PAGE_SIZE, SEEK_SET) != 0)
-        return RC_FILE_OFFSET_FAILED;
-    //update current page position based on fseek
+    //update current page position
     fHandle->curPagePos = pageNum;
-    //writes memPage to the file and flushes the stream
-    if (fwrite(memPage, PAGE_SIZE, 1, fHandle->mgmtInfo) != 1 || fflush(fHandle -> mgmtInfo) != 0)
-        return RC_WRITE_FAILED;
+    stampPageChecksum(fHandle, memPage);
+    return writePage(fHandle, pageNum, memPage);
+}
+
+/***********************************************************
+Write numPages consecutive pages with one pwritev, page
+startPage + i from memPages[i]. The buffers needn't be
+contiguous, e.g. the frames of a buffer pool. Their
+trailers get the checksums, like writeBlock.
+RETURNS: RC_OK, RC_FILE_HANDLE_NOT_INIT, RC_FILE_NOT_INITIALIZED,
+         RC_FILE_OFFSET_FAILED or RC_WRITE_FAILED
+*/
+RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    RC returnCode;
+    if (!(fHandle->fileName) || !(fHandle->totalNumPages))
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (!fHandle->mgmtInfo)
+        return RC_FILE_NOT_INITIALIZED;
+    if (startPage < 0 || numPages < 0)
+        return RC_FILE_OFFSET_FAILED;
+    //pages before startPage are filled with null bytes, the
+    //segment files of the pages written are created
+    if ((returnCode = ensureCapacity(startPage + numPages, fHandle)) != RC_OK)
+        return returnCode;
+    for (int i = 0; i < numPages; i++)
+        stampPageChecksum(fHandle, memPages[i]);
+    if ((returnCode = transferPages(fHandle, true, startPage, numPages, memPages)) != RC_OK)
+        return returnCode;
+    if (numPages > 0)
+        fHandle->curPagePos = startPage + numPages - 1;
+    return RC_OK;
+}
 
+/***********************************************************
+Make every page written to the file durable
+fHandle: Struct whose ->mgmtInfo holds the descriptors of
+         the file's segments, every segment of the file is
+         opened and fdatasynced
+RETURNS: RC_OK, RC_FILE_HANDLE_NOT_INIT, RC_FILE_NOT_INITIALIZED
+         or RC_WRITE_FAILED
+*/
+RC syncPageFile (SM_FileHandle *fHandle)
+{
+    //check that the file handle exists
+    if (!(fHandle->fileName) || !(fHandle->totalNumPages))
+        return RC_FILE_HANDLE_NOT_INIT;
+    //check that the file the file handle points to exists
+    if (!fHandle->mgmtInfo)
+        return RC_FILE_NOT_INITIALIZED;
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    if (info->compressed)
+        return syncCompressedFile(info->compressed);
+    if (info->space)
+        return syncTablespace(info->space);
+    //the kernel's copy of the pages, the file's metadata only as far
+    //as needed to read them back. Pages may have been written through
+    //other handles, e.g. by a checkpoint, so the segments this handle
+    //hasn't opened are synced too
+    int numSegments = (fHandle->totalNumPages - 1) / info->segmentPages + 1;
+    for (int i = 0; i < numSegments; i++)
+    {
+        SM_Segment *seg = getSegment(fHandle, i, false);
+        if (!seg || fdatasync(seg->fd) != 0)
+            return RC_WRITE_FAILED;
+        __atomic_add_fetch(&numSegmentSyncs, 1, __ATOMIC_RELAXED);
+    }
     return RC_OK;
 }
 
 /***********************************************************
 Write a page to disk using relative position
-fHandle: Struct which contains the FILE *stream destination
-         stored in -> mgmtInfo
+fHandle: Struct whose ->mgmtInfo holds the descriptors of
+         the file's segments, see writeBlock
 memPage: The page in main memory that is to be written to disk.
-         memPage is required to be <= PAGE_SIZE
+         memPage is required to be <= pageSize
 RETURNS: RC_OK, RC_FILE_HANDLE_NOT_INIT, RC_FILE_NOT_INITIALIZED,
          RC_FILE_OFFSET_FAILED, RC_INCOMPATIBLE_BLOCKSIZE,
          or RC_FILE_WRITE_FAILED
@@ -166,7 +830,8 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 /***********************************************************
 Increase the number of pages in the file by one. The last
 page is filled with null bytes.
-fHandle: Struct which contains the FILE *stream destination
+fHandle: Struct whose ->mgmtInfo holds the descriptors of
+         the file's segments
 RETURNS: RC_OK, RC_FILE_HANDLE_NOT_INIT, RC_FILE_NOT_INITIALIZED,
          RC_FILE_OFFSET_FAILED, or RC_FILE_WRITE_FAILED
 */
@@ -178,53 +843,112 @@ RC appendEmptyBlock (SM_FileHandle *fHandle)
     //check that the file the file handle points to exists
     if (!fHandle->mgmtInfo) //NULL
         return RC_FILE_NOT_INITIALIZED;
-    /*moves the write pointer to the end
-    //offset from SEEK_SET vice SEEK_END since library implementations
-    //are allowed to not meaningfully support SEEK_END
-    */
-    if (fseek(fHandle->mgmtInfo, fHandle->totalNumPages*PAGE_SIZE, SEEK_SET) != 0)
-        return RC_FILE_OFFSET_FAILED;
-    //creates an array of null elements equal to PAGE_SIZE bytes
-    char buffer[PAGE_SIZE] = {0};
-    //writes the buffer to the file and flushes the stream
-    if (fwrite(buffer, PAGE_SIZE, 1, fHandle->mgmtInfo) != 1 || fflush(fHandle -> mgmtInfo) != 0)
-        return RC_WRITE_FAILED;
-    //increments the total number of pages in the FileHandle struct
-    fHandle->totalNumPages++;
-    //move the write pointer back to the current page
-    if (fseek(fHandle->mgmtInfo, fHandle->curPagePos*PAGE_SIZE, SEEK_SET) != 0)
-        return RC_FILE_OFFSET_FAILED;
-
-    return RC_OK;
+    //the page comes from the reserved extent, see ensureCapacity
+    return ensureCapacity(fHandle->totalNumPages + 1, fHandle);
 }
 
 /***********************************************************
 If the file has fewer than numberOfPages pages, then
-increase the size to numberOfPages
-fHandle: Struct which contains the FILE *stream destination
+increase the size to numberOfPages. The segments before the
+one the new last page is in are filled up, new segment
+files are created as needed. The file system reserves whole
+extents ahead of the size, see reserveExtents, so growing
+the file within them only moves its end with ftruncate. The
+new pages read as zeros.
+fHandle: Struct whose ->mgmtInfo holds the descriptors of
+         the file's segments
 RETURNS: RC_OK, RC_FILE_HANDLE_NOT_INIT, RC_FILE_NOT_INITIALIZED,
-         RC_FILE_OFFSET_FAILED, RC_INCOMPATIBLE_BLOCKSIZE,
-         or RC_FILE_WRITE_FAILED
+         or RC_WRITE_FAILED
 */
 RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
 {
-    //used if calling a function that returns an RC
-    RC returnCode;
     //check that the file handle exists
     if (!(fHandle->fileName) || !(fHandle->totalNumPages))
         return RC_FILE_HANDLE_NOT_INIT;
     //check that the file the file handle points to exists
     if (!fHandle->mgmtInfo)
         return RC_FILE_NOT_INITIALIZED;
-    //increases the number of pages by appending pages
-    while (numberOfPages > fHandle->totalNumPages)
+    if (numberOfPages <= fHandle->totalNumPages)
+        return RC_OK;
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    if (info->compressed)
+    {
+        RC returnCode = growCompressedFile(info->compressed, numberOfPages);
+        if (returnCode == RC_OK)
+            fHandle->totalNumPages = numberOfPages;
+        return returnCode;
+    }
+    if (info->space)
+    {
+        RC returnCode = growRelation(info->space, info->relation, numberOfPages);
+        if (returnCode == RC_OK)
+            fHandle->totalNumPages = numberOfPages;
+        return returnCode;
+    }
+    int segmentPages = info->segmentPages;
+    int lastSegment = (numberOfPages - 1) / segmentPages;
+    for (int segment = (fHandle->totalNumPages - 1) / segmentPages; segment <= lastSegment; segment++)
     {
-        if((returnCode = appendEmptyBlock(fHandle)) != RC_OK)
+        int numPages = segment < lastSegment ? segmentPages : numberOfPages - segment * segmentPages;
+        RC returnCode = growSegment(fHandle, segment, numPages);
+        if (returnCode != RC_OK)
             return returnCode;
     }
+    fHandle->totalNumPages = numberOfPages;
     return RC_OK;
 }
 
+//makes segment hold at least numPages pages, creating its file if needed
+static RC growSegment(SM_FileHandle *fHandle, int segment, int numPages)
+{
+    SM_Segment *seg = getSegment(fHandle, segment, true);
+    if (!seg)
+        return RC_WRITE_FAILED;
+    if (numPages > seg->allocatedPages)
+        reserveExtents(fHandle, segment, numPages);
+    //another handle of the file may have grown it further,
+    //ftruncate must not cut its pages off
+    struct stat st;
+    if (fstat(seg->fd, &st) != 0)
+        return RC_WRITE_FAILED;
+    off_t size = getSegmentOffset(fHandle, segment * ((SM_FileInfo *)fHandle->mgmtInfo)->segmentPages)
+                 + (off_t) numPages * fHandle->pageSize;
+    if (st.st_size < size && ftruncate(seg->fd, size) != 0)
+        return RC_WRITE_FAILED;
+    return RC_OK;
+}
+
+/***********************************************************
+reserveExtents has the file system allocate the segment up
+to numPages rounded up to whole extents, at most the whole
+segment, without changing its size. The blocks of an extent
+are allocated together, so a growing file stays contiguous
+and later growth costs no allocation. Only the extent the
+new end is in and those after it are reserved, pages a
+write far beyond the end skips stay sparse. Without
+fallocate the file grows sparse.
+*/
+static void reserveExtents(SM_FileHandle *fHandle, int segment, int numPages)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    SM_Segment *seg = &info->segments[segment];
+    int extentPages = (int) (extentBytes / fHandle->pageSize);
+    if (extentPages < 1)
+        extentPages = 1;
+    long allocatedPages = ((long) numPages + extentPages - 1) / extentPages * extentPages;
+    if (allocatedPages > info->segmentPages)
+        allocatedPages = info->segmentPages;
+    int firstPage = (numPages - 1) / extentPages * extentPages;
+    if (firstPage < seg->allocatedPages)
+        firstPage = seg->allocatedPages;
+    off_t base = getSegmentOffset(fHandle, segment * info->segmentPages);
+    off_t start = base + (off_t) firstPage * fHandle->pageSize;
+    off_t length = (off_t) (allocatedPages - firstPage) * fHandle->pageSize;
+    if (fallocate(seg->fd, FALLOC_FL_KEEP_SIZE, start, length) != 0)
+        allocatedPages = numPages;
+    seg->allocatedPages = (int) allocatedPages;
+}
+
 /*********************************************************
 *
 *              reading blocks from disc
@@ -245,14 +969,34 @@ RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
     if(pageNum < 0 || pageNum >= fHandle->totalNumPages)
         return RC_READ_NON_EXISTING_PAGE;
 
-    //moves the write pointer to the correct page
-    if (fseek(fHandle->mgmtInfo, pageNum*PAGE_SIZE, SEEK_SET) != 0)
-        return RC_FILE_OFFSET_FAILED;
-
     //read page from disk to memory
-    if (fread(memPage, 1, PAGE_SIZE, fHandle->mgmtInfo) != PAGE_SIZE)
-        return RC_READ_FILE_FAILED;
+    RC returnCode = readPage(fHandle, pageNum, memPage);
+    if (returnCode != RC_OK)
+        return returnCode;
+    return checkPageChecksum(fHandle, memPage);
+}
 
+/***********************************************************
+Read numPages consecutive pages with one preadv, page
+startPage + i into memPages[i]
+RETURNS: RC_OK, RC_FILE_HANDLE_NOT_INIT, RC_FILE_NOT_INITIALIZED,
+         RC_READ_NON_EXISTING_PAGE, RC_READ_FILE_FAILED or
+         RC_PAGE_CHECKSUM_FAILED
+*/
+RC readBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    RC returnCode;
+    if (!(fHandle->fileName) || !(fHandle->totalNumPages))
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (!fHandle->mgmtInfo)
+        return RC_FILE_NOT_INITIALIZED;
+    if (startPage < 0 || numPages < 0 || startPage + numPages > fHandle->totalNumPages)
+        return RC_READ_NON_EXISTING_PAGE;
+    if ((returnCode = transferPages(fHandle, false, startPage, numPages, memPages)) != RC_OK)
+        return returnCode;
+    for (int i = 0; i < numPages; i++)
+        if ((returnCode = checkPageChecksum(fHandle, memPages[i])) != RC_OK)
+            return returnCode;
     return RC_OK;
 }
 
@@ -322,3 +1066,512 @@ RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 
     return returnCode;
 }
+
+/*********************************************************
+*
+*                    helper functions
+*
+*********************************************************/
+//writes pageSize bytes of memPage at page pageNum
+static RC writePage(SM_FileHandle *fHandle, int pageNum, SM_PageHandle memPage)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    int pageSize = fHandle->pageSize;
+    if (info->compressed)
+        return writeCompressedPages(info->compressed, pageNum, 1, &memPage);
+    SM_Segment *seg = getSegment(fHandle, pageNum / info->segmentPages, false);
+    if (!seg)
+        return RC_WRITE_FAILED;
+    off_t offset = getSegmentOffset(fHandle, pageNum);
+    if (seg->directFd != -1)
+    {
+        char *page = alignedPage(info, memPage, pageSize);
+        if (page != memPage)
+            memcpy(page, memPage, pageSize);
+        ssize_t numWritten = pwrite(seg->directFd, page, pageSize, offset);
+        if (numWritten == pageSize)
+            return RC_OK;
+        //the file system takes O_DIRECT opens but not the IO
+        if (numWritten >= 0 || errno != EINVAL)
+            return RC_WRITE_FAILED;
+        closeDirect(info);
+    }
+    //hands memPage to the kernel, syncPageFile makes it durable
+    struct iovec iov = { memPage, pageSize };
+    if (transferVector(seg->fd, true, &iov, 1, offset) != pageSize)
+        return RC_WRITE_FAILED;
+    return RC_OK;
+}
+
+//reads page pageNum into the first pageSize bytes of memPage
+static RC readPage(SM_FileHandle *fHandle, int pageNum, SM_PageHandle memPage)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    int pageSize = fHandle->pageSize;
+    if (info->compressed)
+        return readCompressedPages(info->compressed, pageNum, 1, &memPage);
+    SM_Segment *seg = getSegment(fHandle, pageNum / info->segmentPages, false);
+    if (!seg)
+        return RC_READ_FILE_FAILED;
+    off_t offset = getSegmentOffset(fHandle, pageNum);
+    if (seg->directFd != -1)
+    {
+        char *page = alignedPage(info, memPage, pageSize);
+        ssize_t numRead = pread(seg->directFd, page, pageSize, offset);
+        if (numRead == pageSize)
+        {
+            if (page != memPage)
+                memcpy(memPage, page, pageSize);
+            return RC_OK;
+        }
+        if (numRead >= 0 || errno != EINVAL)
+            return RC_READ_FILE_FAILED;
+        closeDirect(info);
+    }
+    struct iovec iov = { memPage, pageSize };
+    if (transferVector(seg->fd, false, &iov, 1, offset) != pageSize)
+        return RC_READ_FILE_FAILED;
+    return RC_OK;
+}
+
+//RETURNS: memPage if O_DIRECT can use it, the bounce buffer otherwise
+static char *alignedPage(SM_FileInfo *info, SM_PageHandle memPage, int pageSize)
+{
+    if (((size_t) memPage) % SM_DIRECT_ALIGNMENT == 0)
+        return memPage;
+    if (!info->bounce)
+    {
+        void *bounce = NULL;
+        if (posix_memalign(&bounce, SM_DIRECT_ALIGNMENT, pageSize) != 0)
+        {
+            printError(RC_BM_MEMORY_ALOC_FAIL);
+            exit(-1);
+        }
+        info->bounce = bounce;
+    }
+    return info->bounce;
+}
+
+//goes back to the buffered descriptors, which see what was written
+//directly
+static void closeDirect(SM_FileInfo *info)
+{
+    for (int i = 0; i < info->numSegments; i++)
+    {
+        if (info->segments[i].directFd != -1)
+            close(info->segments[i].directFd);
+        info->segments[i].directFd = -1;
+    }
+    info->isDirect = false;
+    free(info->bounce);
+    info->bounce = NULL;
+}
+
+/***********************************************************
+Reads or writes the pages with preadv or pwritev, at most
+SM_MAX_IOVS at a time and never across the end of a
+segment. Direct IO needs every buffer to be aligned,
+otherwise the pages go one by one through the bounce page.
+*/
+static RC transferPages(SM_FileHandle *fHandle, bool isWrite, int startPage, int numPages,
+                        SM_PageHandle *memPages)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    if (info->compressed)
+        return isWrite ? writeCompressedPages(info->compressed, startPage, numPages, memPages)
+               : readCompressedPages(info->compressed, startPage, numPages, memPages);
+    RC failed = isWrite ? RC_WRITE_FAILED : RC_READ_FILE_FAILED;
+    struct iovec iovs[SM_MAX_IOVS];
+    for (int done = 0; done < numPages; )
+    {
+        int pageNum = startPage + done;
+        SM_Segment *seg = getSegment(fHandle, pageNum / info->segmentPages, false);
+        if (!seg)
+            return failed;
+        int numIovs = numPages - done < SM_MAX_IOVS ? numPages - done : SM_MAX_IOVS;
+        int segmentLeft = info->segmentPages - pageNum % info->segmentPages;
+        if (numIovs > segmentLeft)
+            numIovs = segmentLeft;
+        bool isAligned = true;
+        for (int i = 0; i < numIovs; i++)
+        {
+            iovs[i].iov_base = memPages[done + i];
+            iovs[i].iov_len = fHandle->pageSize;
+            isAligned = isAligned && ((size_t) memPages[done + i]) % SM_DIRECT_ALIGNMENT == 0;
+        }
+        if (seg->directFd != -1 && !isAligned)
+        {
+            for (int i = 0; i < numIovs; i++)
+            {
+                RC returnCode = isWrite ? writePage(fHandle, pageNum + i, memPages[done + i])
+                                        : readPage(fHandle, pageNum + i, memPages[done + i]);
+                if (returnCode != RC_OK)
+                    return returnCode;
+            }
+            done += numIovs;
+            continue;
+        }
+        int fd = seg->directFd != -1 ? seg->directFd : seg->fd;
+        ssize_t numBytes = transferVector(fd, isWrite, iovs, numIovs, getSegmentOffset(fHandle, pageNum));
+        //the file system takes O_DIRECT opens but not the IO
+        if (numBytes < 0 && errno == EINVAL && seg->directFd != -1)
+        {
+            closeDirect(info);
+            continue;
+        }
+        if (numBytes != (ssize_t) numIovs * fHandle->pageSize)
+            return failed;
+        done += numIovs;
+    }
+    return RC_OK;
+}
+
+//RETURNS: the bytes transferred, fewer only at the end of the file
+static ssize_t transferVector(int fd, bool isWrite, struct iovec *iovs, int numIovs, off_t offset)
+{
+    ssize_t total = 0;
+    while (numIovs > 0)
+    {
+        ssize_t numBytes = isWrite ? pwritev(fd, iovs, numIovs, offset)
+                                   : preadv(fd, iovs, numIovs, offset);
+        if (numBytes < 0 && errno == EINTR)
+            continue;
+        if (numBytes < 0)
+            return total > 0 ? total : numBytes;
+        if (numBytes == 0)
+            return total;
+        total += numBytes;
+        offset += numBytes;
+        //skips the buffers that are done, continues in a partial one
+        while (numIovs > 0 && (size_t) numBytes >= iovs->iov_len)
+        {
+            numBytes -= iovs->iov_len;
+            iovs++;
+            numIovs--;
+        }
+        if (numIovs > 0)
+        {
+            iovs->iov_base = (char *) iovs->iov_base + numBytes;
+            iovs->iov_len -= numBytes;
+        }
+    }
+    return total;
+}
+
+/***********************************************************
+RETURNS: the segment, with its descriptors opened, NULL if
+         its file can't be opened. create creates a missing
+         file, for ensureCapacity.
+*/
+static SM_Segment *getSegment(SM_FileHandle *fHandle, int segment, bool create)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    if (segment >= info->numSegments)
+    {
+        SM_Segment *segments = (SM_Segment *) realloc(info->segments, (segment + 1) * sizeof(SM_Segment));
+        if (!segments)
+            return NULL;
+        for (int i = info->numSegments; i <= segment; i++)
+        {
+            segments[i].fd = -1;
+            segments[i].directFd = -1;
+            segments[i].allocatedPages = 0;
+        }
+        info->segments = segments;
+        info->numSegments = segment + 1;
+    }
+    SM_Segment *seg = &info->segments[segment];
+    if (seg->fd != -1)
+        return seg;
+    if (info->space)
+    {
+        //the extent of the relation, if it has grown that far
+        seg->base = getRelationOffset(info->space, info->relation, segment * info->segmentPages);
+        if (seg->base < 0)
+            return NULL;
+        seg->fd = info->space->fd;
+        return seg;
+    }
+    seg->base = segment == 0 ? SM_FILE_HEADER_SIZE : 0;
+    char *name = getSegmentName(fHandle->fileName, segment);
+    if (!name)
+        return NULL;
+    if (create && segment >= info->fileSegments)
+        seg->fd = createSegment(fHandle, segment, name);
+    else
+        seg->fd = open(name, O_RDWR | (create ? O_CREAT : 0), 0666);
+    if (seg->fd != -1 && info->isDirect)
+        seg->directFd = open(name, O_RDWR | O_DIRECT);
+    free(name);
+    struct stat st;
+    if (seg->fd == -1 || fstat(seg->fd, &st) != 0)
+        return NULL;
+    //space reserved beyond the end before isn't known, reserving
+    //it again costs no IO
+    seg->allocatedPages = (int) ((st.st_size + fHandle->pageSize - 1) / fHandle->pageSize);
+    return seg;
+}
+
+//RETURNS: the byte of its segment file page pageNum starts at, the
+//segment must have been opened by getSegment
+static off_t getSegmentOffset(SM_FileHandle *fHandle, int pageNum)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    SM_Segment *seg = &info->segments[pageNum / info->segmentPages];
+    return seg->base + (off_t) (pageNum % info->segmentPages) * fHandle->pageSize;
+}
+
+/***********************************************************
+RETURNS: the name of segment file segment of fileName, to be
+         freed, NULL if out of memory. Segment 0 is fileName,
+         segment k is fileName.k, in the directory of
+         setSegmentDirs if there are any.
+*/
+static char *getSegmentName(char *fileName, int segment)
+{
+    if (segment == 0)
+        return strdup(fileName);
+    char *name = NULL;
+    int length;
+    if (numSegmentDirs == 0)
+        length = asprintf(&name, "%s.%d", fileName, segment);
+    else
+    {
+        char *baseName = strrchr(fileName, '/');
+        baseName = baseName ? baseName + 1 : fileName;
+        length = asprintf(&name, "%s/%s.%d", segmentDirs[(segment - 1) % numSegmentDirs],
+                          baseName, segment);
+    }
+    return length < 0 ? NULL : name;
+}
+
+/***********************************************************
+Creates segment file segment, after raising numSegments in
+the header of the page file to own it. A file of the name
+that the page file doesn't own yet is left alone, the
+segment can't be created then. Another handle of the file
+may have created the segment since it was opened, it is
+opened then.
+RETURNS: the descriptor of the segment file, -1 on an error
+*/
+static int createSegment(SM_FileHandle *fHandle, int segment, char *name)
+{
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    int fd = info->segments[0].fd;
+    SM_FileHeader header;
+    int segFd = -1;
+    pthread_mutex_lock(&segmentMutex);
+    if (readFileFormat(fd, &header) != SM_FORMAT_PLAIN)
+    {
+        pthread_mutex_unlock(&segmentMutex);
+        return -1;
+    }
+    if (segment < header.numSegments)
+        segFd = open(name, O_RDWR | O_CREAT, 0666);
+    else
+    {
+        SM_FileHeader owned = header;
+        owned.numSegments = segment + 1;
+        owned.segmentPages = info->segmentPages;
+        if (pwrite(fd, &owned, sizeof(owned), 0) == (ssize_t) sizeof(owned))
+        {
+            segFd = open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+            if (segFd != -1)
+                header = owned;
+            //the file isn't one of ours, the header must not own it
+            else if (pwrite(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header))
+                header = owned;
+        }
+    }
+    info->fileSegments = header.numSegments;
+    pthread_mutex_unlock(&segmentMutex);
+    return segFd;
+}
+
+/***********************************************************
+RETURNS: the segment files of fileName, at least 1. Those
+         the header owns but that were never created, e.g.
+         after a crash, hold no pages and aren't counted.
+*/
+static int countSegments(char *fileName, SM_FileHeader *header)
+{
+    int numSegments = header->numSegments;
+    while (numSegments > 1 && getFileSize(fileName, numSegments - 1) < 0)
+        numSegments--;
+    return numSegments;
+}
+
+//removes the segments the page file fileName owns after segment 0, last first
+static void removeSegments(char *fileName)
+{
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+        return;
+    SM_FileHeader header;
+    SM_FileFormat format = readFileFormat(fd, &header);
+    close(fd);
+    if (format != SM_FORMAT_PLAIN)
+        return;
+    for (int segment = header.numSegments - 1; segment > 0; segment--)
+    {
+        char *name = getSegmentName(fileName, segment);
+        if (name)
+            remove(name);
+        free(name);
+    }
+}
+
+//RETURNS: the bytes of segment file segment of fileName, -1 if it is missing
+static off_t getFileSize(char *fileName, int segment)
+{
+    char *name = getSegmentName(fileName, segment);
+    struct stat st;
+    bool found = name && stat(name, &st) == 0;
+    free(name);
+    return found ? st.st_size : -1;
+}
+
+/***********************************************************
+Opens a relation of a tablespace, see tablespace.h. Its
+pages are read and written through the descriptor of the
+tablespace, every extent is a segment of the handle.
+*/
+static RC openRelationFile(char *fileName, SM_FileHandle *fHandle)
+{
+    SM_FileInfo *info = (SM_FileInfo *) calloc(1, sizeof(SM_FileInfo));
+    if (!info)
+        return RC_BM_MEMORY_ALOC_FAIL;
+    RC returnCode = openRelation(fileName, &info->space, &info->relation);
+    if (returnCode != RC_OK)
+    {
+        free(info);
+        return returnCode;
+    }
+    info->segmentPages = TBS_EXTENT_PAGES;
+    info->pageChecksums = info->space->pageChecksums;
+    fHandle->fileName = fileName;
+    fHandle->pageSize = PAGE_SIZE;
+    fHandle->curPagePos = 0;
+    fHandle->totalNumPages = getRelationNumPages(info->space, info->relation);
+    fHandle->mgmtInfo = info;
+    return RC_OK;
+}
+
+//maps the extents of the relation one after the other, like segments
+static RC mapRelation(char *fileName, SM_MappedFile *map)
+{
+    SM_FileHandle fHandle;
+    RC returnCode = openPageFile(fileName, &fHandle);
+    if (returnCode != RC_OK)
+        return returnCode;
+    int extentPages = getSegmentPages(&fHandle);
+    map->pageSize = fHandle.pageSize;
+    map->totalNumPages = fHandle.totalNumPages;
+    map->bytes = (size_t) fHandle.totalNumPages * fHandle.pageSize;
+    map->memory = mmap(NULL, map->bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    bool isMapped = map->memory != MAP_FAILED;
+    for (int pageNum = 0; pageNum < fHandle.totalNumPages && isMapped; pageNum += extentPages)
+    {
+        int numPages = fHandle.totalNumPages - pageNum < extentPages ? fHandle.totalNumPages - pageNum
+                       : extentPages;
+        off_t fileOffset;
+        int fd = getPageFd(&fHandle, pageNum, &fileOffset);
+        off_t offset = fileOffset + (off_t) pageNum * fHandle.pageSize;
+        isMapped = fd >= 0 && mmap(map->memory + (size_t) pageNum * fHandle.pageSize,
+                                   (size_t) numPages * fHandle.pageSize,
+                                   PROT_READ, MAP_SHARED | MAP_FIXED, fd, offset) != MAP_FAILED;
+    }
+    //the mapping stays valid without the handle
+    closePageFile(&fHandle);
+    if (!isMapped)
+    {
+        if (map->memory != MAP_FAILED)
+            munmap(map->memory, map->bytes);
+        map->memory = NULL;
+        map->pages = NULL;
+        return RC_FILE_NOT_INITIALIZED;
+    }
+    map->pages = map->memory;
+    map->fileName = fileName;
+    return adviseMappedFile(map, false);
+}
+
+/***********************************************************
+Plain and compressed page files both start with a header
+of their own, pages never start at byte 0 of either, so
+the magic of the header tells which one the file is.
+header: set to the header of a plain page file, see
+        SM_FileHeader, a compressed one gets the page size
+        PAGE_SIZE and a single segment
+RETURNS: the format, SM_FORMAT_NONE for any other file
+*/
+static SM_FileFormat readFileFormat(int fd, SM_FileHeader *header)
+{
+    ssize_t numRead = pread(fd, header, sizeof(SM_FileHeader), 0);
+    bool isCompressed = numRead >= CF_MAGIC_SIZE && memcmp(header->magic, CF_MAGIC, CF_MAGIC_SIZE) == 0;
+    bool isPlain = numRead == (ssize_t) sizeof(SM_FileHeader)
+                   && memcmp(header->magic, SM_FILE_MAGIC, SM_FILE_MAGIC_SIZE) == 0
+                   && header->numSegments >= 1 && (header->numSegments == 1 || header->segmentPages >= 1);
+    if (!isPlain)
+    {
+        header->pageSize = PAGE_SIZE;
+        header->numSegments = 1;
+        header->segmentPages = 0;
+    }
+    return isCompressed ? SM_FORMAT_COMPRESSED : isPlain ? SM_FORMAT_PLAIN : SM_FORMAT_NONE;
+}
+
+/***********************************************************
+Page files used to be nothing but pages of PAGE_SIZE bytes.
+upgradePageFile copies such a file, read through fd, behind
+the header of a page file of a single segment without
+checksums into fileName.upgrade and renames that over
+fileName once it is synced, so a crash leaves either the
+old file or the whole new one. fd keeps reading the old
+file, fileName has to be opened again.
+RETURNS: RC_OK, RC_NOT_A_PAGE_FILE for a file that is empty
+         or not a whole number of pages, RC_WRITE_FAILED
+*/
+static RC upgradePageFile(char *fileName, int fd)
+{
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % PAGE_SIZE != 0)
+        return RC_NOT_A_PAGE_FILE;
+    char *upgradeName = (char *) malloc(strlen(fileName) + sizeof(SM_UPGRADE_SUFFIX));
+    size_t chunkSize = (size_t) SM_UPGRADE_PAGES * PAGE_SIZE;
+    char *buffer = (char *) calloc(1, chunkSize > SM_FILE_HEADER_SIZE ? chunkSize : SM_FILE_HEADER_SIZE);
+    if(!upgradeName || !buffer)
+    {
+        free(upgradeName);
+        free(buffer);
+        return RC_BM_MEMORY_ALOC_FAIL;
+    }
+    sprintf(upgradeName, "%s%s", fileName, SM_UPGRADE_SUFFIX);
+    int upgradeFd = open(upgradeName, O_RDWR | O_CREAT | O_TRUNC, st.st_mode & 0777);
+    SM_FileHeader header = {SM_FILE_MAGIC, PAGE_SIZE, 1, 0, 0};
+    memcpy(buffer, &header, sizeof(header));
+    bool isCopied = upgradeFd >= 0 && writeFully(upgradeFd, buffer, SM_FILE_HEADER_SIZE, 0);
+    for(off_t offset = 0; isCopied && offset < st.st_size; offset += chunkSize)
+    {
+        size_t numBytes = st.st_size - offset < (off_t) chunkSize ? (size_t) (st.st_size - offset) : chunkSize;
+        isCopied = readFully(fd, buffer, numBytes, offset)
+                   && writeFully(upgradeFd, buffer, numBytes, SM_FILE_HEADER_SIZE + offset);
+    }
+    isCopied = isCopied && fdatasync(upgradeFd) == 0;
+    if(upgradeFd >= 0 && close(upgradeFd) != 0)
+        isCopied = false;
+    if(isCopied && rename(upgradeName, fileName) != 0)
+        isCopied = false;
+    if(!isCopied)
+        unlink(upgradeName);
+    free(upgradeName);
+    free(buffer);
+    return isCopied ? RC_OK : RC_WRITE_FAILED;
+}
+
+//true for a power of two from SM_MIN_PAGE_SIZE to SM_MAX_PAGE_SIZE
+static bool isValidPageSize(int pageSize)
+{
+    return pageSize >= SM_MIN_PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE
+           && (pageSize & (pageSize - 1)) == 0;
+}
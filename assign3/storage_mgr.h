@@ -2,6 +2,22 @@
 #define STORAGE_MGR_H
 
 #include "dberror.h"
+#include <stdbool.h>
+#include <sys/types.h>
+
+//bytes the file system reserves at once as page files grow
+#define SM_DEFAULT_EXTENT_SIZE (1024*1024)
+//bytes of the segment files page files are split into
+#define SM_DEFAULT_SEGMENT_SIZE (1024L*1024*1024)
+
+//page sizes createPageFileEx takes, powers of two
+#define SM_MIN_PAGE_SIZE PAGE_SIZE
+#define SM_MAX_PAGE_SIZE (64*1024)
+//header every plain page file starts with, see createPageFileEx,
+//it keeps the pages aligned for direct IO
+#define SM_FILE_HEADER_SIZE PAGE_SIZE
+#define SM_FILE_MAGIC "SMPGFILE"
+#define SM_FILE_MAGIC_SIZE 8
 
 /************************************************************
  *                    handle data structures                *
@@ -10,20 +26,55 @@ typedef struct SM_FileHandle {
     char *fileName;
     int totalNumPages;
     int curPagePos;
+    int pageSize; //bytes of every page of the file
     void *mgmtInfo;
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
 
+/* a page file mapped read only, see mapPageFile */
+typedef struct SM_MappedFile {
+    char *fileName;
+    int totalNumPages;
+    int pageSize;
+    char *pages; //page i starts at pages + i*pageSize
+    char *memory; //start of the mapping, the file header comes before pages
+    size_t bytes;
+} SM_MappedFile;
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileEx (char *fileName, int pageSize);
+extern RC createCompressedPageFile (char *fileName);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
+extern bool pageFileExists (char *fileName);
+extern void setDirectIO (bool enabled);
+extern void setExtentSize (long extentSize);
+extern void setSegmentSize (long segmentSize);
+extern void setSegmentDirs (const char *dirs);
+extern void setPageChecksums (bool enabled);
+extern bool isDirectIO (SM_FileHandle *fHandle);
+extern bool isCompressedPageFile (SM_FileHandle *fHandle);
+extern bool hasPageChecksums (SM_FileHandle *fHandle);
+extern int getPageFileFd (SM_FileHandle *fHandle);
+extern int getPageFd (SM_FileHandle *fHandle, int pageNum, off_t *fileOffset);
+extern int getSegmentPages (SM_FileHandle *fHandle);
+extern long getNumSegmentSyncs (void);
+
+/* mapping page files read only */
+extern RC mapPageFile (char *fileName, SM_MappedFile *map);
+extern RC unmapPageFile (SM_MappedFile *map);
+extern RC adviseMappedFile (SM_MappedFile *map, bool isSequential);
+
+/* page checksums, no-ops unless the file was created with them */
+extern void stampPageChecksum (SM_FileHandle *fHandle, SM_PageHandle page);
+extern RC checkPageChecksum (SM_FileHandle *fHandle, SM_PageHandle page);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
@@ -33,11 +84,14 @@ extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC syncPageFile (SM_FileHandle *fHandle);
 
 #endif
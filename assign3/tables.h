@@ -43,10 +43,12 @@ typedef struct Schema {
 } Schema;
 
 // TableData: Management Structure for a Record Manager to handle one relation
+struct RM_TableInfo;
 typedef struct RM_TableData {
     char *name;
     Schema *schema;
     BM_BufferPool *bufferPool;
+    struct RM_TableInfo *mgmtData; // bookkeeping the record manager keeps for an open table
 } RM_TableData;
 
 #define MAKE_STRING_VALUE(result, value)				\
@@ -0,0 +1,662 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "tablespace.h"
+#include "file_io.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define TBS_EXTENT_BYTES ((off_t) TBS_EXTENT_PAGES * PAGE_SIZE)
+//extents come after the header page
+#define TBS_OFFSET(extent) (PAGE_SIZE + (off_t) (extent) * TBS_EXTENT_BYTES)
+#define TBS_NUM_EXTENTS(numBytes) (((numBytes) + TBS_EXTENT_BYTES - 1) / TBS_EXTENT_BYTES)
+#define TBS_NO_EXTENT UINT32_MAX
+#define TBS_WORD_BITS (8 * sizeof(bitmap_type))
+
+typedef struct TBS_Header {
+    char magic[TBS_MAGIC_SIZE];
+    uint32_t catalogExtent;
+    uint32_t catalogBytes;
+    uint32_t nextRelId;
+    uint32_t pageChecksums;
+} TBS_Header;
+
+/*********************************************************************
+*
+*                        PRIVATE VARIABLES
+*
+*********************************************************************/
+//every tablespace loaded so far
+static TBS_Tablespace *openSpaces = NULL;
+static pthread_mutex_t openSpacesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*********************************************************************
+*
+*                        PRIVATE FUNCTIONS
+*
+*********************************************************************/
+static RC acquireSpace(char *name, TBS_Tablespace **space, char **relName);
+static RC releaseSpace(TBS_Tablespace *space);
+static RC loadSpace(char *fileName, TBS_Tablespace **space);
+static bool loadCatalog(TBS_Tablespace *space, char *catalog, uint32_t numBytes);
+static void freeSpace(TBS_Tablespace *space);
+static void freeRelation(TBS_Relation *relation);
+static TBS_Relation *findRelation(TBS_Tablespace *space, char *relName);
+static TBS_Relation *addRelation(TBS_Tablespace *space, char *relName, uint32_t relId);
+static void removeRelation(TBS_Tablespace *space, TBS_Relation *relation);
+static void giveUpExtents(TBS_Tablespace *space, TBS_Relation *relation);
+static bool addExtent(TBS_Relation *relation, uint32_t extent);
+static bool growExtents(TBS_Tablespace *space, TBS_Relation *relation, int numPages);
+static bool growBitmap(bitmap *b, int bits);
+static uint32_t allocExtents(TBS_Tablespace *space, uint32_t numExtents, bool isZeroed);
+static void freeExtents(TBS_Tablespace *space, uint32_t extent, uint32_t numExtents);
+static RC saveCatalog(TBS_Tablespace *space, bool isDurable);
+
+/*********************************************************************
+*
+*                       TABLESPACE FUNCTIONS
+*
+*********************************************************************/
+
+//createTablespace creates fileName with an empty catalog
+RC createTablespace (char *fileName, bool pageChecksums)
+{
+    if(!*fileName)
+        return RC_NO_FILENAME;
+    dropTablespace(fileName);
+    int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd == -1)
+        return RC_FILE_CREATION_FAILED;
+    char header[PAGE_SIZE] = {0};
+    TBS_Header hdr = {TBS_MAGIC, 0, 0, 1, pageChecksums};
+    memcpy(header, &hdr, sizeof(TBS_Header));
+    bool isWritten = writeFully(fd, header, sizeof(header), 0);
+    if(close(fd) != 0 || !isWritten)
+        return RC_WRITE_FAILED;
+    return RC_OK;
+}
+
+/*********************************************************************
+dropTablespace removes fileName from the cache. A tablespace that
+still has handles is freed when the last of them is closed, its
+catalog isn't saved anymore.
+*********************************************************************/
+void dropTablespace (char *fileName)
+{
+    pthread_mutex_lock(&openSpacesMutex);
+    TBS_Tablespace **link = &openSpaces;
+    while(*link && strcmp((*link)->fileName, fileName) != 0)
+        link = &(*link)->next;
+    TBS_Tablespace *space = *link;
+    bool isUnused = false;
+    if(space)
+    {
+        *link = space->next;
+        pthread_mutex_lock(&space->mutex);
+        space->isDropped = true;
+        isUnused = space->numHandles == 0;
+        pthread_mutex_unlock(&space->mutex);
+    }
+    pthread_mutex_unlock(&openSpacesMutex);
+    if(isUnused)
+        freeSpace(space);
+}
+
+/*********************************************************************
+isRelationName is true for "<tablespace file>:<relation>" if the part
+before the first TBS_SEPARATOR is a tablespace, loaded already or in a
+file that starts with TBS_MAGIC. Other names with the separator, e.g.
+"dir:x", are names of page files.
+*********************************************************************/
+bool isRelationName (char *name)
+{
+    char *separator = strchr(name, TBS_SEPARATOR);
+    if(!separator || separator == name || !separator[1])
+        return false;
+    char *fileName = strndup(name, separator - name);
+    if(!fileName)
+        return false;
+    pthread_mutex_lock(&openSpacesMutex);
+    TBS_Tablespace *cached = openSpaces;
+    while(cached && strcmp(cached->fileName, fileName) != 0)
+        cached = cached->next;
+    pthread_mutex_unlock(&openSpacesMutex);
+    bool isSpace = cached != NULL;
+    if(!isSpace)
+    {
+        char magic[TBS_MAGIC_SIZE];
+        int fd = open(fileName, O_RDONLY);
+        isSpace = fd != -1 && readFully(fd, magic, TBS_MAGIC_SIZE, 0)
+                  && memcmp(magic, TBS_MAGIC, TBS_MAGIC_SIZE) == 0;
+        if(fd != -1)
+            close(fd);
+    }
+    free(fileName);
+    return isSpace;
+}
+
+/*********************************************************************
+createRelation adds a relation with a single page of zeros, like
+createPageFile. A relation of that name is replaced.
+*********************************************************************/
+RC createRelation (char *name)
+{
+    TBS_Tablespace *space;
+    char *relName;
+    RC returnCode = acquireSpace(name, &space, &relName);
+    if(returnCode != RC_OK)
+        return returnCode;
+    pthread_mutex_lock(&space->mutex);
+    TBS_Relation *relation = findRelation(space, relName);
+    if(relation)
+        removeRelation(space, relation);
+    relation = addRelation(space, relName, space->nextRelId++);
+    if(!relation)
+        returnCode = RC_BM_MEMORY_ALOC_FAIL;
+    else if(!growExtents(space, relation, 1))
+        returnCode = RC_WRITE_FAILED;
+    pthread_mutex_unlock(&space->mutex);
+    RC releaseCode = releaseSpace(space);
+    return returnCode != RC_OK ? returnCode : releaseCode;
+}
+
+//the extents of a relation that still has handles are given up once
+//the last of them is closed
+RC destroyRelation (char *name)
+{
+    TBS_Tablespace *space;
+    char *relName;
+    RC returnCode = acquireSpace(name, &space, &relName);
+    if(returnCode != RC_OK)
+        return returnCode;
+    pthread_mutex_lock(&space->mutex);
+    TBS_Relation *relation = findRelation(space, relName);
+    if(relation)
+        removeRelation(space, relation);
+    pthread_mutex_unlock(&space->mutex);
+    return releaseSpace(space);
+}
+
+bool relationExists (char *name)
+{
+    TBS_Tablespace *space;
+    char *relName;
+    if(acquireSpace(name, &space, &relName) != RC_OK)
+        return false;
+    pthread_mutex_lock(&space->mutex);
+    bool exists = findRelation(space, relName) != NULL;
+    pthread_mutex_unlock(&space->mutex);
+    releaseSpace(space);
+    return exists;
+}
+
+//RC_FILE_NOT_FOUND if the tablespace has no relation of that name
+RC openRelation (char *name, TBS_Tablespace **space, TBS_Relation **relation)
+{
+    char *relName;
+    RC returnCode = acquireSpace(name, space, &relName);
+    if(returnCode != RC_OK)
+        return returnCode;
+    pthread_mutex_lock(&(*space)->mutex);
+    *relation = findRelation(*space, relName);
+    if(*relation)
+        (*relation)->numHandles++;
+    pthread_mutex_unlock(&(*space)->mutex);
+    if(*relation)
+        return RC_OK;
+    releaseSpace(*space);
+    return RC_FILE_NOT_FOUND;
+}
+
+RC closeRelation (TBS_Tablespace *space, TBS_Relation *relation)
+{
+    pthread_mutex_lock(&space->mutex);
+    relation->numHandles--;
+    if(relation->numHandles == 0 && relation->isDropped)
+    {
+        giveUpExtents(space, relation);
+        freeRelation(relation);
+    }
+    pthread_mutex_unlock(&space->mutex);
+    return releaseSpace(space);
+}
+
+int getRelationNumPages (TBS_Tablespace *space, TBS_Relation *relation)
+{
+    pthread_mutex_lock(&space->mutex);
+    int numPages = relation->numPages;
+    pthread_mutex_unlock(&space->mutex);
+    return numPages;
+}
+
+RC growRelation (TBS_Tablespace *space, TBS_Relation *relation, int numPages)
+{
+    pthread_mutex_lock(&space->mutex);
+    bool isGrown = growExtents(space, relation, numPages);
+    pthread_mutex_unlock(&space->mutex);
+    return isGrown ? RC_OK : RC_WRITE_FAILED;
+}
+
+off_t getRelationOffset (TBS_Tablespace *space, TBS_Relation *relation, int pageNum)
+{
+    off_t offset = -1;
+    pthread_mutex_lock(&space->mutex);
+    int extent = pageNum / TBS_EXTENT_PAGES;
+    if(pageNum >= 0 && extent < relation->numExtents)
+        offset = TBS_OFFSET(relation->extents[extent]) + (off_t) (pageNum % TBS_EXTENT_PAGES) * PAGE_SIZE;
+    pthread_mutex_unlock(&space->mutex);
+    return offset;
+}
+
+//saves the catalog and makes the pages and the catalog durable
+RC syncTablespace (TBS_Tablespace *space)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&space->mutex);
+    if(space->isDirty)
+        returnCode = saveCatalog(space, true);
+    else if(fdatasync(space->fd) != 0)
+        returnCode = RC_WRITE_FAILED;
+    pthread_mutex_unlock(&space->mutex);
+    return returnCode;
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+acquireSpace returns the cached tablespace of the relation name, or
+loads it, and counts a handle of it. *relName points into name.
+*********************************************************************/
+static RC acquireSpace(char *name, TBS_Tablespace **space, char **relName)
+{
+    RC returnCode = RC_OK;
+    char *separator = strchr(name, TBS_SEPARATOR);
+    if(!separator || separator == name || !separator[1])
+        return RC_NO_FILENAME;
+    char *fileName = strndup(name, separator - name);
+    if(!fileName)
+        return RC_BM_MEMORY_ALOC_FAIL;
+    *relName = separator + 1;
+    pthread_mutex_lock(&openSpacesMutex);
+    TBS_Tablespace *cached = openSpaces;
+    while(cached && strcmp(cached->fileName, fileName) != 0)
+        cached = cached->next;
+    if(cached)
+    {
+        pthread_mutex_lock(&cached->mutex);
+        cached->numHandles++;
+        pthread_mutex_unlock(&cached->mutex);
+        *space = cached;
+    }
+    else
+        returnCode = loadSpace(fileName, space);
+    pthread_mutex_unlock(&openSpacesMutex);
+    free(fileName);
+    return returnCode;
+}
+
+//the catalog is saved once the last handle is released
+static RC releaseSpace(TBS_Tablespace *space)
+{
+    RC returnCode = RC_OK;
+    pthread_mutex_lock(&openSpacesMutex);
+    pthread_mutex_lock(&space->mutex);
+    space->numHandles--;
+    if(space->numHandles == 0 && space->isDirty && !space->isDropped)
+        returnCode = saveCatalog(space, false);
+    bool isUnused = space->numHandles == 0 && space->isDropped;
+    pthread_mutex_unlock(&space->mutex);
+    pthread_mutex_unlock(&openSpacesMutex);
+    if(isUnused)
+        freeSpace(space);
+    return returnCode;
+}
+
+//reads the header and the catalog and adds the tablespace to openSpaces
+static RC loadSpace(char *fileName, TBS_Tablespace **space)
+{
+    TBS_Header hdr;
+    struct stat st;
+    int fd = open(fileName, O_RDWR);
+    if(fd == -1)
+        return RC_FILE_NOT_FOUND;
+    if(!readFully(fd, &hdr, sizeof(TBS_Header), 0) || memcmp(hdr.magic, TBS_MAGIC, TBS_MAGIC_SIZE) != 0
+            || fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return RC_NOT_A_TABLESPACE;
+    }
+    TBS_Tablespace *loaded = (TBS_Tablespace *) calloc(1, sizeof(TBS_Tablespace));
+    if(!loaded)
+    {
+        close(fd);
+        return RC_BM_MEMORY_ALOC_FAIL;
+    }
+    loaded->fd = fd;
+    loaded->fileName = strdup(fileName);
+    pthread_mutex_init(&loaded->mutex, NULL);
+    //extents beyond the catalog, e.g. added before a crash, are free
+    loaded->numExtents = st.st_size > PAGE_SIZE ? (uint32_t) ((st.st_size - PAGE_SIZE) / TBS_EXTENT_BYTES) : 0;
+    loaded->nextRelId = hdr.nextRelId;
+    loaded->pageChecksums = hdr.pageChecksums != 0;
+    loaded->catalogExtent = hdr.catalogExtent;
+    loaded->catalogBytes = hdr.catalogBytes;
+    loaded->catalogExtents = (uint32_t) TBS_NUM_EXTENTS(hdr.catalogBytes);
+    char *catalog = (char *) malloc(hdr.catalogBytes + 1);
+    bool isLoaded = catalog && loaded->fileName && growBitmap(&loaded->usedExtents, loaded->numExtents)
+                    && hdr.catalogExtent + loaded->catalogExtents <= loaded->numExtents
+                    && readFully(fd, catalog, hdr.catalogBytes, TBS_OFFSET(hdr.catalogExtent))
+                    && loadCatalog(loaded, catalog, hdr.catalogBytes);
+    free(catalog);
+    if(!isLoaded)
+    {
+        freeSpace(loaded);
+        return RC_READ_FILE_FAILED;
+    }
+    for(uint32_t i = 0; i < loaded->catalogExtents; i++)
+        bitmap_set(&loaded->usedExtents, loaded->catalogExtent + i);
+    loaded->isDirty = false;
+    loaded->numHandles = 1;
+    loaded->next = openSpaces;
+    openSpaces = loaded;
+    *space = loaded;
+    return RC_OK;
+}
+
+//adds the relations of the catalog and marks their extents in use
+static bool loadCatalog(TBS_Tablespace *space, char *catalog, uint32_t numBytes)
+{
+    char *end = catalog + numBytes;
+    while(catalog < end)
+    {
+        uint32_t entry[3];
+        uint16_t nameLength;
+        if(end - catalog < (long) (sizeof(entry) + sizeof(uint16_t)))
+            return false;
+        memcpy(entry, catalog, sizeof(entry));
+        memcpy(&nameLength, catalog + sizeof(entry), sizeof(uint16_t));
+        catalog += sizeof(entry) + sizeof(uint16_t);
+        if(end - catalog < (long) (nameLength + (size_t) entry[2] * sizeof(uint32_t)))
+            return false;
+        char *relName = strndup(catalog, nameLength);
+        TBS_Relation *relation = relName ? addRelation(space, relName, entry[0]) : NULL;
+        free(relName);
+        if(!relation)
+            return false;
+        catalog += nameLength;
+        relation->numPages = (int) entry[1];
+        for(uint32_t i = 0; i < entry[2]; i++, catalog += sizeof(uint32_t))
+        {
+            uint32_t extent;
+            memcpy(&extent, catalog, sizeof(uint32_t));
+            if(extent >= space->numExtents || bitmap_read(&space->usedExtents, extent)
+                    || !addExtent(relation, extent))
+                return false;
+            bitmap_set(&space->usedExtents, extent);
+        }
+    }
+    return true;
+}
+
+static void freeSpace(TBS_Tablespace *space)
+{
+    close(space->fd);
+    pthread_mutex_destroy(&space->mutex);
+    for(int i = 0; i < space->numRelations; i++)
+        freeRelation(space->relations[i]);
+    free(space->relations);
+    free(space->usedExtents.array);
+    free(space->pendingExtents);
+    free(space->fileName);
+    free(space);
+}
+
+static void freeRelation(TBS_Relation *relation)
+{
+    free(relation->name);
+    free(relation->extents);
+    free(relation);
+}
+
+static TBS_Relation *findRelation(TBS_Tablespace *space, char *relName)
+{
+    for(int i = 0; i < space->numRelations; i++)
+        if(strcmp(space->relations[i]->name, relName) == 0)
+            return space->relations[i];
+    return NULL;
+}
+
+//the array of relations grows by powers of two
+static TBS_Relation *addRelation(TBS_Tablespace *space, char *relName, uint32_t relId)
+{
+    if((space->numRelations & (space->numRelations - 1)) == 0)
+    {
+        TBS_Relation **grown = (TBS_Relation **) realloc(space->relations,
+                               (space->numRelations ? 2 * space->numRelations : 1) * sizeof(TBS_Relation *));
+        if(!grown)
+            return NULL;
+        space->relations = grown;
+    }
+    TBS_Relation *relation = (TBS_Relation *) calloc(1, sizeof(TBS_Relation));
+    if(!relation || !(relation->name = strdup(relName)))
+    {
+        free(relation);
+        return NULL;
+    }
+    relation->relId = relId;
+    space->relations[space->numRelations++] = relation;
+    space->isDirty = true;
+    return relation;
+}
+
+//takes the relation out of the catalog, the others keep their order
+static void removeRelation(TBS_Tablespace *space, TBS_Relation *relation)
+{
+    int i = 0;
+    while(space->relations[i] != relation)
+        i++;
+    memmove(&space->relations[i], &space->relations[i + 1],
+            (space->numRelations - i - 1) * sizeof(TBS_Relation *));
+    space->numRelations--;
+    space->isDirty = true;
+    if(relation->numHandles > 0)
+    {
+        relation->isDropped = true;
+        return;
+    }
+    giveUpExtents(space, relation);
+    freeRelation(relation);
+}
+
+//the saved catalog may still point at the extents
+static void giveUpExtents(TBS_Tablespace *space, TBS_Relation *relation)
+{
+    uint32_t *pending = (uint32_t *) realloc(space->pendingExtents,
+                        (space->numPending + relation->numExtents) * sizeof(uint32_t));
+    //extents that can't be remembered stay in use until the next load
+    if(!pending)
+        return;
+    memcpy(pending + space->numPending, relation->extents, relation->numExtents * sizeof(uint32_t));
+    space->pendingExtents = pending;
+    space->numPending += relation->numExtents;
+    relation->numExtents = 0;
+}
+
+static bool addExtent(TBS_Relation *relation, uint32_t extent)
+{
+    if(relation->numExtents == relation->extentCapacity)
+    {
+        int capacity = relation->extentCapacity > 0 ? 2 * relation->extentCapacity : 4;
+        uint32_t *extents = (uint32_t *) realloc(relation->extents, capacity * sizeof(uint32_t));
+        if(!extents)
+            return false;
+        relation->extents = extents;
+        relation->extentCapacity = capacity;
+    }
+    relation->extents[relation->numExtents++] = extent;
+    return true;
+}
+
+//gives the relation extents for numPages pages, one at a time
+static bool growExtents(TBS_Tablespace *space, TBS_Relation *relation, int numPages)
+{
+    while((long) relation->numExtents * TBS_EXTENT_PAGES < numPages)
+    {
+        uint32_t extent = allocExtents(space, 1, true);
+        if(extent == TBS_NO_EXTENT)
+            return false;
+        if(!addExtent(relation, extent))
+        {
+            freeExtents(space, extent, 1);
+            return false;
+        }
+    }
+    if(numPages > relation->numPages)
+    {
+        relation->numPages = numPages;
+        space->isDirty = true;
+    }
+    return true;
+}
+
+static bool growBitmap(bitmap *b, int bits)
+{
+    int words = (int) ((bits + TBS_WORD_BITS - 1) / TBS_WORD_BITS);
+    if(words > b->words)
+    {
+        int capacity = b->words > 0 ? b->words : 1;
+        while(capacity < words)
+            capacity *= 2;
+        bitmap_type *array = (bitmap_type *) realloc(b->array, capacity * sizeof(bitmap_type));
+        if(!array)
+            return false;
+        memset(array + b->words, 0, (capacity - b->words) * sizeof(bitmap_type));
+        b->array = array;
+        b->words = capacity;
+    }
+    if(bits > b->bits)
+        b->bits = bits;
+    return true;
+}
+
+/*********************************************************************
+allocExtents takes the first run of numExtents free extents, else
+grows the file by them. isZeroed zeroes reused extents, the file grows
+by zeros.
+RETURNS: the first extent, TBS_NO_EXTENT if the file can't grow
+*********************************************************************/
+static uint32_t allocExtents(TBS_Tablespace *space, uint32_t numExtents, bool isZeroed)
+{
+    uint32_t extent = TBS_NO_EXTENT;
+    for(uint32_t start = 0, length = 0; start + length < space->numExtents; )
+    {
+        if(bitmap_read(&space->usedExtents, start + length))
+        {
+            start += length + 1;
+            length = 0;
+        }
+        else if(++length == numExtents)
+        {
+            extent = start;
+            break;
+        }
+    }
+    if(extent != TBS_NO_EXTENT && isZeroed)
+    {
+        off_t offset = TBS_OFFSET(extent), length = numExtents * TBS_EXTENT_BYTES;
+        if(fallocate(space->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length) != 0)
+        {
+            char *zeros = (char *) calloc(1, length);
+            bool isZero = zeros && writeFully(space->fd, zeros, length, offset);
+            free(zeros);
+            if(!isZero)
+                return TBS_NO_EXTENT;
+        }
+    }
+    if(extent == TBS_NO_EXTENT)
+    {
+        extent = space->numExtents;
+        off_t end = TBS_OFFSET(extent + numExtents);
+        //allocated together, the extents stay contiguous on disk
+        if(!growBitmap(&space->usedExtents, extent + numExtents)
+                || (fallocate(space->fd, 0, TBS_OFFSET(extent), end - TBS_OFFSET(extent)) != 0
+                    && ftruncate(space->fd, end) != 0))
+            return TBS_NO_EXTENT;
+        space->numExtents += numExtents;
+    }
+    for(uint32_t i = 0; i < numExtents; i++)
+        bitmap_set(&space->usedExtents, extent + i);
+    return extent;
+}
+
+static void freeExtents(TBS_Tablespace *space, uint32_t extent, uint32_t numExtents)
+{
+    for(uint32_t i = 0; i < numExtents; i++)
+        bitmap_clear(&space->usedExtents, extent + i);
+}
+
+/*********************************************************************
+saveCatalog writes the catalog to free extents, then the header that
+points to it. The extents of the old catalog and those given up can be
+reused afterwards. isDurable syncs the pages and the catalog before
+the header and the header before returning.
+*********************************************************************/
+static RC saveCatalog(TBS_Tablespace *space, bool isDurable)
+{
+    size_t numBytes = 0;
+    for(int i = 0; i < space->numRelations; i++)
+        numBytes += 3 * sizeof(uint32_t) + sizeof(uint16_t) + strlen(space->relations[i]->name)
+                    + space->relations[i]->numExtents * sizeof(uint32_t);
+    char *catalog = (char *) malloc(numBytes + 1);
+    if(!catalog)
+        return RC_BM_MEMORY_ALOC_FAIL;
+    char *next = catalog;
+    for(int i = 0; i < space->numRelations; i++)
+    {
+        TBS_Relation *relation = space->relations[i];
+        uint32_t entry[3] = {relation->relId, (uint32_t) relation->numPages, (uint32_t) relation->numExtents};
+        uint16_t nameLength = (uint16_t) strlen(relation->name);
+        memcpy(next, entry, sizeof(entry));
+        memcpy(next + sizeof(entry), &nameLength, sizeof(uint16_t));
+        next += sizeof(entry) + sizeof(uint16_t);
+        memcpy(next, relation->name, nameLength);
+        next += nameLength;
+        memcpy(next, relation->extents, relation->numExtents * sizeof(uint32_t));
+        next += relation->numExtents * sizeof(uint32_t);
+    }
+    uint32_t catalogExtents = (uint32_t) TBS_NUM_EXTENTS(numBytes);
+    uint32_t catalogExtent = catalogExtents > 0 ? allocExtents(space, catalogExtents, false) : 0;
+    bool isWritten = catalogExtent != TBS_NO_EXTENT
+                     && writeFully(space->fd, catalog, numBytes, TBS_OFFSET(catalogExtent))
+                     && (!isDurable || fdatasync(space->fd) == 0);
+    free(catalog);
+    TBS_Header hdr = {TBS_MAGIC, catalogExtent, (uint32_t) numBytes, space->nextRelId,
+                      space->pageChecksums};
+    if(!isWritten || !writeFully(space->fd, &hdr, sizeof(TBS_Header), 0)
+            || (isDurable && fdatasync(space->fd) != 0))
+    {
+        if(catalogExtent != TBS_NO_EXTENT)
+            freeExtents(space, catalogExtent, catalogExtents);
+        return RC_WRITE_FAILED;
+    }
+    freeExtents(space, space->catalogExtent, space->catalogExtents);
+    for(int i = 0; i < space->numPending; i++)
+        freeExtents(space, space->pendingExtents[i], 1);
+    space->numPending = 0;
+    space->catalogExtent = catalogExtent;
+    space->catalogExtents = catalogExtents;
+    space->catalogBytes = (uint32_t) numBytes;
+    space->isDirty = false;
+    return RC_OK;
+}
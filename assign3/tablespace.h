@@ -0,0 +1,107 @@
+#ifndef TABLESPACE_H
+#define TABLESPACE_H
+
+#include "dberror.h"
+#include "bitmap.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+/*********************************************************************
+A tablespace keeps the pages of many relations, e.g. the page files of
+tables and of their zone maps, in a single file. Wherever the storage
+manager takes the name of a page file it also takes
+"<tablespace file>:<relation>" (TBS_SEPARATOR) once the tablespace
+file exists, see isRelationName, so buffer pools and the record
+manager use a relation like a page file.
+
+---------------------------------------------------------------------------
+header (1 page) | extent 0 | extent 1 | ... (TBS_EXTENT_PAGES pages each)
+---------------------------------------------------------------------------
+header:  char magic[8] | uint catalogExtent | uint catalogBytes | uint nextRelId |
+         uint pageChecksums
+catalog: (uint relId | uint numPages | uint numExtents | ushort nameLength |
+          char name[nameLength] | uint extents[numExtents]) * numRelations
+
+Extents: every extent belongs to one relation, to the catalog or to
+no one. Page p of a relation, of PAGE_SIZE bytes, is page
+p % TBS_EXTENT_PAGES of extent extents[p / TBS_EXTENT_PAGES]. A
+relation grows by whole extents and never shrinks, they come first fit
+from the free extent bitmap, else the file is extended. The bitmap
+isn't stored: a load marks the extents the catalog lists, any other
+extent of the file, e.g. one added before a crash, is free.
+
+Catalog: it takes contiguous extents of its own and is never updated
+in place. A save writes the new catalog to free extents and then the
+header that points to it, so a crash leaves the old or the new one
+whole. The extents of a destroyed relation and those of the old
+catalog are still listed by the saved catalog, they only become free
+after the next save and read as zeros when reused. nextRelId only
+grows, a relation created over another gets a new relId. pageChecksums
+is fixed when the tablespace is created and holds for the pages of all
+its relations, see setPageChecksums.
+
+All handles of the relations of a tablespace share the descriptor it
+is loaded with. The catalog is saved once the last of them is
+released and by syncTablespace, which also makes the pages of the
+relations durable. A relation destroyed while it has handles keeps its
+extents until the last of them is closed.
+*********************************************************************/
+#define TBS_MAGIC "SMTBLSP1"
+#define TBS_MAGIC_SIZE 8
+#define TBS_SEPARATOR ':'
+#define TBS_EXTENT_PAGES 16
+
+typedef struct TBS_Relation {
+    char *name;
+    uint32_t relId;
+    int numPages;
+    int numExtents;
+    int extentCapacity;
+    uint32_t *extents;  //the extent of the tablespace of every extent of the relation
+    int numHandles;
+    bool isDropped;     //destroyed or recreated while handles were open
+} TBS_Relation;
+
+typedef struct TBS_Tablespace {
+    char *fileName;
+    int fd;
+    int numHandles;
+    bool isDropped;
+    pthread_mutex_t mutex;
+    TBS_Relation **relations;
+    int numRelations;
+    uint32_t nextRelId;
+    bool pageChecksums;       //the pages of the relations carry checksums
+    bitmap usedExtents;       //the free extent bitmap, free extents are clear
+    uint32_t numExtents;      //extents of the file
+    uint32_t catalogExtent;   //extents of the saved catalog
+    uint32_t catalogExtents;
+    uint32_t catalogBytes;
+    bool isDirty;             //the catalog changed since it was saved
+    uint32_t *pendingExtents; //given up since the catalog was saved
+    int numPending;
+    struct TBS_Tablespace *next;
+} TBS_Tablespace;
+
+extern RC createTablespace (char *fileName, bool pageChecksums);
+// forgets a cached tablespace before its file is destroyed or recreated
+extern void dropTablespace (char *fileName);
+// true for "<tablespace file>:<relation>" of an existing tablespace file
+extern bool isRelationName (char *name);
+
+// relations, by "<tablespace file>:<relation>"
+extern RC createRelation (char *name);
+extern RC destroyRelation (char *name);
+extern bool relationExists (char *name);
+extern RC openRelation (char *name, TBS_Tablespace **space, TBS_Relation **relation);
+extern RC closeRelation (TBS_Tablespace *space, TBS_Relation *relation);
+extern int getRelationNumPages (TBS_Tablespace *space, TBS_Relation *relation);
+// the new pages read as zeros
+extern RC growRelation (TBS_Tablespace *space, TBS_Relation *relation, int numPages);
+// the byte of the file page pageNum starts at, -1 if it has no extent
+extern off_t getRelationOffset (TBS_Tablespace *space, TBS_Relation *relation, int pageNum);
+extern RC syncTablespace (TBS_Tablespace *space);
+
+#endif // TABLESPACE_H
@@ -1,8 +1,21 @@
 #include <stdlib.h>
+#include <pthread.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <dirent.h>
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
 #include "tables.h"
+#include "async_io.h"
+#include "crc32c.h"
+#include "compressed_file.h"
+#include "tablespace.h"
+#include "catalog.h"
 #include "test_helper.h"
 
 
@@ -47,6 +60,19 @@
     ASSERT_TRUE(b,message);				\
    } while (0)
 
+#define AIO_TEST_PAGES 64
+#define VIO_TEST_PAGES 8
+#define VIO_POOL_PAGES 64
+#define EXTENT_TEST_PAGES 64
+#define CF_TEST_PAGES 8
+#define PS_TEST_PAGE_SIZE 16384
+#define SEG_TEST_PAGES 8
+#define SEG_FAR_PAGE 600000
+#define TBS_TEST_PAGES 40
+#define TBS_TEST_TABLES 100
+#define CAT_TEST_TABLES 30
+#define CAT_TEST_NAME_LENGTH 150
+
 // test methods
 static void testRecords (void);
 static void testCreateTableAndInsert (void);
@@ -55,6 +81,33 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testPaxLayout(void);
+static void testCompressedPaxLayout(void);
+static void testZoneMaps(void);
+static void testBloomFilters(void);
+static void testWriteAheadLog(void);
+static void testGroupCommit(void);
+static void testCheckpoints(void);
+static void testBeforeWriteHook(void);
+static void testTransactions(void);
+static void testLockManager(void);
+static void testSharedBufferPool(void);
+static void testConfig(void);
+static void testResizeBufferPool(void);
+static void testFrameArena(void);
+static void testDirectIO(void);
+static void testAsyncIO(void);
+static void testReadOnlyTable(void);
+static void testVectoredIO(void);
+static void testFileExtents(void);
+static void testSyncPoints(void);
+static void testPageChecksums(void);
+static void testCompressedPageFile(void);
+static void testPageSizes(void);
+static void testSegmentedFiles(void);
+static void testTablespace(void);
+static void testCatalog(void);
+static int countOpenFiles(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -67,6 +120,7 @@ typedef struct TestRecord {
 Record *testRecord(Schema *schema, int a, char *b, int c);
 Schema *testSchema (void);
 Record *fromTestRecord (Schema *schema, TestRecord in);
+int getAttrInt (Record *record, Schema *schema, int attrNum);
 
 // test name
 char *testName;
@@ -82,6 +136,32 @@ int main (void) {
     testScans();
     testScansTwo();
     testMultipleScans();
+    testPaxLayout();
+    testCompressedPaxLayout();
+    testZoneMaps();
+    testBloomFilters();
+    testWriteAheadLog();
+    testGroupCommit();
+    testCheckpoints();
+    testBeforeWriteHook();
+    testTransactions();
+    testLockManager();
+    testSharedBufferPool();
+    testConfig();
+    testResizeBufferPool();
+    testFrameArena();
+    testDirectIO();
+    testAsyncIO();
+    testReadOnlyTable();
+    testVectoredIO();
+    testFileExtents();
+    testSyncPoints();
+    testPageChecksums();
+    testCompressedPageFile();
+    testPageSizes();
+    testSegmentedFiles();
+    testTablespace();
+    testCatalog();
 
     return 0;
 }
@@ -584,51 +664,2823 @@ void testScansTwo (void) {
     TEST_DONE();
 }
 
-Schema* testSchema (void) {
-    Schema *result;
-    char *names[] = { "a", "b", "c" };
-    DataType dt[] = { DT_INT, DT_STRING, DT_INT };
-    int sizes[] = { 0, 4, 0 };
-    int keys[] = {0};
-    int i;
-    char **cpNames = (char **) malloc(sizeof(char*) * 3);
-    DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
-    int *cpSizes = (int *) malloc(sizeof(int) * 3);
-    int *cpKeys = (int *) malloc(sizeof(int));
+void testPaxLayout(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord inserts[] = {
+        {1, "aaaa", 3},
+        {2, "bbbb", 2},
+        {3, "cccc", 1},
+        {4, "dddd", 3},
+        {5, "eeee", 5},
+        {6, "ffff", 1},
+        {7, "gggg", 3},
+        {8, "hhhh", 3},
+        {9, "iiii", 2},
+        {10, "jjjj", 5},
+    };
+    TestRecord realInserts[1000];
+    TestRecord update = {500, "zzzz", 4};
+    int numInserts = 1000, numMatches = 0, i, rc;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    Expr *sel, *left, *right;
+    testName = "test PAX page layout spanning several pages";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
 
-    for(i = 0; i < 3; i++) {
-        cpNames[i] = (char *) malloc(2);
-        strcpy(cpNames[i], names[i]);
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTableEx("test_table_p", schema, RM_LAYOUT_PAX));
+    TEST_CHECK(openTable(table, "test_table_p"));
+
+    // insert rows into table
+    for(i = 0; i < numInserts; i++) {
+        realInserts[i] = inserts[i%10];
+        realInserts[i].a = i;
+        r = fromTestRecord(schema, realInserts[i]);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
     }
-    memcpy(cpDt, dt, sizeof(DataType) * 3);
-    memcpy(cpSizes, sizes, sizeof(int) * 3);
-    memcpy(cpKeys, keys, sizeof(int));
+    ASSERT_TRUE(rids[numInserts-1].page > 1, "records span several pages");
 
-    result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+    // update one record and delete another one
+    r = fromTestRecord(schema, update);
+    r->id = rids[500];
+    TEST_CHECK(updateRecord(table, r));
+    realInserts[500] = update;
+    freeRecord(r);
+    TEST_CHECK(deleteRecord(table, rids[3]));
 
-    return result;
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_p"));
+
+    // retrieve records from the table and compare to expected final stage
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++) {
+        if (i == 3)
+            continue;
+        TEST_CHECK(getRecord(table, rids[i], r));
+        Record *expected = fromTestRecord(schema, realInserts[i]);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records");
+        freeRecord(expected);
+    }
+
+    // scan for c=1 on every page
+    MAKE_CONS(left, stringToValue("i1"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+    TEST_CHECK(startScan(table, sc, sel));
+    while((rc = next(sc, r)) == RC_OK) {
+        Record *expected = fromTestRecord(schema, realInserts[getAttrInt(r, schema, 0)]);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare scanned record");
+        freeRecord(expected);
+        numMatches++;
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts / 5, numMatches, "scan found c=1 on every page");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_p"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeRecord(r);
+    freeExpr(sel);
+    free(rids);
+    free(sc);
+    free(table);
+    TEST_DONE();
 }
 
-Record* fromTestRecord (Schema *schema, TestRecord in) {
-    return testRecord(schema, in.a, in.b, in.c);
+void testCompressedPaxLayout(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_TableData *paxTable = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord inserts[] = {
+        {1, "aaaa", 3},
+        {2, "bbbb", 2},
+        {3, "cccc", 1},
+        {4, "dddd", 3},
+        {5, "eeee", 5},
+        {6, "ffff", 1},
+        {7, "gggg", 3},
+        {8, "hhhh", 3},
+        {9, "iiii", 2},
+        {10, "jjjj", 5},
+    };
+    static TestRecord realInserts[3000];
+    static char names[3000][5];
+    TestRecord update = {10, "zzzz", 4};
+    int numInserts = 3000, numMatches = 0, i, rc;
+    int numMoved[2] = {0, 0};
+    Record *r;
+    RID *rids, *paxRids;
+    RM_Transaction tx;
+    Schema *schema;
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    Expr *sel, *left, *right;
+    testName = "test compressed PAX page layout";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    paxRids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTableEx("test_table_c", schema, RM_LAYOUT_PAX_COMPRESSED));
+    TEST_CHECK(openTable(table, "test_table_c"));
+    TEST_CHECK(createTableEx("test_table_p", schema, RM_LAYOUT_PAX));
+    TEST_CHECK(openTable(paxTable, "test_table_p"));
+
+    // insert the same rows into both tables, the last third has distinct
+    // strings so the compressed pages run out of space before slots
+    for(i = 0; i < numInserts; i++) {
+        realInserts[i] = inserts[i%10];
+        realInserts[i].a = i;
+        if (i >= 2000) {
+            sprintf(names[i], "%04d", i);
+            realInserts[i].b = names[i];
+        }
+        r = fromTestRecord(schema, realInserts[i]);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        TEST_CHECK(insertRecord(paxTable,r));
+        paxRids[i] = r->id;
+        freeRecord(r);
+    }
+    ASSERT_TRUE(rids[numInserts-1].page < paxRids[numInserts-1].page, "compressed table uses fewer pages");
+
+    // update one record and delete another one
+    r = fromTestRecord(schema, update);
+    r->id = rids[10];
+    TEST_CHECK(updateRecord(table, r));
+    realInserts[10] = update;
+    freeRecord(r);
+    TEST_CHECK(deleteRecord(table, rids[3]));
+
+    // distinct strings no longer fit on the first page, the updated
+    // records move to other pages, every other one in a transaction
+    for(i = 0; rids[i].page == rids[0].page; i++) {
+        if (i == 3)
+            continue;
+        sprintf(names[i], "%04d", i);
+        realInserts[i].b = names[i];
+        r = fromTestRecord(schema, realInserts[i]);
+        r->id = rids[i];
+        if (i % 2) {
+            TEST_CHECK(beginTransaction(table, &tx));
+            TEST_CHECK(updateRecordTx(&tx, r));
+            TEST_CHECK(commitTransaction(&tx));
+        }
+        else
+            TEST_CHECK(updateRecord(table, r));
+        if (r->id.page != rids[i].page)
+            numMoved[i % 2]++;
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    ASSERT_TRUE(numMoved[0] > 0 && numMoved[1] > 0, "records moved off a full compressed page");
+
+    // retrieve records from the table and compare to expected final stage
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++) {
+        if (i == 3)
+            continue;
+        TEST_CHECK(getRecord(table, rids[i], r));
+        Record *expected = fromTestRecord(schema, realInserts[i]);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records");
+        freeRecord(expected);
+    }
+
+    // scan for c=1, evaluated on the encoded minipages
+    MAKE_CONS(left, stringToValue("i1"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+    TEST_CHECK(startScan(table, sc, sel));
+    while((rc = next(sc, r)) == RC_OK) {
+        Record *expected = fromTestRecord(schema, realInserts[getAttrInt(r, schema, 0)]);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare scanned record");
+        freeRecord(expected);
+        numMatches++;
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts / 5, numMatches, "scan found c=1 on every page");
+
+    TEST_CHECK(closeTable(paxTable));
+    TEST_CHECK(deleteTable("test_table_p"));
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_c"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeRecord(r);
+    freeExpr(sel);
+    free(rids);
+    free(paxRids);
+    free(sc);
+    free(paxTable);
+    free(table);
+    TEST_DONE();
 }
 
-Record* testRecord(Schema *schema, int a, char *b, int c) {
-    Record *result;
-    Value *value;
+// counts the records of a scan with condition sel and the page reads it takes
+static int countScan(RM_TableData *table, Expr *sel, int *numReadIO) {
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    Record *r;
+    int numMatches = 0, rc;
+    // read-only tables have no pool
+    int readIOBefore = table->bufferPool ? getNumReadIO(table->bufferPool) : 0;
 
-    TEST_CHECK(createRecord(&result, schema));
+    TEST_CHECK(createRecord(&r, table->schema));
+    TEST_CHECK(startScan(table, sc, sel));
+    while((rc = next(sc, r)) == RC_OK)
+        numMatches++;
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    *numReadIO = table->bufferPool ? getNumReadIO(table->bufferPool) - readIOBefore : 0;
 
-    MAKE_VALUE(value, DT_INT, a);
-    TEST_CHECK(setAttr(result, schema, 0, value));
-    freeVal(value);
+    freeRecord(r);
+    free(sc);
+    return numMatches;
+}
 
-    MAKE_STRING_VALUE(value, b);
-    TEST_CHECK(setAttr(result, schema, 1, value));
-    freeVal(value);
+void testZoneMaps(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 3000, numMatches, numReadIO, i;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    Expr *sel, *left, *right, *first, *last;
+    testName = "test zone maps skipping pages";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
 
-    MAKE_VALUE(value, DT_INT, c);
-    TEST_CHECK(setAttr(result, schema, 2, value));
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_z", schema));
+    TEST_CHECK(openTable(table, "test_table_z"));
+
+    // a grows with every insert like a timestamp
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    ASSERT_TRUE(rids[numInserts-1].page > 5, "records span several pages");
+
+    // a < 100 only reads the first page
+    MAKE_CONS(right, stringToValue("i100"));
+    MAKE_ATTRREF(left, 0);
+    MAKE_BINOP_EXPR(first, left, right, OP_COMP_SMALLER);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_z"));
+    numMatches = countScan(table, first, &numReadIO);
+    ASSERT_EQUALS_INT(100, numMatches, "scan a < 100");
+    ASSERT_EQUALS_INT(1, numReadIO, "scan a < 100 reads one page");
+
+    // not(a < 2990) only reads the last page
+    MAKE_CONS(right, stringToValue("i2990"));
+    MAKE_ATTRREF(left, 0);
+    MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+    MAKE_UNOP_EXPR(last, sel, OP_BOOL_NOT);
+    numMatches = countScan(table, last, &numReadIO);
+    ASSERT_EQUALS_INT(10, numMatches, "scan a >= 2990");
+    ASSERT_EQUALS_INT(1, numReadIO, "scan a >= 2990 reads one page");
+
+    // an update widens the bounds of its page, a delete narrows them again
+    r = testRecord(schema, -1, "aaaa", 0);
+    r->id = rids[numInserts-1];
+    TEST_CHECK(updateRecord(table, r));
+    freeRecord(r);
+    numMatches = countScan(table, first, &numReadIO);
+    ASSERT_EQUALS_INT(101, numMatches, "scan a < 100 after update");
+    TEST_CHECK(deleteRecord(table, rids[numInserts-1]));
+    TEST_CHECK(deleteRecord(table, rids[0]));
+    numMatches = countScan(table, first, &numReadIO);
+    ASSERT_EQUALS_INT(99, numMatches, "scan a < 100 after delete");
+
+    // zone maps that weren't saved cleanly are rebuilt
+    TEST_CHECK(closeTable(table));
+    remove("test_table_z.zm");
+    TEST_CHECK(openTable(table, "test_table_z"));
+    numMatches = countScan(table, first, &numReadIO);
+    ASSERT_EQUALS_INT(99, numMatches, "scan a < 100 after rebuild");
+    numMatches = countScan(table, last, &numReadIO);
+    ASSERT_EQUALS_INT(9, numMatches, "scan a >= 2990 after rebuild");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_z"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeExpr(first);
+    freeExpr(last);
+    free(rids);
+    free(table);
+    TEST_DONE();
+}
+
+void testBloomFilters(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 3000, numMatches, numReadIO, i;
+    char key[5];
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    Expr *sel, *left, *right;
+    testName = "test bloom filters skipping pages";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_b", schema));
+    TEST_CHECK(openTable(table, "test_table_b"));
+
+    // b is a unique key in random order, so zone maps can't skip pages.
+    // the filter is added halfway, so it is built for existing pages
+    for(i = 0; i < numInserts; i++) {
+        if (i == numInserts / 2)
+            TEST_CHECK(addBloomFilter(table, 1));
+        sprintf(key, "%04d", (i * 7919) % numInserts);
+        r = testRecord(schema, i, key, i % 5);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    ASSERT_TRUE(rids[numInserts-1].page > 5, "records span several pages");
+    r = testRecord(schema, -1, "new1", 0);
+    r->id = rids[10];
+    TEST_CHECK(updateRecord(table, r));
+    freeRecord(r);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_b"));
+
+    // b = '1234' only reads the page of that record
+    MAKE_CONS(left, stringToValue("s1234"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+    numMatches = countScan(table, sel, &numReadIO);
+    ASSERT_EQUALS_INT(1, numMatches, "scan b = 1234");
+    ASSERT_TRUE(numReadIO <= 2, "scan b = 1234 reads few pages");
+    freeExpr(sel);
+
+    // b = 'new1' finds the updated record
+    MAKE_CONS(left, stringToValue("snew1"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+    numMatches = countScan(table, sel, &numReadIO);
+    ASSERT_EQUALS_INT(1, numMatches, "scan b = new1");
+    freeExpr(sel);
+
+    // constants longer than b can't match any page
+    MAKE_CONS(left, stringToValue("s12345"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+    numMatches = countScan(table, sel, &numReadIO);
+    ASSERT_EQUALS_INT(0, numMatches, "scan b = 12345");
+    ASSERT_EQUALS_INT(0, numReadIO, "scan b = 12345 reads no pages");
+    freeExpr(sel);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_b"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(rids);
+    free(table);
+    TEST_DONE();
+}
+
+// counts the frames of the buffer pool that are pinned
+static int countPinnedFrames(BM_BufferPool *bm) {
+    int *fixCounts = getFixCounts(bm);
+    int numPinned = 0, i;
+
+    for(i = 0; i < bm->numPages; i++)
+        if (fixCounts[i] > 0)
+            numPinned++;
+    return numPinned;
+}
+
+void testWriteAheadLog(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_TableData *crashed = (RM_TableData *) malloc(sizeof(RM_TableData));
+    LM_LogInfo *logInfo;
+    int numInserts = 1000, numMatches, numReadIO, rc, i;
+    Record *r, *expected;
+    RID *rids;
+    Schema *schema;
+    Expr *all;
+    testName = "test write-ahead log recovering changes after a crash";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_w", schema));
+    TEST_CHECK(openTable(table, "test_table_w"));
+    for(i = 0; i < numInserts / 2; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+
+    // change the table without closing it, so the changes only are in
+    // the log and in the pages the buffer pool happened to write
+    TEST_CHECK(openTable(crashed, "test_table_w"));
+    for(i = numInserts / 2; i < numInserts; i++) {
+        r = testRecord(schema, i, "bbbb", i % 5);
+        TEST_CHECK(insertRecord(crashed,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    r = testRecord(schema, -1, "upd1", 0);
+    r->id = rids[10];
+    TEST_CHECK(updateRecord(crashed, r));
+    freeRecord(r);
+    TEST_CHECK(deleteRecord(crashed, rids[20]));
+    TEST_CHECK(stopCheckpointer(&crashed->mgmtData->checkpointer));
+    TEST_CHECK(dropBufferPool(crashed->bufferPool));
+
+    // opening the table again redoes the log
+    TEST_CHECK(openTable(table, "test_table_w"));
+    ASSERT_EQUALS_INT(numInserts - 1, getNumTuples(table), "numTuples after recovery");
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts - 1, numMatches, "scan after recovery");
+    freeExpr(all);
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(getRecord(table, rids[10], r));
+    expected = testRecord(schema, -1, "upd1", 0);
+    ASSERT_EQUALS_RECORDS(expected, r, schema, "updated record after recovery");
+    freeRecord(expected);
+    TEST_CHECK(getRecord(table, rids[numInserts - 1], r));
+    expected = testRecord(schema, numInserts - 1, "bbbb", (numInserts - 1) % 5);
+    ASSERT_EQUALS_RECORDS(expected, r, schema, "inserted record after recovery");
+    freeRecord(expected);
+    freeRecord(r);
+
+    // the free space of the recovered pages is reused
+    r = testRecord(schema, -2, "cccc", 0);
+    TEST_CHECK(insertRecord(table, r));
+    ASSERT_TRUE(r->id.page <= rids[numInserts - 1].page, "insert reuses recovered pages");
+    freeRecord(r);
+
+    // changes whose log record can't be appended are taken back from
+    // the pages, which are unpinned
+    TEST_CHECK(waitForCheckpoint(&table->mgmtData->checkpointer));
+    logInfo = table->mgmtData->log.mgmtData;
+    table->mgmtData->log.mgmtData = NULL;
+    r = testRecord(schema, -3, "dddd", 0);
+    rc = insertRecord(table, r);
+    ASSERT_EQUALS_INT(RC_LM_LOG_NOT_OPEN, rc, "insert without a log");
+    r->id = rids[30];
+    rc = updateRecord(table, r);
+    ASSERT_EQUALS_INT(RC_LM_LOG_NOT_OPEN, rc, "update without a log");
+    rc = deleteRecord(table, rids[40]);
+    ASSERT_EQUALS_INT(RC_LM_LOG_NOT_OPEN, rc, "delete without a log");
+    table->mgmtData->log.mgmtData = logInfo;
+    ASSERT_EQUALS_INT(0, countPinnedFrames(table->bufferPool), "no page left pinned");
+    ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "numTuples after the failed changes");
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "failed insert not in the table");
+    freeExpr(all);
+    TEST_CHECK(getRecord(table, rids[30], r));
+    expected = testRecord(schema, 30, "aaaa", 0);
+    ASSERT_EQUALS_RECORDS(expected, r, schema, "failed update left the old record");
+    freeRecord(expected);
+    TEST_CHECK(getRecord(table, rids[40], r));
+    expected = testRecord(schema, 40, "aaaa", 0);
+    ASSERT_EQUALS_RECORDS(expected, r, schema, "failed delete left the record");
+    freeRecord(expected);
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_w"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(rids);
+    free(crashed);
+    free(table);
+    TEST_DONE();
+}
+
+#define GROUP_COMMIT_THREADS 8
+#define GROUP_COMMIT_RECORDS 50
+
+// appends and flushes records like concurrent transactions committing
+static void *commitRecords(void *arg) {
+    LM_LogHandle *log = (LM_LogHandle *) arg;
+    char data[16] = "group commit";
+    LM_LogRecord logRecord = {LOG_INSERT, 0, 1, 0, sizeof(data), data, 0, NULL, 0};
+    LM_LSN lsn;
+    int i;
+
+    for(i = 0; i < GROUP_COMMIT_RECORDS; i++) {
+        logRecord.slotNum = i;
+        TEST_CHECK(appendLogRecord(log, &logRecord, &lsn));
+        TEST_CHECK(flushLog(log, lsn));
+        if (getFlushedLsn(log) < lsn)
+            return arg;
+    }
+    return NULL;
+}
+
+// counts the records redone from the log
+static RC countLogRecord(void *context, LM_LogRecord *logRecord) {
+    (*(int *) context)++;
+    return RC_OK;
+}
+
+void testGroupCommit(void) {
+    LM_LogHandle log;
+    pthread_t threads[GROUP_COMMIT_THREADS];
+    void *result;
+    char data[16] = "failed flush";
+    LM_LogRecord logRecord = {LOG_INSERT, 0, 1, 0, sizeof(data), data, 0, NULL, 0};
+    LM_LSN lsn, redoLsn = 0;
+    struct stat st;
+    off_t sizeBefore;
+    int numCommits = GROUP_COMMIT_THREADS * GROUP_COMMIT_RECORDS;
+    int numFlushes, numRecords = 0, fd, rc, i;
+    testName = "test group commit of the write-ahead log";
+
+    destroyLog("test_log");
+    TEST_CHECK(openLog(&log, "test_log"));
+    for(i = 0; i < GROUP_COMMIT_THREADS; i++)
+        pthread_create(&threads[i], NULL, commitRecords, &log);
+    for(i = 0; i < GROUP_COMMIT_THREADS; i++) {
+        pthread_join(threads[i], &result);
+        ASSERT_TRUE(result == NULL, "every commit is durable when flushLog returns");
+    }
+    numFlushes = getNumLogFlushes(&log);
+    ASSERT_EQUALS_INT(numCommits, getNumLogRecords(&log), "records appended");
+    ASSERT_TRUE(numFlushes > 0 && numFlushes <= numCommits, "commits share flushes");
+    TEST_CHECK(closeLog(&log));
+
+    // all records are read back from the file
+    TEST_CHECK(openLog(&log, "test_log"));
+    TEST_CHECK(redoLog(&log, countLogRecord, &numRecords));
+    ASSERT_EQUALS_INT(numCommits, numRecords, "records redone");
+    TEST_CHECK(truncateLog(&log));
+    ASSERT_TRUE(isLogEmpty(&log), "log is empty after truncation");
+    TEST_CHECK(closeLog(&log));
+
+    // a flush that fails keeps its records for the next one
+    TEST_CHECK(openLog(&log, "test_log"));
+    TEST_CHECK(appendLogRecord(&log, &logRecord, &lsn));
+    fd = log.mgmtData->fd;
+    log.mgmtData->fd = open("test_log", O_RDONLY);
+    rc = flushLog(&log, lsn);
+    ASSERT_EQUALS_INT(RC_LM_WRITE_FAILED, rc, "write to a read only log");
+    ASSERT_TRUE(getFlushedLsn(&log) < lsn, "record not durable");
+    close(log.mgmtData->fd);
+    log.mgmtData->fd = fd;
+    TEST_CHECK(appendLogRecord(&log, &logRecord, &lsn));
+    TEST_CHECK(flushLog(&log, lsn));
+    TEST_CHECK(closeLog(&log));
+    numRecords = 0;
+    TEST_CHECK(openLog(&log, "test_log"));
+    TEST_CHECK(redoLog(&log, countLogRecord, &numRecords));
+    ASSERT_EQUALS_INT(2, numRecords, "failed record written by the next flush");
+
+    // a checkpoint drops the records before it once they outweigh the rest
+    for(i = 0; i < 10; i++) {
+        TEST_CHECK(appendLogRecord(&log, &logRecord, &lsn));
+        if (i == 7)
+            redoLsn = lsn;
+    }
+    TEST_CHECK(flushLog(&log, lsn));
+    stat("test_log", &st);
+    sizeBefore = st.st_size;
+    TEST_CHECK(setRedoLsn(&log, redoLsn));
+    ASSERT_EQUALS_INT(1, getNumLogRecycles(&log), "log recycled");
+    stat("test_log", &st);
+    // 10 records before the checkpoint are dropped, 2 after it are kept
+    ASSERT_EQUALS_INT(5 * (int) (lsn - redoLsn), (int) (sizeBefore - st.st_size), "records before the checkpoint dropped");
+    TEST_CHECK(appendLogRecord(&log, &logRecord, &lsn));
+    TEST_CHECK(closeLog(&log));
+    numRecords = 0;
+    TEST_CHECK(openLog(&log, "test_log"));
+    TEST_CHECK(redoLog(&log, countLogRecord, &numRecords));
+    ASSERT_EQUALS_INT(3, numRecords, "records after the checkpoint redone");
+    ASSERT_EQUALS_INT((int) redoLsn, (int) getRedoLsn(&log), "redo LSN kept");
+    TEST_CHECK(closeLog(&log));
+    TEST_CHECK(destroyLog("test_log"));
+
+    TEST_DONE();
+}
+
+void testCheckpoints(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_TableData *crashed = (RM_TableData *) malloc(sizeof(RM_TableData));
+    BM_PageHandle page;
+    int numInserts = 3000, numAfter = 10, numRedone, rc, i;
+    struct stat st;
+    Record *r;
+    Schema *schema;
+    testName = "test checkpoints bounding the log to redo";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_c", schema));
+    TEST_CHECK(openTable(crashed, "test_table_c"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(crashed,r));
+        freeRecord(r);
+    }
+    // the log grew enough for a checkpoint on its own before this one
+    TEST_CHECK(checkpointTable(crashed));
+    ASSERT_TRUE(getNumCheckpoints(&crashed->mgmtData->checkpointer) > 1, "checkpoints began on their own");
+    ASSERT_TRUE(getNumCheckpointPages(&crashed->mgmtData->checkpointer) > 0, "checkpoint wrote dirty pages");
+    ASSERT_TRUE(getCheckpointDuration(&crashed->mgmtData->checkpointer) >= 0, "checkpoint was timed");
+    ASSERT_EQUALS_INT(0, (int) getRedoSize(&crashed->mgmtData->log), "nothing to redo after checkpoint");
+    ASSERT_TRUE(getNumLogRecycles(&crashed->mgmtData->log) > 0, "checkpoints dropped the records before them");
+    stat("test_table_c.wal", &st);
+    ASSERT_TRUE(st.st_size < PAGE_SIZE, "log of the open table doesn't grow");
+    // a pinned page may still be changed, a checkpoint can't take it as clean
+    TEST_CHECK(pinPage(crashed->bufferPool, &page, 1));
+    rc = writeDirtyPage(crashed->bufferPool, 1);
+    ASSERT_EQUALS_INT(RC_BM_PAGE_PINNED, rc, "pinned clean page is retried");
+    TEST_CHECK(unpinPage(crashed->bufferPool, &page));
+    for(i = 0; i < numAfter; i++) {
+        r = testRecord(schema, numInserts + i, "bbbb", 0);
+        TEST_CHECK(insertRecord(crashed,r));
+        freeRecord(r);
+    }
+    TEST_CHECK(stopCheckpointer(&crashed->mgmtData->checkpointer));
+    TEST_CHECK(dropBufferPool(crashed->bufferPool));
+
+    // only the changes after the checkpoint are redone
+    TEST_CHECK(openTable(table, "test_table_c"));
+    numRedone = getNumRedoRecords(&table->mgmtData->log);
+    ASSERT_EQUALS_INT(numAfter, numRedone, "records redone after checkpoint");
+    ASSERT_EQUALS_INT(numInserts + numAfter, getNumTuples(table), "numTuples after recovery");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_c"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(crashed);
+    free(table);
+    TEST_DONE();
+}
+
+// remembers the pages written by the pool, fails while *context is -2
+static RC recordWrite(void *context, BM_PageHandle *const page) {
+    int *lastWritten = (int *) context;
+    if (*lastWritten == -2)
+        return RC_WRITE_FAILED;
+    *lastWritten = page->pageNum;
+    return RC_OK;
+}
+
+// fails unless the pool is unlocked while the page is written
+static RC checkPoolUnlocked(void *context, BM_PageHandle *const page) {
+    BM_BufferPool *bm = (BM_BufferPool *) context;
+    if (pthread_mutex_trylock(&bm->mgmtData->mutex) != 0)
+        return RC_WRITE_FAILED;
+    pthread_mutex_unlock(&bm->mgmtData->mutex);
+    return RC_OK;
+}
+
+void testBeforeWriteHook(void) {
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    int lastWritten = NO_PAGE, rc;
+    testName = "test buffer pool calling the hook before writing a page";
+
+    TEST_CHECK(createPageFile("test_pool"));
+    TEST_CHECK(openPageFile("test_pool", &fh));
+    TEST_CHECK(ensureCapacity(4, &fh));
+    TEST_CHECK(closePageFile(&fh));
+    TEST_CHECK(initBufferPool(bm, "test_pool", 2, RS_FIFO, NULL));
+    TEST_CHECK(setBeforeWriteHook(bm, recordWrite, &lastWritten));
+
+    // evicting a dirty page calls the hook for it
+    TEST_CHECK(pinPage(bm, h, 0));
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+    TEST_CHECK(pinPage(bm, h, 1));
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+    TEST_CHECK(pinPage(bm, h, 2));
+    TEST_CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(0, lastWritten, "hook called before evicting page 0");
+
+    // a page whose hook fails isn't written or evicted
+    lastWritten = -2;
+    rc = pinPage(bm, h, 3);
+    ASSERT_EQUALS_INT(RC_WRITE_FAILED, rc, "pinPage fails if the victim can't be written");
+    ASSERT_TRUE(getDirtyFlags(bm)[1], "victim is still dirty");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm) - 1, "only page 0 was written");
+
+    lastWritten = NO_PAGE;
+    TEST_CHECK(shutdownBufferPool(bm));
+    ASSERT_EQUALS_INT(1, lastWritten, "hook called before flushing page 1");
+
+    // pinPage writes the victim with the pool unlocked
+    TEST_CHECK(initBufferPool(bm, "test_pool", 1, RS_FIFO, NULL));
+    TEST_CHECK(setBeforeWriteHook(bm, checkPoolUnlocked, bm));
+    TEST_CHECK(pinPage(bm, h, 0));
+    TEST_CHECK(markDirty(bm, h));
+    TEST_CHECK(unpinPage(bm, h));
+    TEST_CHECK(pinPage(bm, h, 1));
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "victim written without the pool's mutex");
+    TEST_CHECK(unpinPage(bm, h));
+    TEST_CHECK(shutdownBufferPool(bm));
+    TEST_CHECK(destroyPageFile("test_pool"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+void testTransactions(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_TableData *crashed = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    RM_Transaction tx, other;
+    RM_Config config;
+    RM_TableConfig tableConfig;
+    FILE *file;
+    int numInserts = 100, numFailInserts = 1500, numMatches, numReadIO, oldValue = -1, value, rc, i;
+    Record *r, *rec;
+    RID *rids, first, last;
+    Schema *schema;
+    Expr *all;
+    testName = "test transactions with snapshot reads";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_t", schema));
+    TEST_CHECK(openTable(table, "test_table_t"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    MAKE_CONS(all, stringToValue("btrue"));
+    TEST_CHECK(createRecord(&rec, schema));
+
+    // a scan keeps reading the records committed before it started
+    TEST_CHECK(startScan(table, sc, all));
+    TEST_CHECK(beginTransaction(table, &tx));
+    r = testRecord(schema, -1, "upd1", 0);
+    r->id = rids[0];
+    TEST_CHECK(updateRecordTx(&tx, r));
+    freeRecord(r);
+    TEST_CHECK(deleteRecordTx(&tx, rids[1]));
+    r = testRecord(schema, numInserts, "new1", 0);
+    TEST_CHECK(insertRecordTx(&tx, r));
+    freeRecord(r);
+    TEST_CHECK(commitTransaction(&tx));
+    numMatches = 0;
+    while((rc = next(sc, rec)) == RC_OK) {
+        numMatches++;
+        if (rec->id.page == rids[0].page && rec->id.slot == rids[0].slot)
+            oldValue = getAttrInt(rec, schema, 0);
+    }
+    ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "no error after last tuple");
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan sees the records of its snapshot");
+    ASSERT_EQUALS_INT(0, oldValue, "scan sees the record before the update");
+    TEST_CHECK(closeScan(sc));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan after the commit");
+    TEST_CHECK(getRecord(table, rids[0], rec));
+    value = getAttrInt(rec, schema, 0);
+    ASSERT_EQUALS_INT(-1, value, "committed update is visible");
+
+    // changes are only visible to their transaction until it commits,
+    // and a record changed after the snapshot can't be changed
+    TEST_CHECK(beginTransaction(table, &tx));
+    TEST_CHECK(beginTransaction(table, &other));
+    r = testRecord(schema, -2, "upd2", 0);
+    r->id = rids[2];
+    TEST_CHECK(updateRecordTx(&tx, r));
+    freeRecord(r);
+    TEST_CHECK(getRecordTx(&tx, rids[2], rec));
+    value = getAttrInt(rec, schema, 0);
+    ASSERT_EQUALS_INT(-2, value, "transaction sees its own update");
+    TEST_CHECK(getRecordTx(&other, rids[2], rec));
+    value = getAttrInt(rec, schema, 0);
+    ASSERT_EQUALS_INT(2, value, "other transaction doesn't see the update");
+    TEST_CHECK(getRecord(table, rids[2], rec));
+    value = getAttrInt(rec, schema, 0);
+    ASSERT_EQUALS_INT(2, value, "uncommitted update isn't visible outside");
+    TEST_CHECK(commitTransaction(&tx));
+    r = testRecord(schema, -3, "upd3", 0);
+    r->id = rids[2];
+    rc = updateRecordTx(&other, r);
+    ASSERT_EQUALS_INT(RC_RM_WRITE_CONFLICT, rc, "first updater wins");
+    TEST_CHECK(abortTransaction(&other));
+
+    // aborting restores the records
+    TEST_CHECK(beginTransaction(table, &tx));
+    r->id = rids[3];
+    TEST_CHECK(updateRecordTx(&tx, r));
+    freeRecord(r);
+    TEST_CHECK(deleteRecordTx(&tx, rids[4]));
+    r = testRecord(schema, numInserts + 1, "new2", 0);
+    TEST_CHECK(insertRecordTx(&tx, r));
+    freeRecord(r);
+    TEST_CHECK(abortTransaction(&tx));
+    TEST_CHECK(getRecord(table, rids[3], rec));
+    value = getAttrInt(rec, schema, 0);
+    ASSERT_EQUALS_INT(3, value, "aborted update is undone");
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "aborted insert and delete are undone");
+    ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "numTuples after abort");
+    TEST_CHECK(closeTable(table));
+
+    // recovery undoes the changes of transactions that didn't commit,
+    // even if they reached the page file
+    TEST_CHECK(openTable(crashed, "test_table_t"));
+    TEST_CHECK(beginTransaction(crashed, &tx));
+    r = testRecord(schema, -4, "upd4", 0);
+    r->id = rids[5];
+    TEST_CHECK(updateRecordTx(&tx, r));
+    freeRecord(r);
+    TEST_CHECK(deleteRecordTx(&tx, rids[6]));
+    r = testRecord(schema, numInserts + 2, "new3", 0);
+    TEST_CHECK(insertRecordTx(&tx, r));
+    freeRecord(r);
+    TEST_CHECK(forceFlushPool(crashed->bufferPool));
+    TEST_CHECK(stopCheckpointer(&crashed->mgmtData->checkpointer));
+    TEST_CHECK(dropBufferPool(crashed->bufferPool));
+    free(tx.writes);
+    TEST_CHECK(releaseLocks(getLockManager(), &tx.locks));
+
+    TEST_CHECK(openTable(table, "test_table_t"));
+    TEST_CHECK(getRecord(table, rids[5], rec));
+    value = getAttrInt(rec, schema, 0);
+    ASSERT_EQUALS_INT(5, value, "uncommitted update undone by recovery");
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "uncommitted insert undone by recovery");
+    ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "numTuples after recovery");
+    freeExpr(all);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_t"));
+    TEST_CHECK(shutdownRecordManager());
+
+    // a commit that fails is aborted, the deletes it applied too, and
+    // its locks are released
+    initConfig(&config);
+    config.pageChecksums = true;
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(createTable("test_table_tf", schema));
+    tableConfig = config.tableDefaults;
+    tableConfig.numPoolFrames = 3;
+    TEST_CHECK(openTableEx(table, "test_table_tf", &tableConfig));
+    free(rids);
+    rids = (RID *) malloc(sizeof(RID) * numFailInserts);
+    for(i = 0; i < numFailInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    first = rids[0];
+    last = rids[numFailInserts - 1];
+    ASSERT_TRUE(last.page > 3, "records on more pages than the pool has frames");
+    TEST_CHECK(beginTransaction(table, &tx));
+    TEST_CHECK(deleteRecordTx(&tx, first));
+    TEST_CHECK(deleteRecordTx(&tx, last));
+    // the page of the second delete is evicted and corrupted on disk
+    TEST_CHECK(forceFlushPool(table->bufferPool));
+    for(i = 0; i < numFailInserts; i++)
+        if(rids[i].page != last.page)
+            TEST_CHECK(getRecord(table, rids[i], rec));
+    file = fopen("test_table_tf", "rb+");
+    fseek(file, SM_FILE_HEADER_SIZE + (long) last.page * PAGE_SIZE + 100, SEEK_SET);
+    value = fgetc(file);
+    fseek(file, SM_FILE_HEADER_SIZE + (long) last.page * PAGE_SIZE + 100, SEEK_SET);
+    fputc(~value & 0xff, file);
+    fclose(file);
+    rc = commitTransaction(&tx);
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, rc, "delete on a corrupted page");
+    rc = abortTransaction(&tx);
+    ASSERT_EQUALS_INT(RC_RM_INIT_ERROR, rc, "the failed commit ended the transaction");
+    TEST_CHECK(getRecord(table, first, rec));
+    ASSERT_EQUALS_INT(0, getAttrInt(rec, schema, 0), "applied delete undone");
+    ASSERT_EQUALS_INT(numFailInserts, getNumTuples(table), "numTuples after the failed commit");
+    TEST_CHECK(beginTransaction(table, &other));
+    TEST_CHECK(deleteRecordTx(&other, first));
+    TEST_CHECK(abortTransaction(&other));
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_tf"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeRecord(rec);
+    free(rids);
+    free(sc);
+    free(crashed);
+    free(table);
+    TEST_DONE();
+}
+
+// updates a record for a transaction, aborting it if it is a deadlock victim
+typedef struct LockedUpdate {
+    RM_Transaction *tx;
+    Record *record;
+    int rc;
+} LockedUpdate;
+
+static void *updateInThread(void *arg) {
+    LockedUpdate *update = (LockedUpdate *) arg;
+    update->rc = updateRecordTx(update->tx, update->record);
+    if (update->rc == RC_LK_DEADLOCK)
+        abortTransaction(update->tx);
+    return NULL;
+}
+
+void testLockManager(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_Transaction tx, other;
+    LK_Owner first, second;
+    LK_ResourceId resource = {1, 0, 0};
+    LockedUpdate update;
+    pthread_t thread;
+    int numDeadlocks, value, rc;
+    Record *r1, *r2, *rec;
+    RID rids[2];
+    Schema *schema;
+    testName = "test record locks and deadlock detection";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_l", schema));
+    TEST_CHECK(openTable(table, "test_table_l"));
+    r1 = testRecord(schema, 1, "aaaa", 1);
+    TEST_CHECK(insertRecord(table, r1));
+    rids[0] = r1->id;
+    r2 = testRecord(schema, 2, "bbbb", 2);
+    TEST_CHECK(insertRecord(table, r2));
+    rids[1] = r2->id;
+
+    // shared and intention locks don't block each other
+    initLockOwner(getLockManager(), &first);
+    initLockOwner(getLockManager(), &second);
+    TEST_CHECK(lockResource(getLockManager(), &first, resource, LOCK_S));
+    TEST_CHECK(lockResource(getLockManager(), &second, resource, LOCK_S));
+    resource.page = -1;
+    resource.slot = -1;
+    TEST_CHECK(lockResource(getLockManager(), &first, resource, LOCK_IX));
+    TEST_CHECK(lockResource(getLockManager(), &second, resource, LOCK_IX));
+    TEST_CHECK(releaseLocks(getLockManager(), &first));
+    TEST_CHECK(releaseLocks(getLockManager(), &second));
+
+    // tx and other each wait for a record the other one changed, the
+    // younger transaction (other) gets RC_LK_DEADLOCK
+    TEST_CHECK(beginTransaction(table, &tx));
+    TEST_CHECK(beginTransaction(table, &other));
+    TEST_CHECK(updateRecordTx(&tx, r1));
+    TEST_CHECK(updateRecordTx(&other, r2));
+    update.tx = &other;
+    update.record = r1;
+    update.rc = RC_OK;
+    pthread_create(&thread, NULL, updateInThread, &update);
+    usleep(20000);
+    rc = updateRecordTx(&tx, r2);
+    pthread_join(thread, NULL);
+    ASSERT_EQUALS_INT(RC_OK, rc, "older transaction gets the lock");
+    ASSERT_EQUALS_INT(RC_LK_DEADLOCK, update.rc, "younger transaction is the victim");
+    numDeadlocks = getNumDeadlocks(getLockManager());
+    ASSERT_TRUE(numDeadlocks >= 1, "deadlock counted");
+    TEST_CHECK(commitTransaction(&tx));
+
+    // the locks of both transactions are released
+    freeRecord(r1);
+    r1 = testRecord(schema, 10, "cccc", 1);
+    r1->id = rids[0];
+    TEST_CHECK(updateRecord(table, r1));
+    TEST_CHECK(createRecord(&rec, schema));
+    TEST_CHECK(getRecord(table, rids[0], rec));
+    value = getAttrInt(rec, schema, 0);
+    ASSERT_EQUALS_INT(10, value, "record unlocked after commit");
+    TEST_CHECK(deleteRecord(table, rids[1]));
+
+    freeRecord(rec);
+    freeRecord(r1);
+    freeRecord(r2);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_l"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    TEST_DONE();
+}
+
+void testSharedBufferPool(void) {
+    RM_TableData *first = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_TableData *second = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_Config config = {8, RS_CLOCK, NULL};
+    int numInserts = 3000, numMatches, numReadIO, numEmpty, i;
+    PageNumber *frameContents;
+    Record *r;
+    Schema *schema;
+    Expr *all;
+    testName = "test buffer pool shared by all tables";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(&config));
+    ASSERT_EQUALS_INT(8, getSharedPool()->numPages, "pool size from the config");
+    TEST_CHECK(createTable("test_table_s1", schema));
+    TEST_CHECK(createTable("test_table_s2", schema));
+    TEST_CHECK(openTable(first, "test_table_s1"));
+    TEST_CHECK(openTable(second, "test_table_s2"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(first, r));
+        TEST_CHECK(insertRecord(second, r));
+        freeRecord(r);
+    }
+
+    // both tables have more pages than the pool has frames
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(second, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "all records of the second table");
+    ASSERT_TRUE(numReadIO > 0, "pages of the second table were read back");
+    numMatches = countScan(first, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "all records of the first table");
+    ASSERT_TRUE(numReadIO > 0, "pages of the first table were read back");
+
+    // a closed table gives its frames back
+    TEST_CHECK(closeTable(first));
+    frameContents = getFrameContents(getSharedPool());
+    numEmpty = 0;
+    for(i = 0; i < getSharedPool()->numPages; i++)
+        if (frameContents[i] == NO_PAGE)
+            numEmpty++;
+    ASSERT_TRUE(numEmpty > 0, "frames of the closed table are empty");
+    numMatches = countScan(second, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "second table after closing the first");
+
+    freeExpr(all);
+    TEST_CHECK(closeTable(second));
+    TEST_CHECK(deleteTable("test_table_s1"));
+    TEST_CHECK(deleteTable("test_table_s2"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(first);
+    free(second);
+    TEST_DONE();
+}
+
+void testConfig(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_Config config;
+    RM_TableConfig tableConfig;
+    RM_TableConfig *loaded;
+    SM_FileHandle fHandle;
+    FILE *file;
+    int numInserts = 2000, numMatches, numReadIO, rc, i, numFiles;
+    Record *r;
+    Schema *schema;
+    Expr *all;
+    testName = "test record manager configuration";
+    schema = testSchema();
+
+    file = fopen("test_config.cfg", "w");
+    fprintf(file, "# pool of all tables\n");
+    fprintf(file, "shared_pool_frames = 64\n");
+    fprintf(file, "shared_pool_strategy = clock\n");
+    fprintf(file, "huge_pages = transparent\n");
+    fprintf(file, "direct_io = on\n");
+    fprintf(file, "file_extent_size = 8388608\n");
+    fprintf(file, "page_checksums = on\n");
+    fprintf(file, "file_segment_size = 2147483648\n");
+    fprintf(file, "segment_dirs = .\n");
+    fprintf(file, "catalog_file = test_config.cat\n");
+    fprintf(file, "prefetch_depth = 2\n\n");
+    fprintf(file, "[table test_table_cfg]\n");
+    fprintf(file, "  pool_frames = 20   # working set\n");
+    fprintf(file, "pool_strategy = fifo\n");
+    fprintf(file, "prefetch_depth = 4\n");
+    fprintf(file, "checkpoint_write_delay = 10\n");
+    fprintf(file, "[table test_table_ref]\n");
+    fprintf(file, "read_only = on\n");
+    fprintf(file, "page_size = 65536\n");
+    fclose(file);
+    TEST_CHECK(loadConfig("test_config.cfg", &config));
+    ASSERT_EQUALS_INT(64, config.numPoolFrames, "shared pool frames");
+    ASSERT_EQUALS_INT(RS_CLOCK, config.poolStrategy, "shared pool strategy");
+    ASSERT_EQUALS_INT(BM_HUGE_PAGES_TRANSPARENT, config.hugePages, "huge pages");
+    ASSERT_TRUE(config.directIO, "direct IO");
+    ASSERT_EQUALS_INT(8388608, (int) config.extentSize, "file extent size");
+    ASSERT_TRUE(config.pageChecksums, "page checksums");
+    ASSERT_TRUE(config.segmentSize == 2147483648L, "file segment size");
+    ASSERT_TRUE(strcmp(config.segmentDirs, ".") == 0, "segment directories");
+    ASSERT_TRUE(strcmp(config.catalogFile, "test_config.cat") == 0, "catalog file");
+    ASSERT_EQUALS_INT(2, config.tableDefaults.prefetchDepth, "default prefetch depth");
+    loaded = getTableConfig(&config, "test_table_cfg");
+    ASSERT_EQUALS_INT(20, loaded->numPoolFrames, "table pool frames");
+    ASSERT_EQUALS_INT(RS_FIFO, loaded->poolStrategy, "table pool strategy");
+    ASSERT_EQUALS_INT(4, loaded->prefetchDepth, "table prefetch depth");
+    ASSERT_EQUALS_INT(RM_DEFAULT_CHECKPOINT_LOG_SIZE, (int) loaded->checkpointLogSize,
+                      "table keeps the default checkpoint log size");
+    ASSERT_TRUE(!loaded->readOnly, "tables are writable by default");
+    loaded = getTableConfig(&config, "test_table_ref");
+    ASSERT_TRUE(loaded->readOnly, "read-only table");
+    ASSERT_EQUALS_INT(65536, loaded->pageSize, "table page size");
+    loaded = getTableConfig(&config, "other_table");
+    ASSERT_EQUALS_INT(0, loaded->numPoolFrames, "other tables use the shared pool");
+
+    // tables are opened with the settings of their section
+    TEST_CHECK(initRecordManager(&config));
+    freeConfig(&config);
+    ASSERT_EQUALS_INT(64, getSharedPool()->numPages, "shared pool from the file");
+    TEST_CHECK(createTable("test_table_cfg", schema));
+    TEST_CHECK(openTable(table, "test_table_cfg"));
+    ASSERT_EQUALS_INT(20, table->bufferPool->numPages, "private pool from the section");
+    ASSERT_EQUALS_INT(RS_FIFO, table->bufferPool->strategy, "strategy from the section");
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table, r));
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+
+    // openTableEx overrides the configuration, scans read ahead
+    initConfig(&config);
+    tableConfig = config.tableDefaults;
+    tableConfig.numPoolFrames = 5;
+    tableConfig.prefetchDepth = 3;
+    TEST_CHECK(openTableEx(table, "test_table_cfg", &tableConfig));
+    ASSERT_EQUALS_INT(5, table->bufferPool->numPages, "private pool from openTableEx");
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan with prefetching");
+    ASSERT_TRUE(numReadIO > 0, "pages read ahead");
+    freeExpr(all);
+    TEST_CHECK(closeTable(table));
+
+    // a table that fails to open is detached from the shared pool again
+    remove("test_table_cfg.wal");
+    mkdir("test_table_cfg.wal", 0755);
+    rc = openTableEx(table, "test_table_cfg", &config.tableDefaults);
+    ASSERT_TRUE(rc != RC_OK, "the log can't be opened");
+    numFiles = 0;
+    for(i = 0; i < getSharedPool()->mgmtData->numFiles; i++)
+        numFiles += getSharedPool()->mgmtData->files[i].pageFile != NULL;
+    ASSERT_EQUALS_INT(0, numFiles, "no table attached to the shared pool");
+    rmdir("test_table_cfg.wal");
+    TEST_CHECK(openTableEx(table, "test_table_cfg", &config.tableDefaults));
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_cfg"));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(destroyPageFile("test_config.cat"));
+
+    // a record manager that fails to start sets the storage defaults again
+    initConfig(&config);
+    config.numPoolFrames = 0;
+    config.pageChecksums = true;
+    rc = initRecordManager(&config);
+    ASSERT_EQUALS_INT(RC_INVALID_PAGE_NUMBER, rc, "shared pool without frames");
+    TEST_CHECK(createPageFile("test_config.bin"));
+    TEST_CHECK(openPageFile("test_config.bin", &fHandle));
+    ASSERT_TRUE(!hasPageChecksums(&fHandle), "page checksums off again");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile("test_config.bin"));
+    TEST_CHECK(initRecordManager(NULL));
+    ASSERT_EQUALS_INT(RM_DEFAULT_POOL_FRAMES, getSharedPool()->numPages, "started after the failure");
+    TEST_CHECK(shutdownRecordManager());
+
+    // a line that can't be parsed fails the whole file
+    file = fopen("test_config.cfg", "w");
+    fprintf(file, "prefetch_depth = many\n");
+    fclose(file);
+    rc = loadConfig("test_config.cfg", &config);
+    ASSERT_EQUALS_INT(RC_RM_CONFIG_ERROR, rc, "invalid value");
+    remove("test_config.cfg");
+
+    free(table);
+    TEST_DONE();
+}
+
+void testResizeBufferPool(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_Config config = {8, RS_LRU, NULL};
+    ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK};
+    BM_BufferPool bm;
+    BM_PageHandle page, pinned, tail;
+    SM_FileHandle fHandle;
+    char buffer[PAGE_SIZE];
+    char *data;
+    int numInserts = 1000, numMatches, numReadIO, numWriteIO, s, i;
+    Record *r;
+    Schema *schema;
+    Expr *all;
+    testName = "test resizing buffer pools";
+
+    TEST_CHECK(createPageFile("test_resize.bin"));
+    TEST_CHECK(openPageFile("test_resize.bin", &fHandle));
+    TEST_CHECK(ensureCapacity(20, &fHandle));
+    TEST_CHECK(closePageFile(&fHandle));
+    for(s = 0; s < 3; s++) {
+        TEST_CHECK(initBufferPool(&bm, "test_resize.bin", 2, strategies[s], NULL));
+        TEST_CHECK(pinPage(&bm, &pinned, 0));
+        sprintf(pinned.data, "page-0");
+        TEST_CHECK(markDirty(&bm, &pinned));
+        data = pinned.data;
+
+        // growing keeps pinned pages where they are
+        TEST_CHECK(resizeBufferPool(&bm, 8));
+        ASSERT_EQUALS_INT(8, bm.numPages, "pool grew");
+        ASSERT_TRUE(pinned.data == data && strcmp(data, "page-0") == 0, "pinned page didn't move");
+        for(i = 1; i < 8; i++) {
+            TEST_CHECK(pinPage(&bm, &page, i));
+            sprintf(page.data, "page-%i", i);
+            TEST_CHECK(markDirty(&bm, &page));
+            TEST_CHECK(unpinPage(&bm, &page));
+        }
+        ASSERT_EQUALS_INT(0, getNumWriteIO(&bm), "new frames used before replacing");
+
+        // shrinking writes the dirty pages of the dropped frames
+        TEST_CHECK(resizeBufferPool(&bm, 4));
+        ASSERT_EQUALS_INT(4, bm.numPages, "pool shrank");
+        ASSERT_EQUALS_INT(4, getNumWriteIO(&bm), "dropped frames written");
+        ASSERT_TRUE(strcmp(pinned.data, "page-0") == 0, "pinned page kept");
+
+        // a pinned page in a frame to drop is retired, the pool shrinks
+        // at once and the frame is written and let go of when unpinned
+        TEST_CHECK(resizeBufferPool(&bm, 6));
+        TEST_CHECK(pinPage(&bm, &tail, 12));
+        sprintf(tail.data, "page-12");
+        TEST_CHECK(markDirty(&bm, &tail));
+        TEST_CHECK(resizeBufferPool(&bm, 4));
+        ASSERT_EQUALS_INT(4, bm.numPages, "pool shrank with a pinned frame");
+        ASSERT_TRUE(bm.mgmtData->numFrames > 4, "pinned frame retired");
+        TEST_CHECK(pinPage(&bm, &page, 12));
+        ASSERT_TRUE(page.data == tail.data, "retired frame still found");
+        TEST_CHECK(unpinPage(&bm, &page));
+        numWriteIO = getNumWriteIO(&bm);
+        TEST_CHECK(unpinPage(&bm, &tail));
+        ASSERT_EQUALS_INT(numWriteIO + 1, getNumWriteIO(&bm), "retired frame written when unpinned");
+        ASSERT_EQUALS_INT(4, bm.mgmtData->numFrames, "retired frame released");
+        for(i = 10; i < 20; i++) {
+            TEST_CHECK(pinPage(&bm, &page, i));
+            TEST_CHECK(unpinPage(&bm, &page));
+        }
+        TEST_CHECK(unpinPage(&bm, &pinned));
+        TEST_CHECK(shutdownBufferPool(&bm));
+
+        TEST_CHECK(openPageFile("test_resize.bin", &fHandle));
+        for(i = 0; i < 8; i++) {
+            char expected[PAGE_SIZE];
+            sprintf(expected, "page-%i", i);
+            TEST_CHECK(readBlock(i, &fHandle, buffer));
+            ASSERT_TRUE(strcmp(buffer, expected) == 0, "page written before or at shutdown");
+        }
+        TEST_CHECK(readBlock(12, &fHandle, buffer));
+        ASSERT_TRUE(strcmp(buffer, "page-12") == 0, "page of the retired frame written");
+        TEST_CHECK(closePageFile(&fHandle));
+    }
+    TEST_CHECK(destroyPageFile("test_resize.bin"));
+
+    // handles of the shared pool follow its size
+    schema = testSchema();
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(createTable("test_table_rs", schema));
+    TEST_CHECK(openTable(table, "test_table_rs"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table, r));
+        freeRecord(r);
+    }
+    TEST_CHECK(resizeBufferPool(getSharedPool(), 64));
+    ASSERT_EQUALS_INT(64, table->bufferPool->numPages, "table sees the grown pool");
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan after growing");
+    TEST_CHECK(resizeBufferPool(getSharedPool(), 4));
+    ASSERT_EQUALS_INT(4, table->bufferPool->numPages, "table sees the shrunk pool");
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan after shrinking");
+
+    freeExpr(all);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_rs"));
+    TEST_CHECK(shutdownRecordManager());
+    free(table);
+    TEST_DONE();
+}
+
+void testFrameArena(void) {
+    BM_HugePages modes[] = {BM_HUGE_PAGES_NONE, BM_HUGE_PAGES_TRANSPARENT, BM_HUGE_PAGES_EXPLICIT};
+    BM_BufferPool bm;
+    BM_PageHandle page;
+    int numAligned, m, i;
+    testName = "test page aligned frames and frame descriptors";
+
+    ASSERT_EQUALS_INT(32, (int) sizeof(BM_FrameDesc), "two descriptors per cache line");
+    TEST_CHECK(createPageFile("test_arena.bin"));
+    for(m = 0; m < 3; m++) {
+        // explicit huge pages fall back to normal pages if none are reserved
+        setHugePages(modes[m]);
+        TEST_CHECK(initBufferPool(&bm, "test_arena.bin", 16, RS_LRU, NULL));
+        numAligned = 0;
+        for(i = 0; i < 32; i++) {
+            TEST_CHECK(pinPage(&bm, &page, i));
+            if (((size_t) page.data) % PAGE_SIZE == 0)
+                numAligned++;
+            sprintf(page.data, "page-%i", i);
+            TEST_CHECK(markDirty(&bm, &page));
+            TEST_CHECK(unpinPage(&bm, &page));
+        }
+        ASSERT_EQUALS_INT(32, numAligned, "frames are page aligned");
+        TEST_CHECK(resizeBufferPool(&bm, 40));
+        TEST_CHECK(pinPage(&bm, &page, 3));
+        ASSERT_TRUE(((size_t) page.data) % PAGE_SIZE == 0 && strcmp(page.data, "page-3") == 0,
+                    "frames of a new chunk are page aligned");
+        TEST_CHECK(unpinPage(&bm, &page));
+        TEST_CHECK(shutdownBufferPool(&bm));
+    }
+    setHugePages(BM_HUGE_PAGES_NONE);
+    TEST_CHECK(destroyPageFile("test_arena.bin"));
+    TEST_DONE();
+}
+
+void testDirectIO(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_Config config = {8, RS_LRU, NULL, BM_HUGE_PAGES_NONE, true};
+    SM_FileHandle fHandle;
+    char *memory = (char *) malloc(PAGE_SIZE + 1);
+    char *unaligned = memory + 1;
+    int numInserts = 1000, numMatches, numReadIO, i;
+    Record *r;
+    Schema *schema;
+    Expr *all;
+    testName = "test direct IO";
+
+    // falls back to the buffered descriptor if the file system refuses O_DIRECT
+    setDirectIO(true);
+    TEST_CHECK(createPageFile("test_direct.bin"));
+    TEST_CHECK(openPageFile("test_direct.bin", &fHandle));
+    for(i = 0; i < 8; i++) {
+        memset(unaligned, 'a' + i, PAGE_SIZE);
+        TEST_CHECK(writeBlock(i, &fHandle, unaligned));
+    }
+    ASSERT_EQUALS_INT(8, fHandle.totalNumPages, "file grew");
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // pages written directly are read back buffered and the other way round
+    setDirectIO(false);
+    TEST_CHECK(openPageFile("test_direct.bin", &fHandle));
+    ASSERT_TRUE(!isDirectIO(&fHandle), "direct IO is opt-in");
+    TEST_CHECK(readBlock(5, &fHandle, unaligned));
+    ASSERT_TRUE(unaligned[0] == 'f' && unaligned[PAGE_SIZE - 1] == 'f', "direct write read buffered");
+    memset(unaligned, 'z', PAGE_SIZE);
+    TEST_CHECK(writeBlock(6, &fHandle, unaligned));
+    TEST_CHECK(closePageFile(&fHandle));
+    setDirectIO(true);
+    TEST_CHECK(openPageFile("test_direct.bin", &fHandle));
+    TEST_CHECK(readBlock(6, &fHandle, unaligned));
+    ASSERT_TRUE(unaligned[0] == 'z' && unaligned[PAGE_SIZE - 1] == 'z', "buffered write read directly");
+    TEST_CHECK(closePageFile(&fHandle));
+    setDirectIO(false);
+    TEST_CHECK(destroyPageFile("test_direct.bin"));
+
+    // tables through a pool smaller than they are
+    schema = testSchema();
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(createTable("test_table_dio", schema));
+    TEST_CHECK(openTable(table, "test_table_dio"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table, r));
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_dio"));
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan with direct IO");
+    ASSERT_TRUE(numReadIO > 0, "pages read directly");
+
+    freeExpr(all);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_dio"));
+    TEST_CHECK(shutdownRecordManager());
+    free(memory);
+    free(table);
+    TEST_DONE();
+}
+
+void testAsyncIO(void) {
+    AIO_Context aio;
+    AIO_Request requests[AIO_TEST_PAGES + 1];
+    AIO_Request *done[AIO_TEST_PAGES];
+    SM_FileHandle fHandle;
+    char *pages = NULL;
+    int numDone, numOk, numMatching, useRing, i;
+    testName = "test asynchronous page IO";
+
+    memset(requests, 0, sizeof(requests));
+    ASSERT_TRUE(posix_memalign((void **) &pages, PAGE_SIZE, AIO_TEST_PAGES * PAGE_SIZE) == 0, "buffers");
+    TEST_CHECK(createPageFile("test_aio.bin"));
+    TEST_CHECK(openPageFile("test_aio.bin", &fHandle));
+    TEST_CHECK(ensureCapacity(AIO_TEST_PAGES, &fHandle));
+    for(useRing = 1; useRing >= 0; useRing--) {
+        // a small queue makes submitting wait for completions
+        TEST_CHECK(initAsyncIO(&aio, 4, useRing));
+        if (!useRing)
+            ASSERT_TRUE(!usesIoUring(&aio), "thread pool forced");
+        for(i = 0; i < AIO_TEST_PAGES; i++) {
+            memset(pages + i * PAGE_SIZE, 'a' + (i + useRing) % 26, PAGE_SIZE);
+            requests[i].op = AIO_WRITE;
+            requests[i].fd = getPageFileFd(&fHandle);
+            requests[i].pageNum = i;
+            requests[i].data = pages + i * PAGE_SIZE;
+            TEST_CHECK(submitPageIO(&aio, &requests[i]));
+        }
+        numDone = numOk = 0;
+        while (numDone < AIO_TEST_PAGES) {
+            int n = waitAsyncIO(&aio, done, AIO_TEST_PAGES);
+            for(i = 0; i < n; i++)
+                if (done[i]->returnCode == RC_OK)
+                    numOk++;
+            numDone += n;
+        }
+        ASSERT_EQUALS_INT(AIO_TEST_PAGES, numOk, "all pages written");
+
+        // read them back, and a page beyond the end of the file
+        memset(pages, 0, AIO_TEST_PAGES * PAGE_SIZE);
+        for(i = 0; i <= AIO_TEST_PAGES; i++) {
+            requests[i].op = AIO_READ;
+            requests[i].fd = getPageFileFd(&fHandle);
+            requests[i].pageNum = i < AIO_TEST_PAGES ? i : AIO_TEST_PAGES + 10;
+            requests[i].data = pages + (i % AIO_TEST_PAGES) * PAGE_SIZE;
+            if (i == AIO_TEST_PAGES)
+                requests[i].data = requests[0].data;
+            TEST_CHECK(submitPageIO(&aio, &requests[i]));
+            if (i == AIO_TEST_PAGES - 1) {
+                numDone = 0;
+                while (numDone < AIO_TEST_PAGES)
+                    numDone += waitAsyncIO(&aio, done, AIO_TEST_PAGES);
+            }
+        }
+        numDone = waitAsyncIO(&aio, done, AIO_TEST_PAGES);
+        ASSERT_EQUALS_INT(1, numDone, "read beyond the end completes");
+        ASSERT_EQUALS_INT(RC_READ_FILE_FAILED, done[0]->returnCode, "read beyond the end fails");
+        numDone = pollAsyncIO(&aio, done, AIO_TEST_PAGES);
+        ASSERT_EQUALS_INT(0, numDone, "nothing left in flight");
+        numMatching = 0;
+        for(i = 1; i < AIO_TEST_PAGES; i++)
+            if (pages[i * PAGE_SIZE] == 'a' + (i + useRing) % 26 &&
+                    pages[(i + 1) * PAGE_SIZE - 1] == 'a' + (i + useRing) % 26)
+                numMatching++;
+        ASSERT_EQUALS_INT(AIO_TEST_PAGES - 1, numMatching, "pages read back");
+        TEST_CHECK(shutdownAsyncIO(&aio));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile("test_aio.bin"));
+    free(pages);
+    TEST_DONE();
+}
+
+void testReadOnlyTable(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_TableData *crashed = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_Config config;
+    RM_TableConfig readOnly;
+    int numInserts = 1000, numMatches, numReadIO, sharedReadIO, i, rc;
+    Record *r, *expected;
+    RID *rids;
+    Schema *schema;
+    Expr *all;
+    testName = "test read-only tables served from a mapping";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    initConfig(&config);
+    readOnly = config.tableDefaults;
+    readOnly.readOnly = true;
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_ro", schema));
+    TEST_CHECK(openTable(table, "test_table_ro"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+
+    // scans and lookups read the mapping, the shared pool isn't used
+    sharedReadIO = getNumReadIO(getSharedPool());
+    TEST_CHECK(openTableEx(table, "test_table_ro", &readOnly));
+    ASSERT_TRUE(table->bufferPool == NULL, "no buffer pool");
+    ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "numTuples");
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan of the mapping");
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(getRecord(table, rids[500], r));
+    expected = testRecord(schema, 500, "aaaa", 0);
+    ASSERT_EQUALS_RECORDS(expected, r, schema, "lookup in the mapping");
+    freeRecord(expected);
+    rc = getNumReadIO(getSharedPool());
+    ASSERT_EQUALS_INT(sharedReadIO, rc, "shared pool bypassed");
+
+    // changes are refused
+    rc = insertRecord(table, r);
+    ASSERT_EQUALS_INT(RC_RM_READ_ONLY, rc, "insert refused");
+    rc = updateRecord(table, r);
+    ASSERT_EQUALS_INT(RC_RM_READ_ONLY, rc, "update refused");
+    rc = deleteRecord(table, rids[0]);
+    ASSERT_EQUALS_INT(RC_RM_READ_ONLY, rc, "delete refused");
+    freeRecord(r);
+    TEST_CHECK(closeTable(table));
+
+    // changes left in the log by a crash are recovered before mapping
+    TEST_CHECK(openTable(crashed, "test_table_ro"));
+    TEST_CHECK(deleteRecord(crashed, rids[20]));
+    TEST_CHECK(stopCheckpointer(&crashed->mgmtData->checkpointer));
+    TEST_CHECK(dropBufferPool(crashed->bufferPool));
+    TEST_CHECK(openTableEx(table, "test_table_ro", &readOnly));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts - 1, numMatches, "scan after recovery");
+    TEST_CHECK(createRecord(&r, schema));
+    rc = getRecord(table, rids[21], r);
+    ASSERT_EQUALS_INT(RC_OK, rc, "lookup after recovery");
+    freeRecord(r);
+
+    freeExpr(all);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_ro"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(rids);
+    free(crashed);
+    free(table);
+    TEST_DONE();
+}
+
+void testVectoredIO(void) {
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fHandle;
+    SM_PageHandle pages[VIO_TEST_PAGES];
+    char *memory = (char *) malloc(VIO_TEST_PAGES * (PAGE_SIZE + 16));
+    int numMatching, numWriteIO, rc, direct, i;
+    testName = "test vectored multi-page IO";
+
+    // pages from buffers that aren't contiguous, or aligned for direct IO
+    for(i = 0; i < VIO_TEST_PAGES; i++)
+        pages[i] = memory + (VIO_TEST_PAGES - 1 - i) * (PAGE_SIZE + 16) + (i % 2);
+    for(direct = 0; direct < 2; direct++) {
+        setDirectIO(direct);
+        TEST_CHECK(createPageFile("test_vio.bin"));
+        TEST_CHECK(openPageFile("test_vio.bin", &fHandle));
+        for(i = 0; i < VIO_TEST_PAGES; i++)
+            memset(pages[i], 'a' + i, PAGE_SIZE);
+        TEST_CHECK(writeBlocks(2, VIO_TEST_PAGES, &fHandle, pages));
+        ASSERT_EQUALS_INT(VIO_TEST_PAGES + 2, fHandle.totalNumPages, "file grew to the last page");
+        for(i = 0; i < VIO_TEST_PAGES; i++)
+            memset(pages[i], 0, PAGE_SIZE);
+        TEST_CHECK(readBlocks(2, VIO_TEST_PAGES, &fHandle, pages));
+        numMatching = 0;
+        for(i = 0; i < VIO_TEST_PAGES; i++)
+            if (pages[i][0] == 'a' + i && pages[i][PAGE_SIZE - 1] == 'a' + i)
+                numMatching++;
+        ASSERT_EQUALS_INT(VIO_TEST_PAGES, numMatching, "pages read back");
+        TEST_CHECK(readBlock(1, &fHandle, pages[0]));
+        ASSERT_TRUE(pages[0][0] == 0 && pages[0][PAGE_SIZE - 1] == 0, "gap filled with zeros");
+        rc = readBlocks(VIO_TEST_PAGES, 3, &fHandle, pages);
+        ASSERT_EQUALS_INT(RC_READ_NON_EXISTING_PAGE, rc, "read beyond the end");
+
+        // growing by more pages than one pwritev takes
+        TEST_CHECK(ensureCapacity(3000, &fHandle));
+        ASSERT_EQUALS_INT(3000, fHandle.totalNumPages, "capacity");
+        TEST_CHECK(readBlocks(2998, 2, &fHandle, pages));
+        ASSERT_TRUE(pages[1][0] == 0 && pages[1][PAGE_SIZE - 1] == 0, "appended pages are empty");
+        TEST_CHECK(closePageFile(&fHandle));
+        TEST_CHECK(destroyPageFile("test_vio.bin"));
+    }
+    setDirectIO(false);
+
+    // a flush of pages dirtied in random order writes them in runs
+    TEST_CHECK(createPageFile("test_vio.bin"));
+    TEST_CHECK(initBufferPool(bm, "test_vio.bin", VIO_POOL_PAGES, RS_CLOCK, NULL));
+    for(i = 0; i < VIO_POOL_PAGES; i++) {
+        int pageNum = (i * 37) % VIO_POOL_PAGES;
+        TEST_CHECK(pinPage(bm, h, pageNum));
+        memset(h->data, 'a' + pageNum % 26, PAGE_SIZE);
+        TEST_CHECK(markDirty(bm, h));
+        TEST_CHECK(unpinPage(bm, h));
+    }
+    TEST_CHECK(forceFlushPool(bm));
+    numWriteIO = getNumWriteIO(bm);
+    ASSERT_EQUALS_INT(VIO_POOL_PAGES, numWriteIO, "every page written once");
+    numMatching = 0;
+    for(i = 0; i < VIO_POOL_PAGES; i++)
+        if (!getDirtyFlags(bm)[i])
+            numMatching++;
+    ASSERT_EQUALS_INT(VIO_POOL_PAGES, numMatching, "pages clean after the flush");
+    TEST_CHECK(shutdownBufferPool(bm));
+
+    // prefetching reads the pages back in runs
+    TEST_CHECK(initBufferPool(bm, "test_vio.bin", VIO_POOL_PAGES, RS_CLOCK, NULL));
+    TEST_CHECK(pinPage(bm, h, 10));
+    TEST_CHECK(unpinPage(bm, h));
+    TEST_CHECK(prefetchPages(bm, 0, VIO_POOL_PAGES));
+    rc = getNumReadIO(bm);
+    ASSERT_EQUALS_INT(VIO_POOL_PAGES, rc, "pages around a cached one read ahead");
+    numMatching = 0;
+    for(i = 0; i < VIO_POOL_PAGES; i++) {
+        TEST_CHECK(pinPage(bm, h, i));
+        if (h->data[0] == 'a' + i % 26 && h->data[PAGE_SIZE - 1] == 'a' + i % 26)
+            numMatching++;
+        TEST_CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(VIO_POOL_PAGES, numMatching, "flushed pages read back");
+    rc = getNumReadIO(bm);
+    ASSERT_EQUALS_INT(VIO_POOL_PAGES, rc, "no misses after prefetching");
+    TEST_CHECK(shutdownBufferPool(bm));
+    TEST_CHECK(destroyPageFile("test_vio.bin"));
+
+    free(memory);
+    free(h);
+    free(bm);
+    TEST_DONE();
+}
+
+// ************************************************************
+void testFileExtents(void) {
+    SM_FileHandle fHandle, other;
+    SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+    struct stat st;
+    int numPages;
+    testName = "test page files growing by extents";
+
+    setExtentSize(EXTENT_TEST_PAGES * PAGE_SIZE);
+    TEST_CHECK(createPageFile("test_extent.bin"));
+    TEST_CHECK(openPageFile("test_extent.bin", &fHandle));
+    memset(page, 'x', PAGE_SIZE);
+    TEST_CHECK(writeBlock(9, &fHandle, page));
+    ASSERT_EQUALS_INT(10, fHandle.totalNumPages, "pages in use");
+    TEST_CHECK(appendEmptyBlock(&fHandle));
+    ASSERT_EQUALS_INT(11, fHandle.totalNumPages, "page appended");
+    stat("test_extent.bin", &st);
+    ASSERT_EQUALS_INT(SM_FILE_HEADER_SIZE + 11 * PAGE_SIZE, (int) st.st_size, "size ends at the last page");
+    ASSERT_TRUE(st.st_blocks * 512 >= EXTENT_TEST_PAGES * PAGE_SIZE, "whole extent reserved");
+
+    // growing past the extent reserves the next one
+    TEST_CHECK(writeBlock(100, &fHandle, page));
+    ASSERT_EQUALS_INT(101, fHandle.totalNumPages, "pages in use");
+    stat("test_extent.bin", &st);
+    ASSERT_EQUALS_INT(SM_FILE_HEADER_SIZE + 101 * PAGE_SIZE, (int) st.st_size, "size ends at the last page");
+    ASSERT_TRUE(st.st_blocks * 512 >= 2 * EXTENT_TEST_PAGES * PAGE_SIZE, "second extent reserved");
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // reopened files count only the pages in use
+    TEST_CHECK(openPageFile("test_extent.bin", &fHandle));
+    ASSERT_EQUALS_INT(101, fHandle.totalNumPages, "pages after reopening");
+    TEST_CHECK(readBlock(50, &fHandle, page));
+    ASSERT_TRUE(page[0] == 0 && page[PAGE_SIZE - 1] == 0, "pages in between are empty");
+    TEST_CHECK(readBlock(9, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'x' && page[PAGE_SIZE - 1] == 'x', "written page kept");
+
+    // a handle that missed growth doesn't shrink the file
+    TEST_CHECK(openPageFile("test_extent.bin", &other));
+    TEST_CHECK(ensureCapacity(200, &fHandle));
+    TEST_CHECK(ensureCapacity(150, &other));
+    stat("test_extent.bin", &st);
+    numPages = (int) ((st.st_size - SM_FILE_HEADER_SIZE) / PAGE_SIZE);
+    ASSERT_EQUALS_INT(200, numPages, "file keeps the pages of the other handle");
+    TEST_CHECK(closePageFile(&other));
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile("test_extent.bin"));
+    setExtentSize(SM_DEFAULT_EXTENT_SIZE);
+
+    free(page);
+    TEST_DONE();
+}
+
+// ************************************************************
+void testSyncPoints(void) {
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fHandle, other;
+    SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+    int numSyncs, numWriteIO, i;
+    testName = "test syncing page files at flushes";
+
+    // buffered writes are read back through the same and other handles
+    TEST_CHECK(createPageFile("test_sync.bin"));
+    TEST_CHECK(openPageFile("test_sync.bin", &fHandle));
+    memset(page, 'a', PAGE_SIZE);
+    TEST_CHECK(writeBlock(0, &fHandle, page));
+    memset(page, 'b', PAGE_SIZE);
+    TEST_CHECK(writeBlock(1, &fHandle, page));
+    TEST_CHECK(readBlock(0, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'a' && page[PAGE_SIZE - 1] == 'a', "page read back");
+    TEST_CHECK(syncPageFile(&fHandle));
+    TEST_CHECK(openPageFile("test_sync.bin", &other));
+    TEST_CHECK(readBlock(1, &other, page));
+    ASSERT_TRUE(page[0] == 'b' && page[PAGE_SIZE - 1] == 'b', "page read by another handle");
+    TEST_CHECK(closePageFile(&other));
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // a flush syncs the file once, however many pages it writes
+    TEST_CHECK(initBufferPool(bm, "test_sync.bin", 16, RS_LRU, NULL));
+    for(i = 0; i < 16; i++) {
+        TEST_CHECK(pinPage(bm, h, i));
+        memset(h->data, 'c', PAGE_SIZE);
+        TEST_CHECK(markDirty(bm, h));
+        TEST_CHECK(unpinPage(bm, h));
+    }
+    TEST_CHECK(forceFlushPool(bm));
+    numWriteIO = getNumWriteIO(bm);
+    ASSERT_EQUALS_INT(16, numWriteIO, "every page written");
+    numSyncs = getNumSyncs(bm);
+    ASSERT_EQUALS_INT(1, numSyncs, "one sync for the flush");
+    TEST_CHECK(forceFlushPool(bm));
+    numSyncs = getNumSyncs(bm);
+    ASSERT_EQUALS_INT(1, numSyncs, "no sync without dirty pages");
+    TEST_CHECK(shutdownBufferPool(bm));
+    TEST_CHECK(destroyPageFile("test_sync.bin"));
+
+    free(page);
+    free(h);
+    free(bm);
+    TEST_DONE();
+}
+
+// ************************************************************
+void testPageChecksums(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fHandle;
+    SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+    RM_Config config;
+    FILE *file;
+    Schema *schema;
+    Expr *all;
+    Record *r;
+    int numInserts = 1000, numMatches, numReadIO, numMatching, length, rc, i;
+    testName = "test CRC32C page checksums";
+    schema = testSchema();
+
+    // both implementations compute the Castagnoli CRC
+    ASSERT_TRUE(crc32c(0, "123456789", 9) == 0xE3069283, "check value");
+    ASSERT_TRUE(crc32cPortable(0, "123456789", 9) == 0xE3069283, "check value of the tables");
+    for(i = 0; i < PAGE_SIZE; i++)
+        page[i] = (char) (i * 131 + 7);
+    numMatching = 0;
+    for(length = 0; length < 64; length++)
+        if(crc32c(0, page + length % 8, PAGE_DATA_SIZE - length)
+                == crc32cPortable(0, page + length % 8, PAGE_DATA_SIZE - length))
+            numMatching++;
+    ASSERT_EQUALS_INT(64, numMatching, "unaligned buffers and odd lengths");
+    ASSERT_TRUE(crc32c(crc32c(0, page, 100), page + 100, 900) == crc32c(0, page, 1000),
+                "checksums continue");
+
+    // pages are stamped when written and checked when read
+    setPageChecksums(true);
+    TEST_CHECK(createPageFile("test_crc.bin"));
+    TEST_CHECK(openPageFile("test_crc.bin", &fHandle));
+    for(i = 0; i < 4; i++) {
+        memset(page, 'a' + i, PAGE_SIZE);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(ensureCapacity(6, &fHandle));
+    TEST_CHECK(readBlock(2, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'c' && page[PAGE_DATA_SIZE - 1] == 'c', "page read back");
+    TEST_CHECK(readBlock(5, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // a flipped byte and a torn write are caught
+    file = fopen("test_crc.bin", "rb+");
+    fseek(file, SM_FILE_HEADER_SIZE + PAGE_SIZE + 100, SEEK_SET);
+    fputc('x', file);
+    memset(page, 'z', PAGE_SIZE / 2);
+    fseek(file, SM_FILE_HEADER_SIZE + 3 * PAGE_SIZE, SEEK_SET);
+    fwrite(page, PAGE_SIZE / 2, 1, file);
+    fclose(file);
+    TEST_CHECK(openPageFile("test_crc.bin", &fHandle));
+    rc = readBlock(1, &fHandle, page);
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, rc, "corrupted page");
+    rc = readBlock(3, &fHandle, page);
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, rc, "torn page");
+    TEST_CHECK(readBlock(0, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // the buffer pool doesn't cache a page that fails its checksum
+    TEST_CHECK(initBufferPool(bm, "test_crc.bin", 8, RS_LRU, NULL));
+    rc = pinPage(bm, h, 1);
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, rc, "pin of a corrupted page");
+    rc = prefetchPages(bm, 2, 2);
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, rc, "prefetch of a torn page");
+    TEST_CHECK(pinPage(bm, h, 2));
+    ASSERT_TRUE(h->data[0] == 'c', "good page of the run cached");
+    TEST_CHECK(unpinPage(bm, h));
+    TEST_CHECK(shutdownBufferPool(bm));
+
+    // a failed read leaves the page of the victim frame alone
+    TEST_CHECK(initBufferPool(bm, "test_crc.bin", 1, RS_LRU, NULL));
+    TEST_CHECK(pinPage(bm, h, 0));
+    TEST_CHECK(unpinPage(bm, h));
+    rc = pinPage(bm, h, 1);
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, rc, "pin of a corrupted page");
+    TEST_CHECK(pinPage(bm, h, 0));
+    ASSERT_TRUE(h->data[0] == 'a' && h->data[PAGE_DATA_SIZE - 1] == 'a', "victim page unchanged");
+    TEST_CHECK(unpinPage(bm, h));
+    TEST_CHECK(shutdownBufferPool(bm));
+
+    // whether pages carry checksums is a setting of the file
+    setPageChecksums(false);
+    TEST_CHECK(openPageFile("test_crc.bin", &fHandle));
+    ASSERT_TRUE(hasPageChecksums(&fHandle), "file created with checksums");
+    rc = readBlock(1, &fHandle, page);
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, rc, "checked with checksums off");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(createPageFile("test_crc.bin"));
+    setPageChecksums(true);
+    TEST_CHECK(openPageFile("test_crc.bin", &fHandle));
+    ASSERT_TRUE(!hasPageChecksums(&fHandle), "file created without checksums");
+    memset(page, 'q', PAGE_SIZE);
+    TEST_CHECK(writeBlock(0, &fHandle, page));
+    memset(page, 0, PAGE_SIZE);
+    TEST_CHECK(readBlock(0, &fHandle, page));
+    ASSERT_TRUE(page[PAGE_SIZE - 1] == 'q', "trailer not stamped with checksums on");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(createCompressedPageFile("test_crc.bin"));
+    TEST_CHECK(createTablespace("test_crc.ts", true));
+    TEST_CHECK(createPageFile("test_crc.ts:rel"));
+    setPageChecksums(false);
+    TEST_CHECK(openPageFile("test_crc.bin", &fHandle));
+    ASSERT_TRUE(hasPageChecksums(&fHandle), "compressed file keeps the setting");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(openPageFile("test_crc.ts:rel", &fHandle));
+    ASSERT_TRUE(hasPageChecksums(&fHandle), "relation gets the setting of its tablespace");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile("test_crc.ts"));
+    TEST_CHECK(destroyPageFile("test_crc.bin"));
+
+    // tables work unchanged with checksums on
+    initConfig(&config);
+    config.pageChecksums = true;
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(createTable("test_table_crc", schema));
+    TEST_CHECK(openTable(table, "test_table_crc"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "aaaa", i % 5);
+        TEST_CHECK(insertRecord(table, r));
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_crc"));
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan of a checksummed table");
+    freeExpr(all);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_crc"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(page);
+    free(h);
+    free(bm);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+//copies the file as it is on disk, like a crash would leave it
+static void copyFile(char *from, char *to) {
+    struct stat st;
+    char *data;
+    FILE *file;
+    ASSERT_TRUE(stat(from, &st) == 0, "file to copy");
+    data = (char *) malloc(st.st_size);
+    file = fopen(from, "rb");
+    ASSERT_TRUE(fread(data, 1, st.st_size, file) == (size_t) st.st_size, "file read");
+    fclose(file);
+    file = fopen(to, "wb");
+    ASSERT_TRUE(fwrite(data, 1, st.st_size, file) == (size_t) st.st_size, "file copied");
+    fclose(file);
+    free(data);
+}
+
+void testCompressedPageFile(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    SM_FileHandle fHandle, other;
+    SM_PageHandle pages[CF_TEST_PAGES];
+    SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+    SM_MappedFile mapping;
+    RM_Config config;
+    struct stat st;
+    Expr *all;
+    Record *r;
+    RID rid;
+    Schema *wide;
+    Value *value, padded;
+    char name[101];
+    char **names = (char **) malloc(2 * sizeof(char *));
+    DataType *dataTypes = (DataType *) malloc(2 * sizeof(DataType));
+    int *typeLength = (int *) malloc(2 * sizeof(int));
+    int *keys = (int *) malloc(sizeof(int));
+    long long sizes[2];
+    int numInserts = 2000, numMatches, numReadIO, numMatching, compressed, rc, i, j;
+    testName = "test compressed page files";
+    names[0] = strdup("id");
+    names[1] = strdup("name");
+    dataTypes[0] = DT_INT;
+    dataTypes[1] = DT_STRING;
+    typeLength[0] = 0;
+    typeLength[1] = 100;
+    keys[0] = 0;
+    wide = createSchema(2, names, dataTypes, typeLength, 1, keys);
+    padded.dt = DT_STRING;
+    for(i = 0; i < CF_TEST_PAGES; i++)
+        pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+
+    TEST_CHECK(createCompressedPageFile("test_cf.bin"));
+    TEST_CHECK(openPageFile("test_cf.bin", &fHandle));
+    ASSERT_TRUE(isCompressedPageFile(&fHandle), "compressed file");
+    ASSERT_EQUALS_INT(1, fHandle.totalNumPages, "one page");
+    ASSERT_EQUALS_INT(-1, getPageFileFd(&fHandle), "no descriptor for async IO");
+    TEST_CHECK(readBlock(0, &fHandle, page));
+    ASSERT_TRUE(page[0] == 0 && page[PAGE_SIZE - 1] == 0, "empty page");
+
+    // padded pages, a page that doesn't compress and pages never written
+    for(i = 0; i < CF_TEST_PAGES; i++) {
+        memset(pages[i], 0, PAGE_SIZE);
+        for(j = 0; j < PAGE_SIZE; j += 64)
+            sprintf(pages[i] + j, "row %d of page %d", j / 64, i);
+    }
+    for(j = 0; j < PAGE_SIZE; j++)
+        pages[3][j] = (char) (j * 7919 % 251 + j / 13);
+    TEST_CHECK(writeBlocks(2, CF_TEST_PAGES, &fHandle, pages));
+    ASSERT_EQUALS_INT(CF_TEST_PAGES + 2, fHandle.totalNumPages, "file grew");
+    TEST_CHECK(openPageFile("test_cf.bin", &other));
+    ASSERT_EQUALS_INT(CF_TEST_PAGES + 2, other.totalNumPages, "handles share the file");
+    TEST_CHECK(readBlock(5, &other, page));
+    ASSERT_TRUE(memcmp(page, pages[3], PAGE_SIZE) == 0, "page that doesn't compress");
+    TEST_CHECK(closePageFile(&other));
+    rc = mapPageFile("test_cf.bin", &mapping);
+    ASSERT_EQUALS_INT(RC_PAGE_FILE_COMPRESSED, rc, "compressed files can't be mapped");
+
+    // a plain file whose page 0 starts with the magic stays plain
+    TEST_CHECK(createPageFile("test_cf_plain.bin"));
+    TEST_CHECK(openPageFile("test_cf_plain.bin", &other));
+    memset(page, 'p', PAGE_SIZE);
+    memcpy(page, CF_MAGIC, CF_MAGIC_SIZE);
+    TEST_CHECK(writeBlock(0, &other, page));
+    TEST_CHECK(closePageFile(&other));
+    TEST_CHECK(openPageFile("test_cf_plain.bin", &other));
+    ASSERT_TRUE(!isCompressedPageFile(&other), "plain file");
+    TEST_CHECK(readBlock(0, &other, page));
+    ASSERT_TRUE(memcmp(page, CF_MAGIC, CF_MAGIC_SIZE) == 0 && page[PAGE_SIZE - 1] == 'p', "page 0 read back");
+    TEST_CHECK(closePageFile(&other));
+    TEST_CHECK(destroyPageFile("test_cf_plain.bin"));
+
+    // a page that no longer fits its slots moves
+    memcpy(page, pages[3], PAGE_SIZE);
+    memcpy(pages[3], pages[0], PAGE_SIZE);
+    memcpy(pages[0], page, PAGE_SIZE);
+    TEST_CHECK(writeBlock(2, &fHandle, pages[0]));
+    TEST_CHECK(writeBlock(5, &fHandle, pages[3]));
+    TEST_CHECK(ensureCapacity(20, &fHandle));
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // the map was saved with the last handle
+    TEST_CHECK(openPageFile("test_cf.bin", &fHandle));
+    ASSERT_EQUALS_INT(20, fHandle.totalNumPages, "pages after reopening");
+    numMatching = 0;
+    for(i = 0; i < CF_TEST_PAGES; i++) {
+        TEST_CHECK(readBlock(2 + i, &fHandle, page));
+        if(memcmp(page, pages[i], PAGE_SIZE) == 0)
+            numMatching++;
+    }
+    ASSERT_EQUALS_INT(CF_TEST_PAGES, numMatching, "pages read back");
+    TEST_CHECK(readBlock(19, &fHandle, page));
+    ASSERT_TRUE(page[0] == 0 && page[PAGE_SIZE - 1] == 0, "appended pages are empty");
+    TEST_CHECK(syncPageFile(&fHandle));
+
+    // a shorter page doesn't overwrite the slots the saved map points at
+    memset(page, 0, PAGE_SIZE);
+    TEST_CHECK(writeBlock(3, &fHandle, page));
+    copyFile("test_cf.bin", "test_cf_crash.bin");
+    TEST_CHECK(openPageFile("test_cf_crash.bin", &other));
+    TEST_CHECK(readBlock(3, &other, page));
+    ASSERT_TRUE(memcmp(page, pages[1], PAGE_SIZE) == 0, "saved page after a crash");
+    TEST_CHECK(closePageFile(&other));
+    TEST_CHECK(destroyPageFile("test_cf_crash.bin"));
+    TEST_CHECK(readBlock(3, &fHandle, page));
+    ASSERT_TRUE(page[0] == 0 && page[PAGE_SIZE - 1] == 0, "shorter page read back");
+    TEST_CHECK(closePageFile(&fHandle));
+    stat("test_cf.bin", &st);
+    ASSERT_TRUE(st.st_size < 20 * PAGE_SIZE / 2, "file smaller than its pages");
+    TEST_CHECK(destroyPageFile("test_cf.bin"));
+
+    // the same records of padded strings in a plain and a compressed
+    // table, with a small pool so pages are evicted and read again
+    for(compressed = 0; compressed < 2; compressed++) {
+        initConfig(&config);
+        config.numPoolFrames = 16;
+        config.tableDefaults.compressPages = compressed;
+        TEST_CHECK(initRecordManager(&config));
+        TEST_CHECK(createTable("test_table_cf", wide));
+        TEST_CHECK(openTable(table, "test_table_cf"));
+        for(i = 0; i < numInserts; i++) {
+            memset(name, 0, sizeof(name));
+            sprintf(name, "customer %d", i);
+            TEST_CHECK(createRecord(&r, wide));
+            MAKE_VALUE(value, DT_INT, i);
+            TEST_CHECK(setAttr(r, wide, 0, value));
+            freeVal(value);
+            padded.v.stringV = name;
+            TEST_CHECK(setAttr(r, wide, 1, &padded));
+            TEST_CHECK(insertRecord(table, r));
+            if(i == 1234)
+                rid = r->id;
+            freeRecord(r);
+        }
+        TEST_CHECK(closeTable(table));
+        stat("test_table_cf", &st);
+        sizes[compressed] = st.st_size;
+        TEST_CHECK(openTable(table, "test_table_cf"));
+        MAKE_CONS(all, stringToValue("btrue"));
+        numMatches = countScan(table, all, &numReadIO);
+        ASSERT_EQUALS_INT(numInserts, numMatches, "scan");
+        freeExpr(all);
+        TEST_CHECK(createRecord(&r, wide));
+        TEST_CHECK(getRecord(table, rid, r));
+        ASSERT_EQUALS_INT(1234, getAttrInt(r, wide, 0), "lookup");
+        freeRecord(r);
+        TEST_CHECK(closeTable(table));
+        TEST_CHECK(deleteTable("test_table_cf"));
+        TEST_CHECK(shutdownRecordManager());
+    }
+    ASSERT_TRUE(sizes[1] < sizes[0] / 2, "compressed table takes less than half");
+    freeSchema(wide);
+
+    for(i = 0; i < CF_TEST_PAGES; i++)
+        free(pages[i]);
+    free(page);
+    free(table);
+    TEST_DONE();
+}
+
+void testPageSizes(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    Schema *schema = testSchema();
+    SM_PageHandle page = (SM_PageHandle) malloc(PS_TEST_PAGE_SIZE);
+    SM_FileHandle fHandle;
+    SM_MappedFile mapping;
+    BM_BufferPool bm, shared, handle;
+    BM_PageHandle pageHandle;
+    RM_Config config;
+    struct stat st;
+    FILE *file;
+    Expr *all;
+    Record *r;
+    RID rid;
+    int pageSizes[2] = {PAGE_SIZE, SM_MAX_PAGE_SIZE};
+    int numReadIOs[2];
+    int numInserts = 5000, numMatches, numReadIO, rc, i;
+    testName = "test page sizes per page file";
+
+    rc = createPageFileEx("test_pagesize.bin", 12288);
+    ASSERT_EQUALS_INT(RC_INCOMPATIBLE_BLOCKSIZE, rc, "not a power of two");
+    TEST_CHECK(createPageFileEx("test_pagesize.bin", PS_TEST_PAGE_SIZE));
+    TEST_CHECK(openPageFile("test_pagesize.bin", &fHandle));
+    ASSERT_EQUALS_INT(PS_TEST_PAGE_SIZE, fHandle.pageSize, "page size from the header");
+    ASSERT_EQUALS_INT(1, fHandle.totalNumPages, "one page");
+    for(i = 0; i < 4; i++) {
+        memset(page, 'a' + i, PS_TEST_PAGE_SIZE);
+        TEST_CHECK(writeBlock(i, &fHandle, page));
+    }
+    TEST_CHECK(closePageFile(&fHandle));
+    stat("test_pagesize.bin", &st);
+    ASSERT_EQUALS_INT(SM_FILE_HEADER_SIZE + 4 * PS_TEST_PAGE_SIZE, (int) st.st_size, "header and pages");
+    TEST_CHECK(openPageFile("test_pagesize.bin", &fHandle));
+    ASSERT_EQUALS_INT(4, fHandle.totalNumPages, "pages after reopening");
+    TEST_CHECK(readBlock(2, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'c' && page[PS_TEST_PAGE_SIZE - 1] == 'c', "large page read back");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(mapPageFile("test_pagesize.bin", &mapping));
+    ASSERT_EQUALS_INT(4, mapping.totalNumPages, "mapped pages");
+    ASSERT_TRUE(mapping.pages[3 * PS_TEST_PAGE_SIZE] == 'd', "mapped page after the header");
+    TEST_CHECK(unmapPageFile(&mapping));
+
+    // a page that looks like a header doesn't change the page size
+    TEST_CHECK(createPageFile("test_pagesize_fake.bin"));
+    TEST_CHECK(openPageFile("test_pagesize_fake.bin", &fHandle));
+    memset(page, 0, PAGE_SIZE);
+    memcpy(page, SM_FILE_MAGIC, SM_FILE_MAGIC_SIZE);
+    i = SM_MAX_PAGE_SIZE;
+    memcpy(page + SM_FILE_MAGIC_SIZE, &i, sizeof(int));
+    TEST_CHECK(writeBlock(0, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(openPageFile("test_pagesize_fake.bin", &fHandle));
+    ASSERT_EQUALS_INT(PAGE_SIZE, fHandle.pageSize, "page size of the header, not of page 0");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile("test_pagesize_fake.bin"));
+
+    // page files from before the header are given one when opened
+    file = fopen("test_pagesize_fake.bin", "wb");
+    memset(page, 'x', PAGE_SIZE);
+    fwrite(page, PAGE_SIZE, 1, file);
+    memset(page, 'y', PAGE_SIZE);
+    fwrite(page, PAGE_SIZE, 1, file);
+    fclose(file);
+    TEST_CHECK(openPageFile("test_pagesize_fake.bin", &fHandle));
+    ASSERT_EQUALS_INT(PAGE_SIZE, fHandle.pageSize, "pages of a headerless file");
+    ASSERT_EQUALS_INT(2, fHandle.totalNumPages, "pages of a headerless file kept");
+    TEST_CHECK(readBlock(1, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'y' && page[PAGE_SIZE - 1] == 'y', "page of a headerless file read back");
+    TEST_CHECK(closePageFile(&fHandle));
+    stat("test_pagesize_fake.bin", &st);
+    ASSERT_EQUALS_INT(SM_FILE_HEADER_SIZE + 2 * PAGE_SIZE, (int) st.st_size, "header added");
+    ASSERT_TRUE(access("test_pagesize_fake.bin.upgrade", F_OK) != 0, "no copy left behind");
+    TEST_CHECK(destroyPageFile("test_pagesize_fake.bin"));
+    file = fopen("test_pagesize_fake.bin", "wb");
+    memset(page, 'x', PAGE_SIZE);
+    fwrite(page, PAGE_SIZE, 1, file);
+    fclose(file);
+    TEST_CHECK(mapPageFile("test_pagesize_fake.bin", &mapping));
+    ASSERT_EQUALS_INT(1, mapping.totalNumPages, "mapped headerless file");
+    ASSERT_TRUE(mapping.pages[0] == 'x', "mapped page of a headerless file");
+    TEST_CHECK(unmapPageFile(&mapping));
+    TEST_CHECK(destroyPageFile("test_pagesize_fake.bin"));
+
+    // other files aren't page files
+    file = fopen("test_pagesize_fake.bin", "wb");
+    fwrite(page, PAGE_SIZE / 2, 1, file);
+    fclose(file);
+    rc = openPageFile("test_pagesize_fake.bin", &fHandle);
+    ASSERT_EQUALS_INT(RC_NOT_A_PAGE_FILE, rc, "not a whole number of pages");
+    rc = mapPageFile("test_pagesize_fake.bin", &mapping);
+    ASSERT_EQUALS_INT(RC_NOT_A_PAGE_FILE, rc, "no mapping of a file that isn't a page file");
+    unlink("test_pagesize_fake.bin");
+
+    // frames as large as the pages, written when evicted and flushed
+    TEST_CHECK(initBufferPool(&bm, "test_pagesize.bin", 2, RS_FIFO, NULL));
+    ASSERT_EQUALS_INT(PS_TEST_PAGE_SIZE, getFrameSize(&bm), "frame size of the file");
+    TEST_CHECK(pinPage(&bm, &pageHandle, 5));
+    memset(pageHandle.data, 'x', PS_TEST_PAGE_SIZE);
+    TEST_CHECK(markDirty(&bm, &pageHandle));
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(pinPage(&bm, &pageHandle, 0));
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(pinPage(&bm, &pageHandle, 1));
+    memset(pageHandle.data, 'y', PS_TEST_PAGE_SIZE);
+    TEST_CHECK(markDirty(&bm, &pageHandle));
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(openPageFile("test_pagesize.bin", &fHandle));
+    ASSERT_EQUALS_INT(6, fHandle.totalNumPages, "evicted page grew the file");
+    TEST_CHECK(readBlock(5, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'x' && page[PS_TEST_PAGE_SIZE - 1] == 'x', "evicted page written");
+    TEST_CHECK(readBlock(1, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'y' && page[PS_TEST_PAGE_SIZE - 1] == 'y', "flushed page written");
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // shared pools only take files of their frame size
+    TEST_CHECK(initSharedPool(&shared, 4, RS_LRU, NULL));
+    rc = attachBufferPool(&handle, &shared, "test_pagesize.bin");
+    ASSERT_EQUALS_INT(RC_INCOMPATIBLE_BLOCKSIZE, rc, "pages larger than the frames");
+    TEST_CHECK(shutdownBufferPool(&shared));
+    TEST_CHECK(initSharedPoolEx(&shared, 4, PS_TEST_PAGE_SIZE, RS_LRU, NULL));
+    TEST_CHECK(attachBufferPool(&handle, &shared, "test_pagesize.bin"));
+    TEST_CHECK(prefetchPages(&handle, 0, 4));
+    TEST_CHECK(pinPage(&handle, &pageHandle, 3));
+    ASSERT_TRUE(pageHandle.data[0] == 'd' && pageHandle.data[PS_TEST_PAGE_SIZE - 1] == 'd',
+                "prefetched large page");
+    TEST_CHECK(unpinPage(&handle, &pageHandle));
+    TEST_CHECK(shutdownBufferPool(&handle));
+    TEST_CHECK(shutdownBufferPool(&shared));
+    TEST_CHECK(destroyPageFile("test_pagesize.bin"));
+
+    // the same table with small and large pages, the large pages
+    // don't fit the shared pool and get a private one
+    for(i = 0; i < 2; i++) {
+        int j;
+        initConfig(&config);
+        config.numPoolFrames = 8;
+        config.tableDefaults.pageSize = pageSizes[i];
+        config.tableDefaults.prefetchDepth = 4;
+        TEST_CHECK(initRecordManager(&config));
+        TEST_CHECK(createTable("test_table_ps", schema));
+        TEST_CHECK(openTable(table, "test_table_ps"));
+        for(j = 0; j < numInserts; j++) {
+            r = testRecord(schema, j, "abcd", j % 7);
+            TEST_CHECK(insertRecord(table, r));
+            if(j == 4321)
+                rid = r->id;
+            freeRecord(r);
+        }
+        TEST_CHECK(closeTable(table));
+        stat("test_table_ps", &st);
+        ASSERT_EQUALS_INT(0, (int) ((st.st_size - SM_FILE_HEADER_SIZE) % pageSizes[i]), "whole pages");
+        TEST_CHECK(openTable(table, "test_table_ps"));
+        ASSERT_EQUALS_INT(pageSizes[i], getFrameSize(table->bufferPool), "frames of the table");
+        MAKE_CONS(all, stringToValue("btrue"));
+        numMatches = countScan(table, all, &numReadIO);
+        ASSERT_EQUALS_INT(numInserts, numMatches, "scan");
+        numReadIOs[i] = numReadIO;
+        freeExpr(all);
+        TEST_CHECK(createRecord(&r, schema));
+        TEST_CHECK(getRecord(table, rid, r));
+        ASSERT_EQUALS_INT(4321, getAttrInt(r, schema, 0), "lookup");
+        freeRecord(r);
+        TEST_CHECK(closeTable(table));
+        TEST_CHECK(deleteTable("test_table_ps"));
+        TEST_CHECK(shutdownRecordManager());
+    }
+    ASSERT_TRUE(numReadIOs[1] * 4 < numReadIOs[0], "large pages take fewer reads");
+
+    freeSchema(schema);
+    free(page);
+    free(table);
+    TEST_DONE();
+}
+
+void testSegmentedFiles(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    Schema *schema = testSchema();
+    SM_PageHandle pages[3 * SEG_TEST_PAGES];
+    SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+    SM_FileHandle fHandle;
+    SM_MappedFile mapping;
+    BM_BufferPool bm;
+    BM_PageHandle pageHandle;
+    RM_Config config;
+    struct stat st;
+    FILE *file;
+    off_t fileOffset;
+    Expr *all;
+    Record *r;
+    RID rid;
+    int numPages = 2 * SEG_TEST_PAGES + 4;
+    long numSyncs;
+    int numInserts = 3000, numMatches, numReadIO, fd, rc, i;
+    testName = "test page files split into segments";
+
+    // segments of 8 pages, a run of writes crosses two of them
+    setSegmentSize(SEG_TEST_PAGES * PAGE_SIZE);
+    for(i = 0; i < numPages; i++) {
+        pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+        memset(pages[i], 'a' + i, PAGE_SIZE);
+    }
+    TEST_CHECK(createPageFile("test_segment.bin"));
+    TEST_CHECK(openPageFile("test_segment.bin", &fHandle));
+    ASSERT_EQUALS_INT(SEG_TEST_PAGES, getSegmentPages(&fHandle), "pages of a segment");
+    TEST_CHECK(writeBlocks(0, numPages, &fHandle, pages));
+    fd = getPageFd(&fHandle, SEG_TEST_PAGES + 1, &fileOffset);
+    ASSERT_TRUE(fd >= 0 && fd != getPageFileFd(&fHandle), "own descriptor of segment 1");
+    ASSERT_TRUE(fileOffset + (SEG_TEST_PAGES + 1) * PAGE_SIZE == PAGE_SIZE, "offset in segment 1");
+    TEST_CHECK(closePageFile(&fHandle));
+    stat("test_segment.bin", &st);
+    ASSERT_EQUALS_INT(SM_FILE_HEADER_SIZE + SEG_TEST_PAGES * PAGE_SIZE, (int) st.st_size, "segment 0 is full");
+    stat("test_segment.bin.1", &st);
+    ASSERT_EQUALS_INT(SEG_TEST_PAGES * PAGE_SIZE, (int) st.st_size, "segment 1 is full");
+    stat("test_segment.bin.2", &st);
+    ASSERT_EQUALS_INT(4 * PAGE_SIZE, (int) st.st_size, "segment 2 holds the rest");
+
+    // the segment size is that of the file, not of setSegmentSize
+    setSegmentSize(SM_DEFAULT_SEGMENT_SIZE);
+    TEST_CHECK(openPageFile("test_segment.bin", &fHandle));
+    ASSERT_EQUALS_INT(numPages, fHandle.totalNumPages, "pages of all segments");
+    ASSERT_EQUALS_INT(SEG_TEST_PAGES, getSegmentPages(&fHandle), "segment size of the file");
+    for(i = 0; i < numPages; i++)
+        memset(pages[i], 0, PAGE_SIZE);
+    TEST_CHECK(readBlocks(0, numPages, &fHandle, pages));
+    for(i = 0; i < numPages; i++)
+        if(pages[i][0] != 'a' + i || pages[i][PAGE_SIZE - 1] != 'a' + i)
+            break;
+    ASSERT_EQUALS_INT(numPages, i, "pages read back across segments");
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // a pool flushes and prefetches runs across segment boundaries
+    TEST_CHECK(initBufferPool(&bm, "test_segment.bin", 8, RS_FIFO, NULL));
+    for(i = SEG_TEST_PAGES - 2; i < SEG_TEST_PAGES + 2; i++) {
+        TEST_CHECK(pinPage(&bm, &pageHandle, i));
+        memset(pageHandle.data, 'A' + i, PAGE_SIZE);
+        TEST_CHECK(markDirty(&bm, &pageHandle));
+        TEST_CHECK(unpinPage(&bm, &pageHandle));
+    }
+    TEST_CHECK(forceFlushPool(&bm));
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(initBufferPool(&bm, "test_segment.bin", 8, RS_FIFO, NULL));
+    TEST_CHECK(prefetchPages(&bm, SEG_TEST_PAGES - 2, 8));
+    TEST_CHECK(pinPage(&bm, &pageHandle, SEG_TEST_PAGES + 1));
+    ASSERT_TRUE(pageHandle.data[0] == 'A' + SEG_TEST_PAGES + 1, "flushed page in segment 1");
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(pinPage(&bm, &pageHandle, 2 * SEG_TEST_PAGES + 1));
+    ASSERT_TRUE(pageHandle.data[0] == 'a' + 2 * SEG_TEST_PAGES + 1, "prefetched page in segment 2");
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // the segments are mapped one after the other
+    TEST_CHECK(mapPageFile("test_segment.bin", &mapping));
+    ASSERT_EQUALS_INT(numPages, mapping.totalNumPages, "mapped pages of all segments");
+    ASSERT_TRUE(mapping.pages[(SEG_TEST_PAGES - 1) * PAGE_SIZE] == 'A' + SEG_TEST_PAGES - 1,
+                "mapped page in segment 0");
+    ASSERT_TRUE(mapping.pages[(numPages - 1) * PAGE_SIZE] == 'a' + numPages - 1,
+                "mapped page in segment 2");
+    TEST_CHECK(unmapPageFile(&mapping));
+    TEST_CHECK(destroyPageFile("test_segment.bin"));
+    ASSERT_TRUE(access("test_segment.bin.1", F_OK) != 0 && access("test_segment.bin.2", F_OK) != 0,
+                "segments destroyed");
+
+    // files named like segments the page file didn't create are left alone
+    setSegmentSize(SEG_TEST_PAGES * PAGE_SIZE);
+    file = fopen("test_segment.bin.1", "wb");
+    fputs("not a segment", file);
+    fclose(file);
+    TEST_CHECK(createPageFile("test_segment.bin"));
+    TEST_CHECK(openPageFile("test_segment.bin", &fHandle));
+    ASSERT_EQUALS_INT(1, fHandle.totalNumPages, "segment 1 isn't counted");
+    rc = writeBlock(SEG_TEST_PAGES, &fHandle, page);
+    ASSERT_EQUALS_INT(RC_WRITE_FAILED, rc, "segment 1 isn't taken over");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(createPageFile("test_segment.bin"));
+    TEST_CHECK(destroyPageFile("test_segment.bin"));
+    stat("test_segment.bin.1", &st);
+    ASSERT_EQUALS_INT(13, (int) st.st_size, "unrelated file kept");
+    unlink("test_segment.bin.1");
+
+    // segments of INT_MAX pages, page numbers don't reach segment 1
+    TEST_CHECK(createPageFile("test_segment.bin"));
+    TEST_CHECK(openPageFile("test_segment.bin", &fHandle));
+    TEST_CHECK(writeBlock(SEG_TEST_PAGES, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+    file = fopen("test_segment.bin", "r+b");
+    fseek(file, SM_FILE_MAGIC_SIZE + 2 * sizeof(int), SEEK_SET);
+    i = INT_MAX;
+    fwrite(&i, sizeof(int), 1, file);
+    fclose(file);
+    rc = openPageFile("test_segment.bin", &fHandle);
+    ASSERT_EQUALS_INT(RC_INVALID_PAGE_NUMBER, rc, "more pages than an int numbers");
+    TEST_CHECK(destroyPageFile("test_segment.bin"));
+    ASSERT_TRUE(access("test_segment.bin.1", F_OK) != 0, "segment destroyed");
+
+    // segments spread over directories in turn
+    mkdir("test_segdir_a", 0777);
+    mkdir("test_segdir_b", 0777);
+    setSegmentDirs("test_segdir_a:test_segdir_b");
+    TEST_CHECK(createPageFile("test_segment.bin"));
+    TEST_CHECK(openPageFile("test_segment.bin", &fHandle));
+    TEST_CHECK(writeBlock(3 * SEG_TEST_PAGES, &fHandle, pages[1]));
+    TEST_CHECK(closePageFile(&fHandle));
+    ASSERT_TRUE(access("test_segdir_a/test_segment.bin.1", F_OK) == 0, "segment 1 in the first directory");
+    ASSERT_TRUE(access("test_segdir_b/test_segment.bin.2", F_OK) == 0, "segment 2 in the second directory");
+    ASSERT_TRUE(access("test_segdir_a/test_segment.bin.3", F_OK) == 0, "segment 3 in the first again");
+    TEST_CHECK(openPageFile("test_segment.bin", &fHandle));
+    ASSERT_EQUALS_INT(3 * SEG_TEST_PAGES + 1, fHandle.totalNumPages, "pages from the directories");
+    TEST_CHECK(readBlock(3 * SEG_TEST_PAGES, &fHandle, page));
+    ASSERT_TRUE(page[0] == 'b', "page read from a directory");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(destroyPageFile("test_segment.bin"));
+    ASSERT_TRUE(rmdir("test_segdir_a") == 0 && rmdir("test_segdir_b") == 0, "directories emptied");
+    setSegmentDirs(NULL);
+
+    // a page beyond 2 GB, the pages skipped stay sparse
+    setSegmentSize(SM_DEFAULT_SEGMENT_SIZE);
+    TEST_CHECK(createPageFile("test_segment.bin"));
+    TEST_CHECK(openPageFile("test_segment.bin", &fHandle));
+    memset(page, 'z', PAGE_SIZE);
+    TEST_CHECK(writeBlock(SEG_FAR_PAGE, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+    stat("test_segment.bin.2", &st);
+    ASSERT_TRUE(st.st_size == (off_t) (SEG_FAR_PAGE + 1) * PAGE_SIZE - 2 * SM_DEFAULT_SEGMENT_SIZE,
+                "far page in segment 2");
+    stat("test_segment.bin", &st);
+    ASSERT_TRUE(st.st_size == SM_FILE_HEADER_SIZE + SM_DEFAULT_SEGMENT_SIZE && st.st_blocks * 512 < 8 * SM_DEFAULT_EXTENT_SIZE,
+                "segment 0 full but sparse");
+    TEST_CHECK(initBufferPool(&bm, "test_segment.bin", 4, RS_FIFO, NULL));
+    TEST_CHECK(pinPage(&bm, &pageHandle, SEG_FAR_PAGE));
+    ASSERT_TRUE(pageHandle.data[0] == 'z' && pageHandle.data[PAGE_SIZE - 1] == 'z', "far page pinned");
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(pinPage(&bm, &pageHandle, SEG_FAR_PAGE + 1));
+    memset(pageHandle.data, 'y', PAGE_SIZE);
+    TEST_CHECK(markDirty(&bm, &pageHandle));
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(mapPageFile("test_segment.bin", &mapping));
+    ASSERT_EQUALS_INT(SEG_FAR_PAGE + 2, mapping.totalNumPages, "mapped beyond 2 GB");
+    ASSERT_TRUE(mapping.pages[(size_t) (SEG_FAR_PAGE + 1) * PAGE_SIZE] == 'y', "flushed far page mapped");
+    TEST_CHECK(unmapPageFile(&mapping));
+    TEST_CHECK(destroyPageFile("test_segment.bin"));
+
+    // a table of segments of 4 pages, from the configuration
+    initConfig(&config);
+    config.numPoolFrames = 8;
+    config.segmentSize = 4 * PAGE_SIZE;
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(createTable("test_table_seg", schema));
+    TEST_CHECK(openTable(table, "test_table_seg"));
+    for(i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "abcd", i % 7);
+        TEST_CHECK(insertRecord(table, r));
+        if(i == numInserts - 1)
+            rid = r->id;
+        freeRecord(r);
+    }
+    // the checkpoint writes the pages through a handle of its own, its
+    // sync covers every segment nonetheless
+    numSyncs = getNumSegmentSyncs();
+    TEST_CHECK(checkpointTable(table));
+    ASSERT_TRUE(getNumSegmentSyncs() - numSyncs >= rid.page / 4 + 1, "checkpoint syncs every segment");
+    TEST_CHECK(closeTable(table));
+    ASSERT_TRUE(access("test_table_seg.2", F_OK) == 0, "table split into segments");
+    TEST_CHECK(openTable(table, "test_table_seg"));
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(table, all, &numReadIO);
+    ASSERT_EQUALS_INT(numInserts, numMatches, "scan across segments");
+    freeExpr(all);
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(getRecord(table, rid, r));
+    ASSERT_EQUALS_INT(numInserts - 1, getAttrInt(r, schema, 0), "lookup in the last segment");
+    freeRecord(r);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_seg"));
+    ASSERT_TRUE(access("test_table_seg.1", F_OK) != 0, "segments of the table deleted");
+    TEST_CHECK(shutdownRecordManager());
+
+    for(i = 0; i < numPages; i++)
+        free(pages[i]);
+    freeSchema(schema);
+    free(page);
+    free(table);
+    TEST_DONE();
+}
+
+//the descriptors the process has open
+int countOpenFiles(void) {
+    DIR *dir = opendir("/proc/self/fd");
+    int numFiles = 0;
+    if (!dir)
+        return 0;
+    while (readdir(dir))
+        numFiles++;
+    closedir(dir);
+    return numFiles;
+}
+
+void testTablespace(void) {
+    RM_TableData *tables = (RM_TableData *) calloc(TBS_TEST_TABLES, sizeof(RM_TableData));
+    Schema *schema = testSchema();
+    SM_PageHandle pages[TBS_TEST_PAGES];
+    SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+    SM_FileHandle fHandle, other;
+    SM_MappedFile mapping;
+    BM_BufferPool bm;
+    BM_PageHandle pageHandle;
+    struct stat st;
+    off_t fileOffset, otherOffset, spaceSize;
+    Expr *all;
+    Record *r;
+    char names[TBS_TEST_TABLES][32];
+    int numRecords = 20, numMatches, numReadIO, numFiles, numWrong, rc, i, j;
+    testName = "test tablespace of many relations";
+
+    // two relations grow in turns, their extents interleave in the file
+    for(i = 0; i < TBS_TEST_PAGES; i++) {
+        pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+        memset(pages[i], 'a' + i % 26, PAGE_SIZE);
+    }
+    TEST_CHECK(createTablespace("test_space.ts", false));
+    TEST_CHECK(createPageFile("test_space.ts:a"));
+    TEST_CHECK(createPageFile("test_space.ts:b"));
+    TEST_CHECK(openPageFile("test_space.ts:a", &fHandle));
+    TEST_CHECK(openPageFile("test_space.ts:b", &other));
+    ASSERT_EQUALS_INT(TBS_EXTENT_PAGES, getSegmentPages(&fHandle), "a segment per extent");
+    for(i = 0; i < TBS_TEST_PAGES; i += TBS_EXTENT_PAGES / 2) {
+        TEST_CHECK(writeBlocks(i, TBS_EXTENT_PAGES / 2, &fHandle, &pages[i]));
+        TEST_CHECK(writeBlock(i / 2, &other, pages[TBS_TEST_PAGES - 1 - i / 2]));
+    }
+    ASSERT_TRUE(getPageFd(&fHandle, 0, &fileOffset) == getPageFd(&other, 0, &otherOffset),
+                "relations share the descriptor of the tablespace");
+    ASSERT_TRUE(fileOffset != otherOffset, "in different extents");
+    TEST_CHECK(closePageFile(&other));
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // the catalog is read back once the tablespace is loaded again
+    dropTablespace("test_space.ts");
+    ASSERT_TRUE(pageFileExists("test_space.ts:a") && !pageFileExists("test_space.ts:c"),
+                "relations of the catalog");
+    TEST_CHECK(openPageFile("test_space.ts:a", &fHandle));
+    ASSERT_EQUALS_INT(TBS_TEST_PAGES, fHandle.totalNumPages, "pages of the relation");
+    for(i = 0; i < TBS_TEST_PAGES; i++)
+        memset(pages[i], 0, PAGE_SIZE);
+    TEST_CHECK(readBlocks(0, TBS_TEST_PAGES, &fHandle, pages));
+    for(i = numWrong = 0; i < TBS_TEST_PAGES; i++)
+        if(pages[i][0] != 'a' + i % 26 || pages[i][PAGE_SIZE - 1] != 'a' + i % 26)
+            numWrong++;
+    ASSERT_EQUALS_INT(0, numWrong, "pages read back across extents");
+    TEST_CHECK(closePageFile(&fHandle));
+    rc = openPageFile("test_space.ts:c", &fHandle);
+    ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, rc, "no such relation");
+    rc = createPageFileEx("test_space.ts:c", PS_TEST_PAGE_SIZE);
+    ASSERT_EQUALS_INT(RC_INCOMPATIBLE_BLOCKSIZE, rc, "relations have pages of PAGE_SIZE");
+
+    // pools and mappings of relations
+    TEST_CHECK(initBufferPool(&bm, "test_space.ts:b", 4, RS_FIFO, NULL));
+    TEST_CHECK(pinPage(&bm, &pageHandle, TBS_EXTENT_PAGES + 1));
+    memset(pageHandle.data, 'Z', PAGE_SIZE);
+    TEST_CHECK(markDirty(&bm, &pageHandle));
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(forceFlushPool(&bm));
+    TEST_CHECK(prefetchPages(&bm, 0, 4));
+    TEST_CHECK(pinPage(&bm, &pageHandle, 4));
+    ASSERT_TRUE(pageHandle.data[0] == 'a' + (TBS_TEST_PAGES - 5) % 26, "prefetched page of the relation");
+    TEST_CHECK(unpinPage(&bm, &pageHandle));
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(mapPageFile("test_space.ts:b", &mapping));
+    ASSERT_EQUALS_INT(TBS_EXTENT_PAGES + 2, mapping.totalNumPages, "mapped pages of the relation");
+    ASSERT_TRUE(mapping.pages[(TBS_EXTENT_PAGES + 1) * PAGE_SIZE] == 'Z', "mapped page in the second extent");
+    TEST_CHECK(unmapPageFile(&mapping));
+
+    // the extents of a destroyed relation are reused, as zeros
+    stat("test_space.ts", &st);
+    spaceSize = st.st_size;
+    TEST_CHECK(destroyPageFile("test_space.ts:a"));
+    TEST_CHECK(createPageFile("test_space.ts:c"));
+    TEST_CHECK(openPageFile("test_space.ts:c", &fHandle));
+    TEST_CHECK(ensureCapacity(TBS_TEST_PAGES, &fHandle));
+    TEST_CHECK(readBlock(TBS_TEST_PAGES - 1, &fHandle, page));
+    ASSERT_TRUE(page[0] == 0 && memcmp(page, page + 1, PAGE_SIZE - 1) == 0, "reused extent reads as zeros");
+    TEST_CHECK(closePageFile(&fHandle));
+    stat("test_space.ts", &st);
+    ASSERT_TRUE(st.st_size == spaceSize, "tablespace didn't grow");
+    TEST_CHECK(createPageFile("test_space.bin"));
+    rc = openPageFile("test_space.bin:a", &fHandle);
+    ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, rc, "a plain page file isn't a tablespace");
+    TEST_CHECK(destroyPageFile("test_space.bin"));
+
+    // names with the separator are page files unless it follows a tablespace
+    TEST_CHECK(createPageFile("test_space_x:y"));
+    TEST_CHECK(openPageFile("test_space_x:y", &fHandle));
+    ASSERT_EQUALS_INT(1, fHandle.totalNumPages, "page file with the separator in its name");
+    TEST_CHECK(closePageFile(&fHandle));
+    ASSERT_TRUE(access("test_space_x:y", F_OK) == 0, "created as a page file");
+    TEST_CHECK(destroyPageFile("test_space_x:y"));
+    TEST_CHECK(destroyPageFile("test_space.ts"));
+
+    // many small tables in one file and the shared pool, open at once
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTablespace("test_tables.ts", false));
+    for(i = 0; i < TBS_TEST_TABLES; i++) {
+        sprintf(names[i], "test_tables.ts:t%d", i);
+        TEST_CHECK(createTable(names[i], schema));
+    }
+    numFiles = countOpenFiles();
+    for(i = 0; i < TBS_TEST_TABLES; i++) {
+        TEST_CHECK(openTable(&tables[i], names[i]));
+        for(j = 0; j < numRecords; j++) {
+            r = testRecord(schema, i * numRecords + j, "abcd", j);
+            TEST_CHECK(insertRecord(&tables[i], r));
+            freeRecord(r);
+        }
+    }
+    numFiles = countOpenFiles() - numFiles;
+    ASSERT_TRUE(numFiles <= TBS_TEST_TABLES + 2, "page files of the tables take no descriptors");
+    for(i = 0; i < TBS_TEST_TABLES; i++)
+        TEST_CHECK(closeTable(&tables[i]));
+    MAKE_CONS(all, stringToValue("btrue"));
+    for(i = numWrong = 0; i < TBS_TEST_TABLES; i++) {
+        TEST_CHECK(openTable(&tables[i], names[i]));
+        numMatches = countScan(&tables[i], all, &numReadIO);
+        if(numMatches != numRecords)
+            numWrong++;
+        TEST_CHECK(closeTable(&tables[i]));
+    }
+    freeExpr(all);
+    ASSERT_EQUALS_INT(0, numWrong, "every table scanned back");
+    for(i = 0; i < TBS_TEST_TABLES; i++)
+        TEST_CHECK(deleteTable(names[i]));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(destroyPageFile("test_tables.ts"));
+
+    for(i = 0; i < TBS_TEST_PAGES; i++)
+        free(pages[i]);
+    freeSchema(schema);
+    free(page);
+    free(tables);
+    TEST_DONE();
+}
+
+void testCatalog(void) {
+    RM_TableData *tables = (RM_TableData *) calloc(3, sizeof(RM_TableData));
+    SM_PageHandle page = (SM_PageHandle) malloc(PAGE_SIZE);
+    SM_FileHandle fHandle;
+    RM_Config config;
+    Schema *schema = testSchema();
+    Schema *other;
+    Record *r;
+    Expr *all;
+    char *names[] = { "customer_id", "customer_name" };
+    char **cpNames = (char **) malloc(sizeof(char*) * 2);
+    DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 2);
+    int *cpSizes = (int *) malloc(sizeof(int) * 2);
+    int *cpKeys = (int *) malloc(sizeof(int));
+    unsigned int numTables;
+    char name[CAT_TEST_NAME_LENGTH + 1];
+    int numRecords = 100, numMatches, numReadIO, rc, i;
+    testName = "test system catalog";
+
+    for(i = 0; i < 2; i++) {
+        cpNames[i] = (char *) malloc(strlen(names[i]) + 1);
+        strcpy(cpNames[i], names[i]);
+    }
+    cpDt[0] = DT_INT;
+    cpDt[1] = DT_STRING;
+    cpSizes[0] = 0;
+    cpSizes[1] = 32;
+    cpKeys[0] = 0;
+    other = createSchema(2, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+    // the attribute names are read back from the PageFile header
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_cat_other", other));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(openTable(&tables[2], "test_cat_other"));
+    ASSERT_TRUE(strcmp(tables[2].schema->attrNames[1], "customer_name") == 0, "attribute name from the header");
+    ASSERT_EQUALS_INT(32, tables[2].schema->typeLength[1], "type length from the header");
+    TEST_CHECK(closeTable(&tables[2]));
+    TEST_CHECK(shutdownRecordManager());
+
+    // tables with the same schema share it
+    initConfig(&config);
+    config.catalogFile = "test_catalog.db";
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(createTable("test_cat_a", schema));
+    TEST_CHECK(createTable("test_cat_b", schema));
+    TEST_CHECK(openTable(&tables[0], "test_cat_a"));
+    TEST_CHECK(openTable(&tables[1], "test_cat_b"));
+    TEST_CHECK(openTable(&tables[2], "test_cat_other"));
+    ASSERT_TRUE(tables[0].schema == tables[1].schema, "interned schema");
+    ASSERT_TRUE(tables[0].schema != schema && tables[2].schema != tables[0].schema, "schemas of the catalog");
+    for(i = 0; i < numRecords; i++) {
+        r = testRecord(schema, i, "abcd", i % 7);
+        TEST_CHECK(insertRecord(&tables[0], r));
+        TEST_CHECK(insertRecord(&tables[1], r));
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(&tables[1]));
+    ASSERT_TRUE(strcmp(tables[0].schema->attrNames[2], "c") == 0, "schema outlives a table using it");
+    TEST_CHECK(closeTable(&tables[0]));
+    TEST_CHECK(closeTable(&tables[2]));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(openPageFile("test_catalog.db", &fHandle));
+    TEST_CHECK(readBlock(0, &fHandle, page));
+    memcpy(&numTables, page + CATALOG_MAGIC_SIZE, sizeof(unsigned int));
+    ASSERT_TRUE(memcmp(page, CATALOG_MAGIC, CATALOG_MAGIC_SIZE) == 0, "catalog file");
+    ASSERT_EQUALS_INT(3, (int) numTables, "created and opened tables saved");
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // the catalog is loaded again, deleting a table saves it right away
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(openTable(&tables[0], "test_cat_a"));
+    MAKE_CONS(all, stringToValue("btrue"));
+    numMatches = countScan(&tables[0], all, &numReadIO);
+    ASSERT_EQUALS_INT(numRecords, numMatches, "table of the loaded catalog");
+    TEST_CHECK(closeTable(&tables[0]));
+    TEST_CHECK(deleteTable("test_cat_b"));
+    TEST_CHECK(openPageFile("test_catalog.db", &fHandle));
+    TEST_CHECK(readBlock(0, &fHandle, page));
+    memcpy(&numTables, page + CATALOG_MAGIC_SIZE, sizeof(unsigned int));
+    ASSERT_EQUALS_INT(2, (int) numTables, "deleted table removed from the file");
+    TEST_CHECK(shutdownRecordManager());
+
+    // a catalog file that was never written is ignored, tables are added
+    // from their headers
+    memset(page, 0, PAGE_SIZE);
+    TEST_CHECK(writeBlock(0, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(openTable(&tables[0], "test_cat_a"));
+    numMatches = countScan(&tables[0], all, &numReadIO);
+    ASSERT_EQUALS_INT(numRecords, numMatches, "table without a catalog entry");
+    TEST_CHECK(closeTable(&tables[0]));
+    TEST_CHECK(deleteTable("test_cat_a"));
+    TEST_CHECK(deleteTable("test_cat_other"));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(destroyPageFile("test_catalog.db"));
+
+    // a catalog over several pages leaves their trailers to the checksums
+    config.pageChecksums = true;
+    TEST_CHECK(initRecordManager(&config));
+    for(i = 0; i < CAT_TEST_TABLES; i++) {
+        sprintf(name, "test_cat_%0*d", CAT_TEST_NAME_LENGTH - 9, i);
+        TEST_CHECK(createTable(name, schema));
+    }
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(openTable(&tables[0], name));
+    TEST_CHECK(closeTable(&tables[0]));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(openPageFile("test_catalog.db", &fHandle));
+    ASSERT_TRUE(fHandle.totalNumPages > 1, "catalog over several pages");
+    TEST_CHECK(closePageFile(&fHandle));
+
+    // a catalog torn by a crash during a save is dropped, its tables are
+    // added again from their headers and the next save replaces it
+    config.pageChecksums = false;
+    TEST_CHECK(openPageFile("test_catalog.db", &fHandle));
+    TEST_CHECK(readBlock(1, &fHandle, page));
+    page[0] ^= 1;
+    TEST_CHECK(writeBlock(1, &fHandle, page));
+    TEST_CHECK(closePageFile(&fHandle));
+    rc = initRecordManager(&config);
+    ASSERT_EQUALS_INT(RC_OK, rc, "starts with a corrupted catalog");
+    TEST_CHECK(openTable(&tables[0], name));
+    ASSERT_TRUE(strcmp(tables[0].schema->attrNames[2], "c") == 0, "schema from the header");
+    TEST_CHECK(closeTable(&tables[0]));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(openPageFile("test_catalog.db", &fHandle));
+    TEST_CHECK(readBlock(0, &fHandle, page));
+    memcpy(&numTables, page + CATALOG_MAGIC_SIZE, sizeof(unsigned int));
+    ASSERT_EQUALS_INT(1, (int) numTables, "corrupted catalog saved over");
+    TEST_CHECK(closePageFile(&fHandle));
+    TEST_CHECK(initRecordManager(&config));
+    TEST_CHECK(shutdownRecordManager());
+    TEST_CHECK(destroyPageFile("test_catalog.db"));
+    TEST_CHECK(initRecordManager(NULL));
+    for(i = 0; i < CAT_TEST_TABLES; i++) {
+        sprintf(name, "test_cat_%0*d", CAT_TEST_NAME_LENGTH - 9, i);
+        TEST_CHECK(deleteTable(name));
+    }
+    TEST_CHECK(shutdownRecordManager());
+
+    freeExpr(all);
+    freeSchema(schema);
+    freeSchema(other);
+    free(page);
+    free(tables);
+    TEST_DONE();
+}
+
+Schema* testSchema (void) {
+    Schema *result;
+    char *names[] = { "a", "b", "c" };
+    DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+    int sizes[] = { 0, 4, 0 };
+    int keys[] = {0};
+    int i;
+    char **cpNames = (char **) malloc(sizeof(char*) * 3);
+    DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+    int *cpSizes = (int *) malloc(sizeof(int) * 3);
+    int *cpKeys = (int *) malloc(sizeof(int));
+
+    for(i = 0; i < 3; i++) {
+        cpNames[i] = (char *) malloc(2);
+        strcpy(cpNames[i], names[i]);
+    }
+    memcpy(cpDt, dt, sizeof(DataType) * 3);
+    memcpy(cpSizes, sizes, sizeof(int) * 3);
+    memcpy(cpKeys, keys, sizeof(int));
+
+    result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+    return result;
+}
+
+Record* fromTestRecord (Schema *schema, TestRecord in) {
+    return testRecord(schema, in.a, in.b, in.c);
+}
+
+Record* testRecord(Schema *schema, int a, char *b, int c) {
+    Record *result;
+    Value *value;
+
+    TEST_CHECK(createRecord(&result, schema));
+
+    MAKE_VALUE(value, DT_INT, a);
+    TEST_CHECK(setAttr(result, schema, 0, value));
+    freeVal(value);
+
+    MAKE_STRING_VALUE(value, b);
+    TEST_CHECK(setAttr(result, schema, 1, value));
+    freeVal(value);
+
+    MAKE_VALUE(value, DT_INT, c);
+    TEST_CHECK(setAttr(result, schema, 2, value));
+    freeVal(value);
+
+    return result;
+}
+
+int getAttrInt (Record *record, Schema *schema, int attrNum) {
+    Value *value;
+    int result;
+
+    TEST_CHECK(getAttr(record, schema, attrNum, &value));
+    result = value->v.intV;
     freeVal(value);
 
     return result;
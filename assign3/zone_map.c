@@ -0,0 +1,431 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "zone_map.h"
+#include "storage_mgr.h"
+
+/*********************************************************************
+*
+*                             MACROS
+*
+*********************************************************************/
+#define VALID_CALLOC(type, varName, number, size)   \
+    type *varName = (type *) calloc(number, size);  \
+    if(!varName){                                   \
+        printError(RC_BM_MEMORY_ALOC_FAIL);         \
+        exit(-1);                                   \
+    }
+
+/**Must declare RC returnCode in function before using ASSERT_RC_OK**/
+#define ASSERT_RC_OK(functionCall)  \
+    returnCode = functionCall;      \
+    if(returnCode != RC_OK )        \
+       return returnCode;
+
+/*********************************************************************
+Offset Macros for the zone map file header
+*********************************************************************/
+#define zmNumPagesOffset 0
+#define zmEntrySizeOffset sizeof(unsigned int)
+#define zmIsCleanOffset zmEntrySizeOffset + sizeof(unsigned short)
+
+#define hasRecordsOffset 0
+#define getEntry(zoneMap, pageNum) ((zoneMap)->entries + (pageNum)*(zoneMap)->entrySize)
+
+/*********************************************************************
+*
+*                       FUNCTION PROTOTYPES
+*
+*********************************************************************/
+static bool hasZoneMap(DataType dt);
+static void growZoneMap(RM_ZoneMap *zoneMap, unsigned int numPages);
+static int compareAttr(DataType dt, int typeLength, char *left, char *right);
+static bool compareCons(DataType dt, int typeLength, char *attr, Value *cons, int *cmp);
+static bool canMatch(RM_ZoneMap *zoneMap, char *entry, Expr *expr, bool negate);
+static bool canMatchComp(RM_ZoneMap *zoneMap, char *entry, Operator *op, bool negate);
+
+/*********************************************************************
+*
+*                       ZONE MAP FUNCTIONS
+*
+*********************************************************************/
+
+/*********************************************************************
+initZoneMap sets up an empty zone map for records of schema
+INPUT:
+    *schema: schema of the table, has to outlive the zone map
+    *attrOffsets: byte offset of every attribute in the record
+*********************************************************************/
+RC initZoneMap (RM_ZoneMap *zoneMap, Schema *schema, int *attrOffsets)
+{
+    if(!zoneMap || !schema || !attrOffsets)
+        return RC_RM_INIT_ERROR;
+    VALID_CALLOC(int, boundsOffsets, schema->numAttr, sizeof(int));
+    int entrySize = sizeof(unsigned char);
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        boundsOffsets[i] = -1;
+        if(!hasZoneMap(schema->dataTypes[i]))
+            continue;
+        boundsOffsets[i] = entrySize;
+        entrySize += 2*schema->typeLength[i];
+    }
+    zoneMap->schema = schema;
+    zoneMap->attrOffsets = attrOffsets;
+    zoneMap->boundsOffsets = boundsOffsets;
+    zoneMap->entrySize = entrySize;
+    zoneMap->numPages = 0;
+    zoneMap->entries = NULL;
+    return RC_OK;
+}
+
+void freeZoneMap (RM_ZoneMap *zoneMap)
+{
+    free(zoneMap->boundsOffsets);
+    free(zoneMap->entries);
+    zoneMap->boundsOffsets = NULL;
+    zoneMap->entries = NULL;
+    zoneMap->numPages = 0;
+}
+
+void clearZoneMapPage (RM_ZoneMap *zoneMap, unsigned int pageNum)
+{
+    if(pageNum < zoneMap->numPages)
+        memset(getEntry(zoneMap, pageNum), 0, zoneMap->entrySize);
+}
+
+/*********************************************************************
+extendZoneMap widens the bounds of page pageNum so they include every
+attribute of the record data. The first record of a page sets them.
+*********************************************************************/
+void extendZoneMap (RM_ZoneMap *zoneMap, unsigned int pageNum, char *data)
+{
+    growZoneMap(zoneMap, pageNum + 1);
+    Schema *schema = zoneMap->schema;
+    char *entry = getEntry(zoneMap, pageNum);
+    bool isFirst = entry[hasRecordsOffset] == 0;
+    entry[hasRecordsOffset] = 1;
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        if(zoneMap->boundsOffsets[i] < 0)
+            continue;
+        int typeLength = schema->typeLength[i];
+        char *value = data + zoneMap->attrOffsets[i];
+        char *min = entry + zoneMap->boundsOffsets[i];
+        char *max = min + typeLength;
+        if(isFirst || compareAttr(schema->dataTypes[i], typeLength, value, min) < 0)
+            memcpy(min, value, typeLength);
+        if(isFirst || compareAttr(schema->dataTypes[i], typeLength, value, max) > 0)
+            memcpy(max, value, typeLength);
+    }
+}
+
+/*********************************************************************
+isZoneMapBound checks if any attribute of the record data is the min
+or max of page pageNum. Only removing such a record narrows the bounds.
+*********************************************************************/
+bool isZoneMapBound (RM_ZoneMap *zoneMap, unsigned int pageNum, char *data)
+{
+    if(pageNum >= zoneMap->numPages)
+        return false;
+    Schema *schema = zoneMap->schema;
+    char *entry = getEntry(zoneMap, pageNum);
+    if(entry[hasRecordsOffset] == 0)
+        return false;
+    for(int i = 0; i < schema->numAttr; i++)
+    {
+        if(zoneMap->boundsOffsets[i] < 0)
+            continue;
+        int typeLength = schema->typeLength[i];
+        char *value = data + zoneMap->attrOffsets[i];
+        char *min = entry + zoneMap->boundsOffsets[i];
+        if(compareAttr(schema->dataTypes[i], typeLength, value, min) == 0
+                || compareAttr(schema->dataTypes[i], typeLength, value, min + typeLength) == 0)
+            return true;
+    }
+    return false;
+}
+
+/*********************************************************************
+zoneMapCanMatch checks the bounds of page pageNum against the
+comparisons of cond. AND, OR and NOT are followed, other expressions
+are assumed to match.
+RETURNS: false if no record of the page can satisfy cond
+*********************************************************************/
+bool zoneMapCanMatch (RM_ZoneMap *zoneMap, unsigned int pageNum, Expr *cond)
+{
+    //pages without an entry never had a record
+    if(pageNum >= zoneMap->numPages)
+        return false;
+    char *entry = getEntry(zoneMap, pageNum);
+    if(entry[hasRecordsOffset] == 0)
+        return false;
+    if(!cond)
+        return true;
+    return canMatch(zoneMap, entry, cond, false);
+}
+
+/*********************************************************************
+canMatch evaluates expr on the bounds of a page. negate is set below
+an odd number of NOTs, in which case expr has to be able to be false.
+*********************************************************************/
+static bool canMatch(RM_ZoneMap *zoneMap, char *entry, Expr *expr, bool negate)
+{
+    if(expr->type != EXPR_OP)
+        return true;
+    Operator *op = expr->expr.op;
+    switch(op->type)
+    {
+    case OP_BOOL_AND:
+        if(negate)
+            return canMatch(zoneMap, entry, op->args[0], true) || canMatch(zoneMap, entry, op->args[1], true);
+        return canMatch(zoneMap, entry, op->args[0], false) && canMatch(zoneMap, entry, op->args[1], false);
+    case OP_BOOL_OR:
+        if(negate)
+            return canMatch(zoneMap, entry, op->args[0], true) && canMatch(zoneMap, entry, op->args[1], true);
+        return canMatch(zoneMap, entry, op->args[0], false) || canMatch(zoneMap, entry, op->args[1], false);
+    case OP_BOOL_NOT:
+        return canMatch(zoneMap, entry, op->args[0], !negate);
+    case OP_COMP_EQUAL:
+    case OP_COMP_SMALLER:
+        return canMatchComp(zoneMap, entry, op, negate);
+    }
+    return true;
+}
+
+/*********************************************************************
+canMatchComp checks a comparison of an attribute with a constant
+against the [min, max] range of the attribute
+*********************************************************************/
+static bool canMatchComp(RM_ZoneMap *zoneMap, char *entry, Operator *op, bool negate)
+{
+    Expr *left = op->args[0];
+    Expr *right = op->args[1];
+    bool consOnLeft;
+    int attrNum;
+    Value *cons;
+    if(left->type == EXPR_ATTRREF && right->type == EXPR_CONST)
+    {
+        attrNum = left->expr.attrRef;
+        cons = right->expr.cons;
+        consOnLeft = false;
+    }
+    else if(left->type == EXPR_CONST && right->type == EXPR_ATTRREF)
+    {
+        attrNum = right->expr.attrRef;
+        cons = left->expr.cons;
+        consOnLeft = true;
+    }
+    else
+        return true;
+    if(attrNum < 0 || attrNum >= zoneMap->schema->numAttr || zoneMap->boundsOffsets[attrNum] < 0)
+        return true;
+    DataType dt = zoneMap->schema->dataTypes[attrNum];
+    int typeLength = zoneMap->schema->typeLength[attrNum];
+    char *min = entry + zoneMap->boundsOffsets[attrNum];
+    char *max = min + typeLength;
+    int minCmp, maxCmp; //min - cons and max - cons
+    if(!compareCons(dt, typeLength, min, cons, &minCmp) || !compareCons(dt, typeLength, max, cons, &maxCmp))
+        return true;
+    if(op->type == OP_COMP_EQUAL)
+    {
+        if(negate)
+            return !(minCmp == 0 && maxCmp == 0);
+        return minCmp <= 0 && maxCmp >= 0;
+    }
+    //attr < cons, or attr >= cons when negated
+    if(!consOnLeft)
+        return negate ? maxCmp >= 0 : minCmp < 0;
+    //cons < attr, or attr <= cons when negated
+    return negate ? minCmp <= 0 : maxCmp > 0;
+}
+
+/*********************************************************************
+*
+*                         ZONE MAP FILES
+*
+*********************************************************************/
+
+/*********************************************************************
+readZoneMap loads the entries saved in fileName. A zone map that was
+saved by a different schema is returned empty and not clean.
+INPUT:
+    *zoneMap: zone map set up by initZoneMap
+    *fileName: name of the zone map file
+    *isClean: set to false if the entries can't be trusted
+RETURNS: RC_OK or the error of the storage manager
+*********************************************************************/
+RC readZoneMap (RM_ZoneMap *zoneMap, char *fileName, bool *isClean)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    ASSERT_RC_OK(openPageFile(fileName, &fHandle));
+    VALID_CALLOC(char, page, 1, PAGE_SIZE);
+    returnCode = readBlock(0, &fHandle, page);
+    if(returnCode != RC_OK)
+    {
+        free(page);
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    unsigned int numPages;
+    unsigned short entrySize, clean;
+    memcpy(&numPages, page + zmNumPagesOffset, sizeof(unsigned int));
+    memcpy(&entrySize, page + zmEntrySizeOffset, sizeof(unsigned short));
+    memcpy(&clean, page + zmIsCleanOffset, sizeof(unsigned short));
+    *isClean = clean && entrySize == zoneMap->entrySize
+               && (long long) numPages*entrySize <= (long long)(fHandle.totalNumPages - 1)*PAGE_DATA_SIZE;
+    if(*isClean)
+    {
+        growZoneMap(zoneMap, numPages);
+        int size = numPages*entrySize;
+        for(int pageNum = 1; size > 0 && returnCode == RC_OK; pageNum++)
+        {
+            int offset = (pageNum - 1)*PAGE_DATA_SIZE;
+            int length = size - offset < PAGE_DATA_SIZE ? size - offset : PAGE_DATA_SIZE;
+            if(length <= 0)
+                break;
+            returnCode = readBlock(pageNum, &fHandle, page);
+            memcpy(zoneMap->entries + offset, page, length);
+        }
+    }
+    free(page);
+    if(returnCode != RC_OK)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    return closePageFile(&fHandle);
+}
+
+/*********************************************************************
+writeZoneMap saves the zone map in fileName, which is created if it
+doesn't exist. The entries are only written if isClean is set, since
+a zone map that isn't clean is rebuilt when the table is opened.
+*********************************************************************/
+RC writeZoneMap (RM_ZoneMap *zoneMap, char *fileName, bool isClean)
+{
+    RC returnCode = RC_INIT;
+    SM_FileHandle fHandle;
+    if(openPageFile(fileName, &fHandle) != RC_OK)
+    {
+        ASSERT_RC_OK(createPageFile(fileName));
+        ASSERT_RC_OK(openPageFile(fileName, &fHandle));
+    }
+    VALID_CALLOC(char, page, 1, PAGE_SIZE);
+    unsigned short entrySize = (unsigned short) zoneMap->entrySize;
+    unsigned short clean = isClean ? 1 : 0;
+    memcpy(page + zmNumPagesOffset, &zoneMap->numPages, sizeof(unsigned int));
+    memcpy(page + zmEntrySizeOffset, &entrySize, sizeof(unsigned short));
+    memcpy(page + zmIsCleanOffset, &clean, sizeof(unsigned short));
+    returnCode = writeBlock(0, &fHandle, page);
+    int size = isClean ? zoneMap->numPages*zoneMap->entrySize : 0;
+    if(returnCode == RC_OK && size > 0)
+        returnCode = ensureCapacity(1 + (size + PAGE_DATA_SIZE - 1)/PAGE_DATA_SIZE, &fHandle);
+    for(int offset = 0; offset < size && returnCode == RC_OK; offset += PAGE_DATA_SIZE)
+    {
+        int length = size - offset < PAGE_DATA_SIZE ? size - offset : PAGE_DATA_SIZE;
+        memset(page, 0, PAGE_SIZE);
+        memcpy(page, zoneMap->entries + offset, length);
+        returnCode = writeBlock(1 + offset/PAGE_DATA_SIZE, &fHandle, page);
+    }
+    free(page);
+    if(returnCode != RC_OK)
+    {
+        closePageFile(&fHandle);
+        return returnCode;
+    }
+    return closePageFile(&fHandle);
+}
+
+/*********************************************************************
+*
+*                        HELPER FUNCTIONS
+*
+*********************************************************************/
+static bool hasZoneMap(DataType dt)
+{
+    return dt == DT_INT || dt == DT_FLOAT || dt == DT_STRING;
+}
+
+//makes room for entries of numPages pages, new entries have no records
+static void growZoneMap(RM_ZoneMap *zoneMap, unsigned int numPages)
+{
+    if(numPages <= zoneMap->numPages)
+        return;
+    unsigned int capacity = zoneMap->numPages ? zoneMap->numPages : 1;
+    while(capacity < numPages)
+        capacity *= 2;
+    char *entries = (char *) realloc(zoneMap->entries, (size_t) capacity*zoneMap->entrySize);
+    if(!entries)
+    {
+        printError(RC_BM_MEMORY_ALOC_FAIL);
+        exit(-1);
+    }
+    memset(entries + zoneMap->numPages*zoneMap->entrySize, 0,
+           (size_t)(capacity - zoneMap->numPages)*zoneMap->entrySize);
+    zoneMap->entries = entries;
+    zoneMap->numPages = capacity;
+}
+
+//compares two attribute values stored in record format
+static int compareAttr(DataType dt, int typeLength, char *left, char *right)
+{
+    switch(dt)
+    {
+    case DT_INT:
+    {
+        int l, r;
+        memcpy(&l, left, sizeof(int));
+        memcpy(&r, right, sizeof(int));
+        return (l > r) - (l < r);
+    }
+    case DT_FLOAT:
+    {
+        float l, r;
+        memcpy(&l, left, sizeof(float));
+        memcpy(&r, right, sizeof(float));
+        return (l > r) - (l < r);
+    }
+    case DT_STRING:
+        return strncmp(left, right, typeLength);
+    case DT_BOOL:
+        break;
+    }
+    return 0;
+}
+
+/*********************************************************************
+compareCons compares an attribute value stored in record format with
+cons the way evalExpr does
+RETURNS: false if the values can't be compared
+*********************************************************************/
+static bool compareCons(DataType dt, int typeLength, char *attr, Value *cons, int *cmp)
+{
+    if(cons->dt != dt)
+        return false;
+    switch(dt)
+    {
+    case DT_INT:
+    case DT_FLOAT:
+    {
+        char consData[sizeof(float) > sizeof(int) ? sizeof(float) : sizeof(int)];
+        if(dt == DT_INT)
+            memcpy(consData, &cons->v.intV, sizeof(int));
+        else
+            memcpy(consData, &cons->v.floatV, sizeof(float));
+        *cmp = compareAttr(dt, typeLength, attr, consData);
+        return true;
+    }
+    case DT_STRING:
+        *cmp = strncmp(attr, cons->v.stringV, typeLength);
+        //attr holds typeLength characters without terminator, so a
+        //longer constant starting with them is larger
+        if(*cmp == 0 && !memchr(attr, '\0', typeLength) && strlen(cons->v.stringV) > (size_t) typeLength)
+            *cmp = -1;
+        return true;
+    case DT_BOOL:
+        break;
+    }
+    return false;
+}
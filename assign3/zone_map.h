@@ -0,0 +1,52 @@
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <stdbool.h>
+#include "dberror.h"
+#include "tables.h"
+#include "expr.h"
+
+/*********************************************************************
+Zone maps keep the smallest and largest value of every DT_INT, DT_FLOAT
+and DT_STRING attribute on a data page, so scans can skip pages that
+can't hold a matching record. The bounds only widen on inserts and
+updates; deletes narrow them again when they remove a bound.
+
+Every page has one entry:
+---------------------------------------------------------------------------
+uchar hasRecords | (min | max) for every attribute with a zone map |
+---------------------------------------------------------------------------
+min and max take typeLength bytes each.
+
+The zone maps of a table are kept in memory while it is open and saved
+in the page file <table name>.zm when it is closed:
+page 0:  uint numPages | ushort entrySize | ushort isClean
+page 1+: the entries of all pages, one after the other
+*********************************************************************/
+typedef struct RM_ZoneMap {
+    Schema *schema;
+    int *attrOffsets;   //byte offset of every attribute in the record
+    int *boundsOffsets; //offset of min in the entry, -1 without zone map
+    int entrySize;
+    unsigned int numPages; //number of entries
+    char *entries;
+} RM_ZoneMap;
+
+#define ZONE_MAP_SUFFIX ".zm"
+
+extern RC initZoneMap (RM_ZoneMap *zoneMap, Schema *schema, int *attrOffsets);
+extern void freeZoneMap (RM_ZoneMap *zoneMap);
+// drops the entry of pageNum, so it can be rebuilt from its records
+extern void clearZoneMapPage (RM_ZoneMap *zoneMap, unsigned int pageNum);
+// widens the bounds of pageNum to include the record data
+extern void extendZoneMap (RM_ZoneMap *zoneMap, unsigned int pageNum, char *data);
+// checks if the record data is on a bound of pageNum
+extern bool isZoneMapBound (RM_ZoneMap *zoneMap, unsigned int pageNum, char *data);
+// returns false only if no record of pageNum can satisfy cond
+extern bool zoneMapCanMatch (RM_ZoneMap *zoneMap, unsigned int pageNum, Expr *cond);
+
+// zone map files
+extern RC readZoneMap (RM_ZoneMap *zoneMap, char *fileName, bool *isClean);
+extern RC writeZoneMap (RM_ZoneMap *zoneMap, char *fileName, bool isClean);
+
+#endif // ZONE_MAP_H